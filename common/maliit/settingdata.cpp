@@ -11,131 +11,127 @@
 
 #include "maliit/settingdata.h"
 
-namespace
+MImSettingValidator::MImSettingValidator(Maliit::SettingEntryType type, const QVariantMap &attributes)
+    : type(type)
+    , malformed(false)
+    , hasDomain(false)
+    , hasMin(false)
+    , hasMax(false)
+    , min(0)
+    , max(0)
 {
-    bool checkValueDomain(const QVariant &value, const QVariant &domain)
-    {
-        if (!domain.isValid())
-            return true;
-        if (!domain.canConvert(QVariant::List))
-            return false;
+    if (type == Maliit::BoolType)
+        return;
 
-        QVariantList domain_values = domain.toList();
+    const bool integral = type == Maliit::IntType || type == Maliit::IntListType;
+    const QVariant domain = attributes.value(Maliit::SettingEntryAttributes::valueDomain);
+
+    if (domain.isValid()) {
+        if (!domain.canConvert(QVariant::List)) {
+            malformed = true;
+            return;
+        }
 
-        return domain_values.contains(value);
+        hasDomain = true;
+        Q_FOREACH (const QVariant &v, domain.toList()) {
+            if (integral) {
+                bool ok = false;
+                const int i = v.toInt(&ok);
+
+                // Values that are no integers can never match
+                if (ok)
+                    intDomain.insert(i);
+            } else {
+                stringDomain.insert(v.toString());
+            }
+        }
     }
 
-    bool checkValueRange(const QVariant &value, const QVariant &range_min, const QVariant &range_max)
-    {
-        if (!range_min.isValid() && !range_max.isValid())
-            return true;
+    if (!integral)
+        return;
 
-        if (range_min.isValid()) {
-            if (!range_min.canConvert(QVariant::Int))
-                return false;
-            if (range_min.toInt() > value.toInt())
-                return false;
-        }
+    const QVariant range_min = attributes.value(Maliit::SettingEntryAttributes::valueRangeMin);
+    const QVariant range_max = attributes.value(Maliit::SettingEntryAttributes::valueRangeMax);
 
-        if (range_max.isValid()) {
-            if (!range_max.canConvert(QVariant::Int))
-                return false;
-            if (range_max.toInt() < value.toInt())
-                return false;
+    if (range_min.isValid()) {
+        if (!range_min.canConvert(QVariant::Int)) {
+            malformed = true;
+            return;
         }
+        hasMin = true;
+        min = range_min.toInt();
+    }
 
-        return true;
+    if (range_max.isValid()) {
+        if (!range_max.canConvert(QVariant::Int)) {
+            malformed = true;
+            return;
+        }
+        hasMax = true;
+        max = range_max.toInt();
     }
+}
 
-    bool checkValueDomain(const QVariantList &values, const QVariant &domain)
-    {
-        if (!domain.isValid())
-            return true;
-        if (!domain.canConvert(QVariant::List))
-            return false;
+bool MImSettingValidator::inDomain(const QString &value) const
+{
+    return !hasDomain || stringDomain.contains(value);
+}
 
-        const QVariantList &domain_values = domain.toList();
+bool MImSettingValidator::inDomain(int value) const
+{
+    return !hasDomain || intDomain.contains(value);
+}
 
-        Q_FOREACH (const QVariant &v, values)
-            if (!domain_values.contains(v))
-                return false;
+bool MImSettingValidator::inRange(int value) const
+{
+    return (!hasMin || min <= value) && (!hasMax || value <= max);
+}
 
-        return true;
-    }
+bool MImSettingValidator::validate(const QVariant &value) const
+{
+    if (malformed)
+        return false;
 
-    bool checkValueRange(const QVariantList &values, const QVariant &range_min, const QVariant &range_max)
+    switch (type)
     {
-        if (!range_min.isValid() && !range_max.isValid())
+    case Maliit::StringType:
+        return value.canConvert<QString>() && inDomain(value.toString());
+    case Maliit::IntType: {
+        bool ok = false;
+        const int i = value.toInt(&ok);
+
+        return ok && inDomain(i) && inRange(i);
+    }
+    case Maliit::BoolType:
+        return value.canConvert<bool>();
+    case Maliit::StringListType:
+        if (!value.canConvert<QStringList>())
+            return false;
+        if (!hasDomain)
             return true;
 
-        Q_FOREACH (const QVariant &v, values)
-            if (!checkValueRange(v, range_min, range_max))
+        Q_FOREACH (const QString &v, value.toStringList())
+            if (!stringDomain.contains(v))
                 return false;
-
         return true;
-    }
-
-    bool checkIntList(const QVariant &value)
-    {
+    case Maliit::IntListType:
         if (!value.canConvert<QVariantList>())
             return false;
 
-        const QVariantList &values = value.toList();
+        Q_FOREACH (const QVariant &v, value.toList()) {
+            bool ok = false;
+            const int i = v.toInt(&ok);
 
-        Q_FOREACH (const QVariant &v, values)
-        {
-            QVariant copy = v;
-
-            if (!v.canConvert<int>() || !copy.convert(QVariant::Int))
+            if (!ok || !inDomain(i) || !inRange(i))
                 return false;
         }
-
         return true;
     }
+
+    return false;
 }
 
 bool validateSettingValue(Maliit::SettingEntryType type, const QVariantMap attributes, const QVariant &value)
 {
-    QVariant domain = attributes[Maliit::SettingEntryAttributes::valueDomain];
-    QVariant range_min = attributes[Maliit::SettingEntryAttributes::valueRangeMin];
-    QVariant range_max = attributes[Maliit::SettingEntryAttributes::valueRangeMax];
-    QVariant copy = value;
-
-    switch (type)
-    {
-    case Maliit::StringType:
-        if (!value.canConvert<QString>())
-            return false;
-        if (!checkValueDomain(value, domain))
-            return false;
-        break;
-    case Maliit::IntType:
-        if (!value.canConvert<int>() || !copy.convert(QVariant::Int))
-            return false;
-        if (!checkValueDomain(value, domain))
-            return false;
-        if (!checkValueRange(value, range_min, range_max))
-            return false;
-        break;
-    case Maliit::BoolType:
-        if (!value.canConvert<bool>())
-            return false;
-        break;
-    case Maliit::StringListType:
-        if (!value.canConvert<QStringList>())
-            return false;
-        if (!checkValueDomain(value.toList(), domain))
-            return false;
-        break;
-    case Maliit::IntListType:
-        if (!checkIntList(value))
-            return false;
-        if (!checkValueDomain(value.toList(), domain))
-            return false;
-        if (!checkValueRange(value.toList(), range_min, range_max))
-            return false;
-        break;
-    }
-
-    return true;
+    return MImSettingValidator(type, attributes).validate(value);
 }
@@ -17,6 +17,7 @@
 #include <QString>
 #include <QVariant>
 #include <QList>
+#include <QSet>
 
 
 /*!
@@ -57,8 +58,44 @@ struct MImPluginSettingsInfo
 };
 
 
+/*!
+ * \brief Validates values of a plugin setting entry.
+ *
+ * Type and attributes of the entry are compiled once: the value domain
+ * becomes a hash set and the range a pair of integers, so that checking a
+ * list value costs one lookup per element regardless of the domain size.
+ * Malformed attributes make every value invalid.
+ */
+class MImSettingValidator
+{
+public:
+    MImSettingValidator(Maliit::SettingEntryType type, const QVariantMap &attributes);
+
+    bool validate(const QVariant &value) const;
+
+private:
+    bool inDomain(const QString &value) const;
+    bool inDomain(int value) const;
+    bool inRange(int value) const;
+
+    Maliit::SettingEntryType type;
+    bool malformed;
+    bool hasDomain;
+    bool hasMin;
+    bool hasMax;
+    int min;
+    int max;
+    //! Domain of string types
+    QSet<QString> stringDomain;
+    //! Domain of integer types
+    QSet<int> intDomain;
+};
+
 /*!
  * \brief Validate the value for a plugin setting entry
+ *
+ * Compiles the attributes on every call; use MImSettingValidator to check
+ * values of the same entry repeatedly.
  */
 bool validateSettingValue(Maliit::SettingEntryType type, const QVariantMap attributes, const QVariant &value);
 
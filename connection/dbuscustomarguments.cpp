@@ -15,6 +15,7 @@
 #include  <maliit/settingdata.h>
 
 #include <QDBusArgument>
+#include <QtEndian>
 
 
 QT_BEGIN_NAMESPACE
@@ -112,3 +113,73 @@ const QDBusArgument &operator>>(const QDBusArgument &arg, Maliit::PreeditTextFor
 }
 QT_END_NAMESPACE
 
+namespace Maliit {
+namespace DBus {
+
+QByteArray packPreeditFormats(const QList<Maliit::PreeditTextFormat> &formats)
+{
+    QByteArray packed(formats.count() * PackedPreeditFormatSize, Qt::Uninitialized);
+    uchar *record = reinterpret_cast<uchar *>(packed.data());
+
+    Q_FOREACH (const Maliit::PreeditTextFormat &format, formats) {
+        qToLittleEndian<quint32>(format.start, record);
+        qToLittleEndian<quint32>(format.length, record + 4);
+        record[8] = static_cast<uchar>(format.preeditFace);
+        record += PackedPreeditFormatSize;
+    }
+
+    return packed;
+}
+
+bool unpackPreeditFormats(const QByteArray &packed, QList<Maliit::PreeditTextFormat> *formats)
+{
+    if (packed.size() % PackedPreeditFormatSize != 0) {
+        return false;
+    }
+
+    const uchar *record = reinterpret_cast<const uchar *>(packed.constData());
+    const int count = packed.size() / PackedPreeditFormatSize;
+
+    formats->clear();
+    formats->reserve(count);
+
+    for (int n = 0; n < count; ++n, record += PackedPreeditFormatSize) {
+        formats->append(Maliit::PreeditTextFormat(qint32(qFromLittleEndian<quint32>(record)),
+                                                  qint32(qFromLittleEndian<quint32>(record + 4)),
+                                                  static_cast<Maliit::PreeditFace>(record[8])));
+    }
+
+    return true;
+}
+
+int compactPreeditPrefix(const QString &sent, const QString &preedit)
+{
+    const int length = qMin(sent.length(), preedit.length());
+    int prefix = 0;
+
+    while (prefix < length && sent.at(prefix) == preedit.at(prefix)) {
+        ++prefix;
+    }
+
+    // A surrogate pair cannot be split
+    if (prefix > 0 && preedit.at(prefix - 1).isHighSurrogate()) {
+        --prefix;
+    }
+
+    return prefix;
+}
+
+bool applyCompactPreedit(QString *preedit, uint prefixLength, const QString &suffix)
+{
+    if (prefixLength > uint(preedit->length())) {
+        return false;
+    }
+
+    preedit->truncate(prefixLength);
+    preedit->append(suffix);
+
+    return true;
+}
+
+} // namespace DBus
+} // namespace Maliit
@@ -35,4 +35,39 @@ QDBusArgument &operator<<(QDBusArgument &arg, const Maliit::PreeditTextFormat &f
 const QDBusArgument &operator>>(const QDBusArgument &arg, Maliit::PreeditTextFormat &format);
 QT_END_NAMESPACE
 
+class QByteArray;
+class QString;
+
+namespace Maliit {
+namespace DBus {
+
+//! Size of one packed preedit format
+const int PackedPreeditFormatSize = 9;
+
+/*!
+ * \brief Packs \a formats into one byte array of fixed size records.
+ *
+ * Each record holds the start and length as little-endian 32 bit integers,
+ * followed by the face in one byte.
+ */
+QByteArray packPreeditFormats(const QList<Maliit::PreeditTextFormat> &formats);
+
+//! Unpacks formats packed with packPreeditFormats(); returns false if \a packed is malformed.
+bool unpackPreeditFormats(const QByteArray &packed, QList<Maliit::PreeditTextFormat> *formats);
+
+/*!
+ * \brief Returns how many leading characters \a preedit shares with \a sent.
+ *
+ * Only the rest of \a preedit goes out with a compact update. The prefix
+ * never ends within a surrogate pair.
+ */
+int compactPreeditPrefix(const QString &sent, const QString &preedit);
+
+//! Keeps the first \a prefixLength characters of \a preedit and appends \a suffix;
+//! returns false, leaving \a preedit alone, if it is shorter than \a prefixLength.
+bool applyCompactPreedit(QString *preedit, uint prefixLength, const QString &suffix);
+
+} // namespace DBus
+} // namespace Maliit
+
 #endif // DBUSCUSTOMARGUMENTS_H
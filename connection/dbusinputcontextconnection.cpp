@@ -16,7 +16,10 @@
 #include "minputmethodserver1interfaceadaptor.h"
 #include "minputmethodcontext1interface_interface.h"
 #include "dbuscustomarguments.h"
+#include "mimmetrics.h"
+#include "mimsessionlog.h"
 
+#include <QDBusArgument>
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QDBusServer>
@@ -36,6 +39,23 @@ const char * const DBusLocalPath("/org/freedesktop/DBus/Local");
 const char * const DBusLocalInterface("org.freedesktop.DBus.Local");
 const char * const DisconnectedSignal("Disconnected");
 
+QVariantList recordablePreeditFormats(const QList<Maliit::PreeditTextFormat> &preeditFormats)
+{
+    QVariantList formats;
+    Q_FOREACH (const Maliit::PreeditTextFormat &format, preeditFormats) {
+        formats.append(QVariantList() << format.start << format.length << int(format.preeditFace));
+    }
+    return formats;
+}
+
+QVariantMap demarshallMap(const QVariant &value)
+{
+    if (value.userType() == qMetaTypeId<QDBusArgument>()) {
+        return qdbus_cast<QVariantMap>(value.value<QDBusArgument>());
+    }
+    return value.toMap();
+}
+
 }
 
 DBusInputContextConnection::DBusInputContextConnection(const QSharedPointer<Maliit::Server::DBus::Address> &address)
@@ -73,6 +93,11 @@ DBusInputContextConnection::newConnection(const QDBusConnection &connection)
     mProxys.insert(connectionNumber, proxy);
     mConnections.insert(connectionNumber, connection.name());
 
+    if (MImMetrics *registry = metrics().data()) {
+        registry->increment(MImMetrics::ClientConnections);
+        registry->setGauge(MImMetrics::ConnectedClients, mConnectionNumbers.count());
+    }
+
     QDBusConnection c(connection);
 
     c.connect(QString(), QString::fromLatin1(DBusLocalPath), QString::fromLatin1(DBusLocalInterface),
@@ -91,6 +116,11 @@ DBusInputContextConnection::onDisconnection()
     unsigned int connectionNumber = mConnectionNumbers.take(name);
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.take(connectionNumber);
     mConnections.remove(connectionNumber);
+    mCompactPreedits.remove(connectionNumber);
+
+    if (MImMetrics *registry = metrics().data()) {
+        registry->setGauge(MImMetrics::ConnectedClients, mConnectionNumbers.count());
+    }
 
     // Call handleDisconnection before deleting proxy to avoid use-after-free
     // if any slots triggered by the signal access the proxy
@@ -116,7 +146,27 @@ DBusInputContextConnection::sendPreeditString(const QString &string,
 
         ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
         if (proxy) {
-            proxy->updatePreedit(string, preeditFormats, replacementStart, replacementLength, cursorPos);
+            QHash<unsigned int, QString>::iterator sent = mCompactPreedits.find(activeConnection);
+
+            if (sent != mCompactPreedits.end()) {
+                // Only what changed since the last preedit; candidate lists
+                // usually keep most of it.
+                const int prefix = Maliit::DBus::compactPreeditPrefix(sent.value(), string);
+
+                proxy->updatePreeditCompact(prefix, string.mid(prefix),
+                                            Maliit::DBus::packPreeditFormats(preeditFormats),
+                                            replacementStart, replacementLength, cursorPos);
+                sent.value() = string;
+            } else {
+                proxy->updatePreedit(string, preeditFormats, replacementStart, replacementLength, cursorPos);
+            }
+            if (MImSessionRecorder *recorder = sessionRecorder()) {
+                const QVariantList arguments = QVariantList()
+                        << string << recordablePreeditFormats(preeditFormats)
+                        << replacementStart << replacementLength << cursorPos;
+                recorder->record(MImSessionEvent::Outbound, MImSessionEvent::UpdatePreedit,
+                                 activeConnection, arguments);
+            }
         }
     }
 }
@@ -131,6 +181,11 @@ DBusInputContextConnection::sendCommitString(const QString &string, int replaceS
         ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
         if (proxy) {
             proxy->commitString(string, replaceStart, replaceLength, cursorPos);
+            if (MImSessionRecorder *recorder = sessionRecorder()) {
+                recorder->record(MImSessionEvent::Outbound, MImSessionEvent::CommitString,
+                                 activeConnection, QVariantList() << string << replaceStart
+                                                                  << replaceLength << cursorPos);
+            }
         }
     }
 }
@@ -146,6 +201,14 @@ DBusInputContextConnection::sendKeyEvent(const QKeyEvent &keyEvent,
         if (proxy) {
             proxy->keyEvent(keyEvent.type(), keyEvent.key(), keyEvent.modifiers(),
                             keyEvent.text(), keyEvent.isAutoRepeat(), keyEvent.count(), requestType);
+            if (MImSessionRecorder *recorder = sessionRecorder()) {
+                const QVariantList arguments = QVariantList()
+                        << int(keyEvent.type()) << keyEvent.key() << int(keyEvent.modifiers())
+                        << keyEvent.text() << keyEvent.isAutoRepeat() << keyEvent.count()
+                        << int(requestType);
+                recorder->record(MImSessionEvent::Outbound, MImSessionEvent::KeyEvent,
+                                 activeConnection, arguments);
+            }
         }
     }
 }
@@ -156,6 +219,10 @@ DBusInputContextConnection::notifyImInitiatedHiding()
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
         proxy->imInitiatedHide();
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::ImInitiatedHide,
+                             activeConnection);
+        }
     }
 }
 
@@ -165,6 +232,10 @@ DBusInputContextConnection::setGlobalCorrectionEnabled(bool enabled)
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if ((enabled != globalCorrectionEnabled()) && proxy) {
         proxy->setGlobalCorrectionEnabled(enabled);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::SetGlobalCorrectionEnabled,
+                             activeConnection, QVariantList() << enabled);
+        }
         MInputContextConnection::setGlobalCorrectionEnabled(enabled);
     }
 }
@@ -174,6 +245,10 @@ DBusInputContextConnection::preeditRectangle(bool &valid)
 {
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::PreeditRectangle,
+                             activeConnection);
+        }
         int x, y, width, height;
         if (proxy->preeditRectangle(x, y, width, height)) {
             valid = true;
@@ -190,6 +265,10 @@ DBusInputContextConnection::setRedirectKeys(bool enabled)
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if ((enabled != redirectKeysEnabled()) && proxy) {
         proxy->setRedirectKeys(enabled);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::SetRedirectKeys,
+                             activeConnection, QVariantList() << enabled);
+        }
         MInputContextConnection::setRedirectKeys(enabled);
     }
 }
@@ -200,6 +279,10 @@ DBusInputContextConnection::setDetectableAutoRepeat(bool enabled)
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if ((enabled != detectableAutoRepeat()) && proxy) {
         proxy->setDetectableAutoRepeat(enabled);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::SetDetectableAutoRepeat,
+                             activeConnection, QVariantList() << enabled);
+        }
         MInputContextConnection::setDetectableAutoRepeat(enabled);
     }
 }
@@ -214,6 +297,10 @@ DBusInputContextConnection::invokeAction(const QString &action,
         arguments << action << sequence.toString();
         message.setArguments(arguments);
         QDBusConnection(mConnections.value(activeConnection)).send(message);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::InvokeAction,
+                             activeConnection, QVariantList() << action << sequence.toString());
+        }
     }
 }
 
@@ -223,6 +310,10 @@ DBusInputContextConnection::setSelection(int start, int length)
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
         proxy->setSelection(start, length);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::SetSelection,
+                             activeConnection, QVariantList() << start << length);
+        }
     }
 }
 
@@ -231,6 +322,10 @@ DBusInputContextConnection::selection(bool &valid)
 {
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::Selection,
+                             activeConnection);
+        }
         QString selectionText;
         if (proxy->selection(selectionText)) {
             valid = true;
@@ -248,6 +343,10 @@ DBusInputContextConnection::setLanguage(const QString &language)
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
         proxy->setLanguage(language);
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::SetLanguage,
+                             activeConnection, QVariantList() << language);
+        }
     }
 }
 
@@ -257,6 +356,10 @@ DBusInputContextConnection::sendActivationLostEvent()
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
         proxy->activationLostEvent();
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::ActivationLost,
+                             activeConnection);
+        }
     }
 }
 
@@ -267,6 +370,10 @@ DBusInputContextConnection::updateInputMethodArea(const QRegion &region)
     if (proxy) {
         QRect rect = region.boundingRect();
         proxy->updateInputMethodArea(rect.x(), rect.y(), rect.width(), rect.height());
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::UpdateInputMethodArea,
+                             activeConnection, QVariantList() << rect);
+        }
     }
 }
 
@@ -280,6 +387,11 @@ DBusInputContextConnection::notifyExtendedAttributeChanged(int id,
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(activeConnection);
     if (proxy) {
         proxy->notifyExtendedAttributeChanged(id, target, targetItem, attribute, QDBusVariant(value));
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound,
+                             MImSessionEvent::NotifyExtendedAttributeChanged, activeConnection,
+                             QVariantList() << id << target << targetItem << attribute << value);
+        }
     }
 }
 
@@ -291,10 +403,29 @@ DBusInputContextConnection::notifyExtendedAttributeChanged(const QList<int> &cli
                                                            const QString &attribute,
                                                            const QVariant &value)
 {
+    if (clientIds.isEmpty()) {
+        return;
+    }
+
+    // Build the call once and hand the same message to every subscribed peer,
+    // instead of going through each proxy and re-wrapping the arguments.
+    QDBusMessage message = QDBusMessage::createMethodCall(QString(), QString::fromLatin1(DBusClientPath),
+                                                          QString::fromLatin1(DBusClientInterface),
+                                                          QString::fromLatin1("notifyExtendedAttributeChanged"));
+    QList<QVariant> arguments;
+    arguments << id << target << targetItem << attribute
+              << QVariant::fromValue(QDBusVariant(value));
+    message.setArguments(arguments);
+
     Q_FOREACH (int clientId, clientIds) {
         ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(clientId);
         if (proxy) {
-            proxy->notifyExtendedAttributeChanged(id, target, targetItem, attribute, QDBusVariant(value));
+            proxy->connection().send(message);
+            if (MImSessionRecorder *recorder = sessionRecorder()) {
+                recorder->record(MImSessionEvent::Outbound,
+                                 MImSessionEvent::NotifyExtendedAttributeChanged, clientId,
+                                 QVariantList() << id << target << targetItem << attribute << value);
+            }
         }
     }
 }
@@ -305,6 +436,68 @@ DBusInputContextConnection::pluginSettingsLoaded(int clientId, const QList<MImPl
     ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(clientId);
     if (proxy) {
         proxy->pluginSettingsLoaded(info);
+
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            QStringList pluginNames;
+            Q_FOREACH (const MImPluginSettingsInfo &plugin, info) {
+                pluginNames.append(plugin.plugin_name);
+            }
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::PluginSettingsLoaded,
+                             clientId, QVariantList() << pluginNames);
+        }
+    }
+}
+
+void
+DBusInputContextConnection::pluginSettingsSnapshotLoaded(int clientId, quint64 version,
+                                                         const QList<MImPluginSettingsInfo> &info)
+{
+    ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(clientId);
+    if (proxy) {
+        proxy->pluginSettingsSnapshotLoaded(version, info);
+
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            QStringList pluginNames;
+            Q_FOREACH (const MImPluginSettingsInfo &plugin, info) {
+                pluginNames.append(plugin.plugin_name);
+            }
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::PluginSettingsLoaded,
+                             clientId, QVariantList() << pluginNames << version);
+        }
+    }
+}
+
+void
+DBusInputContextConnection::pluginSettingsUnchanged(int clientId, quint64 version)
+{
+    ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(clientId);
+    if (proxy) {
+        proxy->pluginSettingsUnchanged(version);
+
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::PluginSettingsLoaded,
+                             clientId, QVariantList() << QStringList() << version);
+        }
+    }
+}
+
+void
+DBusInputContextConnection::pluginSettingsChanged(int clientId, quint64 fromVersion, quint64 version,
+                                                  const QList<MImPluginSettingsInfo> &changed,
+                                                  const QStringList &removedPlugins)
+{
+    ComMeegoInputmethodInputcontext1Interface *proxy = mProxys.value(clientId);
+    if (proxy) {
+        proxy->pluginSettingsChanged(fromVersion, version, changed, removedPlugins);
+
+        if (MImSessionRecorder *recorder = sessionRecorder()) {
+            QStringList pluginNames;
+            Q_FOREACH (const MImPluginSettingsInfo &plugin, changed) {
+                pluginNames.append(plugin.plugin_name);
+            }
+            recorder->record(MImSessionEvent::Outbound, MImSessionEvent::PluginSettingsLoaded,
+                             clientId, QVariantList() << pluginNames << version << removedPlugins);
+        }
     }
 }
 
@@ -345,6 +538,11 @@ void DBusInputContextConnection::updateWidgetInformation(const QVariantMap &stat
     MInputContextConnection::updateWidgetInformation(connectionNumber(), stateInformation, focusChanged);
 }
 
+void DBusInputContextConnection::updateWidgetInformationPartial(const QVariantMap &changedInformation)
+{
+    MInputContextConnection::updateWidgetInformationPartial(connectionNumber(), changedInformation);
+}
+
 void DBusInputContextConnection::reset()
 {
     MInputContextConnection::reset(connectionNumber());
@@ -385,7 +583,68 @@ void DBusInputContextConnection::setExtendedAttribute(int id, const QString &tar
     MInputContextConnection::setExtendedAttribute(connectionNumber(), id, target, targetItem, attribute, value.variant());
 }
 
+void DBusInputContextConnection::setExtendedAttributes(int id, const QString &target, const QString &targetItem, const QVariantMap &attributes)
+{
+    const unsigned int connection = connectionNumber();
+
+    for (QVariantMap::const_iterator iterator = attributes.constBegin();
+         iterator != attributes.constEnd(); ++iterator) {
+        MInputContextConnection::setExtendedAttribute(connection, id, target, targetItem,
+                                                      iterator.key(), iterator.value());
+    }
+}
+
+void DBusInputContextConnection::enableCompactPreedit()
+{
+    const unsigned int connection = connectionNumber();
+
+    if (!mCompactPreedits.contains(connection)) {
+        mCompactPreedits.insert(connection, QString());
+    }
+}
+
+void DBusInputContextConnection::resumeSession(const QVariantMap &session)
+{
+    // Maps nested in the session arrive still marshalled
+    QVariantMap plainSession = session;
+    QVariantMap extensions = demarshallMap(session.value(QStringLiteral("extensions")));
+
+    for (QVariantMap::iterator iterator = extensions.begin(); iterator != extensions.end(); ++iterator) {
+        QVariantMap extension = demarshallMap(iterator.value());
+        extension.insert(QStringLiteral("attributes"),
+                         demarshallMap(extension.value(QStringLiteral("attributes"))));
+        iterator.value() = extension;
+    }
+    plainSession.insert(QStringLiteral("extensions"), extensions);
+
+    if (session.contains(QStringLiteral("widgetState"))) {
+        plainSession.insert(QStringLiteral("widgetState"),
+                            demarshallMap(session.value(QStringLiteral("widgetState"))));
+    }
+
+    MInputContextConnection::resumeSession(connectionNumber(), plainSession);
+}
+
 void DBusInputContextConnection::loadPluginSettings(const QString &descriptionLanguage)
 {
     MInputContextConnection::loadPluginSettings(connectionNumber(), descriptionLanguage);
 }
+
+void DBusInputContextConnection::loadPluginSettingsSnapshot(const QString &descriptionLanguage,
+                                                            qulonglong knownVersion)
+{
+    MInputContextConnection::loadPluginSettingsSnapshot(connectionNumber(), descriptionLanguage,
+                                                        knownVersion);
+}
+
+void DBusInputContextConnection::subscribePluginSettings(const QString &descriptionLanguage,
+                                                         qulonglong lastSeenVersion)
+{
+    MInputContextConnection::subscribePluginSettings(connectionNumber(), descriptionLanguage,
+                                                     lastSeenVersion);
+}
+
+void DBusInputContextConnection::unsubscribePluginSettings()
+{
+    MInputContextConnection::unsubscribePluginSettings(connectionNumber());
+}
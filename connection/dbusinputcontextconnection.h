@@ -66,6 +66,12 @@ public:
                                                 const QString &attribute,
                                                 const QVariant &value);
     virtual void pluginSettingsLoaded(int clientId, const QList<MImPluginSettingsInfo> &info);
+    virtual void pluginSettingsSnapshotLoaded(int clientId, quint64 version,
+                                              const QList<MImPluginSettingsInfo> &info);
+    virtual void pluginSettingsUnchanged(int clientId, quint64 version);
+    virtual void pluginSettingsChanged(int clientId, quint64 fromVersion, quint64 version,
+                                       const QList<MImPluginSettingsInfo> &changed,
+                                       const QStringList &removedPlugins);
     //! \reimp_end
 
     void activateContext();
@@ -74,6 +80,7 @@ public:
     void mouseClickedOnPreedit(int posX, int posY, int preeditRectX, int preeditRectY, int preeditRectWidth, int preeditRectHeight);
     void setPreedit(const QString &text, int cursorPos);
     void updateWidgetInformation(const QVariantMap &stateInformation, bool focusChanged);
+    void updateWidgetInformationPartial(const QVariantMap &changedInformation);
     void reset();
     void appOrientationAboutToChange(int angle);
     void appOrientationChanged(int angle);
@@ -82,7 +89,13 @@ public:
     void registerAttributeExtension(int id, const QString &fileName);
     void unregisterAttributeExtension(int id);
     void setExtendedAttribute(int id, const QString &target, const QString &targetItem, const QString &attribute, const QDBusVariant &value);
+    void setExtendedAttributes(int id, const QString &target, const QString &targetItem, const QVariantMap &attributes);
+    void enableCompactPreedit();
+    void resumeSession(const QVariantMap &session);
     void loadPluginSettings(const QString &descriptionLanguage);
+    void loadPluginSettingsSnapshot(const QString &descriptionLanguage, qulonglong knownVersion);
+    void subscribePluginSettings(const QString &descriptionLanguage, qulonglong lastSeenVersion);
+    void unsubscribePluginSettings();
 
 private Q_SLOTS:
     void newConnection(const QDBusConnection &connection);
@@ -96,6 +109,8 @@ private:
     QHash<QString, unsigned int> mConnectionNumbers;
     QHash<unsigned int, ComMeegoInputmethodInputcontext1Interface *> mProxys;
     QHash<unsigned int, QString> mConnections;
+    //! Clients taking updatePreeditCompact(), with the last preedit sent to them
+    QHash<unsigned int, QString> mCompactPreedits;
 
     QString lastLanguage;
 };
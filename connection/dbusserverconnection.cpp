@@ -21,6 +21,7 @@
 #include "dbuscustomarguments.h"
 
 #include <QDBusConnection>
+#include <QPointer>
 #include <QDebug>
 
 namespace
@@ -32,13 +33,28 @@ namespace
     const char * const DBusLocalInterface("org.freedesktop.DBus.Local");
     const char * const DisconnectedSignal("Disconnected");
     const int ConnectionRetryInterval(6*1000); // in ms
+
+    // Every instance needs its own peer connection, otherwise several
+    // connections in one process (e.g. maliit-bench) would share one client.
+    QString uniqueConnectionName()
+    {
+        static QAtomicInt instanceCount;
+
+        return QString::fromLatin1(IMServerConnection)
+                + QString::number(instanceCount.fetchAndAddRelaxed(1));
+    }
 }
 
 DBusServerConnection::DBusServerConnection(const QSharedPointer<Maliit::InputContext::DBus::Address> &address) :
     MImServerConnection(0)
   , mAddress(address)
+  , mConnectionName(uniqueConnectionName())
   , mProxy(0)
   , mActive(true)
+  , mShowPending(false)
+  , mReconnectedRightAway(false)
+  , mPartialUpdatesChecked(false)
+  , mExtendedAttributesUnsupported(false)
   , pendingResetCalls()
 {
     qDBusRegisterMetaType<MImPluginSettingsEntry>();
@@ -53,6 +69,13 @@ DBusServerConnection::DBusServerConnection(const QSharedPointer<Maliit::InputCon
             this, SLOT(openDBusConnection(QString)));
     connect(mAddress.data(), SIGNAL(addressFetchError(QString)),
             this, SLOT(connectToDBusFailed(QString)));
+    connect(mAddress.data(), SIGNAL(serverAppeared()),
+            this, SLOT(connectToDBus()));
+
+    // Polling is the fallback for addresses that cannot tell when the server appears
+    mRetryTimer.setSingleShot(true);
+    mRetryTimer.setInterval(ConnectionRetryInterval);
+    connect(&mRetryTimer, SIGNAL(timeout()), this, SLOT(connectToDBus()));
 
     QTimer::singleShot(0, this, SLOT(connectToDBus()));
 }
@@ -64,23 +87,41 @@ DBusServerConnection::~DBusServerConnection()
         disconnect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
                    this, SLOT(resetCallFinished(QDBusPendingCallWatcher*)));
     }
+
+    // Otherwise the named peer connection outlives this object and the
+    // server never sees the client go away.
+    QDBusConnection::disconnectFromPeer(mConnectionName);
 }
 
 void DBusServerConnection::connectToDBus()
 {
+    mRetryTimer.stop();
     mAddress->get();
 }
 
+void DBusServerConnection::scheduleReconnect()
+{
+    mAddress->waitForServer();
+    mRetryTimer.start();
+}
+
 void DBusServerConnection::openDBusConnection(const QString &addressString)
 {
+    // Both the retry timer and the address may have asked for a connection
+    if (mProxy)
+        return;
+
     if (addressString.isEmpty()) {
-        QTimer::singleShot(ConnectionRetryInterval, this, SLOT(connectToDBus()));
+        scheduleReconnect();
         return;
     }
 
-    QDBusConnection connection = QDBusConnection::connectToPeer(addressString, QString::fromLatin1(IMServerConnection));
+    QDBusConnection connection = QDBusConnection::connectToPeer(addressString, mConnectionName);
     if (!connection.isConnected()) {
-        QTimer::singleShot(ConnectionRetryInterval, this, SLOT(connectToDBus()));
+        // Otherwise the next attempt gets this failed connection back
+        QDBusConnection::disconnectFromPeer(mConnectionName);
+        mAddress->reportFailure(addressString);
+        scheduleReconnect();
         return;
     }
 
@@ -95,18 +136,34 @@ void DBusServerConnection::openDBusConnection(const QString &addressString)
 #if 0
     connect(mProxy, SIGNAL(invokeAction(QString,QKeySequence)), this, SIGNAL(invokeAction(QString,QKeySequence)));
 #endif
+    mConnectionAge.start();
+
+    // The server keeps track of the preedit it sent on this connection
+    mPreedit.clear();
+    mProxy->enableCompactPreedit();
+    mPartialUpdatesChecked = false;
+    mExtendedAttributesUnsupported = false;
+
     Q_EMIT connected();
+
+    // Handlers of connected() usually activate the context first; a show
+    // requested before the connection goes out after that, if they did not
+    // send it themselves.
+    if (mShowPending && mProxy) {
+        mShowPending = false;
+        mProxy->showInputMethod();
+    }
 }
 
 void DBusServerConnection::connectToDBusFailed(const QString &)
 {
-    QTimer::singleShot(ConnectionRetryInterval, this, SLOT(connectToDBus()));
+    scheduleReconnect();
 }
 
 void DBusServerConnection::onDisconnection()
 {
     // Disconnect signals first to prevent callbacks during deletion
-    QDBusConnection::disconnectFromPeer(QString::fromLatin1(IMServerConnection));
+    QDBusConnection::disconnectFromPeer(mConnectionName);
 
     // Emit disconnected signal before deletion to avoid use-after-free
     // if any slots access mProxy
@@ -118,8 +175,22 @@ void DBusServerConnection::onDisconnection()
         mProxy = nullptr;
     }
 
-    if (mActive)
-        QTimer::singleShot(ConnectionRetryInterval, this, SLOT(connectToDBus()));
+    if (!mActive)
+        return;
+
+    // A connection that lasted was not dropped by a server failing over and over
+    if (mConnectionAge.isValid() && mConnectionAge.hasExpired(ConnectionRetryInterval))
+        mReconnectedRightAway = false;
+
+    // Try again right away once: a socket-activated server keeps its address
+    // through restarts. A server dropping the connection again right after
+    // is waited for instead of reconnected to in a loop.
+    if (mReconnectedRightAway) {
+        scheduleReconnect();
+    } else {
+        mReconnectedRightAway = true;
+        QTimer::singleShot(0, this, SLOT(connectToDBus()));
+    }
 }
 
 void DBusServerConnection::resetCallFinished(QDBusPendingCallWatcher *watcher)
@@ -143,16 +214,21 @@ void DBusServerConnection::activateContext()
 
 void DBusServerConnection::showInputMethod()
 {
-    if (!mProxy)
+    if (!mProxy) {
+        mShowPending = true;
         return;
+    }
 
+    mShowPending = false;
     mProxy->showInputMethod();
 }
 
 void DBusServerConnection::hideInputMethod()
 {
-    if (!mProxy)
+    if (!mProxy) {
+        mShowPending = false;
         return;
+    }
 
     mProxy->hideInputMethod();
 }
@@ -182,6 +258,31 @@ void DBusServerConnection::updateWidgetInformation(const QMap<QString, QVariant>
     mProxy->updateWidgetInformation(stateInformation, focusChanged);
 }
 
+void DBusServerConnection::updateWidgetInformationPartial(const QMap<QString, QVariant> &changedInformation)
+{
+    if (!mProxy)
+        return;
+
+    QDBusPendingCall call = mProxy->updateWidgetInformationPartial(changedInformation);
+
+    // One reply tells whether the server knows partial updates at all
+    if (mPartialUpdatesChecked)
+        return;
+    mPartialUpdatesChecked = true;
+
+    QPointer<ComMeegoInputmethodUiserver1Interface> proxy(mProxy);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            this, [this, proxy](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        if (watcher->isError() && watcher->error().type() == QDBusError::UnknownMethod
+            && proxy && proxy == mProxy) {
+            Q_EMIT partialWidgetUpdatesUnsupported();
+        }
+    });
+}
+
 void DBusServerConnection::reset(bool requireSynchronization)
 {
     if (!mProxy)
@@ -256,6 +357,56 @@ void DBusServerConnection::setExtendedAttribute(int id, const QString &target, c
     mProxy->setExtendedAttribute(id, target, targetItem, attribute, QDBusVariant(value));
 }
 
+void DBusServerConnection::setExtendedAttributes(int id, const QString &target, const QString &targetItem,
+                                                 const QVariantMap &attributes)
+{
+    if (!mProxy)
+        return;
+
+    if (mExtendedAttributesUnsupported) {
+        MImServerConnection::setExtendedAttributes(id, target, targetItem, attributes);
+        return;
+    }
+
+    QPointer<ComMeegoInputmethodUiserver1Interface> proxy(mProxy);
+    QDBusPendingCallWatcher *watcher =
+        new QDBusPendingCallWatcher(mProxy->setExtendedAttributes(id, target, targetItem, attributes), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            this, [this, proxy, id, target, targetItem, attributes](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        // Servers without setExtendedAttributes get one call per attribute
+        if (watcher->isError() && watcher->error().type() == QDBusError::UnknownMethod
+            && proxy && proxy == mProxy) {
+            mExtendedAttributesUnsupported = true;
+            MImServerConnection::setExtendedAttributes(id, target, targetItem, attributes);
+        }
+    });
+}
+
+void DBusServerConnection::resumeSession(const QVariantMap &session)
+{
+    if (!mProxy)
+        return;
+
+    // The session decides whether the input method is shown
+    mShowPending = false;
+
+    QPointer<ComMeegoInputmethodUiserver1Interface> proxy(mProxy);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(mProxy->resumeSession(session), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            this, [this, proxy](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        // By now the captured session may be out of date, so the client
+        // rebuilds its current state for servers without resumeSession
+        if (watcher->isError() && watcher->error().type() == QDBusError::UnknownMethod
+            && proxy && proxy == mProxy) {
+            Q_EMIT resumeSessionUnsupported();
+        }
+    });
+}
+
 void DBusServerConnection::loadPluginSettings(const QString &descriptionLanguage)
 {
     if (!mProxy)
@@ -265,11 +416,55 @@ void DBusServerConnection::loadPluginSettings(const QString &descriptionLanguage
 }
 
 
+void DBusServerConnection::loadPluginSettingsSnapshot(const QString &descriptionLanguage, quint64 knownVersion)
+{
+    if (!mProxy)
+        return;
+
+    mProxy->loadPluginSettingsSnapshot(descriptionLanguage, knownVersion);
+}
+
+
+void DBusServerConnection::subscribePluginSettings(const QString &descriptionLanguage, quint64 lastSeenVersion)
+{
+    if (!mProxy)
+        return;
+
+    mProxy->subscribePluginSettings(descriptionLanguage, lastSeenVersion);
+}
+
+
+void DBusServerConnection::unsubscribePluginSettings()
+{
+    if (!mProxy)
+        return;
+
+    mProxy->unsubscribePluginSettings();
+}
+
+
 void DBusServerConnection::pluginSettingsLoaded(const QList<MImPluginSettingsInfo> &info)
 {
     pluginSettingsReceived(info);
 }
 
+void DBusServerConnection::pluginSettingsSnapshotLoaded(qulonglong version, const QList<MImPluginSettingsInfo> &info)
+{
+    pluginSettingsSnapshotReceived(version, info);
+}
+
+void DBusServerConnection::pluginSettingsUnchanged(qulonglong version)
+{
+    pluginSettingsUpToDate(version);
+}
+
+void DBusServerConnection::pluginSettingsChanged(qulonglong fromVersion, qulonglong version,
+                                                 const QList<MImPluginSettingsInfo> &changed,
+                                                 const QStringList &removedPlugins)
+{
+    pluginSettingsChangesReceived(fromVersion, version, changed, removedPlugins);
+}
+
 void DBusServerConnection::keyEvent(int type, int key, int modifiers, const QString &text, bool autoRepeat,
                                     int count, uchar requestType)
 {
@@ -282,6 +477,21 @@ void DBusServerConnection::notifyExtendedAttributeChanged(int id, const QString
     extendedAttributeChanged(id, target, targetItem, attribute, value.variant());
 }
 
+void DBusServerConnection::updatePreeditCompact(uint prefixLength, const QString &suffix,
+                                                const QByteArray &formats, int replacementStart,
+                                                int replacementLength, int cursorPos)
+{
+    QList<Maliit::PreeditTextFormat> preeditFormats;
+
+    if (!Maliit::DBus::unpackPreeditFormats(formats, &preeditFormats)
+        || !Maliit::DBus::applyCompactPreedit(&mPreedit, prefixLength, suffix)) {
+        qWarning() << "Ignoring malformed compact preedit update";
+        return;
+    }
+
+    updatePreedit(mPreedit, preeditFormats, replacementStart, replacementLength, cursorPos);
+}
+
 bool DBusServerConnection::preeditRectangle(int &x, int &y, int &width, int &height) const
 {
     bool valid;
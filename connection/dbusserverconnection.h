@@ -20,6 +20,8 @@
 
 #include <QDBusVariant>
 #include <QDBusPendingCallWatcher>
+#include <QElapsedTimer>
+#include <QTimer>
 
 class ComMeegoInputmethodUiserver1Interface;
 
@@ -40,6 +42,7 @@ public:
     virtual void setPreedit(const QString &text, int cursorPos);
     virtual void updateWidgetInformation(const QMap<QString, QVariant> &stateInformation,
                                          bool focusChanged);
+    virtual void updateWidgetInformationPartial(const QMap<QString, QVariant> &changedInformation);
     virtual void reset(bool requireSynchronization);
     virtual void appOrientationAboutToChange(int angle);
     virtual void appOrientationChanged(int angle);
@@ -52,7 +55,13 @@ public:
     virtual void unregisterAttributeExtension(int id);
     virtual void setExtendedAttribute(int id, const QString &target, const QString &targetItem,
                                       const QString &attribute, const QVariant &value);
+    virtual void setExtendedAttributes(int id, const QString &target, const QString &targetItem,
+                                       const QVariantMap &attributes);
+    virtual void resumeSession(const QVariantMap &session);
     virtual void loadPluginSettings(const QString &descriptionLanguage);
+    virtual void loadPluginSettingsSnapshot(const QString &descriptionLanguage, quint64 knownVersion);
+    virtual void subscribePluginSettings(const QString &descriptionLanguage, quint64 lastSeenVersion);
+    virtual void unsubscribePluginSettings();
     //! reimpl end
 
     //! forwarding methods for InputContextAdaptor
@@ -66,7 +75,14 @@ public:
                                         const QString &attribute,
                                         const QDBusVariant &value);
     void pluginSettingsLoaded(const QList<MImPluginSettingsInfo> &info);
+    void pluginSettingsSnapshotLoaded(qulonglong version, const QList<MImPluginSettingsInfo> &info);
+    void pluginSettingsUnchanged(qulonglong version);
+    void pluginSettingsChanged(qulonglong fromVersion, qulonglong version,
+                               const QList<MImPluginSettingsInfo> &changed,
+                               const QStringList &removedPlugins);
 
+    void updatePreeditCompact(uint prefixLength, const QString &suffix, const QByteArray &formats,
+                              int replacementStart, int replacementLength, int cursorPos);
     bool preeditRectangle(int &x, int &y, int &width, int &height) const;
     bool selection(QString &selection) const;
 
@@ -81,9 +97,26 @@ private Q_SLOTS:
     void resetCallFinished(QDBusPendingCallWatcher*);
 
 private:
+    //! Retries once the address reports the server, or after ConnectionRetryInterval
+    void scheduleReconnect();
+
     QSharedPointer<Maliit::InputContext::DBus::Address> mAddress;
+    const QString mConnectionName;
     ComMeegoInputmethodUiserver1Interface *mProxy;
     bool mActive;
+    //! showInputMethod() was called while not connected
+    bool mShowPending;
+    QTimer mRetryTimer;
+    //! The last disconnection was answered with a reconnection right away
+    bool mReconnectedRightAway;
+    //! Time since the current connection was made
+    QElapsedTimer mConnectionAge;
+    //! Last preedit received with updatePreeditCompact(), which only sends changes to it
+    QString mPreedit;
+    //! A reply to updateWidgetInformationPartial() is being watched on this connection
+    bool mPartialUpdatesChecked;
+    //! The server on this connection rejected setExtendedAttributes()
+    bool mExtendedAttributesUnsupported;
     QSet<QDBusPendingCallWatcher*> pendingResetCalls;
 };
 
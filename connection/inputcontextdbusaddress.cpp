@@ -12,11 +12,14 @@
  */
 
 #include "inputcontextdbusaddress.h"
+#include "serverdbusaddress.h"
 
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QDBusVariant>
 #include <QDBusError>
+#include <QFile>
+#include <QFileInfo>
 
 namespace {
     const char * const MaliitServerName = "org.maliit.server";
@@ -40,8 +43,28 @@ Address::~Address()
 {
 }
 
+void Address::reportFailure(const QString &)
+{
+}
+
+void Address::waitForServer()
+{
+}
+
+DynamicAddress::DynamicAddress()
+{
+    connect(&mWatcher, SIGNAL(directoryChanged(QString)),
+            this, SLOT(runtimeDirectoryChanged()));
+}
+
 void DynamicAddress::get()
 {
+    const QString cached = cachedAddress();
+    if (!cached.isEmpty()) {
+        Q_EMIT addressReceived(cached);
+        return;
+    }
+
     QList<QVariant> arguments;
     arguments.push_back(QVariant(QString::fromLatin1(MaliitServerInterface)));
     arguments.push_back(QVariant(QString::fromLatin1(MaliitServerAddressProperty)));
@@ -50,13 +73,33 @@ void DynamicAddress::get()
                                                           DBusPropertiesInterface, DBusPropertiesGetMethod);
     message.setArguments(arguments);
 
-    QDBusConnection::sessionBus().callWithCallback(message, this,
-                                                   SLOT(successCallback(QDBusVariant)),
-                                                   SLOT(errorCallback(QDBusError)));
+    // Without a session bus no callback would come, and nothing would retry
+    if (!QDBusConnection::sessionBus().callWithCallback(message, this,
+                                                        SLOT(successCallback(QDBusVariant)),
+                                                        SLOT(errorCallback(QDBusError)))) {
+        QMetaObject::invokeMethod(this, "addressFetchError", Qt::QueuedConnection,
+                                  Q_ARG(QString, QDBusConnection::sessionBus().lastError().message()));
+    }
+}
+
+void DynamicAddress::reportFailure(const QString &address)
+{
+    // Left behind by a server that is gone; ask the bus until it is rewritten
+    mRejectedAddress = address;
+}
+
+void DynamicAddress::waitForServer()
+{
+    const QString directory = QFileInfo(Maliit::Server::DBus::addressFilePath()).absolutePath();
+
+    if (!mWatcher.directories().contains(directory)) {
+        mWatcher.addPath(directory);
+    }
 }
 
 void DynamicAddress::successCallback(const QDBusVariant &address)
 {
+    mRejectedAddress.clear();
     Q_EMIT addressReceived(address.variant().toString());
 }
 
@@ -65,6 +108,28 @@ void DynamicAddress::errorCallback(const QDBusError &error)
     Q_EMIT addressFetchError(error.message());
 }
 
+void DynamicAddress::runtimeDirectoryChanged()
+{
+    if (cachedAddress().isEmpty()) {
+        return;
+    }
+
+    mWatcher.removePaths(mWatcher.directories());
+    Q_EMIT serverAppeared();
+}
+
+QString DynamicAddress::cachedAddress() const
+{
+    QFile file(Maliit::Server::DBus::addressFilePath());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    const QString address = QString::fromUtf8(file.readAll()).trimmed();
+    return address == mRejectedAddress ? QString() : address;
+}
+
 FixedAddress::FixedAddress(const QString &address)
     : mAddress(address)
 {
@@ -14,6 +14,7 @@
 #ifndef MALIIT_INPUTCONTEXT_DBUS_INPUTCONTEXTDBUSADDRESS_H
 #define MALIIT_INPUTCONTEXT_DBUS_INPUTCONTEXTDBUSADDRESS_H
 
+#include <QFileSystemWatcher>
 #include <QObject>
 
 QT_BEGIN_NAMESPACE
@@ -35,22 +36,49 @@ public:
 
     virtual void get() = 0;
 
+    //! Tells that connecting to \a address failed; the default implementation does nothing.
+    virtual void reportFailure(const QString &address);
+
+    //! Emits serverAppeared() once a server might be reachable again, without
+    //! polling; the default implementation never does.
+    virtual void waitForServer();
+
 Q_SIGNALS:
     void addressReceived(const QString &address);
     void addressFetchError(const QString &errorMessage);
+    void serverAppeared();
 };
 
 
+/*!
+ * \brief Address published by the running server.
+ *
+ * Uses the address file of the server when there is one, falling back to
+ * asking the session bus, and waits for the server by watching the runtime
+ * directory for the address file.
+ */
 class DynamicAddress : public Address
 {
     Q_OBJECT
 
 public:
+    DynamicAddress();
+
     void get();
+    void reportFailure(const QString &address);
+    void waitForServer();
 
 private Q_SLOTS:
     void successCallback(const QDBusVariant &address);
     void errorCallback(const QDBusError &error);
+    void runtimeDirectoryChanged();
+
+private:
+    //! Address in the address file, empty if there is none or it failed before
+    QString cachedAddress() const;
+
+    QString mRejectedAddress;
+    QFileSystemWatcher mWatcher;
 };
 
 class FixedAddress : public Address
@@ -0,0 +1,165 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimmetrics.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const char * const CounterNames[] = {
+        "clientConnections",
+        "widgetStateUpdates",
+        "keyEvents",
+        "preeditUpdates",
+        "commitStrings",
+        "pluginSwitches",
+        "settingsWrites",
+        "inputRegionUpdates",
+        "inputMethodAreaUpdates",
+        "slowPluginCalls",
+        "mainLoopStalls",
+        "suppressedVisibilityTransitions"
+    };
+
+    const char * const GaugeNames[] = {
+        "connectedClients",
+        "loadedPlugins",
+        "activePlugins"
+    };
+
+    const char * const HistogramNames[] = {
+        "widgetStateCallbacks",
+        "keyEventCallbacks",
+        "preeditCallbacks",
+        "showCallbacks",
+        "hideCallbacks",
+        "resetCallbacks",
+        "orientationCallbacks"
+    };
+
+    Q_STATIC_ASSERT(sizeof(CounterNames) / sizeof(CounterNames[0]) == MImMetrics::CounterCount);
+    Q_STATIC_ASSERT(sizeof(GaugeNames) / sizeof(GaugeNames[0]) == MImMetrics::GaugeCount);
+    Q_STATIC_ASSERT(sizeof(HistogramNames) / sizeof(HistogramNames[0]) == MImMetrics::HistogramCount);
+}
+
+MImMetrics::MImMetrics()
+{
+    memset(counters, 0, sizeof(counters));
+    memset(gauges, 0, sizeof(gauges));
+    memset(histograms, 0, sizeof(histograms));
+
+    uptime.start();
+}
+
+const char *MImMetrics::name(Counter counter)
+{
+    return CounterNames[counter];
+}
+
+const char *MImMetrics::name(Gauge gauge)
+{
+    return GaugeNames[gauge];
+}
+
+const char *MImMetrics::name(Histogram histogram)
+{
+    return HistogramNames[histogram];
+}
+
+void MImMetrics::addLatency(Histogram histogram, qint64 nanoseconds)
+{
+    HistogramData &data = histograms[histogram];
+    const qint64 microseconds = nanoseconds / 1000;
+
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && (qint64(1) << bucket) <= microseconds) {
+        ++bucket;
+    }
+
+    ++data.count;
+    ++data.buckets[bucket];
+    data.sum += nanoseconds;
+    data.max = qMax(data.max, nanoseconds);
+}
+
+qint64 MImMetrics::counter(Counter counter) const
+{
+    return counters[counter];
+}
+
+qint64 MImMetrics::gauge(Gauge gauge) const
+{
+    return gauges[gauge];
+}
+
+qint64 MImMetrics::count(Histogram histogram) const
+{
+    return histograms[histogram].count;
+}
+
+qint64 MImMetrics::percentile(const HistogramData &data, double fraction) const
+{
+    if (data.count == 0) {
+        return 0;
+    }
+
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(fraction * data.count)));
+    qint64 seen = 0;
+
+    for (int bucket = 0; bucket < BucketCount - 1; ++bucket) {
+        seen += data.buckets[bucket];
+        if (seen >= rank) {
+            return qint64(1) << bucket;
+        }
+    }
+
+    return data.max / 1000;
+}
+
+QVariantMap MImMetrics::snapshot() const
+{
+    QVariantMap counterValues;
+    for (int n = 0; n < CounterCount; ++n) {
+        counterValues.insert(QString::fromLatin1(CounterNames[n]), counters[n]);
+    }
+
+    QVariantMap gaugeValues;
+    for (int n = 0; n < GaugeCount; ++n) {
+        gaugeValues.insert(QString::fromLatin1(GaugeNames[n]), gauges[n]);
+    }
+
+    QVariantMap histogramValues;
+    for (int n = 0; n < HistogramCount; ++n) {
+        const HistogramData &data = histograms[n];
+        QVariantList buckets;
+        QVariantMap values;
+
+        for (int bucket = 0; bucket < BucketCount; ++bucket) {
+            buckets.append(data.buckets[bucket]);
+        }
+
+        values.insert(QStringLiteral("count"), data.count);
+        values.insert(QStringLiteral("sumMicroseconds"), data.sum / 1000);
+        values.insert(QStringLiteral("maxMicroseconds"), data.max / 1000);
+        values.insert(QStringLiteral("p50Microseconds"), percentile(data, 0.50));
+        values.insert(QStringLiteral("p99Microseconds"), percentile(data, 0.99));
+        values.insert(QStringLiteral("buckets"), buckets);
+        histogramValues.insert(QString::fromLatin1(HistogramNames[n]), values);
+    }
+
+    QVariantMap result;
+    result.insert(QStringLiteral("uptimeSeconds"), uptime.elapsed() / 1000);
+    result.insert(QStringLiteral("counters"), counterValues);
+    result.insert(QStringLiteral("gauges"), gaugeValues);
+    result.insert(QStringLiteral("histograms"), histogramValues);
+
+    return result;
+}
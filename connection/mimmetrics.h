@@ -0,0 +1,154 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMMETRICS_H
+#define MIMMETRICS_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariantMap>
+
+//! \internal
+
+/*! \brief Runtime counters, gauges and latency histograms of the server.
+ *
+ * All metrics are known at compile time and stored in plain arrays, so that
+ * updating one is a single add. The registry is only used from the main
+ * thread and is not thread safe.
+ *
+ * Instrumented code holds a possibly null pointer to the registry; metrics
+ * are only collected when the server was started with -enable-metrics.
+ */
+class MImMetrics
+{
+public:
+    enum Counter {
+        ClientConnections,
+        WidgetStateUpdates,
+        KeyEvents,
+        PreeditUpdates,
+        CommitStrings,
+        PluginSwitches,
+        SettingsWrites,
+        InputRegionUpdates,
+        InputMethodAreaUpdates,
+        SlowPluginCalls,
+        MainLoopStalls,
+        SuppressedVisibilityTransitions,
+        CounterCount
+    };
+
+    enum Gauge {
+        ConnectedClients,
+        LoadedPlugins,
+        ActivePlugins,
+        GaugeCount
+    };
+
+    //! Time spent in plugin callbacks, by kind of callback
+    enum Histogram {
+        WidgetStateCallbacks,
+        KeyEventCallbacks,
+        PreeditCallbacks,
+        ShowCallbacks,
+        HideCallbacks,
+        ResetCallbacks,
+        OrientationCallbacks,
+        HistogramCount
+    };
+
+    //! Number of histogram buckets; bucket n holds latencies below 2^n microseconds,
+    //! the last one everything above.
+    static const int BucketCount = 21;
+
+    MImMetrics();
+
+    static const char *name(Counter counter);
+    static const char *name(Gauge gauge);
+    static const char *name(Histogram histogram);
+
+    void increment(Counter counter, qint64 amount = 1)
+    {
+        counters[counter] += amount;
+    }
+
+    void setGauge(Gauge gauge, qint64 value)
+    {
+        gauges[gauge] = value;
+    }
+
+    //! Adds a measurement of \a nanoseconds to \a histogram.
+    void addLatency(Histogram histogram, qint64 nanoseconds);
+
+    qint64 counter(Counter counter) const;
+    qint64 gauge(Gauge gauge) const;
+    //! Returns how many measurements were added to \a histogram.
+    qint64 count(Histogram histogram) const;
+
+    /*!
+     * \brief Returns all metrics.
+     *
+     * The map holds "uptimeSeconds" and one map each for "counters", "gauges"
+     * and "histograms"; every histogram is a map with "count",
+     * "sumMicroseconds", "maxMicroseconds", "p50Microseconds",
+     * "p99Microseconds" and the raw "buckets".
+     */
+    QVariantMap snapshot() const;
+
+private:
+    struct HistogramData {
+        qint64 count;
+        qint64 sum;
+        qint64 max;
+        qint64 buckets[BucketCount];
+    };
+
+    //! Upper bound, in microseconds, of the bucket holding the given fraction of measurements
+    qint64 percentile(const HistogramData &data, double fraction) const;
+
+    qint64 counters[CounterCount];
+    qint64 gauges[GaugeCount];
+    HistogramData histograms[HistogramCount];
+    QElapsedTimer uptime;
+};
+
+/*! \brief Measures the lifetime of the object into a histogram.
+ *
+ * Does nothing, not even reading the clock, if \a metrics is null.
+ */
+class MImMetricsTimer
+{
+public:
+    MImMetricsTimer(MImMetrics *metrics, MImMetrics::Histogram histogram)
+        : metrics(metrics)
+        , histogram(histogram)
+    {
+        if (metrics) {
+            clock.start();
+        }
+    }
+
+    ~MImMetricsTimer()
+    {
+        if (metrics) {
+            metrics->addLatency(histogram, clock.nsecsElapsed());
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(MImMetricsTimer)
+
+    MImMetrics * const metrics;
+    const MImMetrics::Histogram histogram;
+    QElapsedTimer clock;
+};
+
+//! \internal_end
+
+#endif // MIMMETRICS_H
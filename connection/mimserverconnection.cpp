@@ -12,6 +12,7 @@
  */
 
 #include "mimserverconnection.h"
+#include "mimsession.h"
 
 /* Dummy class that does nothing. */
 MImServerConnection::MImServerConnection(QObject *parent)
@@ -48,6 +49,11 @@ void MImServerConnection::updateWidgetInformation(const QMap<QString, QVariant>
     Q_UNUSED(focusChanged);
 }
 
+void MImServerConnection::updateWidgetInformationPartial(const QMap<QString, QVariant> &changedInformation)
+{
+    Q_UNUSED(changedInformation);
+}
+
 void MImServerConnection::reset(bool requireSynchronization)
 {
     Q_UNUSED(requireSynchronization);
@@ -112,7 +118,76 @@ void MImServerConnection::setExtendedAttribute(int id, const QString &target, co
     Q_UNUSED(value);
 }
 
+void MImServerConnection::setExtendedAttributes(int id, const QString &target, const QString &targetItem,
+                                                const QVariantMap &attributes)
+{
+    for (QVariantMap::const_iterator iterator = attributes.constBegin();
+         iterator != attributes.constEnd(); ++iterator) {
+        setExtendedAttribute(id, target, targetItem, iterator.key(), iterator.value());
+    }
+}
+
+void MImServerConnection::resumeSession(const QVariantMap &session)
+{
+    const QVariantMap extensions = session.value(QStringLiteral("extensions")).toMap();
+
+    for (QVariantMap::const_iterator iterator = extensions.constBegin();
+         iterator != extensions.constEnd(); ++iterator) {
+        const QVariantMap extension = iterator.value().toMap();
+        registerAttributeExtension(iterator.key().toInt(),
+                                   extension.value(QStringLiteral("fileName")).toString());
+    }
+
+    if (session.value(QStringLiteral("activate")).toBool()) {
+        activateContext();
+    }
+
+    if (session.contains(QStringLiteral("orientation"))) {
+        appOrientationChanged(session.value(QStringLiteral("orientation")).toInt());
+    }
+
+    for (QVariantMap::const_iterator iterator = extensions.constBegin();
+         iterator != extensions.constEnd(); ++iterator) {
+        const QVariantMap attributes = iterator.value().toMap().value(QStringLiteral("attributes")).toMap();
+
+        for (QVariantMap::const_iterator attribute = attributes.constBegin();
+             attribute != attributes.constEnd(); ++attribute) {
+            QString target, targetItem, name;
+            if (!Maliit::Session::splitAttributeKey(attribute.key(), &target, &targetItem, &name)) {
+                continue;
+            }
+
+            setExtendedAttribute(iterator.key().toInt(), target, targetItem, name, attribute.value());
+        }
+    }
+
+    if (session.contains(QStringLiteral("widgetState"))) {
+        updateWidgetInformation(session.value(QStringLiteral("widgetState")).toMap(), true);
+    }
+
+    if (session.value(QStringLiteral("showInputMethod")).toBool()) {
+        showInputMethod();
+    }
+}
+
 void MImServerConnection::loadPluginSettings(const QString &descriptionLanguage)
 {
     Q_UNUSED(descriptionLanguage);
 }
+
+void MImServerConnection::loadPluginSettingsSnapshot(const QString &descriptionLanguage, quint64 knownVersion)
+{
+    Q_UNUSED(knownVersion);
+
+    loadPluginSettings(descriptionLanguage);
+}
+
+void MImServerConnection::subscribePluginSettings(const QString &descriptionLanguage, quint64 lastSeenVersion)
+{
+    Q_UNUSED(descriptionLanguage);
+    Q_UNUSED(lastSeenVersion);
+}
+
+void MImServerConnection::unsubscribePluginSettings()
+{
+}
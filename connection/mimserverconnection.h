@@ -38,6 +38,9 @@ public:
     virtual void mouseClickedOnPreedit(const QPoint &pos, const QRect &preeditRect);
     virtual void setPreedit(const QString &text, int cursorPos);
     virtual void updateWidgetInformation(const QMap<QString, QVariant> &stateInformation, bool focusChanged);
+    //! Updates some entries of the state last sent with updateWidgetInformation(),
+    //! keeping all others.
+    virtual void updateWidgetInformationPartial(const QMap<QString, QVariant> &changedInformation);
     virtual void reset(bool requireSynchronization);
     virtual void appOrientationAboutToChange(int angle);
     virtual void appOrientationChanged(int angle);
@@ -50,7 +53,34 @@ public:
     virtual void unregisterAttributeExtension(int id);
     virtual void setExtendedAttribute(int id, const QString &target, const QString &targetItem,
                                       const QString &attribute, const QVariant &value);
+    //! Sets several attributes of one target item at once; the default
+    //! implementation calls setExtendedAttribute() for each of them.
+    virtual void setExtendedAttributes(int id, const QString &target, const QString &targetItem,
+                                       const QVariantMap &attributes);
+    /*!
+     * \brief Hands the whole state of a client to a server it just connected to.
+     *
+     * \a session may hold:
+     * - "extensions": map from attribute extension ids, in decimal, to maps
+     *   with the "fileName" of the extension and its "attributes", a map
+     *   keyed by "/target/item/attribute"
+     * - "activate": whether to activate the context
+     * - "orientation": angle of the application
+     * - "widgetState": state of the focused widget, as for a focus change
+     * - "showInputMethod": whether to show the input method
+     *
+     * The default implementation makes the equivalent separate calls.
+     */
+    virtual void resumeSession(const QVariantMap &session);
     virtual void loadPluginSettings(const QString &descriptionLanguage);
+    //! Requests the settings, unless \a knownVersion, as received with
+    //! pluginSettingsSnapshotReceived(), is still current; 0 always loads them.
+    //! The default implementation calls loadPluginSettings().
+    virtual void loadPluginSettingsSnapshot(const QString &descriptionLanguage, quint64 knownVersion);
+    //! Brings the settings up to date from \a lastSeenVersion, see loadPluginSettingsSnapshot(),
+    //! and keeps sending pluginSettingsChangesReceived() until unsubscribePluginSettings().
+    virtual void subscribePluginSettings(const QString &descriptionLanguage, quint64 lastSeenVersion);
+    virtual void unsubscribePluginSettings();
 
 public:
     /*! \brief Notifies about connection to server being established.
@@ -61,6 +91,19 @@ public:
     Q_SIGNAL void connected();
     Q_SIGNAL void disconnected();
 
+    /*! \brief Emitted when the server rejected resumeSession() as unknown.
+     *
+     * The client is expected to send its current state with separate calls.
+     */
+    Q_SIGNAL void resumeSessionUnsupported();
+
+    /*! \brief Emitted when the server rejected updateWidgetInformationPartial() as unknown.
+     *
+     * The client is expected to send complete states from then on, starting
+     * with its current one.
+     */
+    Q_SIGNAL void partialWidgetUpdatesUnsupported();
+
     /* Incoming communication */
     Q_SIGNAL void activationLostEvent();
 
@@ -192,6 +235,31 @@ public:
      */
     Q_SIGNAL void pluginSettingsReceived(const QList<MImPluginSettingsInfo> &info);
 
+    /*!
+     * \brief Sent in response to \a loadPluginSettingsSnapshot() when the settings changed.
+     * \param version identifies this state of the settings
+     * \param info list of server and plugin settings
+     */
+    Q_SIGNAL void pluginSettingsSnapshotReceived(quint64 version, const QList<MImPluginSettingsInfo> &info);
+
+    /*!
+     * \brief Sent in response to \a loadPluginSettingsSnapshot() when the settings
+     * \a version known to the application is still current.
+     */
+    Q_SIGNAL void pluginSettingsUpToDate(quint64 version);
+
+    /*!
+     * \brief Sent to subscribers when the settings changed from \a fromVersion to \a version.
+     * \param changed whole settings of newly registered plugins, changed entries of others
+     * \param removedPlugins plugins whose settings are gone
+     *
+     * If \a fromVersion is not the last version the application received, it
+     * missed changes and should subscribe again with its last version.
+     */
+    Q_SIGNAL void pluginSettingsChangesReceived(quint64 fromVersion, quint64 version,
+                                                const QList<MImPluginSettingsInfo> &changed,
+                                                const QStringList &removedPlugins);
+
 private:
     Q_DISABLE_COPY(MImServerConnection)
 
@@ -0,0 +1,29 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimsession.h"
+
+namespace Maliit {
+namespace Session {
+
+bool splitAttributeKey(const QString &key, QString *target, QString *targetItem, QString *attribute)
+{
+    if (!key.startsWith(QLatin1Char('/')) || key.count(QLatin1Char('/')) < 3) {
+        return false;
+    }
+
+    *target = QLatin1Char('/') + key.section(QLatin1Char('/'), 1, 1);
+    *targetItem = key.section(QLatin1Char('/'), 2, 2);
+    *attribute = key.section(QLatin1Char('/'), 3);
+
+    return true;
+}
+
+} // namespace Session
+} // namespace Maliit
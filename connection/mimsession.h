@@ -0,0 +1,33 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMSESSION_H
+#define MIMSESSION_H
+
+#include <QString>
+
+//! \internal
+
+namespace Maliit {
+namespace Session {
+
+/*!
+ * \brief Splits the key of an attribute in a resumed session.
+ *
+ * Keys have the form "/target/item/attribute"; \a target keeps its leading
+ * slash. Returns false, leaving the outputs alone, if \a key is malformed.
+ */
+bool splitAttributeKey(const QString &key, QString *target, QString *targetItem, QString *attribute);
+
+} // namespace Session
+} // namespace Maliit
+
+//! \internal_end
+
+#endif // MIMSESSION_H
@@ -0,0 +1,251 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimsessionlog.h"
+
+#include <QDBusArgument>
+#include <QDBusVariant>
+#include <QRect>
+
+namespace
+{
+    const quint32 LogMagic = 0x4d494d53; // "MIMS"
+    const quint32 LogVersion = 1;
+    const QDataStream::Version StreamVersion = QDataStream::Qt_5_0;
+
+    const char * const CallNames[] = {
+        "activateContext",
+        "showInputMethod",
+        "hideInputMethod",
+        "mouseClickedOnPreedit",
+        "setPreedit",
+        "updateWidgetInformation",
+        "reset",
+        "appOrientationAboutToChange",
+        "appOrientationChanged",
+        "setCopyPasteState",
+        "processKeyEvent",
+        "registerAttributeExtension",
+        "unregisterAttributeExtension",
+        "setExtendedAttribute",
+        "loadPluginSettings",
+        "clientDisconnected",
+        "updatePreedit",
+        "commitString",
+        "keyEvent",
+        "imInitiatedHide",
+        "setGlobalCorrectionEnabled",
+        "preeditRectangle",
+        "setRedirectKeys",
+        "setDetectableAutoRepeat",
+        "invokeAction",
+        "setSelection",
+        "selection",
+        "setLanguage",
+        "activationLostEvent",
+        "updateInputMethodArea",
+        "notifyExtendedAttributeChanged",
+        "pluginSettingsLoaded",
+        "subscribePluginSettings",
+        "unsubscribePluginSettings",
+        "loadPluginSettingsSnapshot"
+    };
+
+    // Values received over D-Bus may still be marshalled; turn them into
+    // types QDataStream can store.
+    QVariant recordableValue(const QVariant &value)
+    {
+        if (value.userType() == qMetaTypeId<QDBusVariant>()) {
+            return recordableValue(value.value<QDBusVariant>().variant());
+        }
+
+        if (value.userType() == qMetaTypeId<QDBusArgument>()) {
+            const QDBusArgument argument = value.value<QDBusArgument>();
+
+            if (argument.currentSignature() == QLatin1String("(iiii)")) {
+                int x, y, width, height;
+                argument.beginStructure();
+                argument >> x >> y >> width >> height;
+                argument.endStructure();
+                return QRect(x, y, width, height);
+            }
+
+            return argument.currentSignature();
+        }
+
+        if (value.type() == QVariant::Map) {
+            QVariantMap map = value.toMap();
+            for (QVariantMap::iterator iter = map.begin(); iter != map.end(); ++iter) {
+                iter.value() = recordableValue(iter.value());
+            }
+            return map;
+        }
+
+        if (value.type() == QVariant::List) {
+            QVariantList list = value.toList();
+            for (int n = 0; n < list.count(); ++n) {
+                list[n] = recordableValue(list.at(n));
+            }
+            return list;
+        }
+
+        return value;
+    }
+}
+
+MImSessionEvent::MImSessionEvent()
+    : direction(Inbound)
+    , call(ActivateContext)
+    , clientId(0)
+    , timestamp(0)
+{
+}
+
+const char *MImSessionEvent::callName(Call call)
+{
+    const int count = sizeof(CallNames) / sizeof(CallNames[0]);
+
+    return (call >= 0 && call < count) ? CallNames[call] : "unknown";
+}
+
+
+MImSessionRecorder::MImSessionRecorder(const QString &fileName)
+    : file(fileName)
+{
+    counts[MImSessionEvent::Inbound] = 0;
+    counts[MImSessionEvent::Outbound] = 0;
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    stream.setDevice(&file);
+    stream.setVersion(StreamVersion);
+    stream << LogMagic << LogVersion;
+    file.flush();
+
+    clock.start();
+}
+
+MImSessionRecorder::~MImSessionRecorder()
+{
+    flush();
+}
+
+bool MImSessionRecorder::isOpen() const
+{
+    return file.isOpen();
+}
+
+QString MImSessionRecorder::errorString() const
+{
+    return file.errorString();
+}
+
+void MImSessionRecorder::record(MImSessionEvent::Direction direction, MImSessionEvent::Call call,
+                                unsigned int clientId, const QVariantList &arguments)
+{
+    if (!file.isOpen()) {
+        return;
+    }
+
+    QVariantList recordable;
+    recordable.reserve(arguments.count());
+    Q_FOREACH (const QVariant &argument, arguments) {
+        recordable.append(recordableValue(argument));
+    }
+
+    stream << quint8(direction) << quint8(call) << quint32(clientId)
+           << qint64(clock.nsecsElapsed() / 1000) << recordable;
+    // Keep the log complete up to the last call in case the server dies
+    file.flush();
+
+    ++counts[direction];
+}
+
+int MImSessionRecorder::count(MImSessionEvent::Direction direction) const
+{
+    return counts[direction];
+}
+
+void MImSessionRecorder::flush()
+{
+    if (file.isOpen()) {
+        file.flush();
+    }
+}
+
+
+MImSessionReader::MImSessionReader(const QString &fileName)
+    : file(fileName)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return;
+    }
+
+    stream.setDevice(&file);
+    stream.setVersion(StreamVersion);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    if (magic != LogMagic) {
+        error = QString::fromLatin1("not a Maliit session log");
+    } else if (version != LogVersion) {
+        error = QString::fromLatin1("unsupported session log version %1").arg(version);
+    }
+
+    if (!error.isEmpty()) {
+        file.close();
+    }
+}
+
+MImSessionReader::~MImSessionReader()
+{
+}
+
+bool MImSessionReader::isOpen() const
+{
+    return file.isOpen();
+}
+
+QString MImSessionReader::errorString() const
+{
+    return error;
+}
+
+bool MImSessionReader::readNext(MImSessionEvent *event)
+{
+    if (!file.isOpen() || stream.atEnd()) {
+        return false;
+    }
+
+    quint8 direction = 0;
+    quint8 call = 0;
+    quint32 clientId = 0;
+    qint64 timestamp = 0;
+    QVariantList arguments;
+
+    stream >> direction >> call >> clientId >> timestamp >> arguments;
+
+    // A log cut short, e.g. because the server was killed, ends here
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    event->direction = static_cast<MImSessionEvent::Direction>(direction);
+    event->call = static_cast<MImSessionEvent::Call>(call);
+    event->clientId = clientId;
+    event->timestamp = timestamp;
+    event->arguments = arguments;
+
+    return true;
+}
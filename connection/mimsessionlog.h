@@ -0,0 +1,148 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMSESSIONLOG_H
+#define MIMSESSIONLOG_H
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVariant>
+
+//! \internal
+
+/*! \brief One call between an input context and the server, as stored in a
+ * session log.
+ */
+struct MImSessionEvent
+{
+    enum Direction {
+        Inbound,  //!< Sent by an input context to the server
+        Outbound  //!< Sent by the server to an input context
+    };
+
+    enum Call {
+        // inbound
+        ActivateContext,
+        ShowInputMethod,
+        HideInputMethod,
+        MouseClickedOnPreedit,
+        SetPreedit,
+        UpdateWidgetInformation,
+        Reset,
+        AppOrientationAboutToChange,
+        AppOrientationChanged,
+        SetCopyPasteState,
+        ProcessKeyEvent,
+        RegisterAttributeExtension,
+        UnregisterAttributeExtension,
+        SetExtendedAttribute,
+        LoadPluginSettings,
+        ClientDisconnected,
+
+        // outbound
+        UpdatePreedit,
+        CommitString,
+        KeyEvent,
+        ImInitiatedHide,
+        SetGlobalCorrectionEnabled,
+        PreeditRectangle,
+        SetRedirectKeys,
+        SetDetectableAutoRepeat,
+        InvokeAction,
+        SetSelection,
+        Selection,
+        SetLanguage,
+        ActivationLost,
+        UpdateInputMethodArea,
+        NotifyExtendedAttributeChanged,
+        PluginSettingsLoaded,
+
+        // inbound, added later; appended so that the ids above stay valid
+        SubscribePluginSettings,
+        UnsubscribePluginSettings,
+        LoadPluginSettingsSnapshot
+    };
+
+    MImSessionEvent();
+
+    //! Returns the protocol name of \a call, for reports.
+    static const char *callName(Call call);
+
+    Direction direction;
+    Call call;
+    //! Connection the call was received from or sent to; 0 for none
+    quint32 clientId;
+    //! Time since the start of the recording, in microseconds
+    qint64 timestamp;
+    QVariantList arguments;
+};
+
+/*! \brief Writes inbound and outbound input context calls to a binary log.
+ *
+ * The log starts with a header followed by one QDataStream record per call.
+ * Arguments are stored as plain variants; D-Bus specific values are
+ * converted first, so that logs can be read without a bus. Every record is
+ * flushed right away, so that the log of a server that crashed or was
+ * killed is complete.
+ */
+class MImSessionRecorder
+{
+public:
+    explicit MImSessionRecorder(const QString &fileName);
+    ~MImSessionRecorder();
+
+    //! Returns true if the log file could be created.
+    bool isOpen() const;
+    QString errorString() const;
+
+    void record(MImSessionEvent::Direction direction, MImSessionEvent::Call call,
+                unsigned int clientId, const QVariantList &arguments = QVariantList());
+
+    //! Returns how many calls going in \a direction were recorded so far.
+    int count(MImSessionEvent::Direction direction) const;
+
+    //! Writes buffered records to the file.
+    void flush();
+
+private:
+    Q_DISABLE_COPY(MImSessionRecorder)
+
+    QFile file;
+    QDataStream stream;
+    QElapsedTimer clock;
+    int counts[2];
+};
+
+//! \brief Reads a log written by MImSessionRecorder.
+class MImSessionReader
+{
+public:
+    explicit MImSessionReader(const QString &fileName);
+    ~MImSessionReader();
+
+    //! Returns true if the file could be opened and has a valid header.
+    bool isOpen() const;
+    QString errorString() const;
+
+    //! Reads the next call into \a event; returns false at the end of the log.
+    bool readNext(MImSessionEvent *event);
+
+private:
+    Q_DISABLE_COPY(MImSessionReader)
+
+    QFile file;
+    QDataStream stream;
+    QString error;
+};
+
+//! \internal_end
+
+#endif // MIMSESSIONLOG_H
@@ -0,0 +1,98 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimvisibilitystate.h"
+
+MImVisibilityState::MImVisibilityState(int showDelay, int hideDelay, QObject *parent)
+    : QObject(parent)
+    , showDelay(showDelay)
+    , hideDelay(hideDelay)
+    , visible(false)
+    , intent(NoIntent)
+    , requests(0)
+    , suppressed(0)
+{
+    resolveTimer.setSingleShot(true);
+    connect(&resolveTimer, SIGNAL(timeout()), this, SLOT(resolve()));
+}
+
+void MImVisibilityState::requestShow()
+{
+    request(ShowIntent, showDelay);
+}
+
+void MImVisibilityState::requestHide()
+{
+    request(HideIntent, hideDelay);
+}
+
+void MImVisibilityState::request(Intent newIntent, int delay)
+{
+    intent = newIntent;
+    ++requests;
+
+    if (delay <= 0) {
+        resolve();
+    } else if (!resolveTimer.isActive() || resolveTimer.remainingTime() > delay) {
+        // Later requests never postpone the resolution, so that a steady
+        // stream of requests is still resolved once per delay.
+        resolveTimer.start(delay);
+    }
+}
+
+void MImVisibilityState::setVisible(bool newVisible)
+{
+    visible = newVisible;
+}
+
+bool MImVisibilityState::isVisible() const
+{
+    return visible;
+}
+
+bool MImVisibilityState::isPending() const
+{
+    return intent != NoIntent;
+}
+
+qint64 MImVisibilityState::suppressedTransitions() const
+{
+    return suppressed;
+}
+
+void MImVisibilityState::resolve()
+{
+    resolveTimer.stop();
+
+    if (intent == NoIntent) {
+        return;
+    }
+
+    const bool newVisible = (intent == ShowIntent);
+    const bool transition = (newVisible != visible);
+    const int coalesced = requests - (transition ? 1 : 0);
+
+    // Reset before emitting, handlers may request again
+    visible = newVisible;
+    intent = NoIntent;
+    requests = 0;
+
+    if (coalesced > 0) {
+        suppressed += coalesced;
+        Q_EMIT transitionsSuppressed(coalesced);
+    }
+
+    if (transition) {
+        if (newVisible) {
+            Q_EMIT shown();
+        } else {
+            Q_EMIT hidden();
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMVISIBILITYSTATE_H
+#define MIMVISIBILITYSTATE_H
+
+#include <QObject>
+#include <QTimer>
+
+//! \internal
+
+/*! \brief Coalesces requests to show and hide the input method.
+ *
+ * Requests only record the latest intent. The intent is resolved once the
+ * delay of the request has passed, and shown() or hidden() is emitted only if
+ * it differs from the current state. Moving the focus between text fields
+ * usually requests a hide followed by a show, which then resolves to nothing.
+ *
+ * Requests that did not cause a transition are counted as suppressed.
+ */
+class MImVisibilityState : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Requests to show are resolved after \a showDelay, requests to hide
+    //! after \a hideDelay milliseconds; a delay of 0 resolves right away.
+    MImVisibilityState(int showDelay, int hideDelay, QObject *parent = 0);
+
+    void requestShow();
+    void requestHide();
+
+    //! Updates the state after a transition made without requesting it; a
+    //! pending intent is kept and resolved against the new state.
+    void setVisible(bool visible);
+    bool isVisible() const;
+
+    //! Returns true if an intent is waiting to be resolved.
+    bool isPending() const;
+
+    //! Returns how many requests did not cause a transition so far.
+    qint64 suppressedTransitions() const;
+
+public Q_SLOTS:
+    //! Resolves the pending intent right away.
+    void resolve();
+
+Q_SIGNALS:
+    void shown();
+    void hidden();
+    //! Emitted on resolving, before shown() or hidden(), when \a count requests
+    //! were coalesced away.
+    void transitionsSuppressed(int count);
+
+private:
+    Q_DISABLE_COPY(MImVisibilityState)
+
+    enum Intent {
+        NoIntent,
+        ShowIntent,
+        HideIntent
+    };
+
+    void request(Intent newIntent, int delay);
+
+    const int showDelay;
+    const int hideDelay;
+    QTimer resolveTimer;
+    bool visible;
+    Intent intent;
+    int requests;
+    qint64 suppressed;
+};
+
+//! \internal_end
+
+#endif // MIMVISIBILITYSTATE_H
@@ -12,7 +12,11 @@
  */
 
 #include "minputcontextconnection.h"
+#include "mimmetrics.h"
+#include "mimsession.h"
+#include "mimsessionlog.h"
 
+#include <QDebug>
 #include <QKeyEvent>
 
 namespace {
@@ -31,6 +35,18 @@ namespace {
     const char * const CursorRectAttribute = "cursorRectangle";
     const char * const HiddenTextAttribute = "hiddenText";
     const char * const PreeditClickPosAttribute = "preeditClickPos";
+
+    // Removes the surrounding text from \a state and returns it. Unless a
+    // copy of the widget state still shares it, the returned string then holds
+    // the only reference to the text and can be edited without copying it.
+    QString takeSurroundingText(QMap<QString, QVariant> &state)
+    {
+        QVariant &stored = state[SurroundingTextAttribute];
+        QString text = stored.toString();
+
+        stored = QVariant();
+        return text;
+    }
 }
 
 class MInputContextConnectionPrivate
@@ -38,12 +54,17 @@ class MInputContextConnectionPrivate
 public:
     MInputContextConnectionPrivate();
     ~MInputContextConnectionPrivate();
+
+    QSharedPointer<MImSessionRecorder> recorder;
+    QSharedPointer<MImMetrics> metrics;
+    //! Client that sent the last full widget state, 0 if none
+    unsigned int widgetStateConnection;
 };
 
 
 MInputContextConnectionPrivate::MInputContextConnectionPrivate()
+    : widgetStateConnection(0)
 {
-    // nothing
 }
 
 
@@ -201,6 +222,10 @@ int MInputContextConnection::preeditClickPos(bool &valid) const
 /* Handlers for inbound communication */
 void MInputContextConnection::showInputMethod(unsigned int connectionId)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::ShowInputMethod, connectionId);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -210,6 +235,10 @@ void MInputContextConnection::showInputMethod(unsigned int connectionId)
 
 void MInputContextConnection::hideInputMethod(unsigned int connectionId)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::HideInputMethod, connectionId);
+    }
+
     // Only allow this call for current active connection.
     if (activeConnection != connectionId)
         return;
@@ -221,6 +250,11 @@ void MInputContextConnection::hideInputMethod(unsigned int connectionId)
 void MInputContextConnection::mouseClickedOnPreedit(unsigned int connectionId,
                                                             const QPoint &pos, const QRect &preeditRect)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::MouseClickedOnPreedit,
+                            connectionId, QVariantList() << pos << preeditRect);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -231,6 +265,11 @@ void MInputContextConnection::mouseClickedOnPreedit(unsigned int connectionId,
 void MInputContextConnection::setPreedit(unsigned int connectionId,
                                                  const QString &text, int cursorPos)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::SetPreedit,
+                            connectionId, QVariantList() << text << cursorPos);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -242,6 +281,10 @@ void MInputContextConnection::setPreedit(unsigned int connectionId,
 
 void MInputContextConnection::reset(unsigned int connectionId)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::Reset, connectionId);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -260,12 +303,22 @@ MInputContextConnection::updateWidgetInformation(
     unsigned int connectionId, const QMap<QString, QVariant> &stateInfo,
     bool handleFocusChange)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::UpdateWidgetInformation,
+                            connectionId, QVariantList() << stateInfo << handleFocusChange);
+    }
+
     if (activeConnection != connectionId)
         return;
 
+    if (d->metrics) {
+        d->metrics->increment(MImMetrics::WidgetStateUpdates);
+    }
+
     QMap<QString, QVariant> oldState = mWidgetState;
 
     mWidgetState = stateInfo;
+    d->widgetStateConnection = connectionId;
 
 #ifndef Q_WS_WIN
     if (handleFocusChange) {
@@ -276,10 +329,35 @@ MInputContextConnection::updateWidgetInformation(
     Q_EMIT widgetStateChanged(connectionId, mWidgetState, oldState, handleFocusChange);
 }
 
+void
+MInputContextConnection::updateWidgetInformationPartial(
+    unsigned int connectionId, const QMap<QString, QVariant> &changedInfo)
+{
+    // A partial update only makes sense on top of the state of the same
+    // client; the client sends a full one after activating its context.
+    if (activeConnection != connectionId || d->widgetStateConnection != connectionId) {
+        return;
+    }
+
+    QMap<QString, QVariant> stateInfo = mWidgetState;
+    for (QMap<QString, QVariant>::const_iterator iterator = changedInfo.constBegin();
+         iterator != changedInfo.constEnd(); ++iterator) {
+        stateInfo.insert(iterator.key(), iterator.value());
+    }
+
+    // Recorded sessions and plugins see a complete state, as before
+    updateWidgetInformation(connectionId, stateInfo, false);
+}
+
 void
 MInputContextConnection::receivedAppOrientationAboutToChange(unsigned int connectionId,
                                                                      int angle)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::AppOrientationAboutToChange,
+                            connectionId, QVariantList() << angle);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -295,6 +373,11 @@ MInputContextConnection::receivedAppOrientationAboutToChange(unsigned int connec
 void MInputContextConnection::receivedAppOrientationChanged(unsigned int connectionId,
                                                                     int angle)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::AppOrientationChanged,
+                            connectionId, QVariantList() << angle);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -309,6 +392,11 @@ void MInputContextConnection::receivedAppOrientationChanged(unsigned int connect
 void MInputContextConnection::setCopyPasteState(unsigned int connectionId,
                                                         bool copyAvailable, bool pasteAvailable)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::SetCopyPasteState,
+                            connectionId, QVariantList() << copyAvailable << pasteAvailable);
+    }
+
     if (activeConnection != connectionId)
         return;
 
@@ -321,9 +409,21 @@ void MInputContextConnection::processKeyEvent(
     Qt::KeyboardModifiers modifiers, const QString &text, bool autoRepeat, int count,
     quint32 nativeScanCode, quint32 nativeModifiers, unsigned long time)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::ProcessKeyEvent,
+                            connectionId, QVariantList() << int(keyType) << int(keyCode)
+                                            << int(modifiers) << text << autoRepeat << count
+                                            << nativeScanCode << nativeModifiers
+                                            << qulonglong(time));
+    }
+
     if (activeConnection != connectionId)
         return;
 
+    if (d->metrics) {
+        d->metrics->increment(MImMetrics::KeyEvents);
+    }
+
     Q_EMIT receivedKeyEvent(keyType, keyCode,
                             modifiers, text, autoRepeat, count,
                             nativeScanCode, nativeModifiers, time);
@@ -332,11 +432,21 @@ void MInputContextConnection::processKeyEvent(
 void MInputContextConnection::registerAttributeExtension(unsigned int connectionId, int id,
                                                          const QString &attributeExtension)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::RegisterAttributeExtension,
+                            connectionId, QVariantList() << id << attributeExtension);
+    }
+
     Q_EMIT attributeExtensionRegistered(connectionId, id, attributeExtension);
 }
 
 void MInputContextConnection::unregisterAttributeExtension(unsigned int connectionId, int id)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::UnregisterAttributeExtension,
+                            connectionId, QVariantList() << id);
+    }
+
     Q_EMIT attributeExtensionUnregistered(connectionId, id);
 }
 
@@ -344,13 +454,101 @@ void MInputContextConnection::setExtendedAttribute(
     unsigned int connectionId, int id, const QString &target, const QString &targetName,
     const QString &attribute, const QVariant &value)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::SetExtendedAttribute,
+                            connectionId, QVariantList() << id << target << targetName << attribute
+                                            << value);
+    }
+
     Q_EMIT extendedAttributeChanged(connectionId, id, target, targetName, attribute, value);
 }
 
+void MInputContextConnection::resumeSession(unsigned int connectionId, const QVariantMap &session)
+{
+    const QVariantMap extensions = session.value(QStringLiteral("extensions")).toMap();
+
+    for (QVariantMap::const_iterator iterator = extensions.constBegin();
+         iterator != extensions.constEnd(); ++iterator) {
+        const QVariantMap extension = iterator.value().toMap();
+        registerAttributeExtension(connectionId, iterator.key().toInt(),
+                                   extension.value(QStringLiteral("fileName")).toString());
+    }
+
+    if (session.value(QStringLiteral("activate")).toBool()) {
+        activateContext(connectionId);
+    }
+
+    if (session.contains(QStringLiteral("orientation"))) {
+        receivedAppOrientationChanged(connectionId, session.value(QStringLiteral("orientation")).toInt());
+    }
+
+    for (QVariantMap::const_iterator iterator = extensions.constBegin();
+         iterator != extensions.constEnd(); ++iterator) {
+        const QVariantMap attributes = iterator.value().toMap().value(QStringLiteral("attributes")).toMap();
+
+        for (QVariantMap::const_iterator attribute = attributes.constBegin();
+             attribute != attributes.constEnd(); ++attribute) {
+            QString target, targetItem, name;
+            if (!Maliit::Session::splitAttributeKey(attribute.key(), &target, &targetItem, &name)) {
+                qWarning() << "Ignoring invalid extended attribute" << attribute.key();
+                continue;
+            }
+
+            setExtendedAttribute(connectionId, iterator.key().toInt(), target, targetItem, name,
+                                 attribute.value());
+        }
+    }
+
+    if (session.contains(QStringLiteral("widgetState"))) {
+        updateWidgetInformation(connectionId, session.value(QStringLiteral("widgetState")).toMap(), true);
+    }
+
+    if (session.value(QStringLiteral("showInputMethod")).toBool()) {
+        showInputMethod(connectionId);
+    }
+}
+
 void MInputContextConnection::loadPluginSettings(int connectionId, const QString &descriptionLanguage)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::LoadPluginSettings,
+                            connectionId, QVariantList() << descriptionLanguage);
+    }
+
     Q_EMIT pluginSettingsRequested(connectionId, descriptionLanguage);
 }
+
+void MInputContextConnection::loadPluginSettingsSnapshot(int connectionId, const QString &descriptionLanguage,
+                                                         quint64 knownVersion)
+{
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::LoadPluginSettingsSnapshot,
+                            connectionId, QVariantList() << descriptionLanguage << knownVersion);
+    }
+
+    Q_EMIT pluginSettingsSnapshotRequested(connectionId, descriptionLanguage, knownVersion);
+}
+
+void MInputContextConnection::subscribePluginSettings(int connectionId, const QString &descriptionLanguage,
+                                                      quint64 lastSeenVersion)
+{
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::SubscribePluginSettings,
+                            connectionId, QVariantList() << descriptionLanguage << lastSeenVersion);
+    }
+
+    Q_EMIT pluginSettingsSubscriptionRequested(connectionId, descriptionLanguage, lastSeenVersion);
+}
+
+void MInputContextConnection::unsubscribePluginSettings(int connectionId)
+{
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::UnsubscribePluginSettings,
+                            connectionId);
+    }
+
+    Q_EMIT pluginSettingsUnsubscribed(connectionId);
+}
 /* End handlers for inbound communication */
 
 bool MInputContextConnection::detectableAutoRepeat()
@@ -387,6 +585,10 @@ bool MInputContextConnection::redirectKeysEnabled()
 void MInputContextConnection::sendCommitString(const QString &string, int replaceStart,
                                           int replaceLength, int cursorPos) {
 
+    if (d->metrics) {
+        d->metrics->increment(MImMetrics::CommitStrings);
+    }
+
     const int cursorPosition(mWidgetState[CursorPositionAttribute].toInt());
     bool validAnchor(false);
 
@@ -398,8 +600,9 @@ void MInputContextConnection::sendCommitString(const QString &string, int replac
         && validAnchor) {
         const int insertPosition(cursorPosition + replaceStart);
         if (insertPosition >= 0) {
-            mWidgetState[SurroundingTextAttribute]
-                = mWidgetState[SurroundingTextAttribute].toString().insert(insertPosition, string);
+            QString surroundingText(takeSurroundingText(mWidgetState));
+            surroundingText.insert(insertPosition, string);
+            mWidgetState[SurroundingTextAttribute] = surroundingText;
             mWidgetState[CursorPositionAttribute] = cursorPos < 0 ? (insertPosition + string.length()) : cursorPos;
             mWidgetState[AnchorPositionAttribute] = mWidgetState[CursorPositionAttribute];
         }
@@ -413,16 +616,17 @@ void MInputContextConnection::sendKeyEvent(const QKeyEvent &keyEvent,
         && preedit.isEmpty()
         && keyEvent.key() == Qt::Key_Backspace
         && keyEvent.type() == QEvent::KeyPress) {
-        QString surrString(mWidgetState[SurroundingTextAttribute].toString());
         const int cursorPosition(mWidgetState[CursorPositionAttribute].toInt());
         bool validAnchor(false);
 
-        if (!surrString.isEmpty()
+        if (!mWidgetState.value(SurroundingTextAttribute).toString().isEmpty()
             && cursorPosition > 0
             // we don't support selections
             && anchorPosition(validAnchor) == cursorPosition
             && validAnchor) {
-            mWidgetState[SurroundingTextAttribute] = surrString.remove(cursorPosition - 1, 1);
+            QString surroundingText(takeSurroundingText(mWidgetState));
+            surroundingText.remove(cursorPosition - 1, 1);
+            mWidgetState[SurroundingTextAttribute] = surroundingText;
             mWidgetState[CursorPositionAttribute] = cursorPosition - 1;
             mWidgetState[AnchorPositionAttribute] = cursorPosition - 1;
         }
@@ -433,6 +637,10 @@ void MInputContextConnection::sendKeyEvent(const QKeyEvent &keyEvent,
 /* */
 void MInputContextConnection::handleDisconnection(unsigned int connectionId)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::ClientDisconnected, connectionId);
+    }
+
     Q_EMIT clientDisconnected(connectionId);
 
     if (activeConnection != connectionId) {
@@ -446,6 +654,10 @@ void MInputContextConnection::handleDisconnection(unsigned int connectionId)
 
 void MInputContextConnection::activateContext(unsigned int connectionId)
 {
+    if (d->recorder) {
+        d->recorder->record(MImSessionEvent::Inbound, MImSessionEvent::ActivateContext, connectionId);
+    }
+
     if (connectionId == activeConnection) {
         return;
     }
@@ -485,6 +697,9 @@ void MInputContextConnection::sendPreeditString(const QString &string,
     if (activeConnection) {
         preedit = string;
     }
+    if (d->metrics) {
+        d->metrics->increment(MImMetrics::PreeditUpdates);
+    }
 }
 
 /* */
@@ -552,12 +767,61 @@ void MInputContextConnection::pluginSettingsLoaded(int clientId, const QList<MIm
     // empty default implementation
 }
 
+void MInputContextConnection::pluginSettingsSnapshotLoaded(int clientId, quint64 version,
+                                                           const QList<MImPluginSettingsInfo> &info)
+{
+    Q_UNUSED(version);
+
+    pluginSettingsLoaded(clientId, info);
+}
+
+void MInputContextConnection::pluginSettingsUnchanged(int clientId, quint64 version)
+{
+    Q_UNUSED(clientId);
+    Q_UNUSED(version);
+
+    // empty default implementation
+}
+
+void MInputContextConnection::pluginSettingsChanged(int clientId, quint64 fromVersion, quint64 version,
+                                                    const QList<MImPluginSettingsInfo> &changed,
+                                                    const QStringList &removedPlugins)
+{
+    Q_UNUSED(clientId);
+    Q_UNUSED(fromVersion);
+    Q_UNUSED(version);
+    Q_UNUSED(changed);
+    Q_UNUSED(removedPlugins);
+
+    // empty default implementation
+}
+
 
 QVariantMap MInputContextConnection::widgetState() const
 {
     return mWidgetState;
 }
 
+void MInputContextConnection::setSessionRecorder(const QSharedPointer<MImSessionRecorder> &recorder)
+{
+    d->recorder = recorder;
+}
+
+MImSessionRecorder *MInputContextConnection::sessionRecorder() const
+{
+    return d->recorder.data();
+}
+
+void MInputContextConnection::setMetrics(const QSharedPointer<MImMetrics> &metrics)
+{
+    d->metrics = metrics;
+}
+
+QSharedPointer<MImMetrics> MInputContextConnection::metrics() const
+{
+    return d->metrics;
+}
+
 QVariant MInputContextConnection::inputMethodQuery(Qt::InputMethodQuery query, const QVariant &argument) const
 {
     switch (query) {
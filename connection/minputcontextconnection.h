@@ -27,6 +27,8 @@ class MInputContextConnectionPrivate;
 class MAbstractInputMethod;
 class MAttributeExtensionId;
 class MImPluginSettingsInfo;
+class MImSessionRecorder;
+class MImMetrics;
 
 /*! \internal
  * \ingroup maliitserver
@@ -218,6 +220,24 @@ public:
 
     QVariant inputMethodQuery(Qt::InputMethodQuery query, const QVariant &argument) const;
 
+    /*!
+     * \brief Records every inbound and outbound call to \a recorder.
+     *
+     * Passing a null pointer stops recording.
+     */
+    void setSessionRecorder(const QSharedPointer<MImSessionRecorder> &recorder);
+
+    /*!
+     * \brief Collects runtime metrics of the connection into \a metrics.
+     *
+     * The server shares the same registry with the plugin manager, the
+     * window groups and the settings.
+     */
+    void setMetrics(const QSharedPointer<MImMetrics> &metrics);
+
+    //! Returns the metrics registry, or a null pointer if metrics are disabled
+    QSharedPointer<MImMetrics> metrics() const;
+
 public: // Inbound communication handlers
     //! ipc method provided to application, makes the application the active one
     void activateContext(unsigned int connectionId);
@@ -239,6 +259,15 @@ public: // Inbound communication handlers
                                  const QMap<QString, QVariant> &stateInformation,
                                  bool focusChanged);
 
+    /*!
+     * \brief Replaces the entries in \a changedInformation of the widget state
+     * last sent by \a clientId with updateWidgetInformation(), keeping all others.
+     *
+     * Ignored unless the current widget state came from \a clientId.
+     */
+    void updateWidgetInformationPartial(unsigned int clientId,
+                                        const QMap<QString, QVariant> &changedInformation);
+
     //! ipc method provided to the application, resets the input method
     void reset(unsigned int clientId);
 
@@ -288,11 +317,38 @@ public: // Inbound communication handlers
     void setExtendedAttribute(unsigned int clientId, int id, const QString &target,
                               const QString &targetItem, const QString &attribute, const QVariant &value);
 
+    /*!
+     * \brief Takes over the state of a client that just connected, as sent
+     * with MImServerConnection::resumeSession().
+     *
+     * Handled like the equivalent separate calls, in the order a client
+     * would make them.
+     */
+    void resumeSession(unsigned int clientId, const QVariantMap &session);
+
     /*!
      * \brief Requests information about plugin/server settings.
      */
     void loadPluginSettings(int connectionId, const QString &descriptionLanguage);
 
+    /*!
+     * \brief Requests the settings snapshot unless the client already holds \a knownVersion.
+     */
+    void loadPluginSettingsSnapshot(int connectionId, const QString &descriptionLanguage,
+                                    quint64 knownVersion);
+
+    /*!
+     * \brief Brings the client up to date from \a lastSeenVersion of the settings
+     * and keeps sending it settings changes.
+     */
+    void subscribePluginSettings(int connectionId, const QString &descriptionLanguage,
+                                 quint64 lastSeenVersion);
+
+    /*!
+     * \brief Stops sending settings changes to the client.
+     */
+    void unsubscribePluginSettings(int connectionId);
+
 public Q_SLOTS:
     //! Update \a region covered by virtual keyboard
     virtual void updateInputMethodArea(const QRegion &region);
@@ -323,6 +379,29 @@ public Q_SLOTS:
      */
     virtual void pluginSettingsLoaded(int clientId, const QList<MImPluginSettingsInfo> &info);
 
+    /*!
+     * \brief Sends the settings snapshot identified by \a version to the specified client.
+     */
+    virtual void pluginSettingsSnapshotLoaded(int clientId, quint64 version,
+                                              const QList<MImPluginSettingsInfo> &info);
+
+    /*!
+     * \brief Tells the specified client that its settings snapshot \a version is still current.
+     */
+    virtual void pluginSettingsUnchanged(int clientId, quint64 version);
+
+    /*!
+     * \brief Sends the specified client the settings that changed from version
+     * \a fromVersion to \a version.
+     *
+     * \a changed holds the whole settings of newly registered plugins and only
+     * the changed entries of the others; \a removedPlugins names plugins
+     * whose settings are gone.
+     */
+    virtual void pluginSettingsChanged(int clientId, quint64 fromVersion, quint64 version,
+                                       const QList<MImPluginSettingsInfo> &changed,
+                                       const QStringList &removedPlugins);
+
 Q_SIGNALS:
     /* Emitted first */
     void contentOrientationAboutToChange(int angle);
@@ -351,6 +430,11 @@ Q_SIGNALS:
                               const QString &targetName,const QString &attribute, const QVariant &value);
 
     void pluginSettingsRequested(int connectionId, const QString &descriptionLanguage);
+    void pluginSettingsSnapshotRequested(int connectionId, const QString &descriptionLanguage,
+                                         quint64 knownVersion);
+    void pluginSettingsSubscriptionRequested(int connectionId, const QString &descriptionLanguage,
+                                             quint64 lastSeenVersion);
+    void pluginSettingsUnsubscribed(int connectionId);
 
     void clientActivated(unsigned int connectionId);
     void clientDisconnected(unsigned int connectionId);
@@ -374,6 +458,9 @@ protected:
 
     QVariantMap widgetState() const;
 
+    //! Returns the session recorder, or 0 if calls are not being recorded
+    MImSessionRecorder *sessionRecorder() const;
+
 public:
     void handleDisconnection(unsigned int connectionId);
 
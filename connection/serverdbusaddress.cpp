@@ -13,16 +13,37 @@
 
 #include "serverdbusaddress.h"
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDBusConnection>
+#include <QDBusError>
 #include <QDBusServer>
+#include <QFile>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QStringList>
 
 #include <cstdlib>
 
 namespace {
     const char * const MaliitServerName = "org.maliit.server";
     const char * const MaliitServerObjectPath = "/org/maliit/server/address";
+    const char * const AddressFileName = "maliit-server.address";
+
+    QString withoutGuid(const QString &address)
+    {
+        QStringList parts = address.split(QLatin1Char(','));
+
+        for (QStringList::iterator part = parts.begin(); part != parts.end();) {
+            if (part->startsWith(QLatin1String("guid="))) {
+                part = parts.erase(part);
+            } else {
+                ++part;
+            }
+        }
+
+        return parts.join(QLatin1Char(','));
+    }
 }
 
 namespace Maliit {
@@ -50,6 +71,30 @@ QString AddressPublisher::address() const
     return mAddress;
 }
 
+QString addressFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+            + QLatin1Char('/') + QLatin1String(AddressFileName);
+}
+
+bool publishAddress(const QString &address)
+{
+    // Written atomically, clients watching the directory never see a partial address
+    QSaveFile file(addressFilePath());
+
+    return file.open(QIODevice::WriteOnly)
+            && file.write(address.toUtf8()) >= 0
+            && file.commit();
+}
+
+bool socketActivated()
+{
+    static const bool activated = qgetenv("LISTEN_PID").toLongLong() == QCoreApplication::applicationPid()
+                                  && qgetenv("LISTEN_FDS").toInt() > 0;
+
+    return activated;
+}
+
 Address::Address()
 {}
 
@@ -59,14 +104,59 @@ Address::~Address()
 DynamicAddress::DynamicAddress()
 {}
 
+DynamicAddress::~DynamicAddress()
+{
+    if (publishedAddress.isEmpty()) {
+        return;
+    }
+
+    // A server started meanwhile may have published its own address
+    QFile file(addressFilePath());
+    if (file.open(QIODevice::ReadOnly)
+        && QString::fromUtf8(file.readAll()) == publishedAddress) {
+        file.close();
+        file.remove();
+    }
+}
+
 QDBusServer* DynamicAddress::connect()
 {
-    auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
-    auto dbusAddress = QLatin1String("unix:path=%1/maliit-server").arg(runtimeDir);
+    QDBusServer *server = 0;
+    QString address;
+    bool usingSystemdSocket = false;
+
+    // Started by systemd on the socket it listens on; the socket outlives
+    // the server, so clients can reconnect while a new server starts.
+    if (socketActivated()) {
+        server = new QDBusServer(QStringLiteral("systemd:"));
+        if (server->isConnected()) {
+            // Every server has another GUID, which must not keep clients from
+            // connecting to the next one
+            address = withoutGuid(server->address());
+            usingSystemdSocket = true;
+        } else {
+            qWarning() << "Cannot use the socket passed by systemd:" << server->lastError().message();
+            delete server;
+            server = 0;
+        }
+    }
+
+    if (!server) {
+        auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+        auto dbusAddress = QLatin1String("unix:path=%1/maliit-server").arg(runtimeDir);
 
-    QDBusServer *server = new QDBusServer(dbusAddress);
+        server = new QDBusServer(dbusAddress);
+        address = server->address();
+    }
+
+    publisher.reset(new AddressPublisher(address));
 
-    publisher.reset(new AddressPublisher(server->address()));
+    if (!publishAddress(address)) {
+        qWarning() << "Cannot write server address to" << addressFilePath();
+    } else if (!usingSystemdSocket) {
+        // Otherwise the socket stays valid after this server exits
+        publishedAddress = address;
+    }
 
     return server;
 }
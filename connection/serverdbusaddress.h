@@ -41,6 +41,25 @@ private:
     const QString mAddress;
 };
 
+/*!
+ * \brief Returns the path of the file holding the address of the running server.
+ *
+ * Clients read it before asking the session bus, which saves a bus round
+ * trip and lets them wait for the server by watching the runtime directory.
+ */
+QString addressFilePath();
+
+//! Writes \a address to addressFilePath(); returns false on failure.
+bool publishAddress(const QString &address);
+
+/*!
+ * \brief Returns whether systemd passed a listening socket to the server.
+ *
+ * DynamicAddress then listens on that socket, which survives restarts of
+ * the server; see the maliit-server.socket unit.
+ */
+bool socketActivated();
+
 class Address
 {
 public:
@@ -55,12 +74,15 @@ class DynamicAddress : public Address
 
 public:
     explicit DynamicAddress();
+    virtual ~DynamicAddress();
 
     //! reimpl
     virtual QDBusServer* connect();
 
 private:
     QScopedPointer<AddressPublisher> publisher;
+    //! Address written to the address file, removed on exit; empty if none
+    QString publishedAddress;
 };
 
 class FixedAddress : public Address
@@ -0,0 +1,163 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "predictioninputmethod.h"
+
+#include <maliit/plugins/abstractinputmethodhost.h>
+
+#include <QKeyEvent>
+
+namespace {
+
+QStringList exampleDictionary()
+{
+    return QStringList() << "input" << "insert" << "instance" << "keyboard"
+                         << "language" << "maliit" << "method" << "plugin"
+                         << "predict" << "prediction" << "preedit" << "server"
+                         << "surrounding" << "switch" << "text" << "typing";
+}
+
+// Runs on a worker thread: a real plugin would query and rank a dictionary here
+QString findCompletion(const QStringList &dictionary, const QString &prefix)
+{
+    QString best;
+    Q_FOREACH (const QString &candidate, dictionary) {
+        if (candidate.startsWith(prefix, Qt::CaseInsensitive)
+            && (best.isEmpty() || candidate.length() < best.length())) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+}
+
+PredictionInputMethod::PredictionInputMethod(MAbstractInputMethodHost *host)
+    : MAbstractInputMethod(host)
+    , dictionary(exampleDictionary())
+{}
+
+PredictionInputMethod::~PredictionInputMethod()
+{}
+
+void PredictionInputMethod::setState(const QSet<Maliit::HandlerState> &state)
+{
+    inputMethodHost()->setRedirectKeys(state.contains(Maliit::Hardware));
+}
+
+void PredictionInputMethod::reset()
+{
+    word.clear();
+    completion.clear();
+}
+
+void PredictionInputMethod::handleFocusChange(bool focusIn)
+{
+    if (!focusIn) {
+        reset();
+    }
+}
+
+void PredictionInputMethod::processKeyEvent(QEvent::Type keyType, Qt::Key keyCode,
+                                            Qt::KeyboardModifiers modifiers, const QString &text,
+                                            bool autoRepeat, int count, quint32 nativeScanCode,
+                                            quint32 nativeModifiers, unsigned long time)
+{
+    if (keyType == QEvent::KeyPress && handleKeyPress(keyCode, text)) {
+        consumedKeys.insert(nativeScanCode);
+        return;
+    }
+    if (keyType == QEvent::KeyRelease && consumedKeys.remove(nativeScanCode)) {
+        return;
+    }
+
+    const QKeyEvent event(keyType, keyCode, modifiers, nativeScanCode, 0, nativeModifiers,
+                          text, autoRepeat, count);
+    Q_UNUSED(time);
+    inputMethodHost()->sendKeyEvent(event);
+}
+
+bool PredictionInputMethod::handleKeyPress(Qt::Key keyCode, const QString &text)
+{
+    if (text.length() == 1 && text.at(0).isLetter()) {
+        word.append(text);
+        updatePreedit();
+        requestCompletion();
+        return true;
+    }
+
+    if (word.isEmpty()) {
+        return false;
+    }
+
+    switch (keyCode) {
+    case Qt::Key_Backspace:
+        word.chop(1);
+        completion.clear();
+        updatePreedit();
+        if (!word.isEmpty()) {
+            requestCompletion();
+        }
+        return true;
+    case Qt::Key_Tab:
+        if (!completion.isEmpty()) {
+            word = completion;
+        }
+        commitWord();
+        return true;
+    default:
+        // Commit what was typed and let the application handle the key
+        commitWord();
+        return false;
+    }
+}
+
+void PredictionInputMethod::requestCompletion()
+{
+    const QStringList words(dictionary);
+    const QString prefix(word);
+
+    // Anything still pending for the previous prefix is stale by now, as the
+    // key event which changed the word advanced the editor state generation.
+    inputMethodHost()->runTask([words, prefix]() {
+                                   return QVariant(findCompletion(words, prefix));
+                               },
+                               this,
+                               [this](const QVariant &result) {
+                                   handleCompletion(result.toString());
+                               });
+}
+
+void PredictionInputMethod::handleCompletion(const QString &newCompletion)
+{
+    completion = newCompletion;
+    updatePreedit();
+}
+
+void PredictionInputMethod::updatePreedit()
+{
+    QList<Maliit::PreeditTextFormat> formats;
+    QString preedit(word);
+
+    formats << Maliit::PreeditTextFormat(0, word.length(), Maliit::PreeditDefault);
+    if (completion.length() > word.length()
+        && completion.startsWith(word, Qt::CaseInsensitive)) {
+        preedit.append(completion.mid(word.length()));
+        formats << Maliit::PreeditTextFormat(word.length(), completion.length() - word.length(),
+                                             Maliit::PreeditActive);
+    }
+
+    inputMethodHost()->sendPreeditString(preedit, formats, 0, 0, word.length());
+}
+
+void PredictionInputMethod::commitWord()
+{
+    inputMethodHost()->sendCommitString(word);
+    reset();
+}
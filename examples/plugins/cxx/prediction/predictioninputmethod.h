@@ -0,0 +1,54 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef PREDICTION_INPUT_METHOD_H
+#define PREDICTION_INPUT_METHOD_H
+
+#include <maliit/plugins/abstractinputmethod.h>
+
+#include <QSet>
+#include <QStringList>
+
+//! Hardware keyboard input method showing the best completion of the typed
+//! word as preedit. Looking up completions is done with
+//! MAbstractInputMethodHost::runTask(), so that it never blocks the server,
+//! and completions for a word the user has typed past are dropped.
+class PredictionInputMethod
+    : public MAbstractInputMethod
+{
+    Q_OBJECT
+
+public:
+    PredictionInputMethod(MAbstractInputMethodHost *host);
+    ~PredictionInputMethod();
+
+    //! \reimp
+    virtual void setState(const QSet<Maliit::HandlerState> &state);
+    virtual void reset();
+    virtual void handleFocusChange(bool focusIn);
+    virtual void processKeyEvent(QEvent::Type keyType, Qt::Key keyCode,
+                                 Qt::KeyboardModifiers modifiers, const QString &text,
+                                 bool autoRepeat, int count, quint32 nativeScanCode,
+                                 quint32 nativeModifiers, unsigned long time);
+    //! \reimp_end
+
+private:
+    bool handleKeyPress(Qt::Key keyCode, const QString &text);
+    void requestCompletion();
+    void handleCompletion(const QString &completion);
+    void updatePreedit();
+    void commitWord();
+
+    const QStringList dictionary;
+    QString word;
+    QString completion;
+    QSet<quint32> consumedKeys;
+};
+
+#endif // PREDICTION_INPUT_METHOD_H
@@ -0,0 +1,35 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "predictionplugin.h"
+#include "predictioninputmethod.h"
+
+#include <QtPlugin>
+
+PredictionPlugin::PredictionPlugin()
+{
+    /* Completes words typed on the hardware keyboard */
+    allowedStates << Maliit::Hardware;
+}
+
+QString PredictionPlugin::name() const
+{
+    return "PredictionPlugin";
+}
+
+MAbstractInputMethod *
+PredictionPlugin::createInputMethod(MAbstractInputMethodHost *host)
+{
+    return new PredictionInputMethod(host);
+}
+
+QSet<Maliit::HandlerState> PredictionPlugin::supportedStates() const
+{
+    return allowedStates;
+}
@@ -0,0 +1,41 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef PREDICTION_PLUGIN_H
+#define PREDICTION_PLUGIN_H
+
+#include <maliit/plugins/inputmethodplugin.h>
+
+#include <QObject>
+
+//! Example input method plugin doing its word completion on the worker pool
+class PredictionPlugin: public QObject,
+    public Maliit::Plugins::InputMethodPlugin
+{
+    Q_OBJECT
+    Q_INTERFACES(Maliit::Plugins::InputMethodPlugin)
+    Q_PLUGIN_METADATA(IID  "org.maliit.examples.cxx.predictionplugin"
+                      FILE "predictionplugin.json")
+
+public:
+    PredictionPlugin();
+
+    //! \reimp
+    virtual QString name() const;
+
+    virtual MAbstractInputMethod *createInputMethod(MAbstractInputMethodHost *host);
+
+    virtual QSet<Maliit::HandlerState> supportedStates() const;
+    //! \reimp_end
+
+private:
+    QSet<Maliit::HandlerState> allowedStates;
+};
+
+#endif // PREDICTION_PLUGIN_H
@@ -30,6 +30,7 @@
 #include <QWindow>
 #include <QSharedDataPointer>
 #include <QQuickItem>
+#include <QMetaProperty>
 
 // includes needed to load input context plugin
 #include <qpa/qplatforminputcontextfactory_p.h>
@@ -45,8 +46,72 @@ namespace
 {
     const int SoftwareInputPanelHideTimer = 100;
     const char * const InputContextName = "MInputContext";
+    const char * const InputMethodExtensionsProperty = "__inputMethodExtensions";
+
+    // Queries the widget state is made of
+    const Qt::InputMethodQueries StateQueries = Qt::ImSurroundingText | Qt::ImCursorPosition
+            | Qt::ImAnchorPosition | Qt::ImHints | Qt::ImEnterKeyType | Qt::ImCurrentSelection
+            | Qt::ImCursorRectangle;
+
+    // Returns the widget state attributes that depend on \a queries
+    QStringList stateAttributes(Qt::InputMethodQueries queries)
+    {
+        QStringList attributes;
+
+        if (queries & Qt::ImSurroundingText) {
+            attributes << "surroundingText";
+        }
+        if (queries & Qt::ImCursorPosition) {
+            attributes << "cursorPosition";
+        }
+        if (queries & Qt::ImAnchorPosition) {
+            attributes << "anchorPosition";
+        }
+        if (queries & Qt::ImHints) {
+            attributes << "contentType" << "autocapitalizationEnabled" << "hiddenText"
+                       << "predictionEnabled" << "maliit-inputmethod-hints";
+        }
+        if (queries & Qt::ImEnterKeyType) {
+            attributes << "enterKeyType";
+        }
+        if (queries & Qt::ImCurrentSelection) {
+            attributes << "hasSelection";
+        }
+        if (queries & Qt::ImCursorRectangle) {
+            attributes << "cursorRectangle";
+        }
+
+        return attributes;
+    }
+
     QLoggingCategory lcMaliit("org.maliit.inputContext", QtWarningMsg);
 
+    QTextCharFormat preeditFaceFormat(Maliit::PreeditFace face)
+    {
+        QTextCharFormat format;
+
+        switch (face) {
+        case Maliit::PreeditNoCandidates:
+            format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+            format.setUnderlineColor(Qt::red);
+            break;
+        case Maliit::PreeditUnconvertible:
+            format.setForeground(QBrush(QColor(128, 128, 128)));
+            break;
+        case Maliit::PreeditActive:
+            format.setForeground(QBrush(QColor(153, 50, 204)));
+            format.setFontWeight(QFont::Bold);
+            break;
+        case Maliit::PreeditKeyPress:
+        case Maliit::PreeditDefault:
+            format.setUnderlineStyle(QTextCharFormat::SingleUnderline);
+            format.setUnderlineColor(QColor(0, 0, 0));
+            break;
+        }
+
+        return format;
+    }
+
     int orientationAngle(Qt::ScreenOrientation orientation)
     {
         QScreen *screen = qGuiApp->primaryScreen();
@@ -58,9 +123,12 @@ MInputContext::MInputContext()
     : imServer(0),
       active(false),
       inputPanelState(InputPanelHidden),
+      panelVisibility(0, SoftwareInputPanelHideTimer),
       preeditCursorPos(-1),
       redirectKeys(false),
       currentFocusAcceptsInput(false),
+      extensionsNotified(false),
+      partialUpdatesSupported(true),
       composeInputContext(qLoadPlugin<QPlatformInputContext, QPlatformInputContextPlugin>
                           (loader(), "compose", QStringList()))
 {
@@ -71,6 +139,10 @@ MInputContext::MInputContext()
 
     qCDebug(lcMaliit) << "Creating Maliit input context";
 
+    for (int face = 0; face < PreeditFaceCount; ++face) {
+        preeditFaceFormats[face] = preeditFaceFormat(static_cast<Maliit::PreeditFace>(face));
+    }
+
     QSharedPointer<Maliit::InputContext::DBus::Address> address;
 
     QByteArray maliitServerAddress = qgetenv("MALIIT_SERVER_ADDRESS");
@@ -81,10 +153,11 @@ MInputContext::MInputContext()
     }
 
     imServer = new DBusServerConnection(address);
-    
-    sipHideTimer.setSingleShot(true);
-    sipHideTimer.setInterval(SoftwareInputPanelHideTimer);
-    connect(&sipHideTimer, SIGNAL(timeout()), SLOT(sendHideInputMethod()));
+
+    // Showing goes out right away, hiding is held back so that switching
+    // directly between text fields does not hide the input method at all.
+    connect(&panelVisibility, SIGNAL(shown()), SLOT(sendShowInputMethod()));
+    connect(&panelVisibility, SIGNAL(hidden()), SLOT(sendHideInputMethod()));
 
     connectInputMethodServer();
 }
@@ -99,6 +172,9 @@ void MInputContext::connectInputMethodServer()
 {
     connect(imServer, SIGNAL(connected()), this, SLOT(onDBusConnection()));
     connect(imServer, SIGNAL(disconnected()), this, SLOT(onDBusDisconnection()));
+    connect(imServer, SIGNAL(resumeSessionUnsupported()), this, SLOT(onResumeSessionUnsupported()));
+    connect(imServer, SIGNAL(partialWidgetUpdatesUnsupported()),
+            this, SLOT(onPartialWidgetUpdatesUnsupported()));
 
     // Hook up incoming communication from input method server
     connect(imServer, SIGNAL(activationLostEvent()), this, SLOT(activationLostEvent()));
@@ -227,6 +303,8 @@ void MInputContext::invokeAction(QInputMethod::Action action, int x)
         QMap<QString, QVariant> stateInformation = getStateInformation();
         stateInformation["preeditClickPos"] = x;
         imServer->updateWidgetInformation(stateInformation, false);
+        // the click position must not stick to later partial updates
+        sentStateInformation.clear();
 
         // FIXME: proper positions and preeditClickPos
         QRect preeditRect;
@@ -245,7 +323,8 @@ void MInputContext::update(Qt::InputMethodQueries queries)
 
     Q_UNUSED(queries) // fetching everything
 
-    if (queries & Qt::ImPlatformData) {
+    // Extensions of objects that notify about changes are sent when they change
+    if ((queries & Qt::ImPlatformData) && !extensionsNotified) {
         updateInputMethodExtensions();
     }
 
@@ -263,8 +342,46 @@ void MInputContext::update(Qt::InputMethodQueries queries)
         }
     }
     // get the state information of currently focused widget, and pass it to input method server
-    QMap<QString, QVariant> stateInformation = getStateInformation();
-    imServer->updateWidgetInformation(stateInformation, effectiveFocusChange);
+    sendStateInformation(queries, effectiveFocusChange);
+}
+
+void MInputContext::sendStateInformation(Qt::InputMethodQueries queries, bool focusChanged)
+{
+    queries &= StateQueries;
+
+    // Partial updates are only possible on top of a complete state
+    if (partialUpdatesSupported && !focusChanged && queries != StateQueries
+        && !sentStateInformation.isEmpty() && inputMethodAccepted() && qGuiApp->focusObject()) {
+        if (!queries) {
+            return;
+        }
+
+        const QMap<QString, QVariant> changedInformation = getStateInformation(queries);
+        bool removed = false;
+
+        Q_FOREACH (const QString &attribute, stateAttributes(queries)) {
+            if (!changedInformation.contains(attribute) && sentStateInformation.contains(attribute)) {
+                removed = true;
+                break;
+            }
+        }
+
+        // Removing an attribute takes a complete update
+        if (!removed) {
+            if (!changedInformation.isEmpty()) {
+                imServer->updateWidgetInformationPartial(changedInformation);
+                for (QMap<QString, QVariant>::const_iterator iterator = changedInformation.constBegin();
+                     iterator != changedInformation.constEnd(); ++iterator) {
+                    sentStateInformation.insert(iterator.key(), iterator.value());
+                }
+            }
+            return;
+        }
+    }
+
+    const QMap<QString, QVariant> stateInformation = getStateInformation();
+    imServer->updateWidgetInformation(stateInformation, focusChanged);
+    sentStateInformation = stateInformation;
 }
 
 void MInputContext::updateServerOrientation(Qt::ScreenOrientation orientation)
@@ -280,7 +397,10 @@ void MInputContext::setFocusObject(QObject *focused)
     if (composeInputContext) composeInputContext->setFocusObject(focused);
     qCDebug(lcMaliit) << InputContextName << "in" << Q_FUNC_INFO << focused;
 
+    watchInputMethodExtensions(focused);
     updateInputMethodExtensions();
+    // the state sent so far belongs to the previous focus object
+    sentStateInformation.clear();
 
     QWindow *newFocusWindow = qGuiApp->focusWindow();
     if (newFocusWindow != window.data()) {
@@ -310,13 +430,20 @@ void MInputContext::setFocusObject(QObject *focused)
     }
 
     if (active && (currentFocusAcceptsInput || oldAcceptInput)) {
-        const QMap<QString, QVariant> stateInformation = getStateInformation();
-        imServer->updateWidgetInformation(stateInformation, true);
+        sendStateInformation(Qt::ImQueryAll, true);
+
+        // The server hides the input method by itself when the focus is lost,
+        // and cancels that if a show request follows within the same frame.
+        if (!currentFocusAcceptsInput) {
+            panelVisibility.setVisible(false);
+            if (inputPanelState == InputPanelShown) {
+                inputPanelState = InputPanelHidden;
+            }
+        }
     }
 
     if (inputPanelState == InputPanelShowPending && currentFocusAcceptsInput) {
-        sipHideTimer.stop();
-        imServer->showInputMethod();
+        panelVisibility.requestShow();
         inputPanelState = InputPanelShown;
     }
 }
@@ -326,6 +453,11 @@ QString MInputContext::preeditString()
     return preedit;
 }
 
+qint64 MInputContext::suppressedInputPanelTransitions() const
+{
+    return panelVisibility.suppressedTransitions();
+}
+
 bool MInputContext::filterEvent(const QEvent *event)
 {
     bool eaten = false;
@@ -374,10 +506,6 @@ void MInputContext::showInputPanel()
 {
     qCDebug(lcMaliit) << Q_FUNC_INFO;
 
-    if (inputMethodAccepted()) {
-        sipHideTimer.stop();
-    }
-
     if (!active || !inputMethodAccepted()) {
         // in case SIP request comes without a properly focused widget, we
         // don't ask input method server to be shown. It's done when the next widget
@@ -385,9 +513,8 @@ void MInputContext::showInputPanel()
         inputPanelState = InputPanelShowPending;
 
     } else {
-        // note: could do this also if panel was hidden
-
-        imServer->showInputMethod();
+        // cancels a pending hide request
+        panelVisibility.requestShow();
         inputPanelState = InputPanelShown;
     }
 }
@@ -395,7 +522,13 @@ void MInputContext::showInputPanel()
 void MInputContext::hideInputPanel()
 {
     qCDebug(lcMaliit) << Q_FUNC_INFO;
-    sipHideTimer.start();
+
+    // the server was not asked to show yet
+    if (inputPanelState == InputPanelShowPending) {
+        inputPanelState = InputPanelHidden;
+    }
+
+    panelVisibility.requestHide();
 }
 
 bool MInputContext::isInputPanelVisible() const
@@ -413,11 +546,19 @@ Qt::LayoutDirection MInputContext::inputDirection() const
     return inputLocale.textDirection();
 }
 
+void MInputContext::sendShowInputMethod()
+{
+    imServer->showInputMethod();
+}
+
 void MInputContext::sendHideInputMethod()
 {
     imServer->hideInputMethod();
 
-    inputPanelState = InputPanelHidden;
+    // a show requested meanwhile still waits for activation
+    if (inputPanelState == InputPanelShown) {
+        inputPanelState = InputPanelHidden;
+    }
 }
 
 void MInputContext::activationLostEvent()
@@ -427,7 +568,9 @@ void MInputContext::activationLostEvent()
     // This method is called when activation was gracefully lost.
     // There is similar cleaning up done in onDBusDisconnection.
     active = false;
+    sentStateInformation.clear();
     inputPanelState = InputPanelHidden;
+    panelVisibility.setVisible(false);
 
     updateInputMethodArea(QRect());
 }
@@ -438,6 +581,7 @@ void MInputContext::imInitiatedHide()
     qCDebug(lcMaliit) << InputContextName << "in" << Q_FUNC_INFO;
 
     inputPanelState = InputPanelHidden;
+    panelVisibility.setVisible(false);
 
     // remove focus on QtQuick2
     QQuickItem *inputItem = qobject_cast<QQuickItem*>(QGuiApplication::focusObject());
@@ -516,29 +660,12 @@ void MInputContext::updatePreeditInternally(const QString &string,
     preeditCursorPos = cursorPos;
 
     QList<QInputMethodEvent::Attribute> attributes;
+    attributes.reserve(preeditFormats.count() + 1);
     Q_FOREACH (const Maliit::PreeditTextFormat &preeditFormat, preeditFormats) {
-
-        QTextCharFormat format;
-
-        // update style mode
-        switch (preeditFormat.preeditFace) {
-        case Maliit::PreeditNoCandidates:
-            format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-            format.setUnderlineColor(Qt::red);
-            break;
-        case Maliit::PreeditUnconvertible:
-            format.setForeground(QBrush(QColor(128, 128, 128)));
-            break;
-        case Maliit::PreeditActive:
-            format.setForeground(QBrush(QColor(153, 50, 204)));
-            format.setFontWeight(QFont::Bold);
-            break;
-        case Maliit::PreeditKeyPress:
-        case Maliit::PreeditDefault:
-            format.setUnderlineStyle(QTextCharFormat::SingleUnderline);
-            format.setUnderlineColor(QColor(0, 0, 0));
-            break;
-        }
+        const int face = preeditFormat.preeditFace;
+        // Formats are shared, building one for every attribute of every update is not needed
+        const QTextCharFormat &format = (face >= 0 && face < PreeditFaceCount)
+                ? preeditFaceFormats[face] : preeditFaceFormats[Maliit::PreeditDefault];
 
         attributes << QInputMethodEvent::Attribute(QInputMethodEvent::TextFormat,
                                                    preeditFormat.start,
@@ -637,6 +764,7 @@ void MInputContext::onDBusDisconnection()
 
     active = false;
     redirectKeys = false;
+    sentStateInformation.clear();
 
     updateInputMethodArea(QRect());
 }
@@ -645,13 +773,70 @@ void MInputContext::onDBusConnection()
 {
     qCDebug(lcMaliit) << Q_FUNC_INFO;
 
-    // using one attribute extension for everything
-    imServer->registerAttributeExtension(0, QString());
+    // A new server knows nothing of what we sent before. Everything it needs
+    // goes out in one message, instead of the calls that built it up.
+    sentActionKeyAttributes.clear();
+    sentStateInformation.clear();
+    partialUpdatesSupported = true;
 
     // Force activation, since setFocusObject may have been called after
     // onDBusDisconnection set active to false or before the dbus connection.
     active = false;
+    currentFocusAcceptsInput = inputMethodAccepted();
+
+    QVariantMap attributes;
+    if (currentFocusAcceptsInput && qGuiApp->focusObject()) {
+        sentActionKeyAttributes = actionKeyAttributes();
+        for (QVariantMap::const_iterator iterator = sentActionKeyAttributes.constBegin();
+             iterator != sentActionKeyAttributes.constEnd(); ++iterator) {
+            attributes.insert(QStringLiteral("/keys/actionKey/") + iterator.key(), iterator.value());
+        }
+    }
+
+    // using one attribute extension for everything
+    QVariantMap extension;
+    extension.insert(QStringLiteral("fileName"), QString());
+    extension.insert(QStringLiteral("attributes"), attributes);
+
+    QVariantMap extensions;
+    extensions.insert(QString::number(0), extension);
+
+    QVariantMap session;
+    session.insert(QStringLiteral("extensions"), extensions);
+
+    if (currentFocusAcceptsInput) {
+        active = true;
+        session.insert(QStringLiteral("activate"), true);
+
+        if (qGuiApp->focusWindow()) {
+            session.insert(QStringLiteral("orientation"),
+                           orientationAngle(qGuiApp->focusWindow()->contentOrientation()));
+        }
+
+        sentStateInformation = getStateInformation();
+        session.insert(QStringLiteral("widgetState"), sentStateInformation);
+
+        if (inputPanelState != InputPanelHidden) {
+            session.insert(QStringLiteral("showInputMethod"), true);
+            inputPanelState = InputPanelShown;
+        }
+    }
+
+    panelVisibility.setVisible(active && inputPanelState == InputPanelShown);
+    imServer->resumeSession(session);
+}
 
+void MInputContext::onResumeSessionUnsupported()
+{
+    qCDebug(lcMaliit) << Q_FUNC_INFO;
+
+    // An older server ignored the session, so send the current state the way
+    // it expects, one call at a time.
+    imServer->registerAttributeExtension(0, QString());
+    sentActionKeyAttributes.clear();
+    sentStateInformation.clear();
+
+    active = false;
     if (inputMethodAccepted()) {
         setFocusObject(QGuiApplication::focusObject());
         if (inputPanelState != InputPanelHidden) {
@@ -661,6 +846,20 @@ void MInputContext::onDBusConnection()
     }
 }
 
+void MInputContext::onPartialWidgetUpdatesUnsupported()
+{
+    qCDebug(lcMaliit) << Q_FUNC_INFO;
+
+    // The partial updates sent so far were dropped, so the server does not
+    // have what sentStateInformation says
+    partialUpdatesSupported = false;
+    sentStateInformation.clear();
+
+    if (active && inputMethodAccepted() && qGuiApp->focusObject()) {
+        imServer->updateWidgetInformation(getStateInformation(), false);
+    }
+}
+
 void MInputContext::notifyOrientationAboutToChange(MInputContext::OrientationAngle angle)
 {
     // can get called from signal so cannot be sure we are really currently active
@@ -706,74 +905,93 @@ void MInputContext::setDetectableAutoRepeat(bool enabled)
     qCDebug(lcMaliit) << "Detectable autorepeat not supported.";
 }
 
-QMap<QString, QVariant> MInputContext::getStateInformation() const
+QMap<QString, QVariant> MInputContext::getStateInformation(Qt::InputMethodQueries queries) const
 {
     QMap<QString, QVariant> stateInformation;
+    const bool complete = (queries == Qt::ImQueryAll);
 
-    stateInformation["focusState"] = inputMethodAccepted();
+    if (complete) {
+        stateInformation["focusState"] = inputMethodAccepted();
+    }
 
     if (!inputMethodAccepted() || !qGuiApp->focusObject()) {
         return stateInformation;
     }
 
-    QInputMethodQueryEvent query(Qt::ImQueryAll);
+    QInputMethodQueryEvent query(queries);
     QGuiApplication::sendEvent(qGuiApp->focusObject(), &query);
 
     QVariant queryResult;
 
-    queryResult = query.value(Qt::ImSurroundingText);
-    if (queryResult.isValid()) {
-        stateInformation["surroundingText"] = queryResult.toString();
+    if (queries & Qt::ImSurroundingText) {
+        queryResult = query.value(Qt::ImSurroundingText);
+        if (queryResult.isValid()) {
+            stateInformation["surroundingText"] = queryResult.toString();
+        }
     }
 
-    queryResult = query.value(Qt::ImCursorPosition);
-    if (queryResult.isValid()) {
-        stateInformation["cursorPosition"] = queryResult.toInt();
+    if (queries & Qt::ImCursorPosition) {
+        queryResult = query.value(Qt::ImCursorPosition);
+        if (queryResult.isValid()) {
+            stateInformation["cursorPosition"] = queryResult.toInt();
+        }
     }
 
-    queryResult = query.value(Qt::ImAnchorPosition);
-    if (queryResult.isValid()) {
-        stateInformation["anchorPosition"] = queryResult.toInt();
+    if (queries & Qt::ImAnchorPosition) {
+        queryResult = query.value(Qt::ImAnchorPosition);
+        if (queryResult.isValid()) {
+            stateInformation["anchorPosition"] = queryResult.toInt();
+        }
     }
 
-    queryResult = query.value(Qt::ImHints);
-    auto hints = queryResult.value<std::underlying_type<Qt::InputMethodHint>::type>();
+    if (queries & Qt::ImHints) {
+        queryResult = query.value(Qt::ImHints);
+        auto hints = queryResult.value<std::underlying_type<Qt::InputMethodHint>::type>();
 
-    // content type value
-    // Deprecated, replaced by just transmitting all hints (see below):
-    // FIXME: Remove once MAbstractInputMethod API for this got deprecated/removed.
-    stateInformation["contentType"] = contentType(static_cast<Qt::InputMethodHint>(hints));
+        // content type value
+        // Deprecated, replaced by just transmitting all hints (see below):
+        // FIXME: Remove once MAbstractInputMethod API for this got deprecated/removed.
+        stateInformation["contentType"] = contentType(static_cast<Qt::InputMethodHint>(hints));
 
-    stateInformation["autocapitalizationEnabled"] = !(hints & Qt::ImhNoAutoUppercase);
-    stateInformation["hiddenText"] = static_cast<bool>(hints & Qt::ImhHiddenText);
-    stateInformation["predictionEnabled"] = !(hints & Qt::ImhNoPredictiveText);
+        stateInformation["autocapitalizationEnabled"] = !(hints & Qt::ImhNoAutoUppercase);
+        stateInformation["hiddenText"] = static_cast<bool>(hints & Qt::ImhHiddenText);
+        stateInformation["predictionEnabled"] = !(hints & Qt::ImhNoPredictiveText);
 
-    stateInformation["maliit-inputmethod-hints"] = hints;
+        stateInformation["maliit-inputmethod-hints"] = hints;
+    }
 
-    queryResult = query.value(Qt::ImEnterKeyType);
-    stateInformation["enterKeyType"] = queryResult.value<std::underlying_type<Qt::EnterKeyType>::type>();
+    if (queries & Qt::ImEnterKeyType) {
+        queryResult = query.value(Qt::ImEnterKeyType);
+        stateInformation["enterKeyType"] = queryResult.value<std::underlying_type<Qt::EnterKeyType>::type>();
+    }
 
     // is text selected
-    queryResult = query.value(Qt::ImCurrentSelection);
-    if (queryResult.isValid()) {
-        stateInformation["hasSelection"] = !(queryResult.toString().isEmpty());
+    if (queries & Qt::ImCurrentSelection) {
+        queryResult = query.value(Qt::ImCurrentSelection);
+        if (queryResult.isValid()) {
+            stateInformation["hasSelection"] = !(queryResult.toString().isEmpty());
+        }
     }
 
     QWindow *window = qGuiApp->focusWindow();
-    if (window) {
+    if (window && complete) {
         stateInformation["winId"] = static_cast<qulonglong>(window->winId());
     }
 
-    queryResult = query.value(Qt::ImCursorRectangle);
-    if (queryResult.isValid()) {
-        QRect rect = queryResult.toRect();
-        rect = qGuiApp->inputMethod()->inputItemTransform().mapRect(rect);
-        if (window) {
-            stateInformation["cursorRectangle"] = QRect(window->mapToGlobal(rect.topLeft()), rect.size());
+    if (queries & Qt::ImCursorRectangle) {
+        queryResult = query.value(Qt::ImCursorRectangle);
+        if (queryResult.isValid()) {
+            QRect rect = queryResult.toRect();
+            rect = qGuiApp->inputMethod()->inputItemTransform().mapRect(rect);
+            if (window) {
+                stateInformation["cursorRectangle"] = QRect(window->mapToGlobal(rect.topLeft()), rect.size());
+            }
         }
     }
 
-    stateInformation["toolbarId"] = 0; // Global extension id. And bad state parameter name for it.
+    if (complete) {
+        stateInformation["toolbarId"] = 0; // Global extension id. And bad state parameter name for it.
+    }
 
     return stateInformation;
 }
@@ -852,17 +1070,72 @@ void MInputContext::updateInputMethodExtensions()
     }
     qCDebug(lcMaliit) << InputContextName << Q_FUNC_INFO;
 
-    QVariantMap extensions = qGuiApp->focusObject()->property("__inputMethodExtensions").toMap();
+    const QVariantMap attributes = actionKeyAttributes();
+
+    // Only send what the server does not have yet, in one message. Every
+    // attribute set on the server reaches the plugins as a key override change.
+    QVariantMap changed;
+    for (QVariantMap::const_iterator iterator = attributes.constBegin();
+         iterator != attributes.constEnd(); ++iterator) {
+        const QVariantMap::const_iterator sent = sentActionKeyAttributes.constFind(iterator.key());
+        if (sent == sentActionKeyAttributes.constEnd() || sent.value() != iterator.value()) {
+            changed.insert(iterator.key(), iterator.value());
+            sentActionKeyAttributes.insert(iterator.key(), iterator.value());
+        }
+    }
+
+    if (!changed.isEmpty()) {
+        imServer->setExtendedAttributes(0, "/keys", "actionKey", changed);
+    }
+}
+
+QVariantMap MInputContext::actionKeyAttributes() const
+{
+    QVariantMap extensions = qGuiApp->focusObject()->property(InputMethodExtensionsProperty).toMap();
+    QVariantMap attributes;
     QVariant value;
     value = extensions.value("enterKeyIconSource");
-    imServer->setExtendedAttribute(0, "/keys", "actionKey", "icon", QVariant(value.toUrl().toString()));
+    attributes.insert("icon", QVariant(value.toUrl().toString()));
 
     value = extensions.value("enterKeyText");
-    imServer->setExtendedAttribute(0, "/keys", "actionKey", "label", QVariant(value.toString()));
+    attributes.insert("label", QVariant(value.toString()));
 
     value = extensions.value("enterKeyEnabled");
-    imServer->setExtendedAttribute(0, "/keys", "actionKey", "enabled", value.isValid() ? value.toBool() : true);
+    attributes.insert("enabled", value.isValid() ? value.toBool() : true);
 
     value = extensions.value("enterKeyHighlighted");
-    imServer->setExtendedAttribute(0, "/keys", "actionKey", "highlighted", value.isValid() ? value.toBool() : false);
+    attributes.insert("highlighted", value.isValid() ? value.toBool() : false);
+
+    return attributes;
+}
+
+void MInputContext::watchInputMethodExtensions(QObject *focused)
+{
+    if (extensionsObject == focused) {
+        return;
+    }
+
+    if (extensionsObject) {
+        disconnect(extensionsObject.data(), 0, this, SLOT(updateInputMethodExtensions()));
+    }
+
+    extensionsObject = focused;
+    extensionsNotified = false;
+
+    if (!focused) {
+        return;
+    }
+
+    const QMetaObject *focusedMetaObject = focused->metaObject();
+    const int index = focusedMetaObject->indexOfProperty(InputMethodExtensionsProperty);
+    if (index < 0 || !focusedMetaObject->property(index).hasNotifySignal()) {
+        // Dynamic properties and properties without a notify signal are
+        // re-read whenever the platform data is queried.
+        return;
+    }
+
+    const QMetaMethod slot = metaObject()->method(
+        metaObject()->indexOfSlot("updateInputMethodExtensions()"));
+    extensionsNotified = connect(focused, focusedMetaObject->property(index).notifySignal(),
+                                 this, slot);
 }
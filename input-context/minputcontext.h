@@ -16,11 +16,12 @@
 
 #include <maliit/namespace.h>
 #include "dbusserverconnection.h"
+#include "mimvisibilitystate.h"
 
 #include <QObject>
-#include <QTimer>
 #include <QPointer>
 #include <QRect>
+#include <QTextCharFormat>
 
 #include <qpa/qplatforminputcontext.h>
 
@@ -61,6 +62,10 @@ public:
 
     QString preeditString();
 
+    // Returns how many show and hide requests of the input panel were
+    // coalesced instead of being sent to the server.
+    qint64 suppressedInputPanelTransitions() const;
+
 public Q_SLOTS:
     // Hooked up to the input method server
     void activationLostEvent();
@@ -87,11 +92,16 @@ public Q_SLOTS:
     // End input method server connection slots.
 
 private Q_SLOTS:
+    void sendShowInputMethod();
     void sendHideInputMethod();
     void updateServerOrientation(Qt::ScreenOrientation orientation);
 
     void onDBusDisconnection();
     void onDBusConnection();
+    void onResumeSessionUnsupported();
+    void onPartialWidgetUpdatesUnsupported();
+
+    void updateInputMethodExtensions();
 
     // Notify input method plugin about the application's active window prepare to change to a new orientation angle.
     void notifyOrientationAboutToChange(MInputContext::OrientationAngle orientation);
@@ -106,6 +116,9 @@ Q_SIGNALS:
 private:
     Q_DISABLE_COPY(MInputContext)
 
+    // Number of Maliit::PreeditFace values
+    static const int PreeditFaceCount = Maliit::PreeditActive + 1;
+
     enum InputPanelState {
         InputPanelShowPending,   // input panel showing requested, but activation pending
         InputPanelShown,
@@ -117,13 +130,23 @@ private:
 
     void connectInputMethodServer();
 
-    void updateInputMethodExtensions();
+    // Follows changes of the input method extensions of \a focused, if it notifies about them.
+    void watchInputMethodExtensions(QObject *focused);
+
+    // Returns the action key attributes of the focus object, which must exist.
+    QVariantMap actionKeyAttributes() const;
 
     // returns content type corresponding to specified hints
     Maliit::TextContentType contentType(Qt::InputMethodHints hints) const;
 
     // returns state for currently focused widget, key is attribute name.
-    QMap<QString, QVariant> getStateInformation() const;
+    // Only the attributes depending on \a queries are filled in, and only
+    // those queries are sent to the focused widget.
+    QMap<QString, QVariant> getStateInformation(Qt::InputMethodQueries queries = Qt::ImQueryAll) const;
+
+    // Sends the widget state to the server, only the parts depending on
+    // \a queries if possible.
+    void sendStateInformation(Qt::InputMethodQueries queries, bool focusChanged);
 
     // Gets cursor start position, relative to widget surrounding text.
     // Parameter valid set to false on failure.
@@ -135,15 +158,21 @@ private:
     QRect keyboardRectangle;
     InputPanelState inputPanelState; // state for the input method server's software input panel
 
-    /* Timer for hiding the current Software Input Panel.
+    /* Show and hide requests sent to the server; hiding is delayed.
      *  This is mainly for switching directly between widgets that have input method enabled. */
-    QTimer sipHideTimer;
+    MImVisibilityState panelVisibility;
     QString preedit;
     int preeditCursorPos;
     bool redirectKeys; // redirect all hw key events to the input method or not
     QLocale inputLocale;
     bool currentFocusAcceptsInput;
+    QPointer<QObject> extensionsObject; // focus object whose extensions are followed
+    bool extensionsNotified; // extensionsObject notifies about changes of its extensions
+    QVariantMap sentActionKeyAttributes; // action key attributes the server has from us
+    QMap<QString, QVariant> sentStateInformation; // widget state the server has from us, empty if unknown
+    bool partialUpdatesSupported; // the server applies updateWidgetInformationPartial()
     QPlatformInputContext *composeInputContext;
+    QTextCharFormat preeditFaceFormats[PreeditFaceCount]; // text format of every preedit face
 };
 
 #endif
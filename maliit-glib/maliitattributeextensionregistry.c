@@ -129,38 +129,182 @@ extension_weak_unref_global (gpointer data)
 }
 
 static void
-register_all_extensions (MaliitServer *server, gpointer user_data)
+extended_attribute_set (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_server_call_set_extended_attribute_finish (MALIIT_SERVER (source_object),
+                                                           res,
+                                                           &error)) {
+        g_warning ("Unable to set extended attribute: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+/* Sends the attribute without waiting for the answer; the server handles
+ * calls in the order they were sent. */
+static void
+send_extended_attribute (MaliitServer *server,
+                         gint id,
+                         const gchar *key,
+                         GVariant *value)
+{
+    gchar **parts = g_strsplit (key + 1, "/", 3);
+
+    if (!parts)
+        return;
+
+    if (g_strv_length (parts) == 3) {
+        gchar *target = g_strdup_printf ("/%s", parts[0]);
+
+        maliit_server_call_set_extended_attribute (server,
+                                                   id,
+                                                   target,
+                                                   parts[1],
+                                                   parts[2],
+                                                   value,
+                                                   NULL,
+                                                   extended_attribute_set,
+                                                   NULL);
+        g_free (target);
+    } else {
+        g_warning("Key `%s' is not valid. It needs to be `/target/item/key'", key);
+    }
+    g_strfreev (parts);
+}
+
+static void
+extension_mass_registered (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_server_call_register_attribute_extension_finish (MALIIT_SERVER (source_object),
+                                                                 res,
+                                                                 &error)) {
+        g_warning ("Could not register an extension in mass registerer: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+/* Puts the registration of every extension and all of its attributes on
+ * the wire at once, for servers without resumeSession. */
+static void
+register_extensions_separately (MaliitServer                     *server,
+                                MaliitAttributeExtensionRegistry *registry)
 {
-    MaliitAttributeExtensionRegistry *registry = user_data;
     GList *extensions = maliit_attribute_extension_registry_get_extensions (registry);
     GList *iter;
-    GError *error = NULL;
 
     for (iter = extensions; iter; iter = iter->next) {
         MaliitAttributeExtension *extension = MALIIT_ATTRIBUTE_EXTENSION (iter->data);
+        gint id = maliit_attribute_extension_get_id (extension);
+        GHashTable *attributes = maliit_attribute_extension_get_attributes (extension);
+        GHashTableIter attributes_iter;
+        gpointer key;
+        gpointer value;
+
+        maliit_server_call_register_attribute_extension (server,
+                                                         id,
+                                                         maliit_attribute_extension_get_filename (extension),
+                                                         NULL,
+                                                         extension_mass_registered,
+                                                         NULL);
+
+        g_hash_table_iter_init (&attributes_iter, attributes);
+
+        while (g_hash_table_iter_next (&attributes_iter, &key, &value)) {
+            send_extended_attribute (server, id, key, value);
+        }
+    }
+
+    g_list_free (extensions);
+}
+
+static void
+session_resumed (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+    MaliitAttributeExtensionRegistry *registry = user_data;
+    GError *error = NULL;
 
-        if (maliit_server_call_register_attribute_extension_sync (server,
-                                                                  maliit_attribute_extension_get_id (extension),
-                                                                  maliit_attribute_extension_get_filename (extension),
-                                                                  NULL,
-                                                                  &error)) {
-            GHashTable *attributes = maliit_attribute_extension_get_attributes (extension);
-            GHashTableIter attributes_iter;
-            gpointer key;
-            gpointer value;
-
-            g_hash_table_iter_init (&attributes_iter, attributes);
-
-            while (g_hash_table_iter_next (&attributes_iter, &key, &value)) {
-                maliit_attribute_extension_registry_extension_changed(registry, extension, key, value);
-            }
+    if (!maliit_server_call_resume_session_finish (MALIIT_SERVER (source_object),
+                                                   res,
+                                                   &error)) {
+        /* Servers before resumeSession */
+        if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+            register_extensions_separately (MALIIT_SERVER (source_object), registry);
         } else {
-            g_warning ("Could not register an extension in mass registerer: %s", error->message);
-            g_clear_error (&error);
+            g_warning ("Could not register extensions with the server: %s", error->message);
         }
+        g_clear_error (&error);
+    }
+
+    g_object_unref (registry);
+}
+
+/* Hands the registration of every extension and all of its attributes to
+ * the server in a single message; see resumeSession in the server
+ * interface for the layout. */
+static void
+register_all_extensions (MaliitServer *server, gpointer user_data)
+{
+    MaliitAttributeExtensionRegistry *registry = user_data;
+    GList *extensions = maliit_attribute_extension_registry_get_extensions (registry);
+    GList *iter;
+    GVariantBuilder extensions_builder;
+    GVariantBuilder session_builder;
+
+    if (!extensions)
+        return;
+
+    g_variant_builder_init (&extensions_builder, G_VARIANT_TYPE_VARDICT);
+
+    for (iter = extensions; iter; iter = iter->next) {
+        MaliitAttributeExtension *extension = MALIIT_ATTRIBUTE_EXTENSION (iter->data);
+        const gchar *filename = maliit_attribute_extension_get_filename (extension);
+        GHashTable *attributes = maliit_attribute_extension_get_attributes (extension);
+        GHashTableIter attributes_iter;
+        GVariantBuilder attributes_builder;
+        GVariantBuilder extension_builder;
+        gpointer key;
+        gpointer value;
+        gchar *id;
+
+        g_variant_builder_init (&attributes_builder, G_VARIANT_TYPE_VARDICT);
+        g_hash_table_iter_init (&attributes_iter, attributes);
+
+        while (g_hash_table_iter_next (&attributes_iter, &key, &value)) {
+            g_variant_builder_add (&attributes_builder, "{sv}", key, value);
+        }
+
+        g_variant_builder_init (&extension_builder, G_VARIANT_TYPE_VARDICT);
+        g_variant_builder_add (&extension_builder, "{sv}", "fileName",
+                               g_variant_new_string (filename ? filename : ""));
+        g_variant_builder_add (&extension_builder, "{sv}", "attributes",
+                               g_variant_builder_end (&attributes_builder));
+
+        id = g_strdup_printf ("%d", maliit_attribute_extension_get_id (extension));
+        g_variant_builder_add (&extensions_builder, "{sv}", id,
+                               g_variant_builder_end (&extension_builder));
+        g_free (id);
     }
 
     g_list_free (extensions);
+
+    g_variant_builder_init (&session_builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&session_builder, "{sv}", "extensions",
+                           g_variant_builder_end (&extensions_builder));
+
+    maliit_server_call_resume_session (server,
+                                       g_variant_builder_end (&session_builder),
+                                       NULL,
+                                       session_resumed,
+                                       g_object_ref (registry));
 }
 
 static void
@@ -201,14 +345,161 @@ maliit_attribute_extension_registry_get_instance (void)
                                                               NULL));
 }
 
+typedef struct
+{
+    gboolean registering;
+    gint id;
+    gchar *filename;
+} ExtensionCall;
+
+static void
+extension_call_free (gpointer data)
+{
+    ExtensionCall *call = data;
+
+    g_free (call->filename);
+    g_free (call);
+}
+
+static void
+extension_call_done (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+    GTask *task = G_TASK (user_data);
+    ExtensionCall *call = g_task_get_task_data (task);
+    GError *error = NULL;
+    gboolean done;
+
+    if (call->registering) {
+        done = maliit_server_call_register_attribute_extension_finish (MALIIT_SERVER (source_object),
+                                                                       res,
+                                                                       &error);
+    } else {
+        done = maliit_server_call_unregister_attribute_extension_finish (MALIIT_SERVER (source_object),
+                                                                         res,
+                                                                         &error);
+    }
+
+    if (done) {
+        g_task_return_boolean (task, TRUE);
+    } else {
+        g_task_return_error (task, error);
+    }
+
+    g_object_unref (task);
+}
+
+static void
+extension_call_server_ready (GObject      *source_object G_GNUC_UNUSED,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+    GTask *task = G_TASK (user_data);
+    ExtensionCall *call = g_task_get_task_data (task);
+    GError *error = NULL;
+    MaliitServer *server = maliit_get_server_finish (res, &error);
+
+    if (!server) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+    } else if (call->registering) {
+        maliit_server_call_register_attribute_extension (server,
+                                                         call->id,
+                                                         call->filename,
+                                                         g_task_get_cancellable (task),
+                                                         extension_call_done,
+                                                         task);
+    } else {
+        maliit_server_call_unregister_attribute_extension (server,
+                                                           call->id,
+                                                           g_task_get_cancellable (task),
+                                                           extension_call_done,
+                                                           task);
+    }
+}
+
+static void
+start_extension_call (MaliitAttributeExtensionRegistry *registry,
+                      MaliitAttributeExtension *extension,
+                      gboolean registering,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+    GTask *task = g_task_new (registry, cancellable, callback, user_data);
+    ExtensionCall *call = g_new0 (ExtensionCall, 1);
+
+    call->registering = registering;
+    call->id = maliit_attribute_extension_get_id (extension);
+    call->filename = g_strdup (maliit_attribute_extension_get_filename (extension));
+    g_task_set_task_data (task, call, extension_call_free);
+
+    maliit_get_server (cancellable, extension_call_server_ready, task);
+}
+
+static void
+extension_added (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_attribute_extension_registry_add_extension_finish (MALIIT_ATTRIBUTE_EXTENSION_REGISTRY (source_object),
+                                                                   res,
+                                                                   &error)) {
+        g_warning ("Unable to register extension: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+static void
+extension_removed (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_attribute_extension_registry_remove_extension_finish (MALIIT_ATTRIBUTE_EXTENSION_REGISTRY (source_object),
+                                                                      res,
+                                                                      &error)) {
+        g_warning ("Unable to unregister extension: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
 void
 maliit_attribute_extension_registry_add_extension (MaliitAttributeExtensionRegistry *registry,
                                                    MaliitAttributeExtension *extension)
 {
-    MaliitServer *server;
+    maliit_attribute_extension_registry_add_extension_async (registry,
+                                                             extension,
+                                                             NULL,
+                                                             extension_added,
+                                                             NULL);
+}
+
+/**
+ * maliit_attribute_extension_registry_add_extension_async:
+ * @registry: (transfer none): The #MaliitAttributeExtensionRegistry.
+ * @extension: (transfer none): The #MaliitAttributeExtension to add.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: (scope async): Called when the server registered the extension.
+ * @user_data: Data passed to @callback.
+ *
+ * Adds @extension to the registry and registers it on the server without
+ * blocking. Calls on the same registry reach the server in the order they
+ * were made.
+ */
+void
+maliit_attribute_extension_registry_add_extension_async (MaliitAttributeExtensionRegistry *registry,
+                                                         MaliitAttributeExtension *extension,
+                                                         GCancellable *cancellable,
+                                                         GAsyncReadyCallback callback,
+                                                         gpointer user_data)
+{
     GHashTable *extensions;
     gint id;
-    GError *error = NULL;
 
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION_REGISTRY (registry));
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION (extension));
@@ -225,32 +516,66 @@ maliit_attribute_extension_registry_add_extension (MaliitAttributeExtensionRegis
                              GINT_TO_POINTER (id),
                              extension);
 
-        server = maliit_get_server_sync (NULL, &error);
-
-        if (server) {
-            if (!maliit_server_call_register_attribute_extension_sync (server,
-                                                                       id,
-                                                                       maliit_attribute_extension_get_filename (extension),
-                                                                       NULL,
-                                                                       &error)) {
-                g_warning ("Unable to register extension: %s", error->message);
-                g_clear_error (&error);
-            }
-        } else {
-            g_warning ("Unable to connect to server: %s", error->message);
-            g_clear_error (&error);
-        }
+        start_extension_call (registry, extension, TRUE, cancellable, callback, user_data);
+    } else {
+        GTask *task = g_task_new (registry, cancellable, callback, user_data);
+
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
     }
 }
 
+/**
+ * maliit_attribute_extension_registry_add_extension_finish:
+ * @registry: (transfer none): The #MaliitAttributeExtensionRegistry.
+ * @res: The #GAsyncResult passed to the callback.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Finishes maliit_attribute_extension_registry_add_extension_async().
+ *
+ * Returns: %TRUE if the extension is registered on the server.
+ */
+gboolean
+maliit_attribute_extension_registry_add_extension_finish (MaliitAttributeExtensionRegistry *registry,
+                                                          GAsyncResult *res,
+                                                          GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, registry), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 void
 maliit_attribute_extension_registry_remove_extension (MaliitAttributeExtensionRegistry *registry,
                                                       MaliitAttributeExtension *extension)
 {
-    MaliitServer *server;
+    maliit_attribute_extension_registry_remove_extension_async (registry,
+                                                                extension,
+                                                                NULL,
+                                                                extension_removed,
+                                                                NULL);
+}
+
+/**
+ * maliit_attribute_extension_registry_remove_extension_async:
+ * @registry: (transfer none): The #MaliitAttributeExtensionRegistry.
+ * @extension: (transfer none): The #MaliitAttributeExtension to remove.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: (scope async): Called when the server unregistered the extension.
+ * @user_data: Data passed to @callback.
+ *
+ * Removes @extension from the registry and unregisters it on the server
+ * without blocking.
+ */
+void
+maliit_attribute_extension_registry_remove_extension_async (MaliitAttributeExtensionRegistry *registry,
+                                                            MaliitAttributeExtension *extension,
+                                                            GCancellable *cancellable,
+                                                            GAsyncReadyCallback callback,
+                                                            gpointer user_data)
+{
     GHashTable *extensions;
     gint id;
-    GError *error = NULL;
 
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION_REGISTRY (registry));
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION (extension));
@@ -262,75 +587,89 @@ maliit_attribute_extension_registry_remove_extension (MaliitAttributeExtensionRe
         g_hash_table_remove (extensions,
                              GINT_TO_POINTER (id));
 
-        server = maliit_get_server_sync (NULL, &error);
+        start_extension_call (registry, extension, FALSE, cancellable, callback, user_data);
+    } else {
+        GTask *task = g_task_new (registry, cancellable, callback, user_data);
 
-        if (server) {
-            if (!maliit_server_call_unregister_attribute_extension_sync (server,
-                                                                         id,
-                                                                         NULL,
-                                                                         &error)) {
-                g_warning ("Unable to unregister extension: %s", error->message);
-                g_clear_error (&error);
-            }
-        } else {
-            g_warning ("Unable to connect to server: %s", error->message);
-            g_clear_error (&error);
-        }
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
     }
 }
 
+/**
+ * maliit_attribute_extension_registry_remove_extension_finish:
+ * @registry: (transfer none): The #MaliitAttributeExtensionRegistry.
+ * @res: The #GAsyncResult passed to the callback.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Finishes maliit_attribute_extension_registry_remove_extension_async().
+ *
+ * Returns: %TRUE if the extension is unregistered on the server.
+ */
+gboolean
+maliit_attribute_extension_registry_remove_extension_finish (MaliitAttributeExtensionRegistry *registry,
+                                                             GAsyncResult *res,
+                                                             GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, registry), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /* For glib < 2.30 */
 #ifndef G_VALUE_INIT
 #define G_VALUE_INIT { 0, { { 0 } } }
 #endif
 
+typedef struct
+{
+    gint id;
+    gchar *key;
+    GVariant *value;
+} AttributeChange;
+
+static void
+attribute_change_server_ready (GObject      *source_object G_GNUC_UNUSED,
+                               GAsyncResult *res,
+                               gpointer      user_data)
+{
+    AttributeChange *change = user_data;
+    GError *error = NULL;
+    MaliitServer *server = maliit_get_server_finish (res, &error);
+
+    if (server) {
+        send_extended_attribute (server, change->id, change->key, change->value);
+    } else {
+        g_warning ("Unable to connect to server: %s", error->message);
+        g_clear_error (&error);
+    }
+
+    g_free (change->key);
+    g_variant_unref (change->value);
+    g_free (change);
+}
+
 void
 maliit_attribute_extension_registry_extension_changed (MaliitAttributeExtensionRegistry *registry,
                                                        MaliitAttributeExtension *extension,
                                                        const gchar *key,
                                                        GVariant *value)
 {
-    MaliitServer *server;
-    gchar **parts;
-    GError *error = NULL;
+    AttributeChange *change;
 
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION_REGISTRY (registry));
     g_return_if_fail (MALIIT_IS_ATTRIBUTE_EXTENSION (extension));
     g_return_if_fail (key != NULL);
     g_return_if_fail (value != NULL);
 
-    parts = g_strsplit (key + 1, "/", 3);
-
-    if (!parts)
-        return;
+    change = g_new0 (AttributeChange, 1);
+    change->id = maliit_attribute_extension_get_id (extension);
+    change->key = g_strdup (key);
+    change->value = g_variant_ref_sink (value);
 
-    if (g_strv_length (parts) == 3) {
-        gchar *target = g_strdup_printf ("/%s", parts[0]);
-
-        server = maliit_get_server_sync (NULL, &error);
-
-        if (server) {
-            if (!maliit_server_call_set_extended_attribute_sync (server,
-                                                                 maliit_attribute_extension_get_id (extension),
-                                                                 target,
-                                                                 parts[1],
-                                                                 parts[2],
-                                                                 value,
-                                                                 NULL,
-                                                                 &error)) {
-                g_warning ("Unable to set extended attribute: %s", error->message);
-                g_clear_error (&error);
-            }
-        } else {
-            g_warning ("Unable to connect to server: %s", error->message);
-            g_clear_error (&error);
-        }
-
-        g_free (target);
-    } else {
-        g_warning("Key `%s' is not valid. It needs to be `/target/item/key'", key);
-    }
-    g_strfreev (parts);
+    /* Goes through the same queue as registrations, so it cannot overtake
+     * the registration of its extension. */
+    maliit_get_server (NULL, attribute_change_server_ready, change);
 }
 
 static void
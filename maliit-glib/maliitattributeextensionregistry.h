@@ -24,6 +24,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include "maliitattributeextension.h"
 
@@ -67,10 +68,34 @@ void
 maliit_attribute_extension_registry_add_extension (MaliitAttributeExtensionRegistry *registry,
                                                    MaliitAttributeExtension *extension);
 
+void
+maliit_attribute_extension_registry_add_extension_async (MaliitAttributeExtensionRegistry *registry,
+                                                         MaliitAttributeExtension *extension,
+                                                         GCancellable *cancellable,
+                                                         GAsyncReadyCallback callback,
+                                                         gpointer user_data);
+
+gboolean
+maliit_attribute_extension_registry_add_extension_finish (MaliitAttributeExtensionRegistry *registry,
+                                                          GAsyncResult *res,
+                                                          GError **error);
+
 void
 maliit_attribute_extension_registry_remove_extension (MaliitAttributeExtensionRegistry *registry,
                                                       MaliitAttributeExtension *extension);
 
+void
+maliit_attribute_extension_registry_remove_extension_async (MaliitAttributeExtensionRegistry *registry,
+                                                            MaliitAttributeExtension *extension,
+                                                            GCancellable *cancellable,
+                                                            GAsyncReadyCallback callback,
+                                                            gpointer user_data);
+
+gboolean
+maliit_attribute_extension_registry_remove_extension_finish (MaliitAttributeExtensionRegistry *registry,
+                                                             GAsyncResult *res,
+                                                             GError **error);
+
 void
 maliit_attribute_extension_registry_extension_changed (MaliitAttributeExtensionRegistry *registry,
                                                        MaliitAttributeExtension *extension,
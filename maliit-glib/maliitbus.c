@@ -26,14 +26,91 @@
 #define ADDRESS_OBJECT_PATH "/org/maliit/server/address"
 #define ADDRESS_INTERFACE "org.maliit.Server.Address"
 #define ADDRESS_PROPERTY "address"
+#define ADDRESS_FILE "maliit-server.address"
 #define SERVER_OBJECT_PATH  "/com/meego/inputmethod/uiserver1"
 #define CONTEXT_OBJECT_PATH "/com/meego/inputmethod/inputcontext"
 
 static gchar *address;
+/* TRUE while address was read from the address file and not yet connected to */
+static gboolean address_from_file;
+/* Set once the address file led nowhere, until the next successful connection */
+static gboolean address_file_stale;
 static GDBusConnection *bus;
 static MaliitServer *server;
 static MaliitContext *context;
 
+/* Requests waiting for a connection or server proxy that is being set up.
+ * Only the first request starts the D-Bus calls; all the others are
+ * completed together with it. */
+static GList *pending_bus;
+static GList *pending_server;
+
+/* Bumped by maliit_set_bus (), so that answers for a bus that was replaced
+ * in the meantime are dropped. */
+static guint generation;
+
+static void
+maliit_return_to_tasks (GList        *tasks,
+                        gpointer      object,
+                        const GError *error)
+{
+  GList *iter;
+
+  for (iter = tasks; iter; iter = iter->next)
+    {
+      GTask *task = iter->data;
+
+      if (!g_task_return_error_if_cancelled (task))
+        {
+          if (object)
+            g_task_return_pointer (task, g_object_ref (object), g_object_unref);
+          else
+            g_task_return_error (task, g_error_copy (error));
+        }
+
+      g_object_unref (task);
+    }
+
+  g_list_free (tasks);
+}
+
+static void
+maliit_cancel_tasks (GList **tasks)
+{
+  GError *error = g_error_new_literal (G_IO_ERROR,
+                                       G_IO_ERROR_CANCELLED,
+                                       "Connection to the server was reset");
+  GList *cancelled = *tasks;
+
+  *tasks = NULL;
+  maliit_return_to_tasks (cancelled, NULL, error);
+  g_error_free (error);
+}
+
+/* The server writes its address into the runtime directory, which saves
+ * asking the session bus for it. The file may have been left behind by a
+ * server that is gone, so a failed connection falls back to the bus. */
+static gchar *
+maliit_read_address_file (void)
+{
+  gchar *path;
+  gchar *contents = NULL;
+
+  if (address_file_stale)
+    return NULL;
+
+  path = g_build_filename (g_get_user_runtime_dir (), ADDRESS_FILE, NULL);
+
+  if (g_file_get_contents (path, &contents, NULL, NULL) && !*g_strstrip (contents))
+    g_clear_pointer (&contents, g_free);
+
+  g_free (path);
+
+  address_from_file = contents != NULL;
+
+  return contents;
+}
+
 static const gchar *
 maliit_get_address_sync (gboolean verbose)
 {
@@ -45,6 +122,9 @@ maliit_get_address_sync (gboolean verbose)
     {
       address = g_strdup (g_getenv (ADDRESS_ENV));
 
+      if (!address)
+        address = maliit_read_address_file ();
+
       if (!address)
         {
           proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
@@ -82,44 +162,207 @@ maliit_get_address_sync (gboolean verbose)
   return address;
 }
 
+static void
+maliit_lookup_address (void);
+
+static void
+maliit_bus_ready (GObject      *source_object G_GNUC_UNUSED,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  GDBusConnection *connection;
+  GError *error = NULL;
+  GList *tasks;
+
+  connection = g_dbus_connection_new_for_address_finish (res, &error);
+
+  if (GPOINTER_TO_UINT (user_data) != generation)
+    {
+      g_clear_object (&connection);
+      g_clear_error (&error);
+
+      return;
+    }
+
+  if (!connection && address_from_file)
+    {
+      address_from_file = FALSE;
+      address_file_stale = TRUE;
+      g_clear_pointer (&address, g_free);
+      g_clear_error (&error);
+      maliit_lookup_address ();
+
+      return;
+    }
+
+  if (connection)
+    {
+      address_from_file = FALSE;
+      address_file_stale = FALSE;
+
+      if (!bus)
+        bus = g_object_ref (connection);
+    }
+
+  tasks = pending_bus;
+  pending_bus = NULL;
+  maliit_return_to_tasks (tasks, bus, error);
+
+  g_clear_object (&connection);
+  g_clear_error (&error);
+}
+
+static void
+maliit_connect_to_address (const gchar *bus_address)
+{
+  g_dbus_connection_new_for_address (bus_address,
+                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                     NULL,
+                                     NULL,
+                                     maliit_bus_ready,
+                                     GUINT_TO_POINTER (generation));
+}
+
+static void
+maliit_address_ready (GObject      *source_object G_GNUC_UNUSED,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  GDBusProxy *proxy;
+  GVariant *property = NULL;
+  GError *error = NULL;
+  GList *tasks;
+
+  proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+
+  if (GPOINTER_TO_UINT (user_data) != generation)
+    {
+      g_clear_object (&proxy);
+      g_clear_error (&error);
+
+      return;
+    }
+
+  if (proxy)
+    {
+      property = g_dbus_proxy_get_cached_property (proxy, ADDRESS_PROPERTY);
+
+      if (!property)
+        error = g_error_new_literal (G_IO_ERROR,
+                                     G_IO_ERROR_NOT_FOUND,
+                                     "Unable to find address property");
+
+      g_object_unref (proxy);
+    }
+
+  if (property)
+    {
+      if (!address)
+        address = g_strdup (g_variant_get_string (property, NULL));
+
+      maliit_connect_to_address (address);
+      g_variant_unref (property);
+    }
+  else
+    {
+      tasks = pending_bus;
+      pending_bus = NULL;
+      maliit_return_to_tasks (tasks, NULL, error);
+      g_clear_error (&error);
+    }
+}
+
+static void
+maliit_lookup_address (void)
+{
+  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                            G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES,
+                            NULL,
+                            ADDRESS_BUS_NAME,
+                            ADDRESS_OBJECT_PATH,
+                            ADDRESS_INTERFACE,
+                            NULL,
+                            maliit_address_ready,
+                            GUINT_TO_POINTER (generation));
+}
+
 static void
 maliit_get_bus (GCancellable        *cancellable,
                 GAsyncReadyCallback  callback,
                 gpointer             user_data)
 {
+  GTask *task;
+
   g_return_if_fail (callback);
 
-  if (!bus)
-    g_dbus_connection_new_for_address (maliit_get_address_sync (TRUE),
-                                       G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
-                                       NULL,
-                                       cancellable,
-                                       callback,
-                                       user_data);
+  task = g_task_new (NULL, cancellable, callback, user_data);
+
+  if (bus)
+    {
+      g_task_return_pointer (task, g_object_ref (bus), g_object_unref);
+      g_object_unref (task);
+
+      return;
+    }
+
+  pending_bus = g_list_append (pending_bus, task);
+
+  /* Somebody else is already connecting */
+  if (pending_bus->next)
+    return;
+
+  if (!address)
+    address = g_strdup (g_getenv (ADDRESS_ENV));
+
+  if (!address)
+    address = maliit_read_address_file ();
+
+  if (address)
+    maliit_connect_to_address (address);
   else
-    callback (NULL, NULL, user_data);
+    maliit_lookup_address ();
 }
 
+/* Returns a new reference */
 static GDBusConnection *
 maliit_get_bus_finish (GAsyncResult  *res,
                        GError       **error)
 {
-  if (!bus)
-    bus = g_dbus_connection_new_for_address_finish (res, error);
-
-  return bus;
+  return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+/* Blocks until the server answers; must not be called from the main loop
+ * of a graphical application. */
 static GDBusConnection *
 maliit_get_bus_sync (GCancellable  *cancellable,
                      GError       **error)
 {
   if (!bus)
-    bus = g_dbus_connection_new_for_address_sync (maliit_get_address_sync (TRUE),
-                                                  G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
-                                                  NULL,
-                                                  cancellable,
-                                                  error);
+    {
+      bus = g_dbus_connection_new_for_address_sync (maliit_get_address_sync (TRUE),
+                                                    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                                    NULL,
+                                                    cancellable,
+                                                    error);
+
+      if (!bus && address_from_file)
+        {
+          address_file_stale = TRUE;
+          g_clear_pointer (&address, g_free);
+          g_clear_error (error);
+
+          bus = g_dbus_connection_new_for_address_sync (maliit_get_address_sync (TRUE),
+                                                        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                                        NULL,
+                                                        cancellable,
+                                                        error);
+        }
+
+      if (bus)
+        address_file_stale = FALSE;
+
+      address_from_file = FALSE;
+    }
 
   return bus;
 }
@@ -129,16 +372,23 @@ maliit_set_bus (GDBusConnection *bus_)
 {
   if (bus_ != bus)
     {
+      ++generation;
+      maliit_cancel_tasks (&pending_server);
+      maliit_cancel_tasks (&pending_bus);
+
       g_clear_object (&context);
       g_clear_object (&server);
       g_clear_object (&bus);
       g_clear_pointer (&address, g_free);
+      address_from_file = FALSE;
 
       if (bus_)
         bus = g_object_ref (bus_);
     }
 }
 
+/* Blocks until the server answers; must not be called from the main loop
+ * of a graphical application. */
 gboolean
 maliit_is_running (void)
 {
@@ -174,49 +424,116 @@ maliit_is_running (void)
   return running;
 }
 
+static void
+maliit_server_ready (GObject      *source_object G_GNUC_UNUSED,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+  MaliitServer *proxy;
+  GError *error = NULL;
+  GList *tasks;
+
+  proxy = maliit_server_proxy_new_finish (res, &error);
+
+  if (GPOINTER_TO_UINT (user_data) != generation)
+    {
+      g_clear_object (&proxy);
+      g_clear_error (&error);
+
+      return;
+    }
+
+  if (proxy && !server)
+    server = g_object_ref (proxy);
+
+  tasks = pending_server;
+  pending_server = NULL;
+  maliit_return_to_tasks (tasks, server, error);
+
+  g_clear_object (&proxy);
+  g_clear_error (&error);
+}
+
+static void
+maliit_server_bus_ready (GObject      *source_object G_GNUC_UNUSED,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+  GDBusConnection *connection;
+  GError *error = NULL;
+  GList *tasks;
+
+  connection = maliit_get_bus_finish (res, &error);
+
+  if (GPOINTER_TO_UINT (user_data) != generation)
+    {
+      g_clear_object (&connection);
+      g_clear_error (&error);
+
+      return;
+    }
+
+  if (connection)
+    {
+      maliit_server_proxy_new (connection,
+                               G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES,
+                               NULL,
+                               SERVER_OBJECT_PATH,
+                               NULL,
+                               maliit_server_ready,
+                               user_data);
+
+      g_object_unref (connection);
+    }
+  else
+    {
+      tasks = pending_server;
+      pending_server = NULL;
+      maliit_return_to_tasks (tasks, NULL, error);
+      g_clear_error (&error);
+    }
+}
+
 void
 maliit_get_server (GCancellable        *cancellable,
                    GAsyncReadyCallback  callback,
                    gpointer             user_data)
 {
-  GDBusConnection *bus;
-  GError *error = NULL;
+  GTask *task;
 
   g_return_if_fail (callback);
 
-  if (!server)
-    {
-      bus = maliit_get_bus_sync (cancellable, &error);
+  task = g_task_new (NULL, cancellable, callback, user_data);
 
-      if (bus)
-        maliit_server_proxy_new (bus,
-                                 G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES,
-                                 NULL,
-                                 SERVER_OBJECT_PATH,
-                                 cancellable,
-                                 callback,
-                                 user_data);
-      else
-        {
-          g_warning ("Unable to connect to bus: %s", error->message);
+  if (server)
+    {
+      g_task_return_pointer (task, g_object_ref (server), g_object_unref);
+      g_object_unref (task);
 
-          g_clear_error (&error);
-        }
+      return;
     }
-  else
-    callback (NULL, NULL, user_data);
+
+  pending_server = g_list_append (pending_server, task);
+
+  if (!pending_server->next)
+    maliit_get_bus (NULL, maliit_server_bus_ready, GUINT_TO_POINTER (generation));
 }
 
 MaliitServer *
 maliit_get_server_finish (GAsyncResult  *res,
                           GError       **error)
 {
-  if (!server)
-    server = maliit_server_proxy_new_finish (res, error);
+  MaliitServer *result = g_task_propagate_pointer (G_TASK (res), error);
 
-  return server;
+  /* The proxy stays owned by the library */
+  if (result)
+    g_object_unref (result);
+
+  return result;
 }
 
+/* Blocks until the server answers; must not be called from the main loop
+ * of a graphical application, use maliit_get_server () there. */
 MaliitServer *
 maliit_get_server_sync (GCancellable  *cancellable,
                         GError       **error)
@@ -250,6 +567,43 @@ maliit_context_handle_plugin_settings_loaded (MaliitContext         *context,
   return TRUE;
 }
 
+static gboolean
+maliit_context_handle_plugin_settings_snapshot_loaded (MaliitContext         *context,
+                                                       GDBusMethodInvocation *invocation,
+                                                       guint64                version     G_GNUC_UNUSED,
+                                                       GVariant              *plugins     G_GNUC_UNUSED,
+                                                       gpointer               user_data   G_GNUC_UNUSED)
+{
+  maliit_context_complete_plugin_settings_snapshot_loaded (context, invocation);
+
+  return TRUE;
+}
+
+static gboolean
+maliit_context_handle_plugin_settings_unchanged (MaliitContext         *context,
+                                                 GDBusMethodInvocation *invocation,
+                                                 guint64                version     G_GNUC_UNUSED,
+                                                 gpointer               user_data   G_GNUC_UNUSED)
+{
+  maliit_context_complete_plugin_settings_unchanged (context, invocation);
+
+  return TRUE;
+}
+
+static gboolean
+maliit_context_handle_plugin_settings_changed (MaliitContext         *context,
+                                               GDBusMethodInvocation *invocation,
+                                               guint64                from_version    G_GNUC_UNUSED,
+                                               guint64                version         G_GNUC_UNUSED,
+                                               GVariant              *plugins         G_GNUC_UNUSED,
+                                               const gchar *const    *removed_plugins G_GNUC_UNUSED,
+                                               gpointer               user_data       G_GNUC_UNUSED)
+{
+  maliit_context_complete_plugin_settings_changed (context, invocation);
+
+  return TRUE;
+}
+
 static gboolean
 maliit_context_handle_update_input_method_area (MaliitContext         *context,
                                                 GDBusMethodInvocation *invocation,
@@ -264,25 +618,104 @@ maliit_context_handle_update_input_method_area (MaliitContext         *context,
   return TRUE;
 }
 
+static MaliitContext *
+maliit_export_context (GDBusConnection  *connection,
+                       GError          **error)
+{
+  if (!context)
+    {
+      context = maliit_context_skeleton_new ();
+
+      g_signal_connect_after (context,
+                              "handle-plugin-settings-loaded",
+                              G_CALLBACK (maliit_context_handle_plugin_settings_loaded),
+                              NULL);
+
+      g_signal_connect_after (context,
+                              "handle-plugin-settings-snapshot-loaded",
+                              G_CALLBACK (maliit_context_handle_plugin_settings_snapshot_loaded),
+                              NULL);
+
+      g_signal_connect_after (context,
+                              "handle-plugin-settings-unchanged",
+                              G_CALLBACK (maliit_context_handle_plugin_settings_unchanged),
+                              NULL);
+
+      g_signal_connect_after (context,
+                              "handle-plugin-settings-changed",
+                              G_CALLBACK (maliit_context_handle_plugin_settings_changed),
+                              NULL);
+
+      g_signal_connect_after (context,
+                              "handle-update-input-method-area",
+                              G_CALLBACK (maliit_context_handle_update_input_method_area),
+                              NULL);
+
+      if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (context),
+                                             connection,
+                                             CONTEXT_OBJECT_PATH,
+                                             error))
+        g_clear_object (&context);
+    }
+
+  return context;
+}
+
+static void
+maliit_context_bus_ready (GObject      *source_object G_GNUC_UNUSED,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+  GTask *task = user_data;
+  GDBusConnection *connection;
+  GError *error = NULL;
+
+  connection = maliit_get_bus_finish (res, &error);
+
+  if (connection && maliit_export_context (connection, &error))
+    g_task_return_pointer (task, g_object_ref (context), g_object_unref);
+  else
+    g_task_return_error (task, error);
+
+  g_clear_object (&connection);
+  g_object_unref (task);
+}
+
 void
 maliit_get_context (GCancellable        *cancellable,
                     GAsyncReadyCallback  callback,
                     gpointer             user_data)
 {
+  GTask *task;
+
   g_return_if_fail (callback);
 
-  maliit_get_bus (cancellable, callback, user_data);
+  task = g_task_new (NULL, cancellable, callback, user_data);
+
+  if (context)
+    {
+      g_task_return_pointer (task, g_object_ref (context), g_object_unref);
+      g_object_unref (task);
+    }
+  else
+    maliit_get_bus (cancellable, maliit_context_bus_ready, task);
 }
 
 MaliitContext *
 maliit_get_context_finish (GAsyncResult  *res,
                            GError       **error)
 {
-  maliit_get_bus_finish (res, error);
+  MaliitContext *result = g_task_propagate_pointer (G_TASK (res), error);
 
-  return maliit_get_context_sync (NULL, error);
+  /* The skeleton stays owned by the library */
+  if (result)
+    g_object_unref (result);
+
+  return result;
 }
 
+/* Blocks until the server answers; must not be called from the main loop
+ * of a graphical application, use maliit_get_context () there. */
 MaliitContext *
 maliit_get_context_sync (GCancellable  *cancellable,
                          GError       **error)
@@ -294,25 +727,7 @@ maliit_get_context_sync (GCancellable  *cancellable,
       bus = maliit_get_bus_sync (cancellable, error);
 
       if (bus)
-        {
-          context = maliit_context_skeleton_new ();
-
-          g_signal_connect_after (context,
-                                  "handle-plugin-settings-loaded",
-                                  G_CALLBACK (maliit_context_handle_plugin_settings_loaded),
-                                  NULL);
-
-          g_signal_connect_after (context,
-                                  "handle-update-input-method-area",
-                                  G_CALLBACK (maliit_context_handle_update_input_method_area),
-                                  NULL);
-
-          if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (context),
-                                                 bus,
-                                                 CONTEXT_OBJECT_PATH,
-                                                 error))
-            g_clear_object (&context);
-        }
+        maliit_export_context (bus, error);
     }
 
   return context;
@@ -40,6 +40,7 @@ struct _MaliitInputMethodPrivate
     int area[4];
 
     MaliitServer *maliit_proxy;
+    MaliitContext *context;
 };
 
 G_DEFINE_TYPE_WITH_CODE (MaliitInputMethod, maliit_input_method, G_TYPE_OBJECT,
@@ -63,18 +64,14 @@ maliit_input_method_finalize (GObject *object)
 static void
 maliit_input_method_dispose (GObject *object)
 {
-    GError *error = NULL;
     MaliitInputMethod *input_method = MALIIT_INPUT_METHOD (object);
     MaliitInputMethodPrivate *priv = input_method->priv;
-    MaliitContext *context = maliit_get_context_sync (NULL, &error);
 
-    if (context) {
-        g_signal_handlers_disconnect_by_data (context, input_method);
-    } else {
-        g_warning ("Unable to connect to context: %s", error->message);
-        g_clear_error (&error);
+    if (priv->context) {
+        g_signal_handlers_disconnect_by_data (priv->context, input_method);
     }
 
+    g_clear_object (&priv->context);
     g_clear_object (&priv->maliit_proxy);
 
     G_OBJECT_CLASS (maliit_input_method_parent_class)->dispose (object);
@@ -133,29 +130,38 @@ update_input_method_area(MaliitInputMethod *input_method,
 }
 
 static void
-maliit_input_method_init (MaliitInputMethod *input_method)
+server_ready (GObject      *source_object G_GNUC_UNUSED,
+              GAsyncResult *res,
+              gpointer      user_data)
 {
-    MaliitInputMethodPrivate *priv = maliit_input_method_get_instance_private (input_method);
-    MaliitContext *context;
+    MaliitInputMethod *input_method = MALIIT_INPUT_METHOD (user_data);
     GError *error = NULL;
+    MaliitServer *server = maliit_get_server_finish (res, &error);
 
-    priv->area[0] = priv->area[1] = 0;
-    priv->area[2] = priv->area[3] = 0;
-
-    priv->maliit_proxy = maliit_get_server_sync (NULL, &error);
-
-    if (priv->maliit_proxy) {
-        g_object_ref (priv->maliit_proxy);
+    if (server) {
+        if (!input_method->priv->maliit_proxy) {
+            input_method->priv->maliit_proxy = g_object_ref (server);
+        }
     } else {
         g_warning ("Unable to connect to server: %s", error->message);
         g_clear_error (&error);
     }
 
-    input_method->priv = priv;
+    g_object_unref (input_method);
+}
 
-    context = maliit_get_context_sync (NULL, &error);
+static void
+context_ready (GObject      *source_object G_GNUC_UNUSED,
+               GAsyncResult *res,
+               gpointer      user_data)
+{
+    MaliitInputMethod *input_method = MALIIT_INPUT_METHOD (user_data);
+    GError *error = NULL;
+    MaliitContext *context = maliit_get_context_finish (res, &error);
 
     if (context) {
+        input_method->priv->context = g_object_ref (context);
+
         g_signal_connect_swapped (context,
                                   "handle-update-input-method-area",
                                   G_CALLBACK (update_input_method_area),
@@ -164,6 +170,24 @@ maliit_input_method_init (MaliitInputMethod *input_method)
         g_warning ("Unable to connect to context: %s", error->message);
         g_clear_error (&error);
     }
+
+    g_object_unref (input_method);
+}
+
+static void
+maliit_input_method_init (MaliitInputMethod *input_method)
+{
+    MaliitInputMethodPrivate *priv = maliit_input_method_get_instance_private (input_method);
+
+    priv->area[0] = priv->area[1] = 0;
+    priv->area[2] = priv->area[3] = 0;
+    priv->maliit_proxy = NULL;
+    priv->context = NULL;
+
+    input_method->priv = priv;
+
+    maliit_get_server (NULL, server_ready, g_object_ref (input_method));
+    maliit_get_context (NULL, context_ready, g_object_ref (input_method));
 }
 
 /**
@@ -207,60 +231,244 @@ maliit_input_method_get_area (MaliitInputMethod *input_method,
         *height = input_method->priv->area[3];
 }
 
+static void
+context_activated (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_server_call_activate_context_finish (MALIIT_SERVER (source_object),
+                                                     res,
+                                                     &error)) {
+        g_warning ("Unable to activate context: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+static void
+visibility_requested (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GError *error = NULL;
+    gboolean done;
+
+    if (GPOINTER_TO_INT (g_task_get_task_data (task))) {
+        done = maliit_server_call_show_input_method_finish (MALIIT_SERVER (source_object),
+                                                            res,
+                                                            &error);
+    } else {
+        done = maliit_server_call_hide_input_method_finish (MALIIT_SERVER (source_object),
+                                                            res,
+                                                            &error);
+    }
+
+    if (done) {
+        g_task_return_boolean (task, TRUE);
+    } else {
+        g_task_return_error (task, error);
+    }
+
+    g_object_unref (task);
+}
+
+/* Sends both calls right away; the server handles them in order, so there
+ * is no need to wait for the context to be activated. */
+static void
+request_visibility (MaliitServer *server,
+                    GTask *task)
+{
+    GCancellable *cancellable = g_task_get_cancellable (task);
+
+    maliit_server_call_activate_context (server,
+                                         cancellable,
+                                         context_activated,
+                                         NULL);
+
+    if (GPOINTER_TO_INT (g_task_get_task_data (task))) {
+        maliit_server_call_show_input_method (server,
+                                              cancellable,
+                                              visibility_requested,
+                                              task);
+    } else {
+        maliit_server_call_hide_input_method (server,
+                                              cancellable,
+                                              visibility_requested,
+                                              task);
+    }
+}
+
+static void
+visibility_server_ready (GObject      *source_object G_GNUC_UNUSED,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GError *error = NULL;
+    MaliitServer *server = maliit_get_server_finish (res, &error);
+
+    if (server) {
+        request_visibility (server, task);
+    } else {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+    }
+}
+
+static void
+set_visible_async (MaliitInputMethod *input_method,
+                   gboolean visible,
+                   GCancellable *cancellable,
+                   GAsyncReadyCallback callback,
+                   gpointer user_data)
+{
+    GTask *task = g_task_new (input_method, cancellable, callback, user_data);
+
+    g_task_set_task_data (task, GINT_TO_POINTER (visible), NULL);
+
+    if (input_method->priv->maliit_proxy) {
+        request_visibility (input_method->priv->maliit_proxy, task);
+    } else {
+        maliit_get_server (cancellable, visibility_server_ready, task);
+    }
+}
+
+static void
+shown (GObject      *source_object,
+       GAsyncResult *res,
+       gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_input_method_show_finish (MALIIT_INPUT_METHOD (source_object), res, &error)) {
+        g_warning ("Unable to show input method: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+static void
+hidden (GObject      *source_object,
+        GAsyncResult *res,
+        gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_input_method_hide_finish (MALIIT_INPUT_METHOD (source_object), res, &error)) {
+        g_warning ("Unable to hide input method: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
 /**
  * maliit_input_method_show:
  * @input_method: (transfer none): The #MaliitInputMethod which you want to show.
  *
- * Request to explicitly show the Maliit virtual keyboard.
+ * Request to explicitly show the Maliit virtual keyboard. Does not block;
+ * failures are logged.
  */
 void
 maliit_input_method_show (MaliitInputMethod *input_method)
 {
-    GError *error = NULL;
+    g_return_if_fail (MALIIT_IS_INPUT_METHOD (input_method));
+
+    set_visible_async (input_method, TRUE, NULL, shown, NULL);
+}
 
+/**
+ * maliit_input_method_show_async:
+ * @input_method: (transfer none): The #MaliitInputMethod which you want to show.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: (scope async): Called when the server handled the request.
+ * @user_data: Data passed to @callback.
+ *
+ * Request to explicitly show the Maliit virtual keyboard, reporting the
+ * result to @callback.
+ */
+void
+maliit_input_method_show_async (MaliitInputMethod *input_method,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
     g_return_if_fail (MALIIT_IS_INPUT_METHOD (input_method));
-    g_return_if_fail (input_method->priv->maliit_proxy);
 
-    if (!maliit_server_call_activate_context_sync (input_method->priv->maliit_proxy,
-                                                   NULL,
-                                                   &error)) {
-        g_warning ("Unable to activate context: %s", error->message);
-        g_clear_error (&error);
-    }
+    set_visible_async (input_method, TRUE, cancellable, callback, user_data);
+}
 
-    if (!maliit_server_call_show_input_method_sync (input_method->priv->maliit_proxy,
-                                                    NULL,
-                                                    &error)) {
-        g_warning ("Unable to show input method: %s", error->message);
-        g_clear_error (&error);
-    }
+/**
+ * maliit_input_method_show_finish:
+ * @input_method: (transfer none): The #MaliitInputMethod.
+ * @res: The #GAsyncResult passed to the callback.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Finishes maliit_input_method_show_async().
+ *
+ * Returns: %TRUE if the server accepted the request.
+ */
+gboolean
+maliit_input_method_show_finish (MaliitInputMethod *input_method,
+                                 GAsyncResult *res,
+                                 GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, input_method), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 /**
  * maliit_input_method_hide:
  * @input_method: (transfer none): The #MaliitInputMethod which you want to hide.
  *
- * Request to explicitly hide the Maliit virtual keyboard.
+ * Request to explicitly hide the Maliit virtual keyboard. Does not block;
+ * failures are logged.
  */
 void
 maliit_input_method_hide (MaliitInputMethod *input_method)
 {
-    GError *error = NULL;
+    g_return_if_fail (MALIIT_IS_INPUT_METHOD (input_method));
 
+    set_visible_async (input_method, FALSE, NULL, hidden, NULL);
+}
+
+/**
+ * maliit_input_method_hide_async:
+ * @input_method: (transfer none): The #MaliitInputMethod which you want to hide.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: (scope async): Called when the server handled the request.
+ * @user_data: Data passed to @callback.
+ *
+ * Request to explicitly hide the Maliit virtual keyboard, reporting the
+ * result to @callback.
+ */
+void
+maliit_input_method_hide_async (MaliitInputMethod *input_method,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
     g_return_if_fail (MALIIT_IS_INPUT_METHOD (input_method));
-    g_return_if_fail (input_method->priv->maliit_proxy);
 
-    if (!maliit_server_call_activate_context_sync (input_method->priv->maliit_proxy,
-                                                   NULL,
-                                                   &error)) {
-        g_warning ("Unable to activate context: %s", error->message);
-        g_clear_error (&error);
-    }
+    set_visible_async (input_method, FALSE, cancellable, callback, user_data);
+}
 
-    if (!maliit_server_call_hide_input_method_sync (input_method->priv->maliit_proxy,
-                                                    NULL,
-                                                    &error)) {
-        g_warning ("Unable to hide input method: %s", error->message);
-        g_clear_error (&error);
-    }
+/**
+ * maliit_input_method_hide_finish:
+ * @input_method: (transfer none): The #MaliitInputMethod.
+ * @res: The #GAsyncResult passed to the callback.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Finishes maliit_input_method_hide_async().
+ *
+ * Returns: %TRUE if the server accepted the request.
+ */
+gboolean
+maliit_input_method_hide_finish (MaliitInputMethod *input_method,
+                                 GAsyncResult *res,
+                                 GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, input_method), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (res), error);
 }
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -69,9 +70,31 @@ maliit_input_method_get_area (MaliitInputMethod *input_method,
 void
 maliit_input_method_show (MaliitInputMethod *input_method);
 
+void
+maliit_input_method_show_async (MaliitInputMethod *input_method,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data);
+
+gboolean
+maliit_input_method_show_finish (MaliitInputMethod *input_method,
+                                 GAsyncResult *res,
+                                 GError **error);
+
 void
 maliit_input_method_hide (MaliitInputMethod *input_method);
 
+void
+maliit_input_method_hide_async (MaliitInputMethod *input_method,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data);
+
+gboolean
+maliit_input_method_hide_finish (MaliitInputMethod *input_method,
+                                 GAsyncResult *res,
+                                 GError **error);
+
 G_END_DECLS
 
 #endif /* MALIIT_GLIB_INPUT_METHOD_H */
@@ -21,8 +21,10 @@
 
 #include "maliitsettingsmanager.h"
 #include "maliitpluginsettingsprivate.h"
+#include "maliitsettingsentry.h"
 #include "maliitattributeextensionprivate.h"
 #include "maliitbus.h"
+#include "maliitmarshallers.h"
 
 /**
  * SECTION:maliitsettingsmanager
@@ -43,6 +45,13 @@ struct _MaliitSettingsManagerPrivate
 {
     MaliitAttributeExtension *settings_list_changed;
     guint attribute_changed_signal_id;
+
+    /* Last settings snapshot received from the server, 0 if none */
+    guint64 settings_version;
+    gchar *settings_language;
+    gchar *requested_language;
+    GList *settings;
+    gboolean subscribed;
 };
 
 G_DEFINE_TYPE_WITH_CODE (MaliitSettingsManager, maliit_settings_manager,
@@ -51,6 +60,7 @@ G_DEFINE_TYPE_WITH_CODE (MaliitSettingsManager, maliit_settings_manager,
 enum
 {
     PLUGIN_SETTINGS_RECEIVED,
+    PLUGIN_SETTINGS_CHANGED,
     CONNECTED,
     DISCONNECTED,
 
@@ -62,6 +72,11 @@ static guint signals[LAST_SIGNAL] = { 0 };
 static void
 maliit_settings_manager_finalize (GObject *object)
 {
+    MaliitSettingsManager *manager = MALIIT_SETTINGS_MANAGER (object);
+
+    g_free (manager->priv->settings_language);
+    g_free (manager->priv->requested_language);
+
     G_OBJECT_CLASS (maliit_settings_manager_parent_class)->finalize (object);
 }
 
@@ -85,6 +100,9 @@ maliit_settings_manager_dispose (GObject *object)
 
     g_clear_object (&manager->priv->settings_list_changed);
 
+    g_list_free_full (manager->priv->settings, g_object_unref);
+    manager->priv->settings = NULL;
+
     G_OBJECT_CLASS (maliit_settings_manager_parent_class)->dispose (object);
 }
 
@@ -117,6 +135,32 @@ maliit_settings_manager_class_init (MaliitSettingsManagerClass *manager_class)
                       1,
                       G_TYPE_POINTER);
 
+    /**
+     * MaliitSettingsManager::plugin-settings-changed:
+     * @manager: The #MaliitSettingsManager emitting the signal.
+     * @settings: (type GLib.List) (element-type Maliit.PluginSettings): Changed settings.
+     * @removed_plugins: Names of plugins whose settings are gone.
+     *
+     * Emitted after maliit_settings_manager_subscribe_plugin_settings()
+     * when settings changed on the server. @settings holds the whole
+     * settings of new plugins and only the changed entries of others. The
+     * settings emitted with #MaliitSettingsManager::plugin-settings-received
+     * by later calls to maliit_settings_manager_load_plugin_settings()
+     * already include the changes.
+     */
+    signals[PLUGIN_SETTINGS_CHANGED] =
+        g_signal_new ("plugin-settings-changed",
+                      MALIIT_TYPE_SETTINGS_MANAGER,
+                      G_SIGNAL_RUN_FIRST,
+                      0,
+                      NULL,
+                      NULL,
+                      maliit_marshal_VOID__POINTER_BOXED,
+                      G_TYPE_NONE,
+                      2,
+                      G_TYPE_POINTER,
+                      G_TYPE_STRV);
+
     /**
      * MaliitSettingsManager::connected:
      * @manager: The #MaliitSettingsManager emitting the signal.
@@ -161,21 +205,15 @@ on_connection_established (MaliitSettingsManager *manager,
     g_signal_emit(manager, signals[CONNECTED], 0);
 }
 
-static gboolean
-on_plugins_loaded (MaliitSettingsManager *manager,
-                   GDBusMethodInvocation *invocation G_GNUC_UNUSED,
-                   GVariant *plugin_settings,
-                   gpointer user_data G_GNUC_UNUSED)
+static GList *
+parse_plugin_settings (MaliitSettingsManager *manager,
+                       GVariant *plugin_settings)
 {
     guint iter;
     GList *result;
     GHashTable *extensions;
     GVariant *plugin_info;
 
-    if (!plugin_settings) {
-        return FALSE;
-    }
-
     result = NULL;
     extensions = g_hash_table_new (g_direct_hash,
                                    g_direct_equal);
@@ -222,7 +260,24 @@ on_plugins_loaded (MaliitSettingsManager *manager,
         }
     }
 
-    result = g_list_reverse (result);
+    g_hash_table_unref (extensions);
+
+    return g_list_reverse (result);
+}
+
+static gboolean
+on_plugins_loaded (MaliitSettingsManager *manager,
+                   GDBusMethodInvocation *invocation G_GNUC_UNUSED,
+                   GVariant *plugin_settings,
+                   gpointer user_data G_GNUC_UNUSED)
+{
+    GList *result;
+
+    if (!plugin_settings) {
+        return FALSE;
+    }
+
+    result = parse_plugin_settings (manager, plugin_settings);
     g_signal_emit (manager,
                    signals[PLUGIN_SETTINGS_RECEIVED],
                    0,
@@ -234,6 +289,190 @@ on_plugins_loaded (MaliitSettingsManager *manager,
     return FALSE;
 }
 
+static gboolean
+on_plugins_snapshot_loaded (MaliitSettingsManager *manager,
+                            GDBusMethodInvocation *invocation G_GNUC_UNUSED,
+                            guint64 version,
+                            GVariant *plugin_settings,
+                            gpointer user_data G_GNUC_UNUSED)
+{
+    MaliitSettingsManagerPrivate *priv = manager->priv;
+
+    if (!plugin_settings) {
+        return FALSE;
+    }
+
+    g_list_free_full (priv->settings, g_object_unref);
+    priv->settings = parse_plugin_settings (manager, plugin_settings);
+    priv->settings_version = version;
+    g_free (priv->settings_language);
+    priv->settings_language = g_strdup (priv->requested_language);
+
+    g_signal_emit (manager,
+                   signals[PLUGIN_SETTINGS_RECEIVED],
+                   0,
+                   priv->settings);
+
+    return FALSE;
+}
+
+/* The server still has the snapshot we hold, hand out the parsed copy */
+static gboolean
+on_plugins_unchanged (MaliitSettingsManager *manager,
+                      GDBusMethodInvocation *invocation G_GNUC_UNUSED,
+                      guint64 version,
+                      gpointer user_data G_GNUC_UNUSED)
+{
+    MaliitSettingsManagerPrivate *priv = manager->priv;
+
+    if (priv->settings && version == priv->settings_version) {
+        g_signal_emit (manager,
+                       signals[PLUGIN_SETTINGS_RECEIVED],
+                       0,
+                       priv->settings);
+    }
+
+    return FALSE;
+}
+
+/* Replaces the entries of @cached that @changes holds and appends new ones */
+static MaliitPluginSettings *
+merge_plugin_settings (MaliitPluginSettings *cached,
+                       MaliitPluginSettings *changes)
+{
+    GPtrArray *cached_entries = maliit_plugin_settings_get_configuration_entries (cached);
+    GPtrArray *changed_entries = maliit_plugin_settings_get_configuration_entries (changes);
+    GPtrArray *entries;
+    MaliitPluginSettings *merged;
+    guint iter;
+    guint changed_iter;
+
+    entries = g_ptr_array_sized_new (cached_entries->len + changed_entries->len);
+    g_ptr_array_set_free_func (entries, g_object_unref);
+
+    for (iter = 0; iter < cached_entries->len; ++iter) {
+        MaliitSettingsEntry *entry = g_ptr_array_index (cached_entries, iter);
+
+        for (changed_iter = 0; changed_iter < changed_entries->len; ++changed_iter) {
+            MaliitSettingsEntry *changed = g_ptr_array_index (changed_entries, changed_iter);
+
+            if (!g_strcmp0 (maliit_settings_entry_get_key (entry),
+                            maliit_settings_entry_get_key (changed))) {
+                entry = changed;
+                break;
+            }
+        }
+
+        g_ptr_array_add (entries, g_object_ref (entry));
+    }
+
+    for (changed_iter = 0; changed_iter < changed_entries->len; ++changed_iter) {
+        MaliitSettingsEntry *changed = g_ptr_array_index (changed_entries, changed_iter);
+        gboolean found = FALSE;
+
+        for (iter = 0; iter < cached_entries->len && !found; ++iter) {
+            found = !g_strcmp0 (maliit_settings_entry_get_key (g_ptr_array_index (cached_entries, iter)),
+                                maliit_settings_entry_get_key (changed));
+        }
+
+        if (!found) {
+            g_ptr_array_add (entries, g_object_ref (changed));
+        }
+    }
+
+    merged = MALIIT_PLUGIN_SETTINGS (g_object_new (MALIIT_TYPE_PLUGIN_SETTINGS,
+                                                   "description-language", maliit_plugin_settings_get_description_language (changes),
+                                                   "plugin-name", maliit_plugin_settings_get_plugin_name (changes),
+                                                   "plugin-description", maliit_plugin_settings_get_plugin_description (changes),
+                                                   "configuration-entries", entries,
+                                                   NULL));
+
+    g_ptr_array_unref (entries);
+
+    return merged;
+}
+
+static GList *
+find_plugin_settings (GList       *settings,
+                      const gchar *plugin_name)
+{
+    for (; settings; settings = settings->next) {
+        if (!g_strcmp0 (maliit_plugin_settings_get_plugin_name (settings->data), plugin_name)) {
+            return settings;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+subscribe_plugin_settings (MaliitSettingsManager *manager);
+
+/* Settings changed on the server, fold them into the cached settings */
+static gboolean
+on_plugins_changed (MaliitSettingsManager *manager,
+                    GDBusMethodInvocation *invocation G_GNUC_UNUSED,
+                    guint64 from_version,
+                    guint64 version,
+                    GVariant *changed_settings,
+                    const gchar *const *removed_plugins,
+                    gpointer user_data G_GNUC_UNUSED)
+{
+    MaliitSettingsManagerPrivate *priv = manager->priv;
+    GList *changes;
+    GList *iter;
+    guint removed_iter;
+
+    if (!changed_settings) {
+        return FALSE;
+    }
+
+    if (from_version != priv->settings_version) {
+        /* Changes were missed; ask again from what we have */
+        if (priv->subscribed) {
+            subscribe_plugin_settings (manager);
+        }
+        return FALSE;
+    }
+
+    changes = parse_plugin_settings (manager, changed_settings);
+
+    for (iter = changes; iter; iter = iter->next) {
+        GList *cached = find_plugin_settings (priv->settings,
+                                              maliit_plugin_settings_get_plugin_name (iter->data));
+
+        if (cached) {
+            MaliitPluginSettings *merged = merge_plugin_settings (cached->data, iter->data);
+
+            g_object_unref (cached->data);
+            cached->data = merged;
+        } else {
+            priv->settings = g_list_append (priv->settings, g_object_ref (iter->data));
+        }
+    }
+
+    for (removed_iter = 0; removed_plugins && removed_plugins[removed_iter]; ++removed_iter) {
+        GList *cached = find_plugin_settings (priv->settings, removed_plugins[removed_iter]);
+
+        if (cached) {
+            g_object_unref (cached->data);
+            priv->settings = g_list_delete_link (priv->settings, cached);
+        }
+    }
+
+    priv->settings_version = version;
+
+    g_signal_emit (manager,
+                   signals[PLUGIN_SETTINGS_CHANGED],
+                   0,
+                   changes,
+                   removed_plugins);
+
+    g_list_free_full (changes, g_object_unref);
+
+    return FALSE;
+}
+
 static void
 connection_established (GObject      *source_object G_GNUC_UNUSED,
                         GAsyncResult *res,
@@ -259,6 +498,11 @@ maliit_settings_manager_init (MaliitSettingsManager *manager)
 
     priv->settings_list_changed = NULL;
     priv->attribute_changed_signal_id = 0;
+    priv->settings_version = 0;
+    priv->settings_language = NULL;
+    priv->requested_language = NULL;
+    priv->settings = NULL;
+    priv->subscribed = FALSE;
     manager->priv = priv;
 
     maliit_get_server (NULL, connection_established, manager);
@@ -270,6 +514,18 @@ maliit_settings_manager_init (MaliitSettingsManager *manager)
                                   "handle-plugin-settings-loaded",
                                   G_CALLBACK (on_plugins_loaded),
                                   manager);
+        g_signal_connect_swapped (context,
+                                  "handle-plugin-settings-snapshot-loaded",
+                                  G_CALLBACK (on_plugins_snapshot_loaded),
+                                  manager);
+        g_signal_connect_swapped (context,
+                                  "handle-plugin-settings-unchanged",
+                                  G_CALLBACK (on_plugins_unchanged),
+                                  manager);
+        g_signal_connect_swapped (context,
+                                  "handle-plugin-settings-changed",
+                                  G_CALLBACK (on_plugins_changed),
+                                  manager);
     } else {
         g_warning ("Unable to connect to context: %s", error->message);
         g_clear_error (&error);
@@ -296,25 +552,49 @@ maliit_settings_manager_new (void)
  * @manager: (transfer none): The #MaliitSettingsManager.
  *
  * Request the list of settings from maliit-server.
- * The settings will be returned async via the MaliitServerManager::plugin-settings-received signal
+ * The settings will be returned async via the MaliitServerManager::plugin-settings-received signal.
+ * If they did not change since the last request, the server only confirms
+ * that and the previously received list is emitted again.
  */
 void
 maliit_settings_manager_load_plugin_settings (MaliitSettingsManager *manager)
 {
+    MaliitSettingsManagerPrivate *priv;
     MaliitServer *server;
+    const gchar *language;
+    guint64 known_version;
     GError *error = NULL;
 
     g_return_if_fail (MALIIT_IS_SETTINGS_MANAGER (manager));
 
+    priv = manager->priv;
+    language = maliit_settings_manager_get_preferred_description_locale ();
+    known_version = g_strcmp0 (language, priv->settings_language) ? 0 : priv->settings_version;
+
+    g_free (priv->requested_language);
+    priv->requested_language = g_strdup (language);
+
     server = maliit_get_server_sync (NULL, &error);
 
     if (server) {
-        if (!maliit_server_call_load_plugin_settings_sync (server,
-                                                           maliit_settings_manager_get_preferred_description_locale (),
-                                                           NULL,
-                                                           &error)) {
-            g_warning ("Unable to load plugin settings: %s", error->message);
-            g_clear_error (&error);
+        if (!maliit_server_call_load_plugin_settings_snapshot_sync (server,
+                                                                    language,
+                                                                    known_version,
+                                                                    NULL,
+                                                                    &error)) {
+            /* Servers before settings snapshots */
+            if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+                g_clear_error (&error);
+                maliit_server_call_load_plugin_settings_sync (server,
+                                                              language,
+                                                              NULL,
+                                                              &error);
+            }
+
+            if (error) {
+                g_warning ("Unable to load plugin settings: %s", error->message);
+                g_clear_error (&error);
+            }
         }
     } else {
         g_warning ("Unable to connect to server: %s", error->message);
@@ -322,6 +602,113 @@ maliit_settings_manager_load_plugin_settings (MaliitSettingsManager *manager)
     }
 }
 
+static void
+subscribe_done (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_server_call_subscribe_plugin_settings_finish (MALIIT_SERVER (source_object), res, &error)) {
+        g_warning ("Unable to subscribe to plugin settings: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+static void
+unsubscribe_done (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data G_GNUC_UNUSED)
+{
+    GError *error = NULL;
+
+    if (!maliit_server_call_unsubscribe_plugin_settings_finish (MALIIT_SERVER (source_object), res, &error)) {
+        g_warning ("Unable to unsubscribe from plugin settings: %s", error->message);
+        g_clear_error (&error);
+    }
+}
+
+static void
+subscribe_server_ready (GObject      *source_object G_GNUC_UNUSED,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+    MaliitSettingsManager *manager = user_data;
+    MaliitSettingsManagerPrivate *priv = manager->priv;
+    GError *error = NULL;
+    MaliitServer *server = maliit_get_server_finish (res, &error);
+
+    if (!server) {
+        g_warning ("Unable to connect to server: %s", error->message);
+        g_clear_error (&error);
+    } else if (priv->subscribed) {
+        const gchar *language = maliit_settings_manager_get_preferred_description_locale ();
+        guint64 last_seen_version = g_strcmp0 (language, priv->settings_language) ? 0 : priv->settings_version;
+
+        g_free (priv->requested_language);
+        priv->requested_language = g_strdup (language);
+
+        maliit_server_call_subscribe_plugin_settings (server,
+                                                      language,
+                                                      last_seen_version,
+                                                      NULL,
+                                                      subscribe_done,
+                                                      NULL);
+    } else {
+        maliit_server_call_unsubscribe_plugin_settings (server,
+                                                        NULL,
+                                                        unsubscribe_done,
+                                                        NULL);
+    }
+
+    g_object_unref (manager);
+}
+
+static void
+subscribe_plugin_settings (MaliitSettingsManager *manager)
+{
+    maliit_get_server (NULL, subscribe_server_ready, g_object_ref (manager));
+}
+
+/**
+ * maliit_settings_manager_subscribe_plugin_settings:
+ * @manager: (transfer none): The #MaliitSettingsManager.
+ *
+ * Keeps the settings up to date without reloading them. The server first
+ * sends what changed since the settings last received, or all settings
+ * through the MaliitSettingsManager::plugin-settings-received signal, and
+ * then every change through the MaliitSettingsManager::plugin-settings-changed
+ * signal, until maliit_settings_manager_unsubscribe_plugin_settings().
+ */
+void
+maliit_settings_manager_subscribe_plugin_settings (MaliitSettingsManager *manager)
+{
+    g_return_if_fail (MALIIT_IS_SETTINGS_MANAGER (manager));
+
+    manager->priv->subscribed = TRUE;
+    subscribe_plugin_settings (manager);
+}
+
+/**
+ * maliit_settings_manager_unsubscribe_plugin_settings:
+ * @manager: (transfer none): The #MaliitSettingsManager.
+ *
+ * Stops the changes requested with
+ * maliit_settings_manager_subscribe_plugin_settings(). Changes are sent per
+ * connection to the server, so this stops them for all managers of the
+ * process.
+ */
+void
+maliit_settings_manager_unsubscribe_plugin_settings (MaliitSettingsManager *manager)
+{
+    g_return_if_fail (MALIIT_IS_SETTINGS_MANAGER (manager));
+
+    if (manager->priv->subscribed) {
+        manager->priv->subscribed = FALSE;
+        subscribe_plugin_settings (manager);
+    }
+}
+
 /**
  * maliit_settings_manager_set_preferred_description_locale:
  * @locale_name: (transfer none): The new preferred locale.
@@ -64,6 +64,12 @@ maliit_settings_manager_new (void);
 void
 maliit_settings_manager_load_plugin_settings (MaliitSettingsManager *manager);
 
+void
+maliit_settings_manager_subscribe_plugin_settings (MaliitSettingsManager *manager);
+
+void
+maliit_settings_manager_unsubscribe_plugin_settings (MaliitSettingsManager *manager);
+
 void
 maliit_settings_manager_set_preferred_description_locale (const gchar *locale_name);
 
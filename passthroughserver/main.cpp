@@ -14,6 +14,9 @@
 #include <QtGlobal>
 
 #include "connectionfactory.h"
+#include "mimmetrics.h"
+#include "mimmetricsservice.h"
+#include "mimsessionlog.h"
 #include "mimserver.h"
 #include "mimserveroptions.h"
 #ifdef HAVE_XCB
@@ -102,6 +105,24 @@ int main(int argc, char **argv)
     // Input Context Connection
     QSharedPointer<MInputContextConnection> icConnection(createConnection(connectionOptions));
 
+    if (!connectionOptions.sessionRecordingFile.isEmpty()) {
+        QSharedPointer<MImSessionRecorder> recorder(new MImSessionRecorder(connectionOptions.sessionRecordingFile));
+        if (recorder->isOpen()) {
+            icConnection->setSessionRecorder(recorder);
+        } else {
+            qCWarning(lcMaliitFw) << "Cannot record session to" << connectionOptions.sessionRecordingFile
+                                  << ":" << recorder->errorString();
+        }
+    }
+
+    QScopedPointer<MImMetricsService> metricsService;
+    if (connectionOptions.metricsEnabled) {
+        QSharedPointer<MImMetrics> metrics(new MImMetrics);
+        icConnection->setMetrics(metrics);
+        metricsService.reset(new MImMetricsService(metrics));
+        metricsService->setLogInterval(connectionOptions.metricsLogInterval);
+    }
+
     QSharedPointer<Maliit::AbstractPlatform> platform(Maliit::createPlatform().release());
 
     // The actual server
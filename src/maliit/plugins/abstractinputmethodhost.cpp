@@ -13,16 +13,20 @@
 
 #include <maliit/plugins/abstractinputmethodhost.h>
 #include <maliit/plugins/subviewdescription.h>
+#include "abstractinputmethodhost_p.h"
 
-class MAbstractInputMethodHostPrivate
+#include <QThreadPool>
+
+namespace
 {
-public:
-    MAbstractInputMethodHostPrivate();
-    ~MAbstractInputMethodHostPrivate();
-};
+    // Shared by all plugins, so that they do not compete with each other
+    // for threads of the global pool.
+    Q_GLOBAL_STATIC(QThreadPool, workerPool)
+}
 
 
 MAbstractInputMethodHostPrivate::MAbstractInputMethodHostPrivate()
+    : generation(new QAtomicInt(0))
 {
 }
 
@@ -31,6 +35,51 @@ MAbstractInputMethodHostPrivate::~MAbstractInputMethodHostPrivate()
 }
 
 
+MImWorkerTask::MImWorkerTask(const std::function<QVariant ()> &newTask,
+                             QObject *newContext,
+                             const std::function<void (const QVariant &)> &newCallback,
+                             const QSharedPointer<QAtomicInt> &newGeneration)
+    : task(newTask),
+      context(newContext),
+      callback(newCallback),
+      generation(newGeneration),
+      tag(newGeneration->load()),
+      finished(false)
+{
+    setAutoDelete(false);
+}
+
+void MImWorkerTask::run()
+{
+    // Tasks which became stale while queued are not run at all.
+    if (!isStale()) {
+        result = task();
+        finished = true;
+    }
+
+    QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+int MImWorkerTask::taskGeneration() const
+{
+    return tag;
+}
+
+void MImWorkerTask::deliver()
+{
+    if (finished && context && !isStale()) {
+        callback(result);
+    }
+
+    deleteLater();
+}
+
+bool MImWorkerTask::isStale() const
+{
+    return generation->load() != tag;
+}
+
+
 MAbstractInputMethodHost::MAbstractInputMethodHost(QObject *parent)
     : QObject(parent),
       d(new MAbstractInputMethodHostPrivate)
@@ -58,3 +107,28 @@ MAbstractInputMethodHost::surroundingSubViewDescriptions(Maliit::HandlerState /*
 void MAbstractInputMethodHost::setLanguage(const QString &/*language*/)
 {
 }
+
+int MAbstractInputMethodHost::editorStateGeneration() const
+{
+    return d->generation->load();
+}
+
+bool MAbstractInputMethodHost::isStale(int generation) const
+{
+    return d->generation->load() != generation;
+}
+
+int MAbstractInputMethodHost::runTask(const std::function<QVariant ()> &task,
+                                      QObject *context,
+                                      const std::function<void (const QVariant &)> &callback)
+{
+    MImWorkerTask *workerTask = new MImWorkerTask(task, context, callback, d->generation);
+    workerPool()->start(workerTask);
+
+    return workerTask->taskGeneration();
+}
+
+void MAbstractInputMethodHost::advanceEditorStateGeneration()
+{
+    d->generation->ref();
+}
@@ -22,6 +22,8 @@
 
 #include <maliit/namespace.h>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 class QString;
 class QRegion;
@@ -311,6 +313,49 @@ public:
                                                                           Maliit::SettingEntryType type,
                                                                           const QVariantMap &attributes) = 0;
 
+    /*!
+     * \brief Returns the current editor state generation.
+     *
+     * The generation advances whenever a key press, a focus change or a
+     * change of the editor content reaches the input method, making work
+     * based on the previous editor state stale. Key releases and widget
+     * states merely echoing the preedit or commit string the input method
+     * sent itself do not advance it.
+     */
+    int editorStateGeneration() const;
+
+    /*!
+     * \brief Returns true if work tagged with \a generation is stale.
+     *
+     * Can be called from worker threads, so that long running tasks can give
+     * up early.
+     */
+    bool isStale(int generation) const;
+
+    /*!
+     * \brief Runs \a task on the worker thread pool shared by all plugins.
+     * \param task work to run on a worker thread; it must not use the host,
+     *  the input method or any GUI object
+     * \param context receiver of the result; the result is dropped if it is
+     *  destroyed in the meantime
+     * \param callback called with the value returned by \a task, on the
+     *  thread runTask() was called from
+     *
+     * The task is tagged with the current editor state generation. If the
+     * generation advances before the task starts it is not run, and if it
+     * advances before the result is delivered the result is dropped, so
+     * \a callback only ever sees results matching the current editor state.
+     *
+     * Returns the generation the task was tagged with.
+     */
+    int runTask(const std::function<QVariant ()> &task,
+                QObject *context,
+                const std::function<void (const QVariant &result)> &callback);
+
+protected:
+    //! Advances the editor state generation, making all pending tasks stale.
+    void advanceEditorStateGeneration();
+
 private:
     Q_DISABLE_COPY(MAbstractInputMethodHost)
     Q_DECLARE_PRIVATE(MAbstractInputMethodHost)
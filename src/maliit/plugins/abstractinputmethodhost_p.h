@@ -0,0 +1,67 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MABSTRACTINPUTMETHODHOST_P_H
+#define MABSTRACTINPUTMETHODHOST_P_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QVariant>
+
+#include <functional>
+
+class MAbstractInputMethodHostPrivate
+{
+public:
+    MAbstractInputMethodHostPrivate();
+    ~MAbstractInputMethodHostPrivate();
+
+    //! Editor state generation, shared with tasks which may outlive the host
+    QSharedPointer<QAtomicInt> generation;
+};
+
+//! \internal
+//! Runs a task submitted through MAbstractInputMethodHost::runTask() on the
+//! worker pool and hands its result back to the submitting thread.
+class MImWorkerTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    MImWorkerTask(const std::function<QVariant ()> &task,
+                  QObject *context,
+                  const std::function<void (const QVariant &)> &callback,
+                  const QSharedPointer<QAtomicInt> &generation);
+
+    //! \reimp
+    virtual void run();
+    //! \reimp_end
+
+    int taskGeneration() const;
+
+private Q_SLOTS:
+    void deliver();
+
+private:
+    bool isStale() const;
+
+    std::function<QVariant ()> task;
+    QPointer<QObject> context;
+    std::function<void (const QVariant &)> callback;
+    QSharedPointer<QAtomicInt> generation;
+    const int tag;
+    QVariant result;
+    bool finished;
+};
+//! \internal_end
+
+#endif // MABSTRACTINPUTMETHODHOST_P_H
@@ -32,7 +32,8 @@ public:
     //! Defines valid types for input method extension event
     enum Type {
         None,
-        Update
+        Update,
+        KeyOverrides
     };
 
     explicit MImExtensionEvent(Type type);
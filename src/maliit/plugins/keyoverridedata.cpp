@@ -17,13 +17,14 @@
 
 namespace
 {
-    inline bool keyOverrideLessThan(const QSharedPointer<MKeyOverride> &k1, const QSharedPointer<MKeyOverride> &k2)
-    {
-        return (k1->keyId() < k2->keyId());
-    };
+    // Revisions are unique across all key override sets, so that a set
+    // replacing another one under the same extension id never reuses a
+    // revision of its predecessor. Only used from the main thread.
+    int lastRevision = 0;
 }
 
 MKeyOverrideData::MKeyOverrideData()
+    : mRevision(0)
 {
 }
 
@@ -33,9 +34,18 @@ MKeyOverrideData::~MKeyOverrideData()
 
 QList<QSharedPointer<MKeyOverride> > MKeyOverrideData::keyOverrides() const
 {
-    QList<QSharedPointer<MKeyOverride> > results = mKeyOverrides.values();
-    std::sort(results.begin(), results.end(), keyOverrideLessThan);
-    return results;
+    // QMap iterates in key order, so the values are already sorted by key Id
+    return mKeyOverrides.values();
+}
+
+QMap<QString, QSharedPointer<MKeyOverride> > MKeyOverrideData::keyOverrideMap() const
+{
+    return mKeyOverrides;
+}
+
+int MKeyOverrideData::revision() const
+{
+    return mRevision;
 }
 
 bool MKeyOverrideData::createKeyOverride(const QString &keyId)
@@ -44,6 +54,7 @@ bool MKeyOverrideData::createKeyOverride(const QString &keyId)
         QSharedPointer<MKeyOverride> keyOverride;
         keyOverride = QSharedPointer<MKeyOverride>(new MKeyOverride(keyId));
         mKeyOverrides.insert(keyId, keyOverride);
+        mRevision = ++lastRevision;
         return true;
     }
     return false;
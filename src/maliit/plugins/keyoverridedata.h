@@ -49,6 +49,18 @@ public:
      */
     QList<QSharedPointer<MKeyOverride> > keyOverrides() const;
 
+    /*!
+     * \brief Return all key overrides mapped by key Id.
+     * The returned map is an implicitly shared snapshot, it is not copied
+     * until a key override is created.
+     */
+    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrideMap() const;
+
+    //! Returns the revision of the key override set, increased every time a
+    //! key override is created. Revisions are unique across all sets, except
+    //! for 0, the revision of every empty set.
+    int revision() const;
+
     //! Returns true if a new key override is created.
     bool createKeyOverride(const QString &keyId);
 
@@ -59,6 +71,7 @@ protected:
 
     typedef QMap<QString, QSharedPointer<MKeyOverride> > KeyOverrides;
     KeyOverrides mKeyOverrides;
+    int mRevision;
 
     friend class Ut_MKeyOverrideData;
 };
@@ -0,0 +1,54 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include <maliit/plugins/keyoverridesevent.h>
+#include <maliit/plugins/keyoverridesevent_p.h>
+#include <maliit/plugins/keyoverride.h>
+
+MImKeyOverridesEventPrivate::MImKeyOverridesEventPrivate(const QMap<QString, QSharedPointer<MKeyOverride> > &newOverrides,
+                                                         int newRevision,
+                                                         const QStringList &newChangedKeys,
+                                                         bool newReplaced)
+    : overrides(newOverrides)
+    , revision(newRevision)
+    , changedKeys(newChangedKeys)
+    , replaced(newReplaced)
+{}
+
+MImKeyOverridesEvent::MImKeyOverridesEvent(const QMap<QString, QSharedPointer<MKeyOverride> > &overrides,
+                                           int revision,
+                                           const QStringList &changedKeys,
+                                           bool replaced)
+    : MImExtensionEvent(new MImKeyOverridesEventPrivate(overrides, revision, changedKeys, replaced),
+                        MImExtensionEvent::KeyOverrides)
+{}
+
+QMap<QString, QSharedPointer<MKeyOverride> > MImKeyOverridesEvent::keyOverrides() const
+{
+    Q_D(const MImKeyOverridesEvent);
+    return d->overrides;
+}
+
+int MImKeyOverridesEvent::revision() const
+{
+    Q_D(const MImKeyOverridesEvent);
+    return d->revision;
+}
+
+QStringList MImKeyOverridesEvent::changedKeys() const
+{
+    Q_D(const MImKeyOverridesEvent);
+    return d->changedKeys;
+}
+
+bool MImKeyOverridesEvent::replaced() const
+{
+    Q_D(const MImKeyOverridesEvent);
+    return d->replaced;
+}
@@ -0,0 +1,63 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMKEYOVERRIDESEVENT_H
+#define MIMKEYOVERRIDESEVENT_H
+
+#include <maliit/plugins/extensionevent.h>
+
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+
+class MImKeyOverridesEventPrivate;
+class MKeyOverride;
+
+/*! \ingroup pluginapi
+ * \brief Notifies the input method about changed key overrides.
+ *
+ * Sent through MAbstractInputMethod::imExtensionEvent() before falling back
+ * to MAbstractInputMethod::setKeyOverrides(). An input method that handles
+ * this event (returns true) only needs to look at changedKeys() instead of
+ * rebuilding its whole key map. Attribute changes of existing keys are not
+ * sent here, they are signalled by the shared MKeyOverride instances.
+ */
+class MImKeyOverridesEvent
+    : public MImExtensionEvent
+{
+public:
+    //! C'tor
+    //! \param overrides shared snapshot of all key overrides, sorted by key id.
+    //! \param revision revision of the snapshot, increases when keys are added.
+    //! \param changedKeys ids of the keys added since the previous event.
+    //! \param replaced true if the snapshot belongs to a different extension
+    //!        than the previous one, in which case all keys are listed as changed.
+    explicit MImKeyOverridesEvent(const QMap<QString, QSharedPointer<MKeyOverride> > &overrides,
+                                  int revision,
+                                  const QStringList &changedKeys,
+                                  bool replaced);
+
+    //! Returns the shared snapshot of all key overrides.
+    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides() const;
+
+    //! Returns the revision of the snapshot.
+    int revision() const;
+
+    //! Returns ids of keys that changed compared to the last event.
+    QStringList changedKeys() const;
+
+    //! Returns whether the whole set of key overrides was replaced.
+    bool replaced() const;
+
+private:
+    Q_DISABLE_COPY(MImKeyOverridesEvent)
+    Q_DECLARE_PRIVATE(MImKeyOverridesEvent)
+};
+
+#endif // MIMKEYOVERRIDESEVENT_H
@@ -0,0 +1,36 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMKEYOVERRIDESEVENT_P_H
+#define MIMKEYOVERRIDESEVENT_P_H
+
+#include <maliit/plugins/extensionevent_p.h>
+
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+
+class MKeyOverride;
+
+class MImKeyOverridesEventPrivate
+    : public MImExtensionEventPrivate
+{
+public:
+    QMap<QString, QSharedPointer<MKeyOverride> > overrides;
+    int revision;
+    QStringList changedKeys;
+    bool replaced;
+
+    explicit MImKeyOverridesEventPrivate(const QMap<QString, QSharedPointer<MKeyOverride> > &newOverrides,
+                                         int newRevision,
+                                         const QStringList &newChangedKeys,
+                                         bool newReplaced);
+};
+
+#endif // MIMKEYOVERRIDESEVENT_P_H
@@ -28,13 +28,21 @@ public:
 
     //! Contains true if this plugin is enabled onscreen plugin.
     bool enabled;
+
+    //! Contains true if the input method of this plugin is loaded.
+    bool loaded;
+
+    //! Estimated memory held by this plugin, in bytes.
+    qint64 memoryEstimate;
 };
 //! \internal_end
 
 
 MImPluginDescriptionPrivate::MImPluginDescriptionPrivate(const Maliit::Plugins::InputMethodPlugin &plugin)
     : pluginName(plugin.name()),
-    enabled(true)
+    enabled(true),
+    loaded(true),
+    memoryEstimate(0)
 {
 }
 
@@ -79,3 +87,25 @@ void MImPluginDescription::setEnabled(bool newEnabled)
     d->enabled = newEnabled;
 }
 
+
+bool MImPluginDescription::loaded() const
+{
+    Q_D(const MImPluginDescription);
+
+    return d->loaded;
+}
+
+qint64 MImPluginDescription::memoryEstimate() const
+{
+    Q_D(const MImPluginDescription);
+
+    return d->memoryEstimate;
+}
+
+void MImPluginDescription::setLoaded(bool newLoaded, qint64 newMemoryEstimate)
+{
+    Q_D(MImPluginDescription);
+
+    d->loaded = newLoaded;
+    d->memoryEstimate = newMemoryEstimate;
+}
@@ -46,6 +46,13 @@ public:
     //! \brief Return true if this plugin is enabled by settings.
     bool enabled() const;
 
+    //! \brief Return true if the input method of this plugin is loaded,
+    //! false if it was evicted while idle.
+    bool loaded() const;
+
+    //! \brief Return the estimated memory held by this plugin, in bytes.
+    qint64 memoryEstimate() const;
+
 private:
     //! Constructor
     //! \param plugin Reference to loaded plugin.
@@ -54,6 +61,9 @@ private:
     //! Set enabled state to given value.
     void setEnabled(bool newEnabled);
 
+    //! Set loaded state and memory estimate to given values.
+    void setLoaded(bool newLoaded, qint64 newMemoryEstimate);
+
     Q_DECLARE_PRIVATE(MImPluginDescription)
 
     MImPluginDescriptionPrivate * const d_ptr;
@@ -29,6 +29,7 @@ namespace Maliit
 
 StandaloneInputMethod::StandaloneInputMethod(Maliit::Plugins::InputMethodPlugin *plugin)
     : QObject()
+    , mPluginId(plugin->name())
     , mConnection(createConnection())
     , mPlatform(createPlatform().release())
     , mWindowGroup(new WindowGroup(mPlatform))
@@ -37,10 +38,16 @@ StandaloneInputMethod::StandaloneInputMethod(Maliit::Plugins::InputMethodPlugin
 {
     connect(mConnection.get(), &MInputContextConnection::showInputMethodRequest,
             mWindowGroup.get(), &WindowGroup::activate);
-            connect(mConnection.get(), &MInputContextConnection::showInputMethodRequest,
-            mInputMethod.get(), &MAbstractInputMethod::show);
+    connect(mConnection.get(), &MInputContextConnection::showInputMethodRequest,
+            mInputMethod.get(), [this]() {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::Show);
+        mInputMethod->show();
+    });
     connect(mConnection.get(), &MInputContextConnection::hideInputMethodRequest,
-            mInputMethod.get(), &MAbstractInputMethod::hide);
+            mInputMethod.get(), [this]() {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::Hide);
+        mInputMethod->hide();
+    });
     connect(mConnection.get(), &MInputContextConnection::hideInputMethodRequest,
             mWindowGroup.get(), [this]() { mWindowGroup->deactivate(Maliit::WindowGroup::HideDelayed); } );
 
@@ -48,24 +55,43 @@ StandaloneInputMethod::StandaloneInputMethod(Maliit::Plugins::InputMethodPlugin
             mWindowGroup.get(), &WindowGroup::setApplicationWindow);
 
     connect(mConnection.get(), &MInputContextConnection::resetInputMethodRequest,
-            mInputMethod.get(), &MAbstractInputMethod::reset);
+            mInputMethod.get(), [this]() {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::Reset);
+        mInputMethod->reset();
+    });
 
     connect(mConnection.get(), &MInputContextConnection::activeClientDisconnected,
-            mInputMethod.get(), &MAbstractInputMethod::handleClientChange);
+            mInputMethod.get(), [this]() { handleClientChange(); });
     connect(mConnection.get(), &MInputContextConnection::clientActivated,
-            mInputMethod.get(), &MAbstractInputMethod::handleClientChange);
+            mInputMethod.get(), [this]() { handleClientChange(); });
 
     connect(mConnection.get(), &MInputContextConnection::contentOrientationAboutToChangeCompleted,
-            mInputMethod.get(), &MAbstractInputMethod::handleAppOrientationAboutToChange);
+            mInputMethod.get(), [this](int angle) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::HandleAppOrientationAboutToChange);
+        mInputMethod->handleAppOrientationAboutToChange(angle);
+    });
     connect(mConnection.get(), &MInputContextConnection::contentOrientationChangeCompleted,
-            mInputMethod.get(), &MAbstractInputMethod::handleAppOrientationChanged);
+            mInputMethod.get(), [this](int angle) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::HandleAppOrientationChanged);
+        mInputMethod->handleAppOrientationChanged(angle);
+    });
 
     connect(mConnection.get(), &MInputContextConnection::preeditChanged,
-            mInputMethod.get(), &MAbstractInputMethod::setPreedit);
+            mInputMethod.get(), [this](const QString &text, int cursorPos) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::SetPreedit);
+        mInputMethod->setPreedit(text, cursorPos);
+    });
 //    connect(mConnection.get(), &MInputContextConnection::mouseClickedOnPreedit,
 //            mInputMethod.get(), &MAbstractInputMethod::handleMouseClickOnPreedit);
     connect(mConnection.get(), &MInputContextConnection::receivedKeyEvent,
-            mInputMethod.get(), &MAbstractInputMethod::processKeyEvent);
+            mInputMethod.get(), [this](QEvent::Type keyType, Qt::Key keyCode,
+                                       Qt::KeyboardModifiers modifiers, const QString &text,
+                                       bool autoRepeat, int count, quint32 nativeScanCode,
+                                       quint32 nativeModifiers, unsigned long time) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::ProcessKeyEvent);
+        mInputMethod->processKeyEvent(keyType, keyCode, modifiers, text, autoRepeat, count,
+                                      nativeScanCode, nativeModifiers, time);
+    });
 
     connect(mConnection.get(), &MInputContextConnection::widgetStateChanged,
             this, &StandaloneInputMethod::handleWidgetStateChanged);
@@ -79,6 +105,12 @@ StandaloneInputMethod::~StandaloneInputMethod()
 {
 }
 
+void StandaloneInputMethod::handleClientChange()
+{
+    MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::HandleClientChange);
+    mInputMethod->handleClientChange();
+}
+
 void StandaloneInputMethod::handleWidgetStateChanged(unsigned int,
                                                      const QMap<QString, QVariant> &newState,
                                                      const QMap<QString, QVariant> &oldState,
@@ -103,11 +135,13 @@ void StandaloneInputMethod::handleWidgetStateChanged(unsigned int,
     const bool widgetFocusState = newState.value(FocusStateAttribute).toBool();
 
     if (focusChanged) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::HandleFocusChange);
         mInputMethod->handleFocusChange(widgetFocusState);
     }
 
     // call notification methods if needed
     if (oldVisualization != newVisualization) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::HandleVisualizationPriorityChange);
         mInputMethod->handleVisualizationPriorityChange(newVisualization);
     }
 
@@ -116,13 +150,20 @@ void StandaloneInputMethod::handleWidgetStateChanged(unsigned int,
 
     // general notification last
     if (!changedProperties.isEmpty()) {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::ImExtensionEvent);
         mInputMethod->imExtensionEvent(&ev);
     }
-    mInputMethod->update();
+    {
+        MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::Update);
+        mInputMethod->update();
+    }
 
     // Make sure windows get hidden when no longer focus
     if (!widgetFocusState) {
-        mInputMethod->hide();
+        {
+            MImPluginCallGuard guard(&mWatchdog, mPluginId, MImPluginWatchdog::Hide);
+            mInputMethod->hide();
+        }
         mWindowGroup->deactivate(Maliit::WindowGroup::HideDelayed);
     }
 }
@@ -15,6 +15,8 @@
 #include <QtCore/QObject>
 #include <QtCore/QSharedPointer>
 
+#include "mimpluginwatchdog.h"
+
 #include <memory>
 
 class MAbstractInputMethod;
@@ -40,11 +42,14 @@ public:
     ~StandaloneInputMethod();
 
 private:
+    void handleClientChange();
     void handleWidgetStateChanged(unsigned int clientId,
                                   const QMap<QString, QVariant> &newState,
                                   const QMap<QString, QVariant> &oldState,
                                   bool focusChanged);
 
+    MImPluginWatchdog mWatchdog;
+    const QString mPluginId;
     std::unique_ptr<MInputContextConnection> mConnection;
     QSharedPointer<AbstractPlatform> mPlatform; // TODO use std::unique_ptr instead
     std::unique_ptr<WindowGroup> mWindowGroup;
@@ -22,16 +22,24 @@ namespace {
 }
 
 MAttributeExtensionId::MAttributeExtensionId()
-    : m_id(InvalidId)
+    : m_id(InvalidId),
+      m_clientId(0)
 {
 }
 
 MAttributeExtensionId::MAttributeExtensionId(int id, const QString &service)
     : m_id(id),
+      m_clientId(0),
       m_service(service)
 {
 }
 
+MAttributeExtensionId::MAttributeExtensionId(int id, unsigned int clientId)
+    : m_id(id),
+      m_clientId(clientId)
+{
+}
+
 MAttributeExtensionId MAttributeExtensionId::standardAttributeExtensionId()
 {
     return MAttributeExtensionId(StandardId, QString());
@@ -39,12 +47,13 @@ MAttributeExtensionId MAttributeExtensionId::standardAttributeExtensionId()
 
 bool MAttributeExtensionId::isValid() const
 {
-    return m_id >= 0 && !m_service.isEmpty();
+    return m_id >= 0 && (m_clientId != 0 || !m_service.isEmpty());
 }
 
 bool MAttributeExtensionId::operator==(const MAttributeExtensionId &other) const
 {
-    return (m_id == other.m_id) && (m_service == other.m_service);
+    return (m_id == other.m_id) && (m_clientId == other.m_clientId)
+            && (m_service == other.m_service);
 }
 
 bool MAttributeExtensionId::operator!=(const MAttributeExtensionId &other) const
@@ -54,9 +63,17 @@ bool MAttributeExtensionId::operator!=(const MAttributeExtensionId &other) const
 
 QString MAttributeExtensionId::service() const
 {
+    if (m_service.isEmpty() && m_clientId != 0) {
+        return QString::number(m_clientId);
+    }
     return m_service;
 }
 
+unsigned int MAttributeExtensionId::clientId() const
+{
+    return m_clientId;
+}
+
 int MAttributeExtensionId::id() const
 {
     return m_id;
@@ -64,6 +81,6 @@ int MAttributeExtensionId::id() const
 
 uint qHash(const MAttributeExtensionId &id)
 {
-    return qHash(QPair<int, QString>(id.m_id, id.m_service));
+    return qHash(QPair<int, unsigned int>(id.m_id, id.m_clientId)) ^ qHash(id.m_service);
 }
 
@@ -34,6 +34,11 @@ public:
     //! Construct identifier with given application \a id and \a service name.
     MAttributeExtensionId(int id, const QString &service);
 
+    //! Construct identifier with given application \a id and input context \a clientId.
+    //! This is the form used for extensions registered over a connection and
+    //! does not allocate.
+    MAttributeExtensionId(int id, unsigned int clientId);
+
     //! Return identifier for standard attribute extension
     static MAttributeExtensionId standardAttributeExtensionId();
 
@@ -49,6 +54,9 @@ public:
     //! \return service part of the ID, given to constructor
     QString service() const;
 
+    //! \return connection the ID belongs to, or 0 if constructed from a service name
+    unsigned int clientId() const;
+
     //! Id given by application
     int id() const;
 
@@ -56,6 +64,9 @@ private:
     //! Id given by application
     int m_id;
 
+    //! Connection the extension was registered on
+    unsigned int m_clientId;
+
     //! Unique application identifier
     QString m_service;
 
@@ -132,16 +132,20 @@ void MAttributeExtensionManager::setToolbarItemAttribute(const MAttributeExtensi
 QMap<QString, QSharedPointer<MKeyOverride> > MAttributeExtensionManager::keyOverrides(
         const MAttributeExtensionId &id) const
 {
-    QList<QSharedPointer<MKeyOverride> > overrides;
     QSharedPointer<MAttributeExtension> extension = attributeExtension(id);
     if (extension) {
-        overrides = extension->keyOverrideData()->keyOverrides();
+        return extension->keyOverrideData()->keyOverrideMap();
     }
-    QMap<QString, QSharedPointer<MKeyOverride> > overridesMap;
-    Q_FOREACH (const QSharedPointer<MKeyOverride> &override, overrides) {
-        overridesMap.insert(override->keyId(), override);
+    return QMap<QString, QSharedPointer<MKeyOverride> >();
+}
+
+int MAttributeExtensionManager::keyOverridesRevision(const MAttributeExtensionId &id) const
+{
+    QSharedPointer<MAttributeExtension> extension = attributeExtension(id);
+    if (extension) {
+        return extension->keyOverrideData()->revision();
     }
-    return overridesMap;
+    return -1;
 }
 
 void MAttributeExtensionManager::setExtendedAttribute(const MAttributeExtensionId &id,
@@ -194,18 +198,18 @@ void MAttributeExtensionManager::setExtendedAttribute(const MAttributeExtensionI
 }
 
 
+bool MAttributeExtensionManager::isRegisteredByClient(unsigned int clientId, int id) const
+{
+    ClientExtensionIndex::const_iterator iterator(clientExtensionIds.constFind(clientId));
+    return iterator != clientExtensionIds.constEnd() && iterator->contains(id);
+}
+
 void MAttributeExtensionManager::handleClientDisconnect(unsigned int clientId)
 {
     // unregister toolbars registered by the lost connection
-    const QString service(QString::number(clientId));
-    QSet<MAttributeExtensionId>::iterator i(attributeExtensionIds.begin());
-    while (i != attributeExtensionIds.end()) {
-        if ((*i).service() == service) {
-            unregisterAttributeExtension(*i);
-            i = attributeExtensionIds.erase(i);
-        } else {
-            ++i;
-        }
+    const QSet<int> ids(clientExtensionIds.take(clientId));
+    Q_FOREACH (int id, ids) {
+        unregisterAttributeExtension(MAttributeExtensionId(id, clientId));
     }
 }
 
@@ -213,8 +217,8 @@ void MAttributeExtensionManager::handleExtendedAttributeUpdate(unsigned int clie
                                    const QString &target, const QString &targetName,
                                    const QString &attribute, const QVariant &value)
 {
-    MAttributeExtensionId globalId(id, QString::number(clientId));
-    if (globalId.isValid() && attributeExtensionIds.contains(globalId)) {
+    MAttributeExtensionId globalId(id, clientId);
+    if (globalId.isValid() && isRegisteredByClient(clientId, id)) {
         setExtendedAttribute(globalId, target, targetName, attribute, value);
     }
 }
@@ -222,19 +226,24 @@ void MAttributeExtensionManager::handleExtendedAttributeUpdate(unsigned int clie
 void MAttributeExtensionManager::handleAttributeExtensionRegistered(unsigned int clientId,
                                                                   int id, const QString &attributeExtension)
 {
-    MAttributeExtensionId globalId(id, QString::number(clientId));
-    if (globalId.isValid() && !attributeExtensionIds.contains(globalId)) {
+    MAttributeExtensionId globalId(id, clientId);
+    if (globalId.isValid() && !isRegisteredByClient(clientId, id)) {
         registerAttributeExtension(globalId, attributeExtension);
-        attributeExtensionIds.insert(globalId);
+        clientExtensionIds[clientId].insert(id);
     }
 }
 
 void MAttributeExtensionManager::handleAttributeExtensionUnregistered(unsigned int clientId, int id)
 {
-    MAttributeExtensionId globalId(id, QString::number(clientId));
-    if (globalId.isValid() && attributeExtensionIds.contains(globalId)) {
+    MAttributeExtensionId globalId(id, clientId);
+    if (globalId.isValid() && isRegisteredByClient(clientId, id)) {
         unregisterAttributeExtension(globalId);
-        attributeExtensionIds.remove(globalId);
+
+        ClientExtensionIndex::iterator iterator(clientExtensionIds.find(clientId));
+        iterator->remove(id);
+        if (iterator->isEmpty()) {
+            clientExtensionIds.erase(iterator);
+        }
     }
 }
 
@@ -253,7 +262,7 @@ void MAttributeExtensionManager::handleWidgetStateChanged(unsigned int clientId,
     QVariant variant = newState[ToolbarIdAttribute];
     if (variant.isValid()) {
         // map toolbar id from local to global
-        newAttributeExtensionId = MAttributeExtensionId(variant.toInt(), QString::number(clientId));
+        newAttributeExtensionId = MAttributeExtensionId(variant.toInt(), clientId);
     }
     if (!newAttributeExtensionId.isValid()) {
         newAttributeExtensionId = MAttributeExtensionId::standardAttributeExtensionId();
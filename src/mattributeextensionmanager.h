@@ -80,6 +80,11 @@ public:
      */
     QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides(const MAttributeExtensionId &id) const;
 
+    /*!
+     *\brief Returns revision of the key overrides for given \a id, or -1 if \a id is not registered.
+     */
+    int keyOverridesRevision(const MAttributeExtensionId &id) const;
+
     /*!
      *\brief Returns whether registered attribute extensions contain \a id.
      */
@@ -156,7 +161,12 @@ private:
     AttributeExtensionContainer attributeExtensions;
 
     MAttributeExtensionId attributeExtensionId; //current attribute extension id
-    QSet<MAttributeExtensionId> attributeExtensionIds; //all attribute extension ids
+
+    typedef QHash<unsigned int, QSet<int> > ClientExtensionIndex;
+    //! local ids of the attribute extensions registered by each client
+    ClientExtensionIndex clientExtensionIds;
+
+    bool isRegisteredByClient(unsigned int clientId, int id) const;
 
     //! Copy/paste button status
     Maliit::CopyPasteState copyPasteStatus;
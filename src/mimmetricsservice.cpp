@@ -0,0 +1,118 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimmetricsservice.h"
+
+#include "mimmetrics.h"
+#include "logging.h"
+
+#include <QDBusConnection>
+#include <QStringList>
+
+namespace
+{
+    const char * const MetricsObjectPath = "/org/maliit/server/metrics";
+}
+
+MImMetricsService::MImMetricsService(const QSharedPointer<MImMetrics> &newMetrics, QObject *parent)
+    : QObject(parent)
+    , metrics(newMetrics)
+    , loggedCounters(MImMetrics::CounterCount)
+    , registered(false)
+{
+    connect(&logTimer, SIGNAL(timeout()), this, SLOT(logSummary()));
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    registered = bus.isConnected()
+            && bus.registerObject(QString::fromLatin1(MetricsObjectPath), this,
+                                  QDBusConnection::ExportAllSlots);
+    if (!registered) {
+        qCWarning(lcMaliitFw) << "Cannot publish metrics on the session bus";
+    }
+}
+
+MImMetricsService::~MImMetricsService()
+{
+    if (registered) {
+        QDBusConnection::sessionBus().unregisterObject(QString::fromLatin1(MetricsObjectPath));
+    }
+}
+
+void MImMetricsService::setLogInterval(int seconds)
+{
+    if (seconds > 0) {
+        for (int n = 0; n < MImMetrics::CounterCount; ++n) {
+            loggedCounters[n] = metrics->counter(static_cast<MImMetrics::Counter>(n));
+        }
+        logTimer.start(seconds * 1000);
+    } else {
+        logTimer.stop();
+    }
+}
+
+QVariantMap MImMetricsService::snapshot() const
+{
+    return metrics->snapshot();
+}
+
+QString MImMetricsService::summary() const
+{
+    QStringList parts;
+
+    for (int n = 0; n < MImMetrics::GaugeCount; ++n) {
+        const MImMetrics::Gauge gauge = static_cast<MImMetrics::Gauge>(n);
+        parts.append(QString::fromLatin1("%1=%2").arg(QLatin1String(MImMetrics::name(gauge)))
+                                                 .arg(metrics->gauge(gauge)));
+    }
+
+    for (int n = 0; n < MImMetrics::CounterCount; ++n) {
+        const MImMetrics::Counter counter = static_cast<MImMetrics::Counter>(n);
+        parts.append(QString::fromLatin1("%1=%2").arg(QLatin1String(MImMetrics::name(counter)))
+                                                 .arg(metrics->counter(counter)));
+    }
+
+    return parts.join(QLatin1Char(' '));
+}
+
+void MImMetricsService::logSummary()
+{
+    const double interval = logTimer.interval() / 1000.0;
+    QStringList rates;
+
+    // Rates over the last interval tell more about the current load than
+    // totals since startup.
+    for (int n = 0; n < MImMetrics::CounterCount; ++n) {
+        const MImMetrics::Counter counter = static_cast<MImMetrics::Counter>(n);
+        const qint64 value = metrics->counter(counter);
+
+        rates.append(QString::fromLatin1("%1=%2/s").arg(QLatin1String(MImMetrics::name(counter)))
+                                                   .arg((value - loggedCounters[n]) / interval, 0, 'f', 1));
+        loggedCounters[n] = value;
+    }
+
+    const QVariantMap histograms = metrics->snapshot().value(QStringLiteral("histograms")).toMap();
+    QStringList latencies;
+
+    for (QVariantMap::const_iterator iter = histograms.constBegin(); iter != histograms.constEnd(); ++iter) {
+        const QVariantMap values = iter.value().toMap();
+        if (values.value(QStringLiteral("count")).toLongLong() == 0) {
+            continue;
+        }
+        latencies.append(QString::fromLatin1("%1 p50<%2us p99<%3us")
+                         .arg(iter.key())
+                         .arg(values.value(QStringLiteral("p50Microseconds")).toLongLong())
+                         .arg(values.value(QStringLiteral("p99Microseconds")).toLongLong()));
+    }
+
+    qCInfo(lcMaliitFw).noquote() << "Metrics:" << summary();
+    qCInfo(lcMaliitFw).noquote() << "Metrics rates:" << rates.join(QLatin1Char(' '));
+    if (!latencies.isEmpty()) {
+        qCInfo(lcMaliitFw).noquote() << "Metrics plugin callbacks:" << latencies.join(QStringLiteral(", "));
+    }
+}
@@ -0,0 +1,61 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMMETRICSSERVICE_H
+#define MIMMETRICSSERVICE_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+class MImMetrics;
+
+//! \internal
+
+/*! \ingroup maliitserver
+ * \brief Publishes a metrics registry on the session bus and in the log.
+ *
+ * The registry is exported as /org/maliit/server/metrics with the
+ * org.maliit.server.Metrics interface, next to the server address object.
+ */
+class MImMetricsService : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.maliit.server.Metrics")
+
+public:
+    explicit MImMetricsService(const QSharedPointer<MImMetrics> &metrics, QObject *parent = 0);
+    ~MImMetricsService();
+
+    //! Logs a summary of the metrics every \a seconds; 0 stops logging.
+    void setLogInterval(int seconds);
+
+public Q_SLOTS:
+    //! Returns all metrics, see MImMetrics::snapshot()
+    QVariantMap snapshot() const;
+
+    //! Returns a one line summary of the metrics
+    QString summary() const;
+
+private Q_SLOTS:
+    void logSummary();
+
+private:
+    const QSharedPointer<MImMetrics> metrics;
+    QTimer logTimer;
+    //! Counter values at the previous log dump, to log rates
+    QVector<qint64> loggedCounters;
+    bool registered;
+};
+
+//! \internal_end
+
+#endif // MIMMETRICSSERVICE_H
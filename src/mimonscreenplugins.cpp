@@ -28,11 +28,6 @@ namespace
     const char * const EnabledSubViews = MALIIT_CONFIG_ROOT"onscreen/enabled";
     const char * const ActiveSubView   = MALIIT_CONFIG_ROOT"onscreen/active";
 
-    bool equalPlugin(const MImOnScreenPlugins::SubView &subView, const QString &plugin)
-    {
-        return subView.plugin == plugin;
-    }
-
     bool notEqualPlugin(const MImOnScreenPlugins::SubView &subView, const QString &plugin)
     {
         return subView.plugin != plugin;
@@ -62,17 +57,6 @@ namespace
 
         return result;
     }
-
-    QSet<QString> findEnabledPlugins(const QList<MImOnScreenPlugins::SubView> &enabledSubViews)
-    {
-        QSet<QString> result;
-
-        Q_FOREACH (const MImOnScreenPlugins::SubView &subView, enabledSubViews) {
-            result.insert(subView.plugin);
-        }
-
-        return result;
-    }
 }
 
 MImOnScreenPlugins::SubView::SubView()
@@ -112,14 +96,7 @@ MImOnScreenPlugins::MImOnScreenPlugins():
 
 bool MImOnScreenPlugins::isEnabled(const QString &plugin) const
 {
-    QList<MImOnScreenPlugins::SubView> mEnabledAndAvailableSubViews;
-
-    std::remove_copy_if(mEnabledSubViews.begin(), mEnabledSubViews.end(),
-                        std::back_inserter(mEnabledAndAvailableSubViews),
-                        std::tr1::bind(&MImOnScreenPlugins::isSubViewUnavailable, this, _1));
-
-    return std::find_if(mEnabledAndAvailableSubViews.begin(), mEnabledAndAvailableSubViews.end(),
-                        std::tr1::bind(equalPlugin, _1, plugin)) != mEnabledAndAvailableSubViews.end();
+    return enabledPlugins.contains(plugin);
 }
 
 bool MImOnScreenPlugins::isSubViewEnabled(const SubView &subView) const
@@ -149,11 +126,13 @@ void MImOnScreenPlugins::setAutoEnabledSubViews(const QList<MImOnScreenPlugins::
 {
     // Update the enabled subviews list without saving the configuration to disk
     mEnabledSubViews = subViews;
+    updateEnabledPlugins();
 }
 
 void MImOnScreenPlugins::updateAvailableSubViews(const QList<SubView> &availableSubViews)
 {
     mAvailableSubViews = availableSubViews;
+    updateEnabledPlugins();
 
     autoDetectActiveSubView();
 }
@@ -173,6 +152,7 @@ void MImOnScreenPlugins::updateEnabledSubviews()
     const QStringList &list = mEnabledSubViewsSettings.value().toStringList();
     const QList<SubView> oldEnabledSubviews = mEnabledSubViews;
     mEnabledSubViews = fromSettings(list);
+    updateEnabledPlugins();
 
     // Changed subviews cause emission of enabledPluginsChanged() signal
     // because some subview from the setting might not really exists and therefore
@@ -182,6 +162,20 @@ void MImOnScreenPlugins::updateEnabledSubviews()
     }
 }
 
+void MImOnScreenPlugins::updateEnabledPlugins()
+{
+    // isEnabled() is queried for every plugin on each switch, so keep the
+    // plugins having an enabled and available subview around instead of
+    // filtering mEnabledSubViews per call.
+    enabledPlugins.clear();
+
+    Q_FOREACH (const MImOnScreenPlugins::SubView &subView, mEnabledSubViews) {
+        if (isSubViewAvailable(subView)) {
+            enabledPlugins.insert(subView.plugin);
+        }
+    }
+}
+
 void MImOnScreenPlugins::updateActiveSubview()
 {
     const QString &active = mActiveSubViewSettings.value().toString();
@@ -74,6 +74,7 @@ private Q_SLOTS:
 private:
     void autoDetectActiveSubView();
     void autoDetectEnabledSubViews();
+    void updateEnabledPlugins();
 
 private:
     QList<SubView> mAvailableSubViews;
@@ -84,7 +85,7 @@ private:
     MImSettings mEnabledSubViewsSettings;
     MImSettings mActiveSubViewSettings;
 
-    QSet<QString> enabledPlugins; //should be updated when mEnabledSubViews is changed
+    QSet<QString> enabledPlugins; //plugins with an enabled and available subview, see updateEnabledPlugins()
     bool mAllSubviewsEnabled;
 
 };
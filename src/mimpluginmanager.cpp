@@ -22,6 +22,7 @@
 #include "mimsettings.h"
 #include "mimhwkeyboardtracker.h"
 #include <maliit/plugins/updateevent.h>
+#include <maliit/plugins/keyoverridesevent.h>
 #include "mimsubviewoverride.h"
 #include "maliit/namespaceinternal.h"
 #include <maliit/settingdata.h>
@@ -32,10 +33,13 @@
 
 #include <QDir>
 #include <QPluginLoader>
+#include <QRandomGenerator>
+#include <QTranslator>
 #include <QSignalMapper>
 #include <QWeakPointer>
 
 #include <QDebug>
+#include <algorithm>
 #include <deque>
 
 namespace
@@ -51,7 +55,47 @@ namespace
 
     const QString PluginRoot           = MALIIT_CONFIG_ROOT"plugins";
     const QString PluginSettings       = MALIIT_CONFIG_ROOT"pluginsettings";
+    const QString TranslationsDir      = MALIIT_PLUGINS_DATA_DIR"/translations";
     const QString MImAccesoryEnabled   = MALIIT_CONFIG_ROOT"accessoryenabled";
+    const QString MImStandbyMemoryBudget = MALIIT_CONFIG_ROOT"standbymemorybudget"; // in KiB
+    const QString MImPluginEvictionTimeout = MALIIT_CONFIG_ROOT"pluginevictiontimeout"; // in s
+    const QString MImPluginMemoryBudget  = MALIIT_CONFIG_ROOT"pluginmemorybudget"; // in KiB
+    const QString MImPluginCallBudgets   = MALIIT_CONFIG_ROOT"plugincallbudgets"; // call name -> ms
+    const QString MImStallThreshold      = MALIIT_CONFIG_ROOT"stallthreshold"; // in ms
+    const QString MImVisibilityDelay     = MALIIT_CONFIG_ROOT"visibilitydelay"; // in ms
+    const char * const DefaultCallBudget = "default";
+
+    // Show and hide requests of clients are resolved once per frame, unless
+    // configured otherwise
+    int visibilityDelay()
+    {
+        return MImSettings(MImVisibilityDelay).value(Maliit::WindowGroup::frameInterval()).toInt();
+    }
+
+    // Settings changes kept to bring subscribed clients up to date; older
+    // clients get the whole settings instead.
+    const int MaxSettingsChanges = 256;
+
+    // A client may hold a version from an earlier server instance. Each
+    // instance counts up from a random high half, so such a version is
+    // unlikely to match, even for servers started within the same second.
+    quint64 initialSettingsVersion()
+    {
+        return (quint64(QRandomGenerator::system()->generate()) << 32) | 1;
+    }
+
+    bool sameSettingsEntry(const MImPluginSettingsEntry &left, const MImPluginSettingsEntry &right)
+    {
+        return left.extension_key == right.extension_key && left.type == right.type
+                && left.description == right.description && left.value == right.value
+                && left.attributes == right.attributes;
+    }
+
+    bool lessRecentlyUsed(const QPair<qint64, Maliit::Plugins::InputMethodPlugin *> &left,
+                          const QPair<qint64, Maliit::Plugins::InputMethodPlugin *> &right)
+    {
+        return left.first < right.first;
+    }
 
     const char * const InputMethodItem = "inputMethod";
     const char * const LoadAll = "loadAll";
@@ -63,16 +107,33 @@ MIMPluginManagerPrivate::MIMPluginManagerPrivate(const QSharedPointer<MInputCont
     : parent(p),
       mICConnection(connection),
       imAccessoryEnabledConf(0),
+      standbyBudgetConf(0),
+      standbyUpdatePending(false),
+      evictionTimeoutConf(0),
+      pluginMemoryBudgetConf(0),
+      callBudgetsConf(0),
+      stallThresholdConf(0),
+      settingsVersion(initialSettingsVersion()),
+      settingsChangesStart(settingsVersion),
+      applicationWindow(0),
       q_ptr(0),
       visible(false),
+      visibilityState(visibilityDelay(), visibilityDelay()),
+      keyOverridesRevision(-1),
       onScreenPlugins(),
       lastOrientation(0),
       attributeExtensionManager(new MAttributeExtensionManager),
       sharedAttributeExtensionManager(new MSharedAttributeExtensionManager),
-      m_platform(platform)
+      m_platform(platform),
+      metrics(connection->metrics())
 {
     inputSourceToNameMap[Maliit::Hardware] = "hardware";
     inputSourceToNameMap[Maliit::Accessory] = "accessory";
+
+    evictionTimer.setSingleShot(true);
+    settingsPushTimer.setSingleShot(true);
+    usageClock.start();
+    watchdog.setMetrics(metrics);
 }
 
 
@@ -115,6 +176,8 @@ void MIMPluginManagerPrivate::loadPlugins()
 
     const QList<MImOnScreenPlugins::SubView> &availableSubViews = availablePluginsAndSubViews();
     onScreenPlugins.updateAvailableSubViews(availableSubViews);
+    invalidateSubViewRings();
+    scheduleEviction();
 
     Q_EMIT q->pluginsChanged();
 }
@@ -160,25 +223,46 @@ bool MIMPluginManagerPrivate::loadPlugin(const QDir &dir, const QString &fileNam
         return false;
     }
 
+    PluginDescription desc;
+    desc.inputMethod = 0;
+    desc.imHost = 0;
+    desc.lastSwitchDirection = Maliit::SwitchUndefined;
+    desc.pluginId = fileName;
+    desc.lastUsed = 0;
+
+    // only add valid plugin descriptions
+    if (!createInputMethod(plugin, desc)) {
+        qCWarning(lcMaliitFw) << Q_FUNC_INFO
+                              << "Creation of InputMethod failed:" << plugin->name() << dir.absoluteFilePath(fileName);
+        return false;
+    }
+
+    plugins.insert(plugin, desc);
+
+    Q_EMIT q->pluginLoaded();
+
+    return true;
+}
+
+bool MIMPluginManagerPrivate::createInputMethod(Maliit::Plugins::InputMethodPlugin *plugin,
+                                                PluginDescription &desc)
+{
+    Q_Q(MIMPluginManager);
+
     QSharedPointer<Maliit::WindowGroup> windowGroup(new Maliit::WindowGroup(m_platform));
+    windowGroup->setMetrics(metrics);
     MInputMethodHost *host = new MInputMethodHost(mICConnection, q, windowGroup,
-                                                  fileName, plugin->name());
+                                                  desc.pluginId, plugin->name());
 
     MAbstractInputMethod *im = plugin->createInputMethod(host);
 
     QObject::connect(q, SIGNAL(pluginsChanged()), host, SIGNAL(pluginsChanged()));
 
-    // only add valid plugin descriptions
     if (!im) {
-        qCWarning(lcMaliitFw) << Q_FUNC_INFO
-                              << "Creation of InputMethod failed:" << plugin->name() << dir.absoluteFilePath(fileName);
         delete host;
         return false;
     }
 
-    PluginDescription desc = { im, host, PluginState(),
-                               Maliit::SwitchUndefined, fileName, windowGroup };
-
     // Connect surface group signals
     QObject::connect(windowGroup.data(), &Maliit::WindowGroup::inputMethodAreaChanged,
                      q, [this](const QRegion &region) {
@@ -186,10 +270,40 @@ bool MIMPluginManagerPrivate::loadPlugin(const QDir &dir, const QString &fileNam
         mICConnection->updateInputMethodArea(region);
     });
 
-    plugins.insert(plugin, desc);
+    if (applicationWindow) {
+        windowGroup->setApplicationWindow(applicationWindow);
+    }
+
     host->setInputMethod(im);
 
-    Q_EMIT q->pluginLoaded();
+    desc.inputMethod = im;
+    desc.imHost = host;
+    desc.windowGroup = windowGroup;
+    desc.lastUsed = usageClock.elapsed();
+
+    updatePluginGauges();
+
+    return true;
+}
+
+bool MIMPluginManagerPrivate::ensurePluginLoaded(Maliit::Plugins::InputMethodPlugin *plugin)
+{
+    const Plugins::iterator iterator = plugins.find(plugin);
+    if (iterator == plugins.end()) {
+        return false;
+    }
+
+    if (iterator->inputMethod) {
+        return true;
+    }
+
+    if (!createInputMethod(plugin, *iterator)) {
+        qCWarning(lcMaliitFw) << Q_FUNC_INFO << "Reloading of InputMethod failed:" << iterator->pluginId;
+        return false;
+    }
+
+    qCDebug(lcMaliitFw) << Q_FUNC_INFO << "Reloaded evicted plugin" << iterator->pluginId;
+    iterator->evictedSubViews.clear();
 
     return true;
 }
@@ -201,9 +315,14 @@ void MIMPluginManagerPrivate::activatePlugin(Maliit::Plugins::InputMethodPlugin
         return;
     }
 
+    if (!ensurePluginLoaded(plugin)) {
+        return;
+    }
+
     MAbstractInputMethod *inputMethod = 0;
 
     activePlugins.insert(plugin);
+    standbyPlugins.remove(plugin);
     inputMethod = plugins.value(plugin).inputMethod;
     plugins.value(plugin).imHost->setEnabled(true);
 
@@ -215,8 +334,14 @@ void MIMPluginManagerPrivate::activatePlugin(Maliit::Plugins::InputMethodPlugin
                      SLOT(_q_setActiveSubView(QString, Maliit::HandlerState)));
 
 
-    inputMethod->handleAppOrientationChanged(lastOrientation);
+    {
+        MImPluginCallGuard guard(&watchdog, plugins.value(plugin).pluginId,
+                                 MImPluginWatchdog::HandleAppOrientationChanged);
+        inputMethod->handleAppOrientationChanged(lastOrientation);
+    }
     targets.insert(inputMethod);
+
+    updatePluginGauges();
 }
 
 
@@ -239,7 +364,7 @@ MImPluginSettingsInfo MIMPluginManagerPrivate::globalSettings() const
 
     Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, plugins.keys()) {
         const MIMPluginManagerPrivate::PluginDescription &descr = plugins[plugin];
-        QList<MAbstractInputMethod::MInputMethodSubView> subviews = descr.inputMethod->subViews();
+        QList<MAbstractInputMethod::MInputMethodSubView> subviews = pluginSubViews(descr, Maliit::OnScreen);
 
         Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subview, subviews) {
             domain.append(descr.pluginId + ":" + subview.subViewId);
@@ -293,11 +418,28 @@ void MIMPluginManagerPrivate::registerSettings()
 void MIMPluginManagerPrivate::registerSettings(const MImPluginSettingsInfo &info)
 {
     bool found = false;
+    bool changed = false;
 
     for (int i = 0; i < settings.size(); ++i) {
         if (settings[i].plugin_name == info.plugin_name) {
+            QList<MImPluginSettingsEntry> &entries = settings[i].entries;
+
             found = true;
-            settings[i].entries.append(info.entries);
+            // Registering a key again replaces its entry, e.g. when an
+            // evicted plugin is loaded again
+            Q_FOREACH (const MImPluginSettingsEntry &entry, info.entries) {
+                int index = 0;
+                while (index < entries.count() && entries[index].extension_key != entry.extension_key) {
+                    ++index;
+                }
+                if (index == entries.count()) {
+                    entries.append(entry);
+                    changed = true;
+                } else if (!sameSettingsEntry(entries[index], entry)) {
+                    entries[index] = entry;
+                    changed = true;
+                }
+            }
             break;
         }
     }
@@ -305,11 +447,211 @@ void MIMPluginManagerPrivate::registerSettings(const MImPluginSettingsInfo &info
     // No setting info for this plugin yet: add the whole entry
     if (!found) {
         settings.append(info);
+    } else if (!changed) {
+        return;
     }
 
     Q_FOREACH (const MImPluginSettingsEntry &entry, info.entries) {
         sharedAttributeExtensionManager->registerPluginSetting(entry.extension_key, entry.type, entry.attributes);
     }
+
+    invalidateSettingsSnapshots();
+    recordSettingsChange(info.plugin_name, QString());
+}
+
+
+const QList<MImPluginSettingsInfo> &MIMPluginManagerPrivate::settingsSnapshot(const QString &language)
+{
+    QHash<QString, QList<MImPluginSettingsInfo> >::iterator snapshot = settingsSnapshots.find(language);
+    if (snapshot != settingsSnapshots.end()) {
+        return *snapshot;
+    }
+
+    QList<MImPluginSettingsInfo> result = settings;
+
+    for (int i = 0; i < result.count(); ++i) {
+        MImPluginSettingsInfo &info = result[i];
+        QList<MImPluginSettingsEntry> &entries = info.entries;
+        // Catalogs are named after the plugin, e.g. libmaliit-keyboard-plugin.so_de.qm
+        QTranslator translator;
+        const bool translate = !language.isEmpty()
+                && translator.load(info.plugin_name + QLatin1Char('_') + language, TranslationsDir);
+        const QByteArray context = info.plugin_name.toUtf8();
+
+        info.description_language = language;
+        if (translate) {
+            const QString description = translator.translate(context.constData(),
+                                                             info.plugin_description.toUtf8().constData());
+            if (!description.isEmpty()) {
+                info.plugin_description = description;
+            }
+        }
+
+        for (int j = 0; j < entries.count(); ++j) {
+            MImPluginSettingsEntry &entry = entries[j];
+
+            if (translate) {
+                const QString description = translator.translate(context.constData(),
+                                                                 entry.description.toUtf8().constData());
+                if (!description.isEmpty()) {
+                    entry.description = description;
+                }
+            }
+            entry.value = MImSettings(entry.extension_key).value(entry.attributes.value(Maliit::SettingEntryAttributes::defaultValue));
+        }
+    }
+
+    return *settingsSnapshots.insert(language, result);
+}
+
+
+void MIMPluginManagerPrivate::invalidateSettingsSnapshots()
+{
+    settingsSnapshots.clear();
+    ++settingsVersion;
+}
+
+
+void MIMPluginManagerPrivate::updateSettingValue(const QString &key, const QVariant &value)
+{
+    QString pluginName;
+
+    Q_FOREACH (const MImPluginSettingsInfo &info, settings) {
+        Q_FOREACH (const MImPluginSettingsEntry &entry, info.entries) {
+            if (entry.extension_key == key) {
+                pluginName = info.plugin_name;
+                break;
+            }
+        }
+        if (!pluginName.isEmpty()) {
+            break;
+        }
+    }
+
+    if (pluginName.isEmpty()) {
+        invalidateSettingsSnapshots();
+        return;
+    }
+
+    // Translations do not depend on the value, so the snapshots stay valid
+    for (QHash<QString, QList<MImPluginSettingsInfo> >::iterator snapshot = settingsSnapshots.begin();
+         snapshot != settingsSnapshots.end(); ++snapshot) {
+        for (int i = 0; i < snapshot->count(); ++i) {
+            QList<MImPluginSettingsEntry> &entries = (*snapshot)[i].entries;
+
+            for (int j = 0; j < entries.count(); ++j) {
+                MImPluginSettingsEntry &entry = entries[j];
+
+                if (entry.extension_key == key) {
+                    entry.value = value.isValid()
+                            ? value : entry.attributes.value(Maliit::SettingEntryAttributes::defaultValue);
+                }
+            }
+        }
+    }
+
+    ++settingsVersion;
+    recordSettingsChange(pluginName, key);
+}
+
+
+void MIMPluginManagerPrivate::recordSettingsChange(const QString &pluginName, const QString &key)
+{
+    const SettingsChange change = { settingsVersion, pluginName, key };
+
+    settingsChanges.append(change);
+    while (settingsChanges.count() > MaxSettingsChanges) {
+        settingsChangesStart = settingsChanges.takeFirst().version;
+    }
+
+    if (!settingsSubscribers.isEmpty()) {
+        // Coalesces changes made in one go, e.g. by a plugin registering its settings
+        settingsPushTimer.start(0);
+    }
+}
+
+
+bool MIMPluginManagerPrivate::settingsChangesSince(quint64 version, const QString &language,
+                                                   QList<MImPluginSettingsInfo> &changed,
+                                                   QStringList &removedPlugins)
+{
+    if (version < settingsChangesStart || version > settingsVersion) {
+        return false;
+    }
+
+    // Changed keys by plugin; plugins in wholePlugins are sent with all entries
+    QHash<QString, QSet<QString> > changedKeys;
+    QSet<QString> wholePlugins;
+
+    Q_FOREACH (const SettingsChange &change, settingsChanges) {
+        if (change.version <= version) {
+            continue;
+        }
+        if (change.key.isEmpty()) {
+            wholePlugins.insert(change.pluginName);
+        }
+        changedKeys[change.pluginName].insert(change.key);
+    }
+
+    Q_FOREACH (const MImPluginSettingsInfo &info, settingsSnapshot(language)) {
+        QHash<QString, QSet<QString> >::iterator keys = changedKeys.find(info.plugin_name);
+        if (keys == changedKeys.end()) {
+            continue;
+        }
+
+        MImPluginSettingsInfo delta = info;
+        if (!wholePlugins.contains(info.plugin_name)) {
+            delta.entries.clear();
+            Q_FOREACH (const MImPluginSettingsEntry &entry, info.entries) {
+                if (keys->contains(entry.extension_key)) {
+                    delta.entries.append(entry);
+                }
+            }
+        }
+        changed.append(delta);
+        changedKeys.erase(keys);
+    }
+
+    // Whatever is left changed and is gone by now
+    removedPlugins = changedKeys.keys();
+
+    return true;
+}
+
+
+void MIMPluginManagerPrivate::sendSettingsSince(int clientId, const QString &language, quint64 version)
+{
+    QList<MImPluginSettingsInfo> changed;
+    QStringList removedPlugins;
+
+    if (version == settingsVersion) {
+        mICConnection->pluginSettingsUnchanged(clientId, settingsVersion);
+    } else if (version != 0 && settingsChangesSince(version, language, changed, removedPlugins)) {
+        mICConnection->pluginSettingsChanged(clientId, version, settingsVersion, changed, removedPlugins);
+    } else {
+        mICConnection->pluginSettingsSnapshotLoaded(clientId, settingsVersion, settingsSnapshot(language));
+    }
+}
+
+
+void MIMPluginManagerPrivate::subscribeSettings(int clientId, const QString &language, quint64 lastSeenVersion)
+{
+    const SettingsSubscriber subscriber = { language, settingsVersion };
+
+    settingsSubscribers.insert(clientId, subscriber);
+    sendSettingsSince(clientId, language, lastSeenVersion);
+}
+
+
+void MIMPluginManagerPrivate::pushSettingsChanges()
+{
+    for (QHash<int, SettingsSubscriber>::iterator subscriber = settingsSubscribers.begin();
+         subscriber != settingsSubscribers.end(); ++subscriber) {
+        if (subscriber->version != settingsVersion) {
+            sendSettingsSince(subscriber.key(), subscriber->language, subscriber->version);
+            subscriber->version = settingsVersion;
+        }
+    }
 }
 
 
@@ -346,9 +688,13 @@ void MIMPluginManagerPrivate::setActiveHandlers(const QSet<Maliit::HandlerState>
     // notify plugins about new states
     Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, activatedPlugins) {
         PluginDescription desc = plugins.value(plugin);
-        desc.inputMethod->setState(desc.state);
+        {
+            MImPluginCallGuard guard(&watchdog, desc.pluginId, MImPluginWatchdog::SetState);
+            desc.inputMethod->setState(desc.state);
+        }
         if (visible) {
             desc.windowGroup->activate();
+            MImPluginCallGuard guard(&watchdog, desc.pluginId, MImPluginWatchdog::Show);
             desc.inputMethod->show();
         }
     }
@@ -360,6 +706,8 @@ void MIMPluginManagerPrivate::setActiveHandlers(const QSet<Maliit::HandlerState>
             deactivatePlugin(plugin);  //activePlugins is modified here
         }
     }
+
+    scheduleStandbyUpdate();
 }
 
 
@@ -387,15 +735,25 @@ void MIMPluginManagerPrivate::deactivatePlugin(Maliit::Plugins::InputMethodPlugi
 
     Q_ASSERT(inputMethod);
 
-    inputMethod->hide();
-    inputMethod->reset();
+    {
+        MImPluginCallGuard guard(&watchdog, plugins.value(plugin).pluginId, MImPluginWatchdog::Hide);
+        inputMethod->hide();
+    }
+    {
+        MImPluginCallGuard guard(&watchdog, plugins.value(plugin).pluginId, MImPluginWatchdog::Reset);
+        inputMethod->reset();
+    }
 
     // this call disables normal behaviour on inputMethod->hide
     plugins.value(plugin).imHost->setEnabled(false);
 
     plugins[plugin].state = PluginState();
+    plugins[plugin].lastUsed = usageClock.elapsed();
     QObject::disconnect(inputMethod, 0, q, 0);
     targets.remove(inputMethod);
+
+    updatePluginGauges();
+    scheduleEviction();
 }
 
 void MIMPluginManagerPrivate::replacePlugin(Maliit::SwitchDirection direction,
@@ -410,12 +768,34 @@ void MIMPluginManagerPrivate::replacePlugin(Maliit::SwitchDirection direction,
         state << Maliit::OnScreen;
     MAbstractInputMethod *switchedTo = 0;
 
+    // A standby plugin already has the state and key overrides applied and
+    // only needs to be shown.
+    const StandbyPlugins::const_iterator standby = standbyPlugins.constFind(replacement.key());
+    const bool warm = standby != standbyPlugins.constEnd() && standby->state == state;
+    const MAttributeExtensionId standbyToolbarId = warm ? standby->toolbarId : MAttributeExtensionId();
+    const int standbyKeyOverridesRevision = warm ? standby->keyOverridesRevision : -1;
+
+    if (metrics) {
+        metrics->increment(MImMetrics::PluginSwitches);
+    }
+
     deactivatePlugin(source);
+    if (source && standbyMemoryBudget() > 0) {
+        // The source still has the state applied, so keep it on standby;
+        // updateStandbyPlugins() releases it unless it is a neighbour of the
+        // replacement.
+        StandbyPlugin previous = { state, toolbarId, keyOverridesRevision };
+        standbyPlugins.insert(source, previous);
+    }
     activatePlugin(replacement.key());
     switchedTo = replacement->inputMethod;
     replacement->state = state;
-    switchedTo->setState(state);
+    if (!warm) {
+        MImPluginCallGuard guard(&watchdog, replacement->pluginId, MImPluginWatchdog::SetState);
+        switchedTo->setState(state);
+    }
     if (state.contains(Maliit::OnScreen) && !subViewId.isNull()) {
+        MImPluginCallGuard guard(&watchdog, replacement->pluginId, MImPluginWatchdog::SetActiveSubView);
         switchedTo->setActiveSubView(subViewId);
     } else if (replacement->lastSwitchDirection == direction
                || (replacement->lastSwitchDirection == Maliit::SwitchUndefined
@@ -426,18 +806,27 @@ void MIMPluginManagerPrivate::replacePlugin(Maliit::SwitchDirection direction,
         // 2) if we have plugin A and B, and subviews A.0, A.1, A.2 and B.0, and B.0 is active,
         // and plugin A was not active since start of meego-im-uiserver,
         // then if we switch back to plugin A, we want to start with subview A.2, not A.0
+        MImPluginCallGuard guard(&watchdog, replacement->pluginId, MImPluginWatchdog::SwitchContext);
         switchedTo->switchContext(direction, false);
     }
     if (source) {
         plugins[source].lastSwitchDirection = direction;
     }
-    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
-        attributeExtensionManager->keyOverrides(toolbarId);
-    switchedTo->setKeyOverrides(keyOverrides);
+    const int revision = attributeExtensionManager->keyOverridesRevision(toolbarId);
+    if (!warm || standbyToolbarId != toolbarId || standbyKeyOverridesRevision != revision) {
+        const QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
+            attributeExtensionManager->keyOverrides(toolbarId);
+        sendKeyOverrides(switchedTo, keyOverrides, revision, keyOverrides.keys(), true);
+    }
 
     if (visible) {
         ensureActivePluginsVisible(DontShowInputMethod);
-        switchedTo->show();
+        {
+            MImPluginCallGuard guard(&watchdog, replacement->pluginId, MImPluginWatchdog::Show);
+            switchedTo->show();
+        }
+        MImPluginCallGuard guard(&watchdog, replacement->pluginId,
+                                 MImPluginWatchdog::ShowLanguageNotification);
         switchedTo->showLanguageNotification();
     }
 
@@ -449,6 +838,8 @@ void MIMPluginManagerPrivate::replacePlugin(Maliit::SwitchDirection direction,
         // Save the last active subview
         onScreenPlugins.setActiveSubView(MImOnScreenPlugins::SubView(replacement->pluginId, activeSubViewIdOnScreen));
     }
+
+    scheduleStandbyUpdate();
 }
 
 
@@ -475,6 +866,27 @@ bool MIMPluginManagerPrivate::switchPlugin(Maliit::SwitchDirection direction,
 
     Plugins::iterator source = iterator;
 
+    if (source->state.contains(Maliit::OnScreen)
+        && subViewRing(Maliit::OnScreen).pluginIndex.contains(source.key())) {
+        // Only enabled on-screen plugins can take over, walk their ring
+        // instead of probing every loaded plugin.
+        const int count = subViewRing(Maliit::OnScreen).plugins.size();
+        Plugins::const_iterator candidate = source;
+
+        for (int n = 0; n < count - 1; ++n) {
+            candidate = findEnabledPlugin(candidate, direction, Maliit::OnScreen);
+            if (candidate == plugins.constEnd()) {
+                break;
+            }
+
+            if (trySwitchPlugin(direction, source.key(), plugins.find(candidate.key()))) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     //find next inactive plugin and activate it
     for (int n = 0; n < plugins.size() - 1; ++n) {
         if (direction == Maliit::SwitchForward) {
@@ -504,11 +916,14 @@ bool MIMPluginManagerPrivate::switchPlugin(const QString &pluginId,
     //Find plugin initiated this switch
     Plugins::iterator iterator(plugins.begin());
 
-    for (; iterator != plugins.end(); ++iterator) {
+    for (; initiator && iterator != plugins.end(); ++iterator) {
         if (iterator->inputMethod == initiator) {
             break;
         }
     }
+    if (!initiator) {
+        iterator = plugins.end();
+    }
 
     Plugins::iterator source = iterator;
 
@@ -575,6 +990,10 @@ bool MIMPluginManagerPrivate::trySwitchPlugin(Maliit::SwitchDirection direction,
         }
     }
 
+    if (!ensurePluginLoaded(newPlugin)) {
+        return false;
+    }
+
     changeHandlerMap(source, newPlugin, newPlugin->supportedStates());
     replacePlugin(direction, source, replacement, subViewId);
 
@@ -586,6 +1005,41 @@ QString MIMPluginManagerPrivate::inputSourceName(Maliit::HandlerState source) co
     return inputSourceToNameMap.value(source);
 }
 
+void MIMPluginManagerPrivate::advanceEditorStateGeneration()
+{
+    Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, activePlugins) {
+        plugins.value(plugin).imHost->handleEditorStateChanged();
+    }
+}
+
+void MIMPluginManagerPrivate::handleWidgetStateChanged(const QMap<QString, QVariant> &oldState,
+                                                       const QMap<QString, QVariant> &newState,
+                                                       bool focusChanged)
+{
+    Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, activePlugins) {
+        plugins.value(plugin).imHost->handleWidgetStateChanged(oldState, newState, focusChanged);
+    }
+}
+
+void MIMPluginManagerPrivate::sendKeyOverrides(MAbstractInputMethod *target,
+                                               const QMap<QString, QSharedPointer<MKeyOverride> > &overrides,
+                                               int revision,
+                                               const QStringList &changedKeys,
+                                               bool replaced)
+{
+    MImKeyOverridesEvent ev(overrides, revision, changedKeys, replaced);
+    bool handled = false;
+
+    {
+        MImPluginCallGuard guard(&watchdog, pluginId(target), MImPluginWatchdog::ImExtensionEvent);
+        handled = target->imExtensionEvent(&ev);
+    }
+    if (!handled) {
+        MImPluginCallGuard guard(&watchdog, pluginId(target), MImPluginWatchdog::SetKeyOverrides);
+        target->setKeyOverrides(overrides);
+    }
+}
+
 void MIMPluginManagerPrivate::changeHandlerMap(Maliit::Plugins::InputMethodPlugin *origin,
                                                Maliit::Plugins::InputMethodPlugin *replacement,
                                                QSet<Maliit::HandlerState> states)
@@ -642,6 +1096,8 @@ QList<MImPluginDescription> MIMPluginManagerPrivate::pluginDescriptions(Maliit::
         const Maliit::Plugins::InputMethodPlugin * const plugin = iterator.key();
         if (plugin && plugin->supportedStates().contains(state)) {
             result.append(MImPluginDescription(*plugin));
+            result.last().setLoaded(iterator->inputMethod != 0,
+                                    pluginMemoryEstimate(iterator.key()));
 
             if (state == Maliit::OnScreen) {
                 result.last().setEnabled(onScreenPlugins.isEnabled(iterator->pluginId));
@@ -657,39 +1113,22 @@ MIMPluginManagerPrivate::findEnabledPlugin(Plugins::const_iterator current,
                                            Maliit::SwitchDirection direction,
                                            Maliit::HandlerState state) const
 {
-    MIMPluginManagerPrivate::Plugins::const_iterator iterator = current;
-    MIMPluginManagerPrivate::Plugins::const_iterator result = plugins.constEnd();
-
-    for (int n = 0; n < plugins.size() - 1; ++n) {
-        if (direction == Maliit::SwitchForward) {
-            ++iterator;
-            if (iterator == plugins.end()) {
-                iterator = plugins.begin();
-            }
-        } else if (direction == Maliit::SwitchBackward) { // Backward
-            if (iterator == plugins.begin()) {
-                iterator = plugins.end();
-            }
-            --iterator;
-        }
-
-        Maliit::Plugins::InputMethodPlugin *otherPlugin = iterator.key();
-        Q_ASSERT(otherPlugin);
-        const MIMPluginManagerPrivate::PluginState &supportedStates = otherPlugin->supportedStates();
-        if (!supportedStates.contains(state)) {
-            continue;
-        }
+    if (current == plugins.constEnd()
+        || (direction != Maliit::SwitchForward && direction != Maliit::SwitchBackward)) {
+        return plugins.constEnd();
+    }
 
-        if (state == Maliit::OnScreen
-            && not onScreenPlugins.isEnabled(iterator->pluginId)) {
-            continue;
-        }
+    const SubViewRing &ring = subViewRing(state);
+    const int index = ring.pluginIndex.value(current.key(), -1);
+    const int count = ring.plugins.size();
 
-        result = iterator;
-        break;
+    if (index < 0 || count <= 1) {
+        return plugins.constEnd();
     }
 
-    return result;
+    const int other = direction == Maliit::SwitchForward ? (index + 1) % count
+                                                         : (index + count - 1) % count;
+    return plugins.constFind(ring.plugins.at(other));
 }
 
 void MIMPluginManagerPrivate::filterEnabledSubViews(QMap<QString, QString> &subViews,
@@ -707,19 +1146,6 @@ void MIMPluginManagerPrivate::filterEnabledSubViews(QMap<QString, QString> &subV
     }
 }
 
-void MIMPluginManagerPrivate::append(QList<MImSubViewDescription> &list,
-                                     const QMap<QString, QString> &map,
-                                     const QString &pluginId) const
-{
-    for(QMap<QString, QString>::const_iterator iterator = map.constBegin();
-        iterator != map.constEnd();
-        ++iterator) {
-        MImSubViewDescription desc(pluginId, iterator.key(), iterator.value());
-
-        list.append(desc);
-    }
-}
-
 QList<MImSubViewDescription>
 MIMPluginManagerPrivate::surroundingSubViewDescriptions(Maliit::HandlerState state) const
 {
@@ -733,65 +1159,409 @@ MIMPluginManagerPrivate::surroundingSubViewDescriptions(Maliit::HandlerState sta
     Plugins::const_iterator iterator = plugins.find(plugin);
     Q_ASSERT(iterator != plugins.constEnd());
 
-    QString pluginId = iterator->pluginId;
-    QString subViewId = iterator->inputMethod->activeSubView(state);
-    QMap<QString, QString> subViews = availableSubViews(pluginId, state);
-    filterEnabledSubViews(subViews, pluginId, state);
+    const QPair<QString, QString> current(iterator->pluginId,
+                                          iterator->inputMethod->activeSubView(state));
+    const SubViewRing *ring = &subViewRing(state);
+    int index = ring->subViewIndex.value(current, -1);
 
-    if (plugins.size() == 1 && subViews.size() == 1) {
-        // there is one subview only
-        return result;
+    if (index < 0 && (state != Maliit::OnScreen
+                      || onScreenPlugins.isSubViewEnabled(MImOnScreenPlugins::SubView(current.first,
+                                                                                      current.second)))) {
+        // The plugin may have changed its subviews since the ring was built.
+        subViewRings.remove(state);
+        ring = &subViewRing(state);
+        index = ring->subViewIndex.value(current, -1);
     }
 
-    QList<MImSubViewDescription> enabledSubViews;
+    const int count = ring->subViews.size();
+    if (index < 0 || count <= 1) {
+        return result; //there is no other enabled subview
+    }
 
-    Plugins::const_iterator otherPlugin;
-    otherPlugin = findEnabledPlugin(iterator,
-                                    Maliit::SwitchBackward,
-                                    state);
+    result.append(ring->subViews.at((index + count - 1) % count));
+    result.append(ring->subViews.at((index + 1) % count));
 
-    if (otherPlugin != plugins.constEnd()) {
-        QMap<QString, QString> prevSubViews = availableSubViews(otherPlugin->pluginId);
-        filterEnabledSubViews(prevSubViews, otherPlugin->pluginId, state);
-        append(enabledSubViews, prevSubViews, otherPlugin->pluginId);
+    return result;
+}
+
+const MIMPluginManagerPrivate::SubViewRing &
+MIMPluginManagerPrivate::subViewRing(Maliit::HandlerState state) const
+{
+    SubViewRings::const_iterator cached = subViewRings.constFind(state);
+    if (cached != subViewRings.constEnd()) {
+        return *cached;
     }
 
-    append(enabledSubViews, subViews, pluginId);
+    SubViewRing &ring = subViewRings[state];
 
-    otherPlugin = findEnabledPlugin(iterator,
-                                    Maliit::SwitchForward,
-                                    state);
+    for (Plugins::const_iterator iterator = plugins.constBegin();
+         iterator != plugins.constEnd(); ++iterator) {
+        Maliit::Plugins::InputMethodPlugin *plugin = iterator.key();
+
+        if (!plugin || !plugin->supportedStates().contains(state)) {
+            continue;
+        }
 
-    if (otherPlugin != plugins.constEnd()) {
-        QMap<QString, QString> prevSubViews = availableSubViews(otherPlugin->pluginId);
-        filterEnabledSubViews(prevSubViews, otherPlugin->pluginId, state);
-        append(enabledSubViews, prevSubViews, otherPlugin->pluginId);
+        if (state == Maliit::OnScreen
+            && not onScreenPlugins.isEnabled(iterator->pluginId)) {
+            continue;
+        }
+
+        ring.pluginIndex.insert(plugin, ring.plugins.size());
+        ring.plugins.append(plugin);
+
+        QMap<QString, QString> subViews;
+        Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subView,
+                   pluginSubViews(*iterator, state)) {
+            subViews.insert(subView.subViewId, subView.subViewTitle);
+        }
+        filterEnabledSubViews(subViews, iterator->pluginId, state);
+
+        for (QMap<QString, QString>::const_iterator subView = subViews.constBegin();
+             subView != subViews.constEnd(); ++subView) {
+            ring.subViewIndex.insert(qMakePair(iterator->pluginId, subView.key()),
+                                     ring.subViews.size());
+            ring.subViews.append(MImSubViewDescription(iterator->pluginId,
+                                                       subView.key(), subView.value()));
+        }
     }
 
-    if (enabledSubViews.size() == 1) {
-        return result; //there is no other enabled subview
+    return ring;
+}
+
+void MIMPluginManagerPrivate::invalidateSubViewRings()
+{
+    subViewRings.clear();
+}
+
+void MIMPluginManagerPrivate::scheduleStandbyUpdate()
+{
+    Q_Q(MIMPluginManager);
+
+    if (standbyUpdatePending
+        || (standbyPlugins.isEmpty() && standbyMemoryBudget() <= 0)) {
+        return;
     }
 
-    const QMap<QString, QString>::const_iterator subViewIterator = subViews.find(subViewId);
-    if (subViewIterator == subViews.constEnd()) {
-        return result;
+    // Warm up neighbours once the switch or state change itself is done.
+    standbyUpdatePending = true;
+    QTimer::singleShot(0, q, [this]() { updateStandbyPlugins(); });
+}
+
+void MIMPluginManagerPrivate::updateStandbyPlugins()
+{
+    standbyUpdatePending = false;
+
+    const qint64 budget = standbyMemoryBudget();
+    QList<Maliit::Plugins::InputMethodPlugin *> candidates;
+    PluginState state;
+
+    if (budget > 0) {
+        Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, activePlugins) {
+            if (!plugins.value(plugin).state.contains(Maliit::OnScreen)) {
+                continue;
+            }
+
+            state = plugins.value(plugin).state;
+            const Plugins::const_iterator current = plugins.constFind(plugin);
+            const Plugins::const_iterator next = findEnabledPlugin(current, Maliit::SwitchForward,
+                                                                   Maliit::OnScreen);
+            const Plugins::const_iterator previous = findEnabledPlugin(current, Maliit::SwitchBackward,
+                                                                       Maliit::OnScreen);
+            if (next != plugins.constEnd()) {
+                candidates.append(next.key());
+            }
+            if (previous != plugins.constEnd() && previous != next) {
+                candidates.append(previous.key());
+            }
+            break;
+        }
     }
 
-    MImSubViewDescription current(pluginId, subViewId, *subViewIterator);
+    QSet<Maliit::Plugins::InputMethodPlugin *> kept;
+    qint64 used = 0;
 
-    const int index = enabledSubViews.indexOf(current);
-    if (index < 0 || enabledSubViews.isEmpty()) {
-        qCWarning(lcMaliitFw) << Q_FUNC_INFO << "Invalid subview index or empty list";
-        return result;
+    Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, candidates) {
+        if (activePlugins.contains(plugin) || !plugin->supportedStates().contains(state)
+            || !ensurePluginLoaded(plugin)) {
+            continue;
+        }
+
+        const QSharedPointer<Maliit::WindowGroup> windowGroup = plugins.value(plugin).windowGroup;
+        if (used + windowGroup->memoryEstimate() > budget) {
+            continue;
+        }
+
+        const StandbyPlugins::const_iterator standby = standbyPlugins.constFind(plugin);
+        if (standby == standbyPlugins.constEnd() || standby->state != state) {
+            warmUpPlugin(plugin, state);
+        }
+
+        // Windows are usually only sized once the plugin got its state.
+        const qint64 estimate = windowGroup->memoryEstimate();
+        if (used + estimate > budget) {
+            qCDebug(lcMaliitFw) << Q_FUNC_INFO << plugins.value(plugin).pluginId
+                                << "does not fit into the standby budget:" << estimate << "bytes";
+            continue;
+        }
+
+        used += estimate;
+        kept.insert(plugin);
     }
 
-    const int prevIndex = index > 0 ? index - 1 : enabledSubViews.size() - 1;
-    result.append(enabledSubViews.at(prevIndex));
+    Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, standbyPlugins.keys()) {
+        if (!kept.contains(plugin)) {
+            releaseStandbyPlugin(plugin);
+        }
+    }
 
-    const int nextIndex = index < (enabledSubViews.size() - 1) ? index + 1 : 0;
-    result.append(enabledSubViews.at(nextIndex));
+    scheduleEviction();
+}
 
-    return result;
+void MIMPluginManagerPrivate::warmUpPlugin(Maliit::Plugins::InputMethodPlugin *plugin,
+                                           const PluginState &state)
+{
+    const PluginDescription &desc = plugins[plugin];
+
+    // The host stays disabled, so nothing the plugin does in standby reaches
+    // the application.
+    {
+        MImPluginCallGuard guard(&watchdog, desc.pluginId, MImPluginWatchdog::SetState);
+        desc.inputMethod->setState(state);
+    }
+    sendKeyOverrides(desc.inputMethod, keyOverrides, keyOverridesRevision,
+                     keyOverrides.keys(), true);
+    desc.windowGroup->prepareWindows();
+
+    StandbyPlugin standby = { state, toolbarId, keyOverridesRevision };
+    standbyPlugins.insert(plugin, standby);
+}
+
+void MIMPluginManagerPrivate::releaseStandbyPlugin(Maliit::Plugins::InputMethodPlugin *plugin)
+{
+    if (!standbyPlugins.remove(plugin) || activePlugins.contains(plugin)) {
+        return;
+    }
+
+    PluginDescription &desc = plugins[plugin];
+    {
+        MImPluginCallGuard guard(&watchdog, desc.pluginId, MImPluginWatchdog::Hide);
+        desc.inputMethod->hide();
+    }
+    {
+        MImPluginCallGuard guard(&watchdog, desc.pluginId, MImPluginWatchdog::Reset);
+        desc.inputMethod->reset();
+    }
+    desc.windowGroup->deactivate(Maliit::WindowGroup::HideImmediate);
+    desc.lastUsed = usageClock.elapsed();
+}
+
+qint64 MIMPluginManagerPrivate::standbyMemoryBudget() const
+{
+    if (!standbyBudgetConf) {
+        return 0;
+    }
+
+    return standbyBudgetConf->value(0).toLongLong() * 1024;
+}
+
+void MIMPluginManagerPrivate::scheduleEviction()
+{
+    if (!evictionTimeoutConf || !pluginMemoryBudgetConf) {
+        return;
+    }
+
+    if (evictionTimeoutConf->value(0).toInt() <= 0
+        && pluginMemoryBudgetConf->value(0).toLongLong() <= 0) {
+        evictionTimer.stop();
+        return;
+    }
+
+    evictionTimer.start(0);
+}
+
+void MIMPluginManagerPrivate::evictIdlePlugins()
+{
+    if (!evictionTimeoutConf || !pluginMemoryBudgetConf) {
+        return;
+    }
+
+    const qint64 timeout = evictionTimeoutConf->value(0).toLongLong() * 1000;
+    const qint64 budget = pluginMemoryBudgetConf->value(0).toLongLong() * 1024;
+    const qint64 now = usageClock.elapsed();
+    qint64 nextEviction = -1;
+
+    if (timeout > 0) {
+        Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, plugins.keys()) {
+            const PluginDescription &desc = plugins[plugin];
+            if (!isEvictable(plugin) || onScreenPlugins.isEnabled(desc.pluginId)) {
+                continue;
+            }
+
+            const qint64 idle = now - desc.lastUsed;
+            if (idle >= timeout) {
+                evictPlugin(plugin);
+            } else if (nextEviction < 0 || timeout - idle < nextEviction) {
+                nextEviction = timeout - idle;
+            }
+        }
+    }
+
+    if (budget > 0) {
+        qint64 used = 0;
+        QList<QPair<qint64, Maliit::Plugins::InputMethodPlugin *> > candidates;
+
+        for (Plugins::const_iterator iterator = plugins.constBegin();
+             iterator != plugins.constEnd(); ++iterator) {
+            used += pluginMemoryEstimate(iterator.key());
+
+            if (isEvictable(iterator.key())) {
+                // Plugins without enabled subviews go first, then the least
+                // recently used ones.
+                const bool enabled = onScreenPlugins.isEnabled(iterator->pluginId);
+                candidates.append(qMakePair(enabled ? iterator->lastUsed : iterator->lastUsed - now - 1,
+                                            iterator.key()));
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), lessRecentlyUsed);
+
+        for (int n = 0; used > budget && n < candidates.size(); ++n) {
+            used -= pluginMemoryEstimate(candidates.at(n).second);
+            evictPlugin(candidates.at(n).second);
+        }
+    }
+
+    if (nextEviction >= 0) {
+        evictionTimer.start(nextEviction);
+    }
+}
+
+void MIMPluginManagerPrivate::evictPlugin(Maliit::Plugins::InputMethodPlugin *plugin)
+{
+    Q_Q(MIMPluginManager);
+
+    if (!isEvictable(plugin)) {
+        return;
+    }
+
+    PluginDescription &desc = plugins[plugin];
+
+    qCDebug(lcMaliitFw) << Q_FUNC_INFO << "Evicting idle plugin" << desc.pluginId
+                        << pluginMemoryEstimate(plugin) << "bytes";
+
+    // Subviews are still needed for the enabled subviews and the subview ring.
+    Q_FOREACH (Maliit::HandlerState state, plugin->supportedStates()) {
+        desc.evictedSubViews.insert(state, desc.inputMethod->subViews(state));
+    }
+
+    QObject::disconnect(desc.inputMethod, 0, q, 0);
+    targets.remove(desc.inputMethod);
+
+    delete desc.inputMethod;
+    desc.inputMethod = 0;
+    delete desc.imHost;
+    desc.imHost = 0;
+    desc.windowGroup.clear();
+
+    updatePluginGauges();
+}
+
+void MIMPluginManagerPrivate::configureWatchdog()
+{
+    if (!callBudgetsConf || !stallThresholdConf) {
+        return;
+    }
+
+    const QVariantMap budgets = callBudgetsConf->value().toMap();
+    const int defaultBudget = budgets.value(DefaultCallBudget, MImPluginWatchdog::DefaultBudget).toInt();
+
+    for (int n = 0; n < MImPluginWatchdog::CallCount; ++n) {
+        const MImPluginWatchdog::Call call = static_cast<MImPluginWatchdog::Call>(n);
+        watchdog.setBudget(call, budgets.value(MImPluginWatchdog::callName(call), defaultBudget).toInt());
+    }
+
+    for (QVariantMap::const_iterator iterator = budgets.constBegin();
+         iterator != budgets.constEnd(); ++iterator) {
+        if (iterator.key() != DefaultCallBudget
+            && MImPluginWatchdog::call(iterator.key()) == MImPluginWatchdog::CallCount) {
+            qCWarning(lcMaliitFw) << Q_FUNC_INFO << "Budget for unknown plugin call:" << iterator.key();
+        }
+    }
+
+    watchdog.setStallThreshold(stallThresholdConf->value(MImPluginWatchdog::DefaultStallThreshold).toInt());
+}
+
+QString MIMPluginManagerPrivate::pluginId(MAbstractInputMethod *inputMethod) const
+{
+    for (Plugins::const_iterator iterator = plugins.constBegin();
+         iterator != plugins.constEnd(); ++iterator) {
+        if (iterator->inputMethod == inputMethod) {
+            return iterator->pluginId;
+        }
+    }
+
+    return QString();
+}
+
+void MIMPluginManagerPrivate::updatePluginGauges()
+{
+    if (!metrics) {
+        return;
+    }
+
+    int loaded = 0;
+    Q_FOREACH (const PluginDescription &desc, plugins) {
+        if (desc.inputMethod) {
+            ++loaded;
+        }
+    }
+
+    metrics->setGauge(MImMetrics::LoadedPlugins, loaded);
+    metrics->setGauge(MImMetrics::ActivePlugins, activePlugins.count());
+}
+
+bool MIMPluginManagerPrivate::isEvictable(Maliit::Plugins::InputMethodPlugin *plugin) const
+{
+    const Plugins::const_iterator iterator = plugins.constFind(plugin);
+
+    if (iterator == plugins.constEnd() || !iterator->inputMethod
+        || activePlugins.contains(plugin) || standbyPlugins.contains(plugin)) {
+        return false;
+    }
+
+    // Handlers of the input sources are switched to without going through
+    // switchPlugin(), keep them loaded.
+    for (HandlerMap::const_iterator handler = handlerToPlugin.constBegin();
+         handler != handlerToPlugin.constEnd(); ++handler) {
+        if (handler.value() == plugin) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+qint64 MIMPluginManagerPrivate::pluginMemoryEstimate(Maliit::Plugins::InputMethodPlugin *plugin) const
+{
+    const Plugins::const_iterator iterator = plugins.constFind(plugin);
+
+    if (iterator == plugins.constEnd() || !iterator->windowGroup) {
+        return 0;
+    }
+
+    return iterator->windowGroup->memoryEstimate();
+}
+
+QList<MAbstractInputMethod::MInputMethodSubView>
+MIMPluginManagerPrivate::pluginSubViews(const PluginDescription &desc,
+                                        Maliit::HandlerState state) const
+{
+    if (desc.inputMethod) {
+        return desc.inputMethod->subViews(state);
+    }
+
+    return desc.evictedSubViews.value(state);
 }
 
 QStringList MIMPluginManagerPrivate::activePluginsNames() const
@@ -962,6 +1732,8 @@ void MIMPluginManagerPrivate::_q_setActiveSubView(const QString &subViewId,
         if (subView.subViewId == subViewId) {
             activeSubViewIdOnScreen = subViewId;
             if (inputMethod->activeSubView(Maliit::OnScreen) != activeSubViewIdOnScreen) {
+                MImPluginCallGuard guard(&watchdog, plugins.value(plugin).pluginId,
+                                         MImPluginWatchdog::SetActiveSubView);
                 inputMethod->setActiveSubView(activeSubViewIdOnScreen, Maliit::OnScreen);
             }
             // Save the last active subview
@@ -977,14 +1749,19 @@ void MIMPluginManagerPrivate::_q_setActiveSubView(const QString &subViewId,
 void MIMPluginManagerPrivate::showActivePlugins()
 {
     visible = true;
+    visibilityState.setVisible(true);
     ensureActivePluginsVisible(ShowInputMethod);
 }
 
 void MIMPluginManagerPrivate::hideActivePlugins()
 {
     visible = false;
+    visibilityState.setVisible(false);
     Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, activePlugins) {
-        plugins.value(plugin).inputMethod->hide();
+        {
+            MImPluginCallGuard guard(&watchdog, plugins.value(plugin).pluginId, MImPluginWatchdog::Hide);
+            plugins.value(plugin).inputMethod->hide();
+        }
         plugins.value(plugin).windowGroup->deactivate(Maliit::WindowGroup::HideDelayed);
     }
 }
@@ -997,9 +1774,10 @@ void MIMPluginManagerPrivate::ensureActivePluginsVisible(ShowInputMethodRequest
         if (activePlugins.contains(iterator.key())) {
             iterator.value().windowGroup->activate();
             if (request == ShowInputMethod) {
+                MImPluginCallGuard guard(&watchdog, iterator.value().pluginId, MImPluginWatchdog::Show);
                 iterator.value().inputMethod->show();
             }
-        } else {
+        } else if (iterator.value().windowGroup) {
             iterator.value().windowGroup->deactivate(Maliit::WindowGroup::HideImmediate);
         }
     }
@@ -1014,11 +1792,9 @@ MIMPluginManagerPrivate::availableSubViews(const QString &plugin,
 
     for (; iterator != plugins.constEnd(); ++iterator) {
         if (plugins.value(iterator.key()).pluginId == plugin) {
-            if (iterator->inputMethod) {
-                Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subView,
-                         iterator->inputMethod->subViews(state)) {
-                    subViews.insert(subView.subViewId, subView.subViewTitle);
-                }
+            Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subView,
+                       pluginSubViews(*iterator, state)) {
+                subViews.insert(subView.subViewId, subView.subViewTitle);
             }
             break;
         }
@@ -1033,12 +1809,10 @@ MIMPluginManagerPrivate::availablePluginsAndSubViews(Maliit::HandlerState state)
     Plugins::const_iterator iterator(plugins.constBegin());
 
     for (; iterator != plugins.constEnd(); ++iterator) {
-        if (iterator->inputMethod) {
-            const QString plugin = plugins.value(iterator.key()).pluginId;
-            Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subView,
-                     iterator->inputMethod->subViews(state)) {
-                pluginsAndSubViews.append(MImOnScreenPlugins::SubView(plugin, subView.subViewId));
-            }
+        const QString plugin = iterator->pluginId;
+        Q_FOREACH (const MAbstractInputMethod::MInputMethodSubView &subView,
+                   pluginSubViews(*iterator, state)) {
+            pluginsAndSubViews.append(MImOnScreenPlugins::SubView(plugin, subView.subViewId));
         }
     }
 
@@ -1114,6 +1888,20 @@ MIMPluginManager::MIMPluginManager(const QSharedPointer<MInputContextConnection>
     connect(d->mICConnection.data(), SIGNAL(resetInputMethodRequest()),
             this, SLOT(resetInputMethods()));
 
+    connect(&d->visibilityState, &MImVisibilityState::shown, this, [d]() {
+        MImMetricsTimer timer(d->metrics.data(), MImMetrics::ShowCallbacks);
+        d->showActivePlugins();
+    });
+    connect(&d->visibilityState, &MImVisibilityState::hidden, this, [d]() {
+        MImMetricsTimer timer(d->metrics.data(), MImMetrics::HideCallbacks);
+        d->hideActivePlugins();
+    });
+    connect(&d->visibilityState, &MImVisibilityState::transitionsSuppressed, this, [d](int count) {
+        if (d->metrics) {
+            d->metrics->increment(MImMetrics::SuppressedVisibilityTransitions, count);
+        }
+    });
+
     connect(d->mICConnection.data(), SIGNAL(activeClientDisconnected()),
             this, SLOT(handleClientChange()));
 
@@ -1178,6 +1966,35 @@ MIMPluginManager::MIMPluginManager(const QSharedPointer<MInputContextConnection>
     connect(d->mICConnection.data(), SIGNAL(pluginSettingsRequested(int,QString)),
             this, SLOT(pluginSettingsRequested(int,QString)));
 
+    connect(d->mICConnection.data(), SIGNAL(pluginSettingsSnapshotRequested(int,QString,quint64)),
+            this, SLOT(pluginSettingsSnapshotRequested(int,QString,quint64)));
+
+    connect(d->mICConnection.data(), &MInputContextConnection::pluginSettingsSubscriptionRequested,
+            this, [d](int clientId, const QString &descriptionLanguage, quint64 lastSeenVersion) {
+        d->subscribeSettings(clientId, descriptionLanguage, lastSeenVersion);
+    });
+
+    connect(d->mICConnection.data(), &MInputContextConnection::pluginSettingsUnsubscribed,
+            this, [d](int clientId) {
+        d->settingsSubscribers.remove(clientId);
+    });
+
+    connect(d->mICConnection.data(), &MInputContextConnection::clientDisconnected,
+            this, [d](unsigned int clientId) {
+        d->settingsSubscribers.remove(clientId);
+    });
+
+    connect(&d->settingsPushTimer, &QTimer::timeout,
+            this, [d]() {
+        d->pushSettingsChanges();
+    });
+
+    connect(d->sharedAttributeExtensionManager.data(), &MSharedAttributeExtensionManager::notifyExtensionAttributeChanged,
+            this, [d](const QList<int> &, int, const QString &target, const QString &targetItem,
+                      const QString &attribute, const QVariant &value) {
+        d->updateSettingValue(QString::fromLatin1("%1/%2/%3").arg(target, targetItem, attribute), value);
+    });
+
     connect(d->mICConnection.data(), SIGNAL(focusChanged(WId)),
             this, SLOT(handleAppFocusChanged(WId)));
 
@@ -1204,6 +2021,12 @@ MIMPluginManager::MIMPluginManager(const QSharedPointer<MInputContextConnection>
             this, SLOT(_q_onScreenSubViewChanged()));
     d->_q_onScreenSubViewChanged();
 
+    connect(&d->onScreenPlugins, &MImOnScreenPlugins::enabledPluginsChanged,
+            this, [d]() {
+        d->invalidateSubViewRings();
+        d->scheduleStandbyUpdate();
+        d->scheduleEviction();
+    });
     connect(&d->onScreenPlugins, SIGNAL(enabledPluginsChanged()),
             this, SIGNAL(pluginsChanged()));
 
@@ -1216,6 +2039,30 @@ MIMPluginManager::MIMPluginManager(const QSharedPointer<MInputContextConnection>
     d->imAccessoryEnabledConf = new MImSettings(MImAccesoryEnabled, this);
     connect(d->imAccessoryEnabledConf, SIGNAL(valueChanged()), this, SLOT(updateInputSource()));
 
+    d->standbyBudgetConf = new MImSettings(MImStandbyMemoryBudget, this);
+    connect(d->standbyBudgetConf, &MImSettings::valueChanged,
+            this, [d]() { d->scheduleStandbyUpdate(); });
+
+    d->evictionTimeoutConf = new MImSettings(MImPluginEvictionTimeout, this);
+    d->pluginMemoryBudgetConf = new MImSettings(MImPluginMemoryBudget, this);
+    connect(d->evictionTimeoutConf, &MImSettings::valueChanged,
+            this, [d]() { d->scheduleEviction(); });
+    connect(d->pluginMemoryBudgetConf, &MImSettings::valueChanged,
+            this, [d]() { d->scheduleEviction(); });
+    connect(&d->evictionTimer, &QTimer::timeout,
+            this, [d]() { d->evictIdlePlugins(); });
+    d->scheduleEviction();
+
+    connect(&d->watchdog, SIGNAL(eventOccurred(MImPluginCallEvent)),
+            this, SIGNAL(pluginCallEventOccurred(MImPluginCallEvent)));
+    d->callBudgetsConf = new MImSettings(MImPluginCallBudgets, this);
+    d->stallThresholdConf = new MImSettings(MImStallThreshold, this);
+    connect(d->callBudgetsConf, &MImSettings::valueChanged,
+            this, [d]() { d->configureWatchdog(); });
+    connect(d->stallThresholdConf, &MImSettings::valueChanged,
+            this, [d]() { d->configureWatchdog(); });
+    d->configureWatchdog();
+
     updateInputSource();
 }
 
@@ -1227,6 +2074,13 @@ MIMPluginManager::~MIMPluginManager()
 }
 
 
+QList<MImPluginCallEvent> MIMPluginManager::pluginCallEvents() const
+{
+    Q_D(const MIMPluginManager);
+    return d->watchdog.events();
+}
+
+
 QStringList MIMPluginManager::loadedPluginsNames() const
 {
     Q_D(const MIMPluginManager);
@@ -1304,6 +2158,7 @@ void MIMPluginManager::switchPlugin(Maliit::SwitchDirection direction,
     if (initiator) {
         if (!d->switchPlugin(direction, initiator)) {
             // no next plugin, just switch context
+            MImPluginCallGuard guard(&d->watchdog, d->pluginId(initiator), MImPluginWatchdog::SwitchContext);
             initiator->switchContext(direction, true);
         }
     }
@@ -1334,8 +2189,10 @@ void MIMPluginManager::setToolbar(const MAttributeExtensionId &id)
     // Record MAttributeExtensionId for switch Plugin
     d->toolbarId = id;
 
-    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
+    const QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
         d->attributeExtensionManager->keyOverrides(id);
+    d->keyOverrides = keyOverrides;
+    d->keyOverridesRevision = d->attributeExtensionManager->keyOverridesRevision(id);
 
     bool focusStateOk(false);
     const bool focusState(d->mICConnection->focusState(focusStateOk));
@@ -1356,7 +2213,8 @@ void MIMPluginManager::setToolbar(const MAttributeExtensionId &id)
     Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, d->activePlugins) {
         if (callKeyOverrides)
         {
-            d->plugins.value(plugin).inputMethod->setKeyOverrides(keyOverrides);
+            d->sendKeyOverrides(d->plugins.value(plugin).inputMethod, keyOverrides,
+                                d->keyOverridesRevision, keyOverrides.keys(), true);
         }
     }
 }
@@ -1365,14 +2223,14 @@ void MIMPluginManager::showActivePlugins()
 {
     Q_D(MIMPluginManager);
 
-    d->showActivePlugins();
+    d->visibilityState.requestShow();
 }
 
 void MIMPluginManager::hideActivePlugins()
 {
     Q_D(MIMPluginManager);
 
-    d->hideActivePlugins();
+    d->visibilityState.requestHide();
 }
 
 QMap<QString, QString> MIMPluginManager::availableSubViews(const QString &plugin,
@@ -1403,17 +2261,58 @@ void MIMPluginManager::setActiveSubView(const QString &subViewId, Maliit::Handle
 void MIMPluginManager::updateKeyOverrides()
 {
     Q_D(MIMPluginManager);
-    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
+
+    // Key overrides may have been created in an extension other than the
+    // current one, nothing to hand over in that case.
+    const int revision = d->attributeExtensionManager->keyOverridesRevision(d->toolbarId);
+    if (revision == d->keyOverridesRevision) {
+        return;
+    }
+
+    const QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides =
         d->attributeExtensionManager->keyOverrides(d->toolbarId);
 
+    // Key overrides are only ever added to an extension, so the changed keys
+    // are the ones missing from the previous snapshot. If keys were dropped or
+    // are different instances, the extension was registered again under the
+    // same id and the snapshot is replaced as a whole.
+    QStringList changedKeys;
+    bool replaced = false;
+    for (QMap<QString, QSharedPointer<MKeyOverride> >::const_iterator iterator = keyOverrides.constBegin();
+         iterator != keyOverrides.constEnd();
+         ++iterator) {
+        const QSharedPointer<MKeyOverride> previous = d->keyOverrides.value(iterator.key());
+        if (!previous) {
+            changedKeys.append(iterator.key());
+        } else if (previous != iterator.value()) {
+            replaced = true;
+        }
+    }
+    Q_FOREACH (const QString &key, d->keyOverrides.keys()) {
+        if (!keyOverrides.contains(key)) {
+            replaced = true;
+        }
+    }
+    if (replaced) {
+        changedKeys = keyOverrides.keys();
+    }
+
+    d->keyOverrides = keyOverrides;
+    d->keyOverridesRevision = revision;
+
     Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, d->activePlugins) {
-        d->plugins.value(plugin).inputMethod->setKeyOverrides(keyOverrides);
+        d->sendKeyOverrides(d->plugins.value(plugin).inputMethod, keyOverrides,
+                            revision, changedKeys, replaced);
     }
 }
 
 void MIMPluginManager::handleAppOrientationAboutToChange(int angle)
 {
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::OrientationCallbacks);
+
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleAppOrientationAboutToChange);
         target->handleAppOrientationAboutToChange(angle);
     }
 }
@@ -1424,7 +2323,9 @@ void MIMPluginManager::handleAppOrientationChanged(int angle)
 
     d->lastOrientation = angle;
 
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::OrientationCallbacks);
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleAppOrientationChanged);
         target->handleAppOrientationChanged(angle);
     }
 }
@@ -1433,17 +2334,25 @@ void MIMPluginManager::handleAppFocusChanged(WId id)
 {
     Q_D(MIMPluginManager);
 
+    // Remembered for plugins reloaded after eviction.
+    d->applicationWindow = id;
+
     MIMPluginManagerPrivate::Plugins::iterator i = d->plugins.begin();
     while (i != d->plugins.end()) {
-        i.value().windowGroup.data()->setApplicationWindow(id);
+        if (i.value().windowGroup) {
+            i.value().windowGroup.data()->setApplicationWindow(id);
+        }
         ++i;
     }
 }
 
 void MIMPluginManager::handleClientChange()
 {
+    Q_D(MIMPluginManager);
+
     // notify plugins
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleClientChange);
         target->handleClientChange();
     }
 }
@@ -1454,6 +2363,10 @@ void MIMPluginManager::handleWidgetStateChanged(unsigned int clientId,
                                                 bool focusChanged)
 {
     Q_UNUSED(clientId);
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::WidgetStateCallbacks);
+
+    d->handleWidgetStateChanged(oldState, newState, focusChanged);
 
     // check visualization change
     bool oldVisualization = false;
@@ -1487,6 +2400,7 @@ void MIMPluginManager::handleWidgetStateChanged(unsigned int clientId,
 
     if (focusChanged) {
         Q_FOREACH (MAbstractInputMethod *target, targets()) {
+            MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleFocusChange);
             target->handleFocusChange(widgetFocusState);
         }
     }
@@ -1494,6 +2408,7 @@ void MIMPluginManager::handleWidgetStateChanged(unsigned int clientId,
     // call notification methods if needed
     if (oldVisualization != newVisualization) {
         Q_FOREACH (MAbstractInputMethod *target, targets()) {
+            MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleVisualizationPriorityChange);
             target->handleVisualizationPriorityChange(newVisualization);
         }
     }
@@ -1504,12 +2419,15 @@ void MIMPluginManager::handleWidgetStateChanged(unsigned int clientId,
     // general notification last
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
         if (not changedProperties.isEmpty()) {
+            MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::ImExtensionEvent);
             (void) target->imExtensionEvent(&ev);
         }
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::Update);
         target->update();
     }
 
-    // Make sure windows get hidden when no longer focus
+    // Make sure windows get hidden when no longer focus; a show following
+    // within the same frame, e.g. when hopping between fields, cancels it.
     if (not widgetFocusState) {
         hideActivePlugins();
     }
@@ -1517,21 +2435,33 @@ void MIMPluginManager::handleWidgetStateChanged(unsigned int clientId,
 
 void MIMPluginManager::handleMouseClickOnPreedit(const QPoint &pos, const QRect &preeditRect)
 {
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::PreeditCallbacks);
+
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::HandleMouseClickOnPreedit);
         target->handleMouseClickOnPreedit(pos, preeditRect);
     }
 }
 
 void MIMPluginManager::handlePreeditChanged(const QString &text, int cursorPos)
 {
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::PreeditCallbacks);
+
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::SetPreedit);
         target->setPreedit(text, cursorPos);
     }
 }
 
 void MIMPluginManager::resetInputMethods()
 {
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::ResetCallbacks);
+
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::Reset);
         target->reset();
     }
 }
@@ -1541,7 +2471,17 @@ void MIMPluginManager::processKeyEvent(QEvent::Type keyType, Qt::Key keyCode,
                      quint32 nativeScanCode, quint32 nativeModifiers, unsigned long time)
 
 {
+    Q_D(MIMPluginManager);
+    MImMetricsTimer timer(d->metrics.data(), MImMetrics::KeyEventCallbacks);
+
+    // Releases follow every press, and must not make the work started on
+    // the press stale
+    if (keyType == QEvent::KeyPress) {
+        d->advanceEditorStateGeneration();
+    }
+
     Q_FOREACH (MAbstractInputMethod *target, targets()) {
+        MImPluginCallGuard guard(&d->watchdog, d->pluginId(target), MImPluginWatchdog::ProcessKeyEvent);
         target->processKeyEvent(keyType, keyCode, modifiers, text, autoRepeat, count,
                                 nativeScanCode, nativeModifiers, time);
     }
@@ -1582,21 +2522,20 @@ void MIMPluginManager::pluginSettingsRequested(int clientId, const QString &desc
 {
     Q_D(MIMPluginManager);
 
-    QList<MImPluginSettingsInfo> settings = d->settings;
-
-    for (int i = 0; i < settings.count(); ++i) {
-        QList<MImPluginSettingsEntry> &entries = settings[i].entries;
+    d->mICConnection->pluginSettingsLoaded(clientId, d->settingsSnapshot(descriptionLanguage));
+}
 
-        // TODO translate descriptions using descriptionLanguage
-        settings[i].description_language = descriptionLanguage;
+void MIMPluginManager::pluginSettingsSnapshotRequested(int clientId, const QString &descriptionLanguage,
+                                                       quint64 knownVersion)
+{
+    Q_D(MIMPluginManager);
 
-        for (int j = 0; j < entries.count(); ++j) {
-            // TODO translate descriptions using descriptionLanguage
-            entries[j].value = MImSettings(entries[j].extension_key).value(entries[j].attributes.value(Maliit::SettingEntryAttributes::defaultValue));
-        }
+    if (knownVersion == d->settingsVersion) {
+        d->mICConnection->pluginSettingsUnchanged(clientId, d->settingsVersion);
+    } else {
+        d->mICConnection->pluginSettingsSnapshotLoaded(clientId, d->settingsVersion,
+                                                       d->settingsSnapshot(descriptionLanguage));
     }
-
-    d->mICConnection->pluginSettingsLoaded(clientId, settings);
 }
 
 AbstractPluginSetting *MIMPluginManager::registerPluginSetting(const QString &pluginId,
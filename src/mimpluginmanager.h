@@ -25,6 +25,7 @@
 
 #include "mattributeextensionid.h"
 #include "minputcontextconnection.h"
+#include "mimpluginwatchdog.h"
 
 QT_BEGIN_NAMESPACE
 class QRegion;
@@ -66,6 +67,9 @@ public:
     //! Returns names of loaded plugins
     QStringList loadedPluginsNames() const;
 
+    //! Returns the most recent slow plugin calls and main loop stalls, oldest first.
+    QList<MImPluginCallEvent> pluginCallEvents() const;
+
     //! Returns names of loaded plugins which support \a state
     QStringList loadedPluginsNames(Maliit::HandlerState state) const;
 
@@ -121,11 +125,14 @@ Q_SIGNALS:
 
     void pluginLoaded();
 
+    //! Emitted when a plugin call exceeded its budget or the main loop stalled.
+    void pluginCallEventOccurred(const MImPluginCallEvent &event);
+
 public Q_SLOTS:
-    //! Show active plugins.
+    //! Show active plugins. Requests are coalesced and resolved once per frame.
     void showActivePlugins();
 
-    //! Hide active plugins.
+    //! Hide active plugins. Requests are coalesced and resolved once per frame.
     void hideActivePlugins();
 
     void resetInputMethods();
@@ -156,6 +163,8 @@ private Q_SLOTS:
                          int count, quint32 nativeScanCode, quint32 nativeModifiers, unsigned long time);
 
     void pluginSettingsRequested(int clientId, const QString &descriptionLanguage);
+    void pluginSettingsSnapshotRequested(int clientId, const QString &descriptionLanguage,
+                                         quint64 knownVersion);
 
     /*!
      * \brief Handle global attribute change
@@ -185,6 +194,7 @@ private:
     friend class Ut_MIMPluginManager;
     friend class Ut_MIMPluginManagerConfig;
     friend class Ft_MIMPluginManager;
+    friend class Bench_PluginSwitch;
     friend class Ut_MIMSettingsDialog;
 };
 
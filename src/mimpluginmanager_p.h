@@ -21,8 +21,13 @@
 #include "mimonscreenplugins.h"
 #include "mimsettings.h"
 #include "mimhwkeyboardtracker.h"
+#include "mimmetrics.h"
+#include "mimpluginwatchdog.h"
+#include "mimvisibilitystate.h"
 #include <maliit/settingdata.h>
+#include <maliit/plugins/abstractinputmethod.h>
 #include <maliit/plugins/abstractpluginsetting.h>
+#include <maliit/plugins/subviewdescription.h>
 #include "windowgroup.h"
 #include "abstractplatform.h"
 
@@ -41,6 +46,7 @@ class MSharedAttributeExtensionManager;
 class MImSettings;
 class MAbstractInputMethod;
 class MIMPluginManagerAdaptor;
+class MKeyOverride;
 
 /* Internal class only! Interfaces here change, internal developers only*/
 class PluginSetting : public Maliit::Plugins::AbstractPluginSetting
@@ -81,12 +87,50 @@ public:
         Maliit::SwitchDirection lastSwitchDirection;
         QString pluginId; // the library filename is used as ID
         QSharedPointer<Maliit::WindowGroup> windowGroup;
+        qint64 lastUsed; // usageClock time the plugin was last loaded or active
+        //! Subviews per supported state, kept while the input method is evicted
+        QMap<Maliit::HandlerState, QList<MAbstractInputMethod::MInputMethodSubView> > evictedSubViews;
     };
 
     typedef QMap<Maliit::Plugins::InputMethodPlugin *, PluginDescription> Plugins;
     typedef QSet<Maliit::Plugins::InputMethodPlugin *> ActivePlugins;
     typedef QMap<Maliit::HandlerState, Maliit::Plugins::InputMethodPlugin *> HandlerMap;
 
+    /*!
+     * \brief Enabled subviews of one handler state, in switching order.
+     *
+     * Plugins appear in the order of \a plugins, each followed by its enabled
+     * subviews sorted by id; the list wraps around at both ends.
+     */
+    struct SubViewRing {
+        QList<MImSubViewDescription> subViews;
+        QHash<QPair<QString, QString>, int> subViewIndex; // (plugin id, subview id) -> subViews
+        QVector<Maliit::Plugins::InputMethodPlugin *> plugins;
+        QHash<Maliit::Plugins::InputMethodPlugin *, int> pluginIndex; // -> plugins
+    };
+    typedef QHash<Maliit::HandlerState, SubViewRing> SubViewRings;
+
+    //! What a plugin kept warm next to the active on-screen plugin was handed.
+    struct StandbyPlugin {
+        PluginState state;
+        MAttributeExtensionId toolbarId;
+        int keyOverridesRevision;
+    };
+    typedef QHash<Maliit::Plugins::InputMethodPlugin *, StandbyPlugin> StandbyPlugins;
+
+    //! A settings version and what changed in it.
+    struct SettingsChange {
+        quint64 version;
+        QString pluginName;
+        QString key; // empty if entries of the plugin were registered
+    };
+
+    //! A client following settings changes, see subscribeSettings().
+    struct SettingsSubscriber {
+        QString language;
+        quint64 version; // last version sent to the client
+    };
+
     MIMPluginManagerPrivate(const QSharedPointer<MInputContextConnection>& connection,
                             const QSharedPointer<Maliit::AbstractPlatform> &platform,
                             MIMPluginManager *p);
@@ -97,10 +141,37 @@ public:
     void activatePlugin(Maliit::Plugins::InputMethodPlugin *plugin);
     void loadPlugins();
     bool loadPlugin(const QDir &dir, const QString &fileName);
+    //! Creates input method, host and window group of \a plugin into \a desc.
+    bool createInputMethod(Maliit::Plugins::InputMethodPlugin *plugin, PluginDescription &desc);
+    //! Recreates the input method of \a plugin if it was evicted.
+    bool ensurePluginLoaded(Maliit::Plugins::InputMethodPlugin *plugin);
     void addHandlerMap(Maliit::HandlerState state, const QString &pluginName);
     void registerSettings();
     void registerSettings(const MImPluginSettingsInfo &info);
     MImPluginSettingsInfo globalSettings() const;
+    //! Returns the settings with current values and descriptions translated to \a language,
+    //! building them only after the settings changed.
+    const QList<MImPluginSettingsInfo> &settingsSnapshot(const QString &language);
+    //! Drops all settings snapshots and starts a new settings version.
+    void invalidateSettingsSnapshots();
+    //! Updates the value of the setting \a key in the snapshots and starts a new settings version.
+    void updateSettingValue(const QString &key, const QVariant &value);
+    //! Logs a change of the current settings version and schedules pushing it to subscribers.
+    void recordSettingsChange(const QString &pluginName, const QString &key);
+    /*!
+     * \brief Collects the settings that changed after \a version.
+     *
+     * Plugins whose entries were registered are returned whole, others only
+     * with their changed entries. Returns false if the change log does not
+     * reach back to \a version.
+     */
+    bool settingsChangesSince(quint64 version, const QString &language,
+                              QList<MImPluginSettingsInfo> &changed, QStringList &removedPlugins);
+    //! Sends \a clientId what changed after \a version, or everything if that is not known.
+    void sendSettingsSince(int clientId, const QString &language, quint64 version);
+    //! Brings \a clientId up to date from \a lastSeenVersion and keeps pushing changes to it.
+    void subscribeSettings(int clientId, const QString &language, quint64 lastSeenVersion);
+    void pushSettingsChanges();
     void setActiveHandlers(const QSet<Maliit::HandlerState> &states);
     QSet<Maliit::HandlerState> activeHandlers() const;
     void deactivatePlugin(Maliit::Plugins::InputMethodPlugin *plugin);
@@ -128,10 +199,52 @@ public:
     void filterEnabledSubViews(QMap<QString, QString> &subViews,
                                const QString &pluginId,
                                Maliit::HandlerState state) const;
-    void append(QList<MImSubViewDescription> &list,
-                const QMap<QString, QString> &map,
-                const QString &pluginId) const;
     QList<MImSubViewDescription> surroundingSubViewDescriptions(Maliit::HandlerState state) const;
+
+    //! Returns the subview ring of \a state, building it if it was invalidated.
+    const SubViewRing &subViewRing(Maliit::HandlerState state) const;
+    //! Drops all subview rings, to be called when plugins or enabled subviews change.
+    void invalidateSubViewRings();
+
+    /*!
+     * \brief Keeps the plugins before and after the active on-screen plugin in
+     * the subview ring warm, within the configured standby memory budget.
+     *
+     * Standby plugins have their state and key overrides applied and their
+     * windows created but stay hidden and disabled, so that switching to
+     * them only has to show them.
+     */
+    void updateStandbyPlugins();
+    void scheduleStandbyUpdate();
+    void warmUpPlugin(Maliit::Plugins::InputMethodPlugin *plugin, const PluginState &state);
+    void releaseStandbyPlugin(Maliit::Plugins::InputMethodPlugin *plugin);
+    //! Returns the standby memory budget in bytes, 0 if standby is disabled.
+    qint64 standbyMemoryBudget() const;
+
+    /*!
+     * \brief Destroys the input methods of idle plugins.
+     *
+     * Plugins which are neither active, on standby nor configured as handler
+     * are evicted once they have been idle for the eviction timeout if they
+     * have no enabled subview, and least recently used first whenever the
+     * loaded plugins exceed the plugin memory budget. Evicted plugins are
+     * reloaded by ensurePluginLoaded() when switched to.
+     */
+    void evictIdlePlugins();
+    void scheduleEviction();
+    //! Updates the loaded and active plugin gauges, if metrics are enabled.
+    void updatePluginGauges();
+    //! Applies the plugin call budgets and stall threshold from the settings to the watchdog.
+    void configureWatchdog();
+    //! Returns the id of the plugin owning \a inputMethod, for watchdog reports.
+    QString pluginId(MAbstractInputMethod *inputMethod) const;
+    void evictPlugin(Maliit::Plugins::InputMethodPlugin *plugin);
+    bool isEvictable(Maliit::Plugins::InputMethodPlugin *plugin) const;
+    //! Returns the estimated memory held by \a plugin in bytes, 0 if evicted.
+    qint64 pluginMemoryEstimate(Maliit::Plugins::InputMethodPlugin *plugin) const;
+    //! Returns the subviews of \a desc, from the cache if it is evicted.
+    QList<MAbstractInputMethod::MInputMethodSubView> pluginSubViews(const PluginDescription &desc,
+                                                                    Maliit::HandlerState state) const;
     QStringList activePluginsNames() const;
     QString activePluginsName(Maliit::HandlerState state) const;
     void loadHandlerMap();
@@ -168,6 +281,25 @@ public:
 
     QString inputSourceName(Maliit::HandlerState source) const;
 
+    //! Makes worker tasks of the active plugins stale, see MAbstractInputMethodHost::runTask().
+    void advanceEditorStateGeneration();
+
+    //! Hands a widget state update to the hosts of the active plugins, which
+    //! decide whether it makes their worker tasks stale.
+    void handleWidgetStateChanged(const QMap<QString, QVariant> &oldState,
+                                  const QMap<QString, QVariant> &newState,
+                                  bool focusChanged);
+
+    /*!
+     * \brief Hands key overrides to \a target, as a MImKeyOverridesEvent if
+     * the input method handles it or through setKeyOverrides() otherwise.
+     */
+    void sendKeyOverrides(MAbstractInputMethod *target,
+                          const QMap<QString, QSharedPointer<MKeyOverride> > &overrides,
+                          int revision,
+                          const QStringList &changedKeys,
+                          bool replaced);
+
     MIMPluginManager *parent;
     QSharedPointer<MInputContextConnection> mICConnection;
 
@@ -175,13 +307,34 @@ public:
     ActivePlugins activePlugins;
     QSet<MAbstractInputMethod *> targets;
     QList<MImPluginSettingsInfo> settings;
+    //! Prebuilt answers to settings requests, by description language
+    QHash<QString, QList<MImPluginSettingsInfo> > settingsSnapshots;
+    //! Identifies the current state of settings and their values for clients; never 0
+    quint64 settingsVersion;
+    //! Recent settings changes, oldest first
+    QList<SettingsChange> settingsChanges;
+    //! Oldest version settingsChanges can bring up to date
+    quint64 settingsChangesStart;
+    QHash<int, SettingsSubscriber> settingsSubscribers;
+    QTimer settingsPushTimer;
 
     QStringList paths;
     QStringList blacklist;
     HandlerMap handlerToPlugin;
+    mutable SubViewRings subViewRings;
 
     QList<MImSettings *> handlerToPluginConfs;
     MImSettings *imAccessoryEnabledConf;
+    MImSettings *standbyBudgetConf;
+    StandbyPlugins standbyPlugins;
+    bool standbyUpdatePending;
+    MImSettings *evictionTimeoutConf;
+    MImSettings *pluginMemoryBudgetConf;
+    MImSettings *callBudgetsConf;
+    MImSettings *stallThresholdConf;
+    QTimer evictionTimer;
+    QElapsedTimer usageClock;
+    WId applicationWindow;
     QString activeSubViewIdOnScreen;
 
     MIMPluginManagerAdaptor *adaptor;
@@ -189,11 +342,16 @@ public:
     MIMPluginManager *q_ptr;
 
     bool visible;
+    //! Show and hide requests of clients, resolved once per frame by default
+    MImVisibilityState visibilityState;
 
     typedef QMap<Maliit::HandlerState, QString> InputSourceToNameMap;
     InputSourceToNameMap inputSourceToNameMap;
 
     MAttributeExtensionId toolbarId;
+    //! last key override snapshot of toolbarId handed to the active plugins
+    QMap<QString, QSharedPointer<MKeyOverride> > keyOverrides;
+    int keyOverridesRevision;
 
     MImOnScreenPlugins onScreenPlugins;
     MImHwKeyboardTracker hwkbTracker;
@@ -204,6 +362,10 @@ public:
     QScopedPointer<MSharedAttributeExtensionManager> sharedAttributeExtensionManager;
 
     QSharedPointer<Maliit::AbstractPlatform> m_platform;
+
+    //! Shared with mICConnection; null if metrics are disabled
+    QSharedPointer<MImMetrics> metrics;
+    MImPluginWatchdog watchdog;
 };
 
 #endif
@@ -0,0 +1,286 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "mimpluginwatchdog.h"
+
+#include "mimmetrics.h"
+#include "logging.h"
+
+#include <QDateTime>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace
+{
+    const char * const CallNames[] = {
+        "show",
+        "hide",
+        "reset",
+        "update",
+        "processKeyEvent",
+        "setPreedit",
+        "handleFocusChange",
+        "handleVisualizationPriorityChange",
+        "imExtensionEvent",
+        "handleMouseClickOnPreedit",
+        "handleClientChange",
+        "handleAppOrientationAboutToChange",
+        "handleAppOrientationChanged",
+        "setState",
+        "setActiveSubView",
+        "switchContext",
+        "setKeyOverrides",
+        "showLanguageNotification"
+    };
+
+    Q_STATIC_ASSERT(sizeof(CallNames) / sizeof(CallNames[0]) == MImPluginWatchdog::CallCount);
+
+    // Smallest heartbeat interval, so that low thresholds do not keep the
+    // main loop busy.
+    const int MinimumBeatInterval = 10; // in ms
+}
+
+//! Wakes up regularly to check the heartbeat of the main loop.
+class MImPluginWatchdogThread : public QThread
+{
+public:
+    MImPluginWatchdogThread(MImPluginWatchdog *watchdog, int interval)
+        : watchdog(watchdog)
+        , interval(interval)
+        , stopping(false)
+    {}
+
+    void stop()
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeAll();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&mutex);
+
+        while (!stopping) {
+            condition.wait(&mutex, interval);
+            if (!stopping) {
+                watchdog->checkForStall();
+            }
+        }
+    }
+
+private:
+    MImPluginWatchdog * const watchdog;
+    const int interval;
+    QMutex mutex;
+    QWaitCondition condition;
+    bool stopping;
+};
+
+MImPluginCallEvent::MImPluginCallEvent()
+    : type(OverBudget)
+    , duration(0)
+    , limit(0)
+    , timestamp(0)
+{
+}
+
+MImPluginWatchdog::MImPluginWatchdog(QObject *parent)
+    : QObject(parent)
+    , threshold(0)
+    , lastBeat(-1)
+    , stallReported(false)
+{
+    qRegisterMetaType<MImPluginCallEvent>();
+
+    for (int n = 0; n < CallCount; ++n) {
+        budgets[n] = DefaultBudget;
+    }
+
+    clock.start();
+    connect(&heartbeat, SIGNAL(timeout()), this, SLOT(beat()));
+}
+
+MImPluginWatchdog::~MImPluginWatchdog()
+{
+    setStallThreshold(0);
+}
+
+const char *MImPluginWatchdog::callName(Call call)
+{
+    return (call >= 0 && call < CallCount) ? CallNames[call] : "unknown";
+}
+
+MImPluginWatchdog::Call MImPluginWatchdog::call(const QString &name)
+{
+    for (int n = 0; n < CallCount; ++n) {
+        if (name == QLatin1String(CallNames[n])) {
+            return static_cast<Call>(n);
+        }
+    }
+
+    return CallCount;
+}
+
+void MImPluginWatchdog::setBudget(Call call, int milliseconds)
+{
+    budgets[call] = qMax(0, milliseconds);
+}
+
+int MImPluginWatchdog::budget(Call call) const
+{
+    return budgets[call];
+}
+
+void MImPluginWatchdog::setStallThreshold(int milliseconds)
+{
+    milliseconds = qMax(0, milliseconds);
+    if (milliseconds == threshold) {
+        return;
+    }
+
+    if (thread) {
+        thread->stop();
+        thread->wait();
+        thread.reset();
+    }
+    heartbeat.stop();
+
+    {
+        QMutexLocker locker(&mutex);
+        threshold = milliseconds;
+        // Stalls are only reported once the main loop is running.
+        lastBeat = -1;
+        stallReported = false;
+    }
+
+    if (threshold > 0) {
+        const int interval = qMax(MinimumBeatInterval, threshold / 4);
+
+        heartbeat.start(interval);
+        thread.reset(new MImPluginWatchdogThread(this, interval));
+        thread->start(QThread::LowPriority);
+    }
+}
+
+int MImPluginWatchdog::stallThreshold() const
+{
+    return threshold;
+}
+
+void MImPluginWatchdog::setMetrics(const QSharedPointer<MImMetrics> &newMetrics)
+{
+    metrics = newMetrics;
+}
+
+void MImPluginWatchdog::beginCall(const QString &pluginId, Call call)
+{
+    QMutexLocker locker(&mutex);
+    const Frame frame = { pluginId, call, clock.elapsed() };
+
+    stack.append(frame);
+}
+
+void MImPluginWatchdog::endCall()
+{
+    QMutexLocker locker(&mutex);
+
+    if (stack.isEmpty()) {
+        return;
+    }
+
+    const Frame frame = stack.takeLast();
+    const qint64 duration = clock.elapsed() - frame.start;
+    locker.unlock();
+
+    const int budget = budgets[frame.call];
+    if (budget == 0 || duration <= budget) {
+        return;
+    }
+
+    MImPluginCallEvent event;
+    event.type = MImPluginCallEvent::OverBudget;
+    event.pluginId = frame.pluginId;
+    event.call = QString::fromLatin1(CallNames[frame.call]);
+    event.duration = duration;
+    event.limit = budget;
+    event.timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    qCWarning(lcMaliitFw) << "Plugin" << event.pluginId << "took" << duration << "ms in"
+                          << CallNames[frame.call] << ", budget is" << budget << "ms";
+
+    addEvent(event);
+}
+
+QList<MImPluginCallEvent> MImPluginWatchdog::events() const
+{
+    return recentEvents;
+}
+
+void MImPluginWatchdog::beat()
+{
+    QMutexLocker locker(&mutex);
+
+    lastBeat = clock.elapsed();
+    stallReported = false;
+}
+
+void MImPluginWatchdog::addEvent(const MImPluginCallEvent &event)
+{
+    recentEvents.append(event);
+    while (recentEvents.count() > MaxEvents) {
+        recentEvents.removeFirst();
+    }
+
+    if (metrics) {
+        metrics->increment(event.type == MImPluginCallEvent::Stall ? MImMetrics::MainLoopStalls
+                                                                   : MImMetrics::SlowPluginCalls);
+    }
+
+    Q_EMIT eventOccurred(event);
+}
+
+void MImPluginWatchdog::checkForStall()
+{
+    MImPluginCallEvent event;
+
+    {
+        QMutexLocker locker(&mutex);
+        const qint64 now = clock.elapsed();
+
+        if (lastBeat < 0 || stallReported || threshold == 0 || now - lastBeat <= threshold) {
+            return;
+        }
+
+        stallReported = true;
+        event.type = MImPluginCallEvent::Stall;
+        event.duration = now - lastBeat;
+        event.limit = threshold;
+        if (!stack.isEmpty()) {
+            event.pluginId = stack.last().pluginId;
+            event.call = QString::fromLatin1(CallNames[stack.last().call]);
+        }
+    }
+
+    event.timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    // Logged right away, while the main thread is still stuck; the event
+    // itself is recorded once the main loop runs again.
+    if (event.pluginId.isEmpty()) {
+        qCWarning(lcMaliitFw) << "Main loop stalled for" << event.duration
+                              << "ms outside of plugin calls";
+    } else {
+        qCWarning(lcMaliitFw) << "Main loop stalled for" << event.duration << "ms in"
+                              << event.call << "of plugin" << event.pluginId;
+    }
+
+    QMetaObject::invokeMethod(this, "addEvent", Qt::QueuedConnection,
+                              Q_ARG(MImPluginCallEvent, event));
+}
@@ -0,0 +1,197 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MIMPLUGINWATCHDOG_H
+#define MIMPLUGINWATCHDOG_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+class MImMetrics;
+class MImPluginWatchdogThread;
+
+//! \internal
+
+//! \brief A plugin call that exceeded its time budget, or a stall of the main loop.
+struct MImPluginCallEvent
+{
+    enum Type {
+        OverBudget, //!< A plugin call returned after its budget
+        Stall       //!< The main loop did not run for longer than the stall threshold
+    };
+
+    MImPluginCallEvent();
+
+    Type type;
+    //! Plugin being called; empty for stalls outside of plugin calls
+    QString pluginId;
+    //! Name of the MAbstractInputMethod method being called
+    QString call;
+    //! Duration of the call or stall so far, in milliseconds
+    qint64 duration;
+    //! Budget or stall threshold that was exceeded, in milliseconds
+    qint64 limit;
+    //! When the event was detected, in milliseconds since the epoch
+    qint64 timestamp;
+};
+
+Q_DECLARE_METATYPE(MImPluginCallEvent)
+
+/*! \ingroup maliitserver
+ * \brief Measures calls into plugins against per-call budgets and watches
+ * the main loop for stalls.
+ *
+ * Plugins are called serially on the main thread, so a slow plugin delays
+ * every client. Callers wrap each call into a plugin with an
+ * MImPluginCallGuard; calls taking longer than their budget are logged with
+ * the plugin id. A separate thread checks a heartbeat of the main loop and
+ * reports stalls over the threshold while they happen, naming the plugin
+ * call that is running.
+ *
+ * All events are logged, counted in the metrics registry and kept in a
+ * bounded list, see events().
+ */
+class MImPluginWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Methods of MAbstractInputMethod called by the server
+    enum Call {
+        Show,
+        Hide,
+        Reset,
+        Update,
+        ProcessKeyEvent,
+        SetPreedit,
+        HandleFocusChange,
+        HandleVisualizationPriorityChange,
+        ImExtensionEvent,
+        HandleMouseClickOnPreedit,
+        HandleClientChange,
+        HandleAppOrientationAboutToChange,
+        HandleAppOrientationChanged,
+        SetState,
+        SetActiveSubView,
+        SwitchContext,
+        SetKeyOverrides,
+        ShowLanguageNotification,
+        CallCount
+    };
+
+    //! Default budget of every call, in milliseconds
+    static const int DefaultBudget = 50;
+    //! Default stall threshold, in milliseconds; stall detection runs a
+    //! thread and is opt-in
+    static const int DefaultStallThreshold = 0;
+    //! Number of events kept by events()
+    static const int MaxEvents = 64;
+
+    explicit MImPluginWatchdog(QObject *parent = 0);
+    ~MImPluginWatchdog();
+
+    //! Returns the method name of \a call, e.g. "processKeyEvent".
+    static const char *callName(Call call);
+    //! Returns the call named \a name, or CallCount if there is none.
+    static Call call(const QString &name);
+
+    //! Sets the budget of \a call in milliseconds; 0 disables the check.
+    void setBudget(Call call, int milliseconds);
+    int budget(Call call) const;
+
+    //! Sets the stall threshold in milliseconds; 0 stops the watchdog thread.
+    void setStallThreshold(int milliseconds);
+    int stallThreshold() const;
+
+    void setMetrics(const QSharedPointer<MImMetrics> &metrics);
+
+    //! Marks the start of \a call into the plugin \a pluginId. Calls may nest.
+    void beginCall(const QString &pluginId, Call call);
+    //! Marks the end of the innermost call and checks its budget.
+    void endCall();
+
+    //! Returns the most recent events, oldest first.
+    QList<MImPluginCallEvent> events() const;
+
+Q_SIGNALS:
+    void eventOccurred(const MImPluginCallEvent &event);
+
+private Q_SLOTS:
+    void beat();
+    void addEvent(const MImPluginCallEvent &event);
+
+private:
+    Q_DISABLE_COPY(MImPluginWatchdog)
+
+    friend class MImPluginWatchdogThread;
+
+    struct Frame {
+        QString pluginId;
+        Call call;
+        qint64 start;
+    };
+
+    //! Called from the watchdog thread
+    void checkForStall();
+
+    int budgets[CallCount];
+    int threshold;
+    QSharedPointer<MImMetrics> metrics;
+    QList<MImPluginCallEvent> recentEvents;
+    QTimer heartbeat;
+    QScopedPointer<MImPluginWatchdogThread> thread;
+
+    // Shared with the watchdog thread, guarded by mutex
+    mutable QMutex mutex;
+    QElapsedTimer clock;
+    QVector<Frame> stack;
+    qint64 lastBeat;
+    bool stallReported;
+};
+
+/*! \brief Reports a call into a plugin to a watchdog for its lifetime.
+ *
+ * Does nothing if the watchdog is null.
+ */
+class MImPluginCallGuard
+{
+public:
+    MImPluginCallGuard(MImPluginWatchdog *watchdog, const QString &pluginId,
+                       MImPluginWatchdog::Call call)
+        : watchdog(watchdog)
+    {
+        if (watchdog) {
+            watchdog->beginCall(pluginId, call);
+        }
+    }
+
+    ~MImPluginCallGuard()
+    {
+        if (watchdog) {
+            watchdog->endCall();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(MImPluginCallGuard)
+
+    MImPluginWatchdog * const watchdog;
+};
+
+//! \internal_end
+
+#endif // MIMPLUGINWATCHDOG_H
@@ -14,7 +14,9 @@
 #include "mimserver.h"
 
 #include "mimpluginmanager.h"
+#include "mimmetrics.h"
 #include "mimsettings.h"
+#include "minputcontextconnection.h"
 #include "logging.h"
 
 class MImServerPrivate
@@ -44,11 +46,13 @@ MImServer::MImServer(const QSharedPointer<MInputContextConnection> &icConnection
     Q_D(MImServer);
 
     d->icConnection = icConnection;
+    MImSettings::setMetrics(icConnection->metrics());
     d->pluginManager = new MIMPluginManager(d->icConnection, platform);
 }
 
 MImServer::~MImServer()
 {
+    MImSettings::setMetrics(QSharedPointer<MImMetrics>());
 }
 
 void MImServer::configureSettings(MImServer::SettingsType settingsType)
@@ -14,6 +14,7 @@
 #include "mimserveroptions.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <QtGlobal>
@@ -30,7 +31,10 @@ namespace {
 
     CommandLineParameter AvailableConnectionParameters[] = {
         { "-allow-anonymous",   "Allow anonymous/unauthenticated use of DBus interface"},
-        { "-override-address",  "Override the DBus peer-to-peer address for input-context"}
+        { "-override-address",  "Override the DBus peer-to-peer address for input-context"},
+        { "-record-session",    "Record all input-context calls to the given file, for maliit-replay"},
+        { "-enable-metrics",    "Collect runtime metrics and publish them on D-Bus as org.maliit.server.Metrics"},
+        { "-metrics-log-interval", "Log the runtime metrics every given number of seconds; implies -enable-metrics"}
     };
 
     struct IgnoredParameter {
@@ -353,6 +357,27 @@ MImServerConnectionOptionsParser::parseParameter(const char *parameter,
                     fprintf(stderr, "ERROR: No argument passed to -override-address\n");
                     *argumentCount = 0;
                 }
+            } else if (!strcmp(parameter, "-record-session")) {
+                if (next) {
+                    storage->sessionRecordingFile = QString::fromUtf8(next);
+                    *argumentCount = 1;
+                } else {
+                    fprintf(stderr, "ERROR: No argument passed to -record-session\n");
+                    *argumentCount = 0;
+                }
+            } else if (!strcmp(parameter, "-enable-metrics")) {
+                storage->metricsEnabled = true;
+                *argumentCount = 0;
+            } else if (!strcmp(parameter, "-metrics-log-interval")) {
+                const int interval = next ? atoi(next) : 0;
+                if (interval > 0) {
+                    storage->metricsEnabled = true;
+                    storage->metricsLogInterval = interval;
+                    *argumentCount = 1;
+                } else {
+                    fprintf(stderr, "ERROR: -metrics-log-interval needs a positive number of seconds\n");
+                    *argumentCount = next ? 1 : 0;
+                }
             } else {
                 fprintf(stderr, "ERROR: connection option %s declared but unhandled\n", parameter);
             }
@@ -377,6 +402,8 @@ void MImServerConnectionOptionsParser::printAvailableOptions(const char *format)
 }
 MImServerConnectionOptions::MImServerConnectionOptions()
     : allowAnonymous(false)
+    , metricsEnabled(false)
+    , metricsLogInterval(0)
 {
     const ParserBasePtr p(new MImServerConnectionOptionsParser(this));
     parsers.append(p);
@@ -39,6 +39,12 @@ public:
     //! Contains true if user asks for help or provided incorrect parameter
     bool allowAnonymous;
     QString overriddenAddress;
+    //! File all input context calls are recorded to; empty if not recording
+    QString sessionRecordingFile;
+    //! Contains true if runtime metrics are collected
+    bool metricsEnabled;
+    //! Interval of the metrics log dump in seconds; 0 if metrics are not logged
+    int metricsLogInterval;
 };
 
 
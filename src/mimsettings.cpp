@@ -13,6 +13,7 @@
 
 #include "mimsettings.h"
 #include "mimsettingsqsettings.h"
+#include "mimmetrics.h"
 #include "logging.h"
 
 #include <QString>
@@ -26,6 +27,7 @@ typedef MImSettingsQSettingsBackendFactory MImSettingsDefaultPersistentBackendFa
 
 QScopedPointer<MImSettingsBackendFactory> MImSettings::factory;
 MImSettings::SettingsType MImSettings::preferredSettingsType = MImSettings::InvalidSettings;
+QSharedPointer<MImMetrics> MImSettings::metrics;
 
 // Mutex for thread-safe factory initialization
 static QMutex &factoryMutex()
@@ -64,6 +66,10 @@ QVariant MImSettings::value(const QVariant &def) const
 
 void MImSettings::set(const QVariant &val)
 {
+    if (metrics) {
+        metrics->increment(MImMetrics::SettingsWrites);
+    }
+
     if (val.isValid()) {
         backend->set(val);
     } else {
@@ -73,6 +79,10 @@ void MImSettings::set(const QVariant &val)
 
 void MImSettings::unset()
 {
+    if (metrics) {
+        metrics->increment(MImMetrics::SettingsWrites);
+    }
+
     backend->unset();
 }
 
@@ -139,6 +149,11 @@ void MImSettings::setImplementationFactory(MImSettingsBackendFactory *newFactory
     factory.reset(newFactory);
 }
 
+void MImSettings::setMetrics(const QSharedPointer<MImMetrics> &newMetrics)
+{
+    metrics = newMetrics;
+}
+
 QHash<QString, QVariant> MImSettings::defaults()
 {
     QHash<QString, QVariant> defaults;
@@ -22,7 +22,9 @@
 #include <QStringList>
 #include <QObject>
 #include <QScopedPointer>
+#include <QSharedPointer>
 
+class MImMetrics;
 
 //! \internal
 
@@ -241,6 +243,11 @@ public:
     */
     static QHash<QString, QVariant> defaults();
 
+    /*! Count every set() and unset() in \a metrics; pass a null pointer
+     *  to stop counting.
+     */
+    static void setMetrics(const QSharedPointer<MImMetrics> &metrics);
+
 Q_SIGNALS:
     /*! Emitted when the value of this item has changed.
      */
@@ -250,6 +257,7 @@ private:
     QScopedPointer<MImSettingsBackend> backend;
     static QScopedPointer<MImSettingsBackendFactory> factory;
     static SettingsType preferredSettingsType;
+    static QSharedPointer<MImMetrics> metrics;
 };
 
 //! \internal_end
@@ -19,6 +19,13 @@
 
 #include <maliit/namespace.h>
 
+namespace
+{
+    const char * const SurroundingTextAttribute = "surroundingText";
+    const char * const CursorPositionAttribute = "cursorPosition";
+    const char * const AnchorPositionAttribute = "anchorPosition";
+}
+
 MInputMethodHost::MInputMethodHost(const QSharedPointer<MInputContextConnection> &inputContextConnection,
                                    MIMPluginManager *pluginManager,
                                    const QSharedPointer<Maliit::WindowGroup> &windowGroup,
@@ -31,7 +38,9 @@ MInputMethodHost::MInputMethodHost(const QSharedPointer<MInputContextConnection>
       enabled(false),
       pluginId(plugin),
       pluginDescription(description),
-      mWindowGroup(windowGroup)
+      mWindowGroup(windowGroup),
+      expectedCursorPosition(-1),
+      preeditStart(-1)
 {
     // nothing
 }
@@ -53,6 +62,67 @@ void MInputMethodHost::setInputMethod(MAbstractInputMethod *inputMethod)
     this->inputMethod = inputMethod;
 }
 
+void MInputMethodHost::handleEditorStateChanged()
+{
+    sentText.clear();
+    expectedCursorPosition = -1;
+    preeditStart = -1;
+    advanceEditorStateGeneration();
+}
+
+void MInputMethodHost::handleWidgetStateChanged(const QMap<QString, QVariant> &oldState,
+                                                const QMap<QString, QVariant> &newState,
+                                                bool focusChanged)
+{
+    if (focusChanged) {
+        handleEditorStateChanged();
+        return;
+    }
+
+    const QString text = newState.value(SurroundingTextAttribute).toString();
+    const int cursorPosition = newState.value(CursorPositionAttribute).toInt();
+
+    if (text == oldState.value(SurroundingTextAttribute).toString()
+        && cursorPosition == oldState.value(CursorPositionAttribute).toInt()
+        && newState.value(AnchorPositionAttribute) == oldState.value(AnchorPositionAttribute)) {
+        // Only the cursor rectangle, hints and the like changed, e.g. while
+        // the preedit grew
+        return;
+    }
+
+    // Editors report the preedit or commit string of the input method in front
+    // of the cursor, right where it was sent to; that is the input method's
+    // own doing. Anywhere else, the user moved the cursor.
+    if (expectedCursorPosition >= 0 && cursorPosition == expectedCursorPosition
+        && text.left(cursorPosition).endsWith(sentText)) {
+        sentText.clear();
+        expectedCursorPosition = -1;
+        return;
+    }
+
+    handleEditorStateChanged();
+}
+
+void MInputMethodHost::expectEcho(const QString &string, int replaceStart, int cursorPos, bool preedit)
+{
+    // A preedit replaces the previous one; a commit replaces the preedit
+    int start = preeditStart;
+    if (start < 0) {
+        QString text;
+        if (!connection->surroundingText(text, start)) {
+            sentText.clear();
+            expectedCursorPosition = -1;
+            return;
+        }
+    }
+    start += replaceStart;
+
+    sentText = string;
+    expectedCursorPosition = start + ((cursorPos >= 0) ? qMin(cursorPos, string.length())
+                                                         : string.length());
+    preeditStart = (preedit && !string.isEmpty()) ? start : -1;
+}
+
 int MInputMethodHost::contentType(bool &valid)
 {
     return connection->contentType(valid);
@@ -125,6 +195,7 @@ void MInputMethodHost::sendPreeditString(const QString &string,
                                          int cursorPos)
 {
     if (enabled) {
+        expectEcho(string, replacementStart, cursorPos, true);
         connection->sendPreeditString(string, preeditFormats, replacementStart, replacementLength, cursorPos);
     }
 }
@@ -133,6 +204,7 @@ void MInputMethodHost::sendCommitString(const QString &string, int replaceStart,
                                         int replaceLength, int cursorPos)
 {
     if (enabled) {
+        expectEcho(string, replaceStart, cursorPos, false);
         connection->sendCommitString(string, replaceStart, replaceLength, cursorPos);
     }
 }
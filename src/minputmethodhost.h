@@ -16,6 +16,9 @@
 
 #include <maliit/plugins/abstractinputmethodhost.h>
 
+#include <QMap>
+#include <QVariant>
+
 class MInputContextConnection;
 class MIMPluginManager;
 class MAbstractInputMethod;
@@ -55,6 +58,16 @@ public:
     //! Multiple calls is (currently) undefined behavior.
     void setInputMethod(MAbstractInputMethod *inputMethod);
 
+    //! a key press arrived or the editor changed, worker tasks submitted
+    //! before are stale
+    void handleEditorStateChanged();
+
+    //! a newer widget state arrived; worker tasks submitted before are stale
+    //! unless the update only echoes what this host sent to the editor
+    void handleWidgetStateChanged(const QMap<QString, QVariant> &oldState,
+                                  const QMap<QString, QVariant> &newState,
+                                  bool focusChanged);
+
     // \reimp
     virtual int contentType(bool &valid);
     virtual bool correctionEnabled(bool &valid);
@@ -108,6 +121,9 @@ public:
 private:
     Q_DISABLE_COPY(MInputMethodHost)
 
+    //! Remembers where the editor reports the cursor once it shows \a string
+    void expectEcho(const QString &string, int replaceStart, int cursorPos, bool preedit);
+
     QSharedPointer<MInputContextConnection> connection;
     MIMPluginManager *pluginManager;
     MAbstractInputMethod *inputMethod;
@@ -115,6 +131,12 @@ private:
     QString pluginId;
     QString pluginDescription;
     QSharedPointer<Maliit::WindowGroup> mWindowGroup;
+    //! preedit or commit string sent since the editor state last changed
+    QString sentText;
+    //! cursor position the editor reports after showing sentText; -1 if none
+    int expectedCursorPosition;
+    //! position of the preedit shown in the editor; -1 if none
+    int preeditStart;
 };
 
 //! \internal_end
@@ -18,13 +18,24 @@ struct MSharedAttributeExtensionManagerPluginSetting
     MSharedAttributeExtensionManagerPluginSetting(const QString &key, Maliit::SettingEntryType type, QVariantMap attributes) :
         setting(key),
         type(type),
-        attributes(attributes)
+        attributes(attributes),
+        validator(type, attributes),
+        target(QString::fromLatin1("/") + key.section('/', 1, 1)),
+        targetItem(key.section('/', 2, -2)),
+        attribute(key.section('/', -1, -1))
     {
     }
 
     MImSettings setting;
     Maliit::SettingEntryType type;
     QVariantMap attributes;
+    // attributes compiled once, values are checked on every update
+    const MImSettingValidator validator;
+
+    // key split into the parts sent to clients, computed once at registration
+    const QString target;
+    const QString targetItem;
+    const QString attribute;
 };
 
 
@@ -88,7 +99,7 @@ void MSharedAttributeExtensionManager::handleExtendedAttributeUpdate(unsigned in
     if (it == sharedAttributeExtensions.end())
         return;
     // TODO error notification
-    if (!validateSettingValue(it->data()->type, it->data()->attributes, value))
+    if (!it->data()->validator.validate(value))
         return;
 
     it->data()->setting.set(value);
@@ -100,13 +111,13 @@ void MSharedAttributeExtensionManager::attributeValueChanged()
 
     if (!value)
         return;
-    if (sharedAttributeExtensions.find(value->key()) == sharedAttributeExtensions.end())
+
+    SharedAttributeExtensionContainer::const_iterator it = sharedAttributeExtensions.constFind(value->key());
+    if (it == sharedAttributeExtensions.constEnd())
         return;
 
-    const QString fullName = value->key();
-    const QString &target = QString::fromLatin1("/") + fullName.section('/', 1, 1);
-    const QString &targetItem = fullName.section('/', 2, -2);
-    const QString &attribute = fullName.section('/', -1, -1);
+    const MSharedAttributeExtensionManagerPluginSetting *setting = it->data();
 
-    Q_EMIT notifyExtensionAttributeChanged(clientIds, PluginSettings, target, targetItem, attribute, value->value());
+    Q_EMIT notifyExtensionAttributeChanged(clientIds, PluginSettings, setting->target, setting->targetItem,
+                                           setting->attribute, value->value());
 }
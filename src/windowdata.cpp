@@ -17,12 +17,14 @@ namespace Maliit
 
 WindowData::WindowData()
     : m_window(),
-      m_position(Maliit::PositionCenterBottom)
+      m_position(Maliit::PositionCenterBottom),
+      m_inputRegionSet(false)
 {}
 
 WindowData::WindowData(QWindow *window, Maliit::Position position)
     : m_window(window),
-      m_position(position)
+      m_position(position),
+      m_inputRegionSet(false)
 {}
 
 } // namespace Maliit
@@ -31,6 +31,8 @@ struct WindowData
     QPointer<QWindow> m_window;
     Maliit::Position m_position;
     QRegion m_inputMethodArea;
+    QRegion m_inputRegion;
+    bool m_inputRegionSet;
 };
 
 } // namespace Maliit
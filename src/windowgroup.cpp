@@ -11,26 +11,55 @@
  */
 
 #include <QDebug>
+#include <QGuiApplication>
+#include <QQuickWindow>
+#include <QScreen>
 
 #include "abstractplatform.h"
+#include "mimmetrics.h"
 #include "windowgroup.h"
 #include "logging.h"
 
+namespace
+{
+    const qreal DefaultRefreshRate = 60.0;
+    const qint64 UpdateRatePeriod = 1000; // in ms
+}
+
 namespace Maliit
 {
 
 WindowGroup::WindowGroup(const QSharedPointer<AbstractPlatform> &platform)
     : m_platform(platform),
-      m_active(false)
+      m_active(false),
+      m_areaUpdatePending(false),
+      m_areaUpdateCount(0)
 {
     m_hideTimer.setSingleShot(true);
     m_hideTimer.setInterval(2000);
     connect(&m_hideTimer, SIGNAL(timeout()), this, SLOT(hideWindows()));
+
+    // Geometry changes during show/hide animations arrive on every tick;
+    // resolve them at most once per frame.
+    m_areaUpdateTimer.setSingleShot(true);
+    m_areaUpdateTimer.setInterval(frameInterval());
+    connect(&m_areaUpdateTimer, SIGNAL(timeout()), this, SLOT(flushInputMethodAreaUpdate()));
+
+    m_areaUpdateClock.start();
 }
 
 WindowGroup::~WindowGroup()
 {}
 
+int WindowGroup::frameInterval()
+{
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate = (screen && screen->refreshRate() > 0)
+            ? screen->refreshRate() : DefaultRefreshRate;
+
+    return qMax(1, qRound(1000.0 / refreshRate));
+}
+
 void WindowGroup::activate()
 {
     m_active = true;
@@ -75,13 +104,17 @@ void WindowGroup::setupWindow(QWindow *window, Maliit::Position position)
             connect (window, SIGNAL (visibleChanged(bool)),
                      this, SLOT (onVisibleChanged(bool)));
             connect (window, SIGNAL (heightChanged(int)),
-                     this, SLOT (updateInputMethodArea()));
+                     this, SLOT (scheduleInputMethodAreaUpdate()));
             connect (window, SIGNAL (widthChanged(int)),
-                     this, SLOT (updateInputMethodArea()));
+                     this, SLOT (scheduleInputMethodAreaUpdate()));
             connect (window, SIGNAL (xChanged(int)),
-                     this, SLOT (updateInputMethodArea()));
+                     this, SLOT (scheduleInputMethodAreaUpdate()));
             connect (window, SIGNAL (yChanged(int)),
-                     this, SLOT (updateInputMethodArea()));
+                     this, SLOT (scheduleInputMethodAreaUpdate()));
+            if (QQuickWindow *quickWindow = qobject_cast<QQuickWindow *>(window)) {
+                connect (quickWindow, SIGNAL (frameSwapped()),
+                         this, SLOT (flushInputMethodAreaUpdate()));
+            }
             m_platform->setupInputPanel(window, position);
             updateInputMethodArea();
         }
@@ -101,6 +134,23 @@ void WindowGroup::setScreenRegion(const QRegion &region, QWindow *window)
         qCWarning(lcMaliitFw) << Q_FUNC_INFO << "No window to set region on";
         return;
     }
+
+    for (int i = 0; i < m_window_list.size(); ++i) {
+        WindowData &data = m_window_list[i];
+        if (data.m_window == window) {
+            if (data.m_inputRegionSet && data.m_inputRegion == region) {
+                return;
+            }
+            data.m_inputRegion = region;
+            data.m_inputRegionSet = true;
+            break;
+        }
+    }
+
+    if (m_metrics) {
+        m_metrics->increment(MImMetrics::InputRegionUpdates);
+    }
+
     m_platform->setInputRegion(window, region);
 }
 
@@ -125,7 +175,7 @@ void WindowGroup::setInputMethodArea(const QRegion &region, QWindow *window)
     // We should update the input method area regardless of whether we're still
     // active or not, as keyboard hiding animations could be changing this
     // region after we've deactivated
-    updateInputMethodArea();
+    scheduleInputMethodAreaUpdate();
 }
 
 void WindowGroup::setApplicationWindow(WId id)
@@ -151,8 +201,52 @@ void WindowGroup::onVisibleChanged(bool visible)
     }
 }
 
+quint64 WindowGroup::inputMethodAreaUpdateCount() const
+{
+    return m_areaUpdateCount;
+}
+
+qreal WindowGroup::inputMethodAreaUpdateRate() const
+{
+    // Measured against the current time, so that the rate drops once
+    // updates stop instead of reporting the last busy period forever.
+    const qint64 periodStart = m_areaUpdateClock.elapsed() - UpdateRatePeriod;
+    int updates = 0;
+
+    Q_FOREACH (qint64 timestamp, m_areaUpdateTimestamps) {
+        if (timestamp > periodStart) {
+            ++updates;
+        }
+    }
+
+    return updates * 1000.0 / UpdateRatePeriod;
+}
+
+void WindowGroup::setMetrics(const QSharedPointer<MImMetrics> &metrics)
+{
+    m_metrics = metrics;
+}
+
+void WindowGroup::scheduleInputMethodAreaUpdate()
+{
+    m_areaUpdatePending = true;
+    if (not m_areaUpdateTimer.isActive()) {
+        m_areaUpdateTimer.start();
+    }
+}
+
+void WindowGroup::flushInputMethodAreaUpdate()
+{
+    if (m_areaUpdatePending) {
+        updateInputMethodArea();
+    }
+}
+
 void WindowGroup::updateInputMethodArea()
 {
+    m_areaUpdatePending = false;
+    m_areaUpdateTimer.stop();
+
     QRegion new_area;
 
     Q_FOREACH (const WindowData &data, m_window_list) {
@@ -165,10 +259,28 @@ void WindowGroup::updateInputMethodArea()
 
     if (new_area != m_last_im_area) {
         m_last_im_area = new_area;
+        recordInputMethodAreaUpdate();
         Q_EMIT inputMethodAreaChanged(m_last_im_area);
     }
 }
 
+void WindowGroup::recordInputMethodAreaUpdate()
+{
+    ++m_areaUpdateCount;
+
+    if (m_metrics) {
+        m_metrics->increment(MImMetrics::InputMethodAreaUpdates);
+    }
+
+    // Updates are coalesced per frame, so this holds at most one period
+    // worth of frames.
+    const qint64 now = m_areaUpdateClock.elapsed();
+    m_areaUpdateTimestamps.enqueue(now);
+    while (m_areaUpdateTimestamps.head() <= now - UpdateRatePeriod) {
+        m_areaUpdateTimestamps.dequeue();
+    }
+}
+
 bool WindowGroup::containsWindow(QWindow *window)
 {
     Q_FOREACH (const WindowData &data, m_window_list) {
@@ -180,6 +292,29 @@ bool WindowGroup::containsWindow(QWindow *window)
     return false;
 }
 
+void WindowGroup::prepareWindows()
+{
+    Q_FOREACH (const WindowData &data, m_window_list) {
+        if (data.m_window && not data.m_window->handle()) {
+            data.m_window->create();
+        }
+    }
+}
+
+qint64 WindowGroup::memoryEstimate() const
+{
+    qint64 estimate = 0;
+
+    Q_FOREACH (const WindowData &data, m_window_list) {
+        if (data.m_window) {
+            const QSize size = data.m_window->size() * data.m_window->devicePixelRatio();
+            estimate += qint64(size.width()) * size.height() * 4 * 2;
+        }
+    }
+
+    return estimate;
+}
+
 void WindowGroup::hideWindows()
 {
     m_hideTimer.stop();
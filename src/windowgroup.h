@@ -13,7 +13,9 @@
 #ifndef MALIIT_SERVER_WINDOW_GROUP_H
 #define MALIIT_SERVER_WINDOW_GROUP_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QQueue>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QRegion>
@@ -24,6 +26,8 @@
 
 #include <maliit/namespace.h>
 
+class MImMetrics;
+
 QT_BEGIN_NAMESPACE
 class QWindow;
 QT_END_NAMESPACE
@@ -48,6 +52,9 @@ public:
     WindowGroup(const QSharedPointer<AbstractPlatform> &platform);
     ~WindowGroup();
 
+    //! Returns the duration of one frame of the primary screen, in milliseconds.
+    static int frameInterval();
+
     void activate();
     void deactivate(HideMode mode);
 
@@ -56,6 +63,26 @@ public:
     void setInputMethodArea(const QRegion &region, QWindow *window);
     void setApplicationWindow(WId id);
 
+    //! Creates the platform windows of the group without showing them, so
+    //! that a later show does not pay for window creation.
+    void prepareWindows();
+
+    //! Returns a rough estimate, in bytes, of the memory held by the window
+    //! surfaces of the group (double-buffered 32 bit surfaces).
+    qint64 memoryEstimate() const;
+
+    //! Returns how many times inputMethodAreaChanged has been emitted.
+    quint64 inputMethodAreaUpdateCount() const;
+
+    //! Returns the measured inputMethodAreaChanged rate over the last second,
+    //! in updates per second.
+    //! Geometry changes are coalesced per frame, so this stays at or below
+    //! the refresh rate of the screen.
+    qreal inputMethodAreaUpdateRate() const;
+
+    //! Counts input region and input method area updates in \a metrics.
+    void setMetrics(const QSharedPointer<MImMetrics> &metrics);
+
 Q_SIGNALS:
     void inputMethodAreaChanged(const QRegion &inputMethodArea);
 
@@ -63,15 +90,25 @@ private Q_SLOTS:
     void hideWindows();
     void onVisibleChanged(bool visible);
     void updateInputMethodArea();
+    void scheduleInputMethodAreaUpdate();
+    void flushInputMethodAreaUpdate();
 
 private:
     bool containsWindow(QWindow *window);
+    void recordInputMethodAreaUpdate();
 
     QSharedPointer<AbstractPlatform> m_platform;
     QVector<WindowData> m_window_list;
     QRegion m_last_im_area;
     bool m_active;
     QTimer m_hideTimer;
+    QTimer m_areaUpdateTimer;
+    bool m_areaUpdatePending;
+    quint64 m_areaUpdateCount;
+    //! When the updates of the last rate period happened, oldest first
+    QQueue<qint64> m_areaUpdateTimestamps;
+    QElapsedTimer m_areaUpdateClock;
+    QSharedPointer<MImMetrics> m_metrics;
 };
 
 } // namespace Maliit
@@ -15,6 +15,7 @@
 
 #include <QDebug>
 #include <QGuiApplication>
+#include <QHash>
 #include <QRegion>
 #include <QVector>
 #include <QWindow>
@@ -23,12 +24,144 @@
 #include "xcbplatform.h"
 #include "logging.h"
 
+namespace
+{
+    enum Atom {
+        NetWmWindowType,
+        NetWmWindowTypeInput,
+        AtomCount
+    };
+
+    const char * const AtomNames[AtomCount] = {
+        "_NET_WM_WINDOW_TYPE",
+        "_NET_WM_WINDOW_TYPE_INPUT"
+    };
+}
+
 namespace Maliit
 {
 
+// Per-connection state: the connection itself, interned atoms and one
+// XFixes region per input panel window, so that neither window setup nor
+// input region changes need to block on the X server.
+class XCBPlatformPrivate : public QObject
+{
+public:
+    XCBPlatformPrivate();
+    ~XCBPlatformPrivate();
+
+    xcb_connection_t *connectionFor(QWindow *window);
+    bool internAtoms();
+    xcb_xfixes_region_t regionFor(QWindow *window);
+    void releaseRegion(QWindow *window);
+
+    xcb_connection_t *connection;
+    bool atomsInterned;
+    xcb_atom_t atoms[AtomCount];
+    QHash<QWindow *, xcb_xfixes_region_t> regions;
+    QVector<xcb_rectangle_t> rects;
+    int roundTrips;
+};
+
+XCBPlatformPrivate::XCBPlatformPrivate()
+    : connection(0),
+      atomsInterned(false),
+      regions(),
+      rects(),
+      roundTrips(0)
+{
+    for (int i = 0; i < AtomCount; ++i) {
+        atoms[i] = XCB_ATOM_NONE;
+    }
+}
+
+XCBPlatformPrivate::~XCBPlatformPrivate()
+{
+    if (connection) {
+        Q_FOREACH (xcb_xfixes_region_t region, regions) {
+            xcb_xfixes_destroy_region(connection, region);
+        }
+    }
+}
+
+xcb_connection_t *XCBPlatformPrivate::connectionFor(QWindow *window)
+{
+    if (!connection) {
+        QPlatformNativeInterface *xcbiface = QGuiApplication::platformNativeInterface();
+        connection = static_cast<xcb_connection_t *>(xcbiface->nativeResourceForWindow("connection", window));
+    }
+
+    return connection;
+}
+
+bool XCBPlatformPrivate::internAtoms()
+{
+    if (atomsInterned) {
+        return true;
+    }
+
+    // Send all requests before waiting for the first reply, so interning
+    // costs a single round-trip regardless of the number of atoms.
+    xcb_intern_atom_cookie_t cookies[AtomCount];
+    for (int i = 0; i < AtomCount; ++i) {
+        cookies[i] = xcb_intern_atom(connection, false, strlen(AtomNames[i]), AtomNames[i]);
+    }
+
+    bool success = true;
+    for (int i = 0; i < AtomCount; ++i) {
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, cookies[i], 0);
+        if (reply) {
+            atoms[i] = reply->atom;
+            free(reply);
+        } else {
+            qCWarning(lcMaliitFw) << "Unable to fetch atom" << AtomNames[i];
+            success = false;
+        }
+    }
+
+    ++roundTrips;
+    qCDebug(lcMaliitFw) << "Xcb platform interned atoms, round-trips so far:" << roundTrips;
+
+    atomsInterned = success;
+    return success;
+}
+
+xcb_xfixes_region_t XCBPlatformPrivate::regionFor(QWindow *window)
+{
+    QHash<QWindow *, xcb_xfixes_region_t>::const_iterator iterator = regions.constFind(window);
+    if (iterator != regions.constEnd()) {
+        return iterator.value();
+    }
+
+    xcb_xfixes_region_t region = xcb_generate_id(connection);
+    xcb_xfixes_create_region(connection, region, 0, 0);
+    regions.insert(window, region);
+
+    QObject::connect(window, &QObject::destroyed,
+                     this, [this, window]() { releaseRegion(window); });
+
+    return region;
+}
+
+void XCBPlatformPrivate::releaseRegion(QWindow *window)
+{
+    const xcb_xfixes_region_t region = regions.take(window);
+    if (region != XCB_NONE && connection) {
+        xcb_xfixes_destroy_region(connection, region);
+    }
+}
+
+XCBPlatform::XCBPlatform()
+    : d_ptr(new XCBPlatformPrivate)
+{}
+
+XCBPlatform::~XCBPlatform()
+{}
+
 void XCBPlatform::setupInputPanel(QWindow* window,
                                   Maliit::Position position)
 {
+    Q_D(XCBPlatform);
     Q_UNUSED(position);
 
     if (not window) {
@@ -36,90 +169,69 @@ void XCBPlatform::setupInputPanel(QWindow* window,
     }
 
     // set window type as input, supported by at least mcompositor
-    QPlatformNativeInterface *xcbiface = QGuiApplication::platformNativeInterface();
-    xcb_connection_t *xcbConnection
-            = static_cast<xcb_connection_t *>(xcbiface->nativeResourceForWindow("connection", window));
+    xcb_connection_t *xcbConnection = d->connectionFor(window);
     if (!xcbConnection) {
         qCWarning(lcMaliitFw) << "Unable to get Xcb connection";
         return;
     }
 
-    const char * windowType = "_NET_WM_WINDOW_TYPE";
-    const char * windowTypeInput = "_NET_WM_WINDOW_TYPE_INPUT";
-
-    xcb_intern_atom_cookie_t windowTypeCookie =
-            xcb_intern_atom(xcbConnection, false, strlen(windowType), windowType);
-    xcb_intern_atom_cookie_t typeInputCookie =
-            xcb_intern_atom(xcbConnection, false, strlen(windowTypeInput), windowTypeInput);
-
-    xcb_atom_t windowTypeAtom;
-    xcb_atom_t windowTypeInputAtom;
-
-    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(xcbConnection, windowTypeCookie, 0);
-    if (reply) {
-        windowTypeAtom = reply->atom;
-        free(reply);
-    } else {
-        qCWarning(lcMaliitFw) << "Unable to fetch window type atom";
+    if (!d->internAtoms()) {
         return;
     }
 
-    reply = xcb_intern_atom_reply(xcbConnection, typeInputCookie, 0);
-    if (reply) {
-        windowTypeInputAtom = reply->atom;
-        free(reply);
-    } else {
-        qCWarning(lcMaliitFw) << "Unable to fetch window type input atom";
-        return;
-    }
-
-    xcb_change_property(xcbConnection, XCB_PROP_MODE_REPLACE, window->winId(), windowTypeAtom, XCB_ATOM_ATOM,
-                        32, 1, &windowTypeInputAtom);
+    xcb_change_property(xcbConnection, XCB_PROP_MODE_REPLACE, window->winId(),
+                        d->atoms[NetWmWindowType], XCB_ATOM_ATOM,
+                        32, 1, &d->atoms[NetWmWindowTypeInput]);
 }
 
 void XCBPlatform::setInputRegion(QWindow* window,
                                  const QRegion& region)
 {
+    Q_D(XCBPlatform);
+
     if (not window) {
         return;
     }
 
-    QVector<xcb_rectangle_t> xcbrects;
-
-    xcbrects.reserve(region.rectCount());
-    Q_FOREACH (const QRect &rect, region) {
-        xcb_rectangle_t xcbrect;
+    xcb_connection_t *xcbconnection = d->connectionFor(window);
+    if (!xcbconnection) {
+        qCWarning(lcMaliitFw) << "Unable to get Xcb connection";
+        return;
+    }
 
-        xcbrect.x = rect.x();
-        xcbrect.y = rect.y();
-        xcbrect.width = rect.width();
-        xcbrect.height = rect.height();
-        xcbrects.append (xcbrect);
+    d->rects.resize(region.rectCount());
+    xcb_rectangle_t *xcbrect = d->rects.data();
+    for (const QRect &rect : region) {
+        xcbrect->x = rect.x();
+        xcbrect->y = rect.y();
+        xcbrect->width = rect.width();
+        xcbrect->height = rect.height();
+        ++xcbrect;
     }
 
-    QPlatformNativeInterface *xcbiface = QGuiApplication::platformNativeInterface();
-    xcb_connection_t *xcbconnection = static_cast<xcb_connection_t *>(xcbiface->nativeResourceForWindow("connection", window));
-    xcb_xfixes_region_t xcbregion = xcb_generate_id(xcbconnection);
-    xcb_xfixes_create_region(xcbconnection, xcbregion,
-                             xcbrects.size(), xcbrects.constData());
+    xcb_xfixes_region_t xcbregion = d->regionFor(window);
+    xcb_xfixes_set_region(xcbconnection, xcbregion,
+                          d->rects.size(), d->rects.constData());
 
     xcb_window_t xcbwindow  = window->winId();
     xcb_xfixes_set_window_shape_region(xcbconnection, xcbwindow,
                                        XCB_SHAPE_SK_BOUNDING, 0, 0, 0);
     xcb_xfixes_set_window_shape_region(xcbconnection, xcbwindow,
                                        XCB_SHAPE_SK_INPUT, 0, 0, xcbregion);
-
-    xcb_xfixes_destroy_region(xcbconnection, xcbregion);
 }
 
 void XCBPlatform::setApplicationWindow(QWindow *window, WId appWindowId)
 {
+    Q_D(XCBPlatform);
+
     qCDebug(lcMaliitFw) << "Xcb platform setting transient target" << QString("0x%1").arg(QString::number(appWindowId, 16))
                         << "for" << QString("0x%1").arg(QString::number(window->winId(), 16));
 
-    QPlatformNativeInterface *xcbiface = QGuiApplication::platformNativeInterface();
-    xcb_connection_t *xcbConnection
-            = static_cast<xcb_connection_t *>(xcbiface->nativeResourceForWindow("connection", window));
+    xcb_connection_t *xcbConnection = d->connectionFor(window);
+    if (!xcbConnection) {
+        qCWarning(lcMaliitFw) << "Unable to get Xcb connection";
+        return;
+    }
 
     xcb_change_property(xcbConnection, XCB_PROP_MODE_REPLACE, window->winId(),
                         XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 32, 1, &appWindowId);
@@ -13,19 +13,31 @@
 #ifndef MALIIT_XCB_PLATFORM_H
 #define MALIIT_XCB_PLATFORM_H
 
+#include <QScopedPointer>
+
 #include "abstractplatform.h"
 
 namespace Maliit
 {
 
+class XCBPlatformPrivate;
+
 class XCBPlatform : public AbstractPlatform
 {
+    Q_DECLARE_PRIVATE(XCBPlatform)
+
 public:
+    XCBPlatform();
+    ~XCBPlatform();
+
     virtual void setupInputPanel(QWindow* window,
                                  Maliit::Position position);
     virtual void setInputRegion(QWindow* window,
                                 const QRegion& region);
     virtual void setApplicationWindow(QWindow *window, WId appWindowId);
+
+private:
+    QScopedPointer<XCBPlatformPrivate> d_ptr;
 };
 
 } // namespace Maliit
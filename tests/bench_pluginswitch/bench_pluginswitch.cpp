@@ -0,0 +1,136 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "bench_pluginswitch.h"
+
+#include "dummyinputmethod.h"
+#include "dummyinputmethod3.h"
+#include "core-utils.h"
+
+#include <minputcontextconnection.h>
+#include <mimpluginmanager.h>
+#include <mimpluginmanager_p.h>
+#include <mimsettings.h>
+#include <unknownplatform.h>
+
+#include <QElapsedTimer>
+
+namespace
+{
+    const QString pluginId  = "libdummyimplugin.so";
+    const QString pluginId3 = "libdummyimplugin3.so";
+
+    const QString EnabledPluginsKey = MALIIT_CONFIG_ROOT"onscreen/enabled";
+    const QString ActivePluginKey   = MALIIT_CONFIG_ROOT"onscreen/active";
+
+    const QString ConfigRoot             = MALIIT_CONFIG_ROOT;
+    const QString MImPluginPaths         = ConfigRoot + "paths";
+    const QString MImPluginDisabled      = ConfigRoot + "disabledpluginfiles";
+    const QString MImAccesoryEnabled     = ConfigRoot + "accessoryenabled";
+    const QString MImStandbyMemoryBudget = ConfigRoot + "standbymemorybudget";
+
+    const int SwitchCount = 200;
+
+    MAbstractInputMethod *onScreenInputMethod(MIMPluginManagerPrivate *d)
+    {
+        Q_FOREACH (Maliit::Plugins::InputMethodPlugin *plugin, d->activePlugins) {
+            if (d->plugins.value(plugin).state.contains(Maliit::OnScreen)) {
+                return d->plugins.value(plugin).inputMethod;
+            }
+        }
+
+        return 0;
+    }
+}
+
+void Bench_PluginSwitch::initTestCase()
+{
+    MImSettings::setPreferredSettingsType(MImSettings::TemporarySettings);
+}
+
+void Bench_PluginSwitch::init()
+{
+    MImSettings(MImPluginPaths).set(MaliitTestUtils::getTestPluginPath());
+    MImSettings(MImPluginDisabled).set(QStringList("libdummyimplugin2.so"));
+    MImSettings(MImAccesoryEnabled).set(QVariant(false));
+
+    MImSettings(EnabledPluginsKey).set(QStringList()
+                                       << pluginId + ":" + "dummyimsv1"
+                                       << pluginId + ":" + "dummyimsv2"
+                                       << pluginId3 + ":" + "dummyim3sv1"
+                                       << pluginId3 + ":" + "dummyim3sv2");
+    MImSettings(ActivePluginKey).set(pluginId + ":" + "dummyimsv1");
+
+    QSharedPointer<MInputContextConnection> icConnection(new MInputContextConnection);
+    subject = new MIMPluginManager(icConnection, QSharedPointer<Maliit::AbstractPlatform>(new Maliit::UnknownPlatform));
+}
+
+void Bench_PluginSwitch::cleanup()
+{
+    delete subject;
+    MImSettings(MImStandbyMemoryBudget).set(QVariant(0));
+}
+
+void Bench_PluginSwitch::benchSwitch_data()
+{
+    QTest::addColumn<int>("budget");
+
+    QTest::newRow("cold") << 0;
+    QTest::newRow("standby") << 64 * 1024; // KiB
+}
+
+void Bench_PluginSwitch::benchSwitch()
+{
+    QFETCH(int, budget);
+
+    MIMPluginManagerPrivate *d = subject->d_ptr;
+    MImSettings(MImStandbyMemoryBudget).set(QVariant(budget));
+    subject->showActivePlugins();
+    // Showing is resolved once per frame
+    QTRY_VERIFY(d->visible);
+    QCoreApplication::processEvents();
+
+    QCOMPARE(d->standbyPlugins.isEmpty(), budget == 0);
+
+    qint64 elapsed = 0;
+    QElapsedTimer timer;
+
+    for (int n = 0; n < SwitchCount; ++n) {
+        MAbstractInputMethod *source = onScreenInputMethod(d);
+        QVERIFY(source);
+
+        // Let the manager warm up the neighbours of the new plugin, this is
+        // not part of the switch latency.
+        QCoreApplication::processEvents();
+
+        timer.start();
+        subject->switchPlugin(Maliit::SwitchForward, source);
+        elapsed += timer.nsecsElapsed();
+
+        QVERIFY(onScreenInputMethod(d) != source);
+    }
+
+    // On standby, plugins get their state once and switching only flips
+    // their visibility.
+    if (budget > 0) {
+        DummyInputMethod3 *inputMethod3 = 0;
+        Q_FOREACH (const MIMPluginManagerPrivate::PluginDescription &desc, d->plugins) {
+            if (desc.pluginId == pluginId3) {
+                inputMethod3 = dynamic_cast<DummyInputMethod3 *>(desc.inputMethod);
+            }
+        }
+        QVERIFY(inputMethod3);
+        QCOMPARE(inputMethod3->setStateCount, 1);
+    }
+
+    QTest::setBenchmarkResult(qreal(elapsed) / SwitchCount / 1000000.0,
+                              QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(Bench_PluginSwitch)
@@ -0,0 +1,35 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef BENCH_PLUGINSWITCH_H
+#define BENCH_PLUGINSWITCH_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+class MIMPluginManager;
+
+class Bench_PluginSwitch : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void init();
+    void cleanup();
+
+    void benchSwitch_data();
+    void benchSwitch();
+
+private:
+    MIMPluginManager *subject;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "bench_settingvalidation.h"
+
+#include <maliit/settingdata.h>
+
+namespace
+{
+    QVariantMap domainAttributes(const QVariantList &domain)
+    {
+        QVariantMap attributes;
+        attributes.insert(Maliit::SettingEntryAttributes::valueDomain, domain);
+        return attributes;
+    }
+
+    // Subview names as found in onscreen/enabled
+    QStringList subViews(int count)
+    {
+        QStringList result;
+        for (int n = 0; n < count; ++n) {
+            result.append(QString::fromLatin1("libmaliit-keyboard-plugin.so:layout%1").arg(n));
+        }
+        return result;
+    }
+
+    void addRows()
+    {
+        QTest::addColumn<int>("size");
+        QTest::addColumn<bool>("compiled");
+
+        const int sizes[] = { 10, 100, 1000 };
+        for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); ++n) {
+            QTest::newRow(QByteArray::number(sizes[n]) + " per call") << sizes[n] << false;
+            QTest::newRow(QByteArray::number(sizes[n]) + " compiled") << sizes[n] << true;
+        }
+    }
+}
+
+void Bench_SettingValidation::testValidation()
+{
+    QVariantMap attributes = domainAttributes(QVariantList() << 1 << 2 << 3);
+    attributes.insert(Maliit::SettingEntryAttributes::valueRangeMax, 2);
+
+    const MImSettingValidator intValidator(Maliit::IntType, attributes);
+    QVERIFY(intValidator.validate(2));
+    QVERIFY(intValidator.validate(QString("1")));
+    QVERIFY(!intValidator.validate(3)); // in domain, above range
+    QVERIFY(!intValidator.validate(4));
+    QVERIFY(!intValidator.validate(QString("one")));
+
+    const MImSettingValidator listValidator(Maliit::IntListType, attributes);
+    QVERIFY(listValidator.validate(QVariantList() << 1 << 2));
+    QVERIFY(listValidator.validate(QVariantList()));
+    QVERIFY(!listValidator.validate(QVariantList() << 1 << 3));
+
+    const MImSettingValidator stringValidator(Maliit::StringListType,
+                                              domainAttributes(QVariantList() << "a" << "b"));
+    QVERIFY(stringValidator.validate(QStringList() << "b" << "a"));
+    QVERIFY(!stringValidator.validate(QStringList() << "a" << "c"));
+
+    const MImSettingValidator boolValidator(Maliit::BoolType, attributes);
+    QVERIFY(boolValidator.validate(true));
+
+    // A domain that is no list rejects everything
+    QVariantMap badAttributes;
+    badAttributes.insert(Maliit::SettingEntryAttributes::valueDomain, QVariant(QPoint()));
+    QVERIFY(!MImSettingValidator(Maliit::StringType, badAttributes).validate("a"));
+}
+
+void Bench_SettingValidation::benchStringList_data()
+{
+    addRows();
+}
+
+void Bench_SettingValidation::benchStringList()
+{
+    QFETCH(int, size);
+    QFETCH(bool, compiled);
+
+    const QStringList names = subViews(size);
+    const QVariantMap attributes = domainAttributes(QVariant(names).toList());
+    // Every subview enabled, the worst case of onscreen/enabled
+    const QVariant value(names);
+    const MImSettingValidator validator(Maliit::StringListType, attributes);
+
+    bool valid = false;
+    if (compiled) {
+        QBENCHMARK {
+            valid = validator.validate(value);
+        }
+    } else {
+        QBENCHMARK {
+            valid = validateSettingValue(Maliit::StringListType, attributes, value);
+        }
+    }
+    QVERIFY(valid);
+}
+
+void Bench_SettingValidation::benchIntList_data()
+{
+    addRows();
+}
+
+void Bench_SettingValidation::benchIntList()
+{
+    QFETCH(int, size);
+    QFETCH(bool, compiled);
+
+    QVariantList values;
+    for (int n = 0; n < size; ++n) {
+        values.append(n);
+    }
+
+    QVariantMap attributes = domainAttributes(values);
+    attributes.insert(Maliit::SettingEntryAttributes::valueRangeMin, 0);
+    attributes.insert(Maliit::SettingEntryAttributes::valueRangeMax, size);
+    const QVariant value(values);
+    const MImSettingValidator validator(Maliit::IntListType, attributes);
+
+    bool valid = false;
+    if (compiled) {
+        QBENCHMARK {
+            valid = validator.validate(value);
+        }
+    } else {
+        QBENCHMARK {
+            valid = validateSettingValue(Maliit::IntListType, attributes, value);
+        }
+    }
+    QVERIFY(valid);
+}
+
+QTEST_MAIN(Bench_SettingValidation)
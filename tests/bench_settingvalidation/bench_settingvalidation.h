@@ -0,0 +1,30 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef BENCH_SETTINGVALIDATION_H
+#define BENCH_SETTINGVALIDATION_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+class Bench_SettingValidation : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testValidation();
+
+    void benchStringList_data();
+    void benchStringList();
+
+    void benchIntList_data();
+    void benchIntList();
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include <QTimer>
 
 #include <maliit/plugins/abstractinputmethodhost.h>
+#include <maliit/plugins/keyoverridesevent.h>
 
 DummyInputMethod::DummyInputMethod(MAbstractInputMethodHost *host)
     : MAbstractInputMethod(host),
@@ -10,7 +11,10 @@ DummyInputMethod::DummyInputMethod(MAbstractInputMethodHost *host)
       switchContextCallCount(0),
       directionParam(Maliit::SwitchUndefined),
       enableAnimationParam(false),
-      pluginsChangedSignalCount(0)
+      pluginsChangedSignalCount(0),
+      keyOverridesEventCount(0),
+      keyOverridesRevisionParam(-1),
+      replacedParam(false)
 {
     MAbstractInputMethod::MInputMethodSubView sv1;
     sv1.subViewId = "dummyimsv1";
@@ -59,6 +63,21 @@ void DummyInputMethod::onPluginsChange()
     ++pluginsChangedSignalCount;
 }
 
+bool DummyInputMethod::imExtensionEvent(MImExtensionEvent *event)
+{
+    if (event->type() != MImExtensionEvent::KeyOverrides) {
+        return MAbstractInputMethod::imExtensionEvent(event);
+    }
+
+    const MImKeyOverridesEvent *keyOverridesEvent = static_cast<MImKeyOverridesEvent *>(event);
+    ++keyOverridesEventCount;
+    keyOverridesRevisionParam = keyOverridesEvent->revision();
+    changedKeysParam = keyOverridesEvent->changedKeys();
+    replacedParam = keyOverridesEvent->replaced();
+
+    return true;
+}
+
 void DummyInputMethod::switchContext(Maliit::SwitchDirection direction, bool enableAnimation)
 {
     ++switchContextCallCount;
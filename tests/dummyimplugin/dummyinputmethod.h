@@ -3,6 +3,7 @@
 
 #include <maliit/plugins/abstractinputmethod.h>
 #include <QSet>
+#include <QStringList>
 
 class DummyInputMethod : public MAbstractInputMethod
 {
@@ -21,6 +22,7 @@ public:
     virtual void setActiveSubView(const QString &,
                                   Maliit::HandlerState state = Maliit::OnScreen);
     virtual QString activeSubView(Maliit::HandlerState state = Maliit::OnScreen) const;
+    virtual bool imExtensionEvent(MImExtensionEvent *event);
     //! \reimp_end
 
 public:
@@ -33,6 +35,11 @@ public:
 
     int pluginsChangedSignalCount;
 
+    int keyOverridesEventCount;
+    int keyOverridesRevisionParam;
+    QStringList changedKeysParam;
+    bool replacedParam;
+
 public Q_SLOTS:
     void switchMe();
     void switchMe(const QString &name);
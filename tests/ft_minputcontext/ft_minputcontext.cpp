@@ -0,0 +1,264 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ft_minputcontext.h"
+
+#include "connectionfactory.h"
+#include "core-utils.h"
+#include "mimmetrics.h"
+#include "mimserver.h"
+#include "mimsettings.h"
+#include "minputcontext.h"
+#include "minputcontextconnection.h"
+#include "unknownplatform.h"
+
+#include <qpa/qwindowsysteminterface.h>
+
+#include <QGuiApplication>
+
+namespace
+{
+    const QString ConfigRoot        = MALIIT_CONFIG_ROOT;
+    const QString MImPluginPaths    = ConfigRoot + "paths";
+    const QString MImPluginDisabled = ConfigRoot + "disabledpluginfiles";
+    const QString EnabledPluginsKey = ConfigRoot + "onscreen/enabled";
+    const QString ActivePluginKey   = ConfigRoot + "onscreen/active";
+    const QString VisibilityDelayKey = ConfigRoot + "visibilitydelay";
+
+    const QString pluginId = "libdummyimplugin.so";
+
+    // The server resolves show and hide requests after this instead of after
+    // a frame, so that all hops of a test reliably fall into one resolution
+    const int ResolveDelay = 1000; // in ms
+    // Longer than the hide delay of the client plus the resolve delay
+    const int SettleTime = ResolveDelay + 250; // in ms
+    const int Hops = 10;
+}
+
+TextField::TextField()
+    : surroundingText(QString())
+    , cursorPosition(0)
+{}
+
+bool TextField::event(QEvent *event)
+{
+    if (event->type() == QEvent::InputMethodQuery) {
+        QInputMethodQueryEvent *query = static_cast<QInputMethodQueryEvent *>(event);
+
+        query->setValue(Qt::ImEnabled, true);
+        query->setValue(Qt::ImSurroundingText, surroundingText);
+        query->setValue(Qt::ImCursorPosition, cursorPosition);
+        query->setValue(Qt::ImAnchorPosition, cursorPosition);
+        query->setValue(Qt::ImHints, int(Qt::ImhNone));
+        query->accept();
+        return true;
+    }
+
+    if (event->type() == QEvent::InputMethod) {
+        preedit = static_cast<QInputMethodEvent *>(event)->preeditString();
+        event->accept();
+        return true;
+    }
+
+    return QObject::event(event);
+}
+
+FocusWindow::FocusWindow()
+    : field(0)
+{}
+
+void FocusWindow::setFocusField(QObject *newField)
+{
+    field = newField;
+}
+
+QObject *FocusWindow::focusObject() const
+{
+    return field;
+}
+
+void Ft_MInputContext::focus(QObject *field)
+{
+    window->setFocusField(field);
+    subject->setFocusObject(field);
+}
+
+void Ft_MInputContext::initTestCase()
+{
+    MImServer::configureSettings(MImServer::TemporarySettings);
+    MImSettings(MImPluginPaths).set(MaliitTestUtils::getTestPluginPath());
+    MImSettings(MImPluginDisabled).set(QStringList("libdummyimplugin2.so"));
+    MImSettings(EnabledPluginsKey).set(QStringList(pluginId + ":" + "dummyimsv1"));
+    MImSettings(ActivePluginKey).set(pluginId + ":" + "dummyimsv1");
+    MImSettings(VisibilityDelayKey).set(ResolveDelay);
+
+    // Client and server talk peer-to-peer, on a private socket
+    QVERIFY(socketDir.isValid());
+    const QString address = "unix:path=" + socketDir.path() + "/ft_minputcontext";
+    qputenv("MALIIT_SERVER_ADDRESS", address.toUtf8());
+
+    metrics.reset(new MImMetrics);
+    icConnection.reset(Maliit::DBus::createInputContextConnectionWithFixedAddress(address, false));
+    icConnection->setMetrics(metrics);
+    server = new MImServer(icConnection, QSharedPointer<Maliit::AbstractPlatform>(new Maliit::UnknownPlatform));
+
+    window = new FocusWindow;
+    window->show();
+    QWindowSystemInterface::handleWindowActivated<QWindowSystemInterface::SynchronousDelivery>(window);
+    QCOMPARE(qGuiApp->focusWindow(), static_cast<QWindow *>(window));
+
+    subject = new MInputContext;
+    QTRY_COMPARE(metrics->counter(MImMetrics::ClientConnections), qint64(1));
+}
+
+void Ft_MInputContext::cleanupTestCase()
+{
+    delete subject;
+    delete window;
+    delete server;
+    icConnection.clear();
+}
+
+void Ft_MInputContext::cleanup()
+{
+    focus(0);
+    subject->hideInputPanel();
+    QTest::qWait(SettleTime);
+
+    for (TextField &field : fields) {
+        field.surroundingText = QString();
+        field.cursorPosition = 0;
+        field.preedit.clear();
+    }
+}
+
+void Ft_MInputContext::testFocusHopping()
+{
+    QSignalSpy shows(icConnection.data(), SIGNAL(showInputMethodRequest()));
+    QSignalSpy hides(icConnection.data(), SIGNAL(hideInputMethodRequest()));
+    const qint64 showCallbacks = metrics->count(MImMetrics::ShowCallbacks);
+    const qint64 hideCallbacks = metrics->count(MImMetrics::HideCallbacks);
+
+    focus(&fields[0]);
+    subject->showInputPanel();
+    QTRY_COMPARE(metrics->count(MImMetrics::ShowCallbacks), showCallbacks + 1);
+
+    const qint64 clientSuppressed = subject->suppressedInputPanelTransitions();
+    const qint64 serverSuppressed = metrics->counter(MImMetrics::SuppressedVisibilityTransitions);
+
+    for (int n = 1; n <= Hops; ++n) {
+        // Applications hide the input panel when a text field loses the
+        // focus, and show it again when the next one gets it.
+        focus(0);
+        subject->hideInputPanel();
+        focus(&fields[n % 2]);
+        subject->showInputPanel();
+
+        QTRY_COMPARE(shows.count(), n + 1);
+    }
+    QTest::qWait(SettleTime);
+
+    // No hide request crossed the connection, and the plugin was never
+    // hidden and shown again.
+    QCOMPARE(hides.count(), 0);
+    QCOMPARE(metrics->count(MImMetrics::ShowCallbacks), showCallbacks + 1);
+    QCOMPARE(metrics->count(MImMetrics::HideCallbacks), hideCallbacks);
+
+    // The client held back every hide; the server coalesced the hide on
+    // focus loss and the show of every hop.
+    QCOMPARE(subject->suppressedInputPanelTransitions() - clientSuppressed, qint64(Hops));
+    QCOMPARE(metrics->counter(MImMetrics::SuppressedVisibilityTransitions) - serverSuppressed,
+             qint64(2 * Hops));
+}
+
+void Ft_MInputContext::testFocusLoss()
+{
+    QSignalSpy hides(icConnection.data(), SIGNAL(hideInputMethodRequest()));
+    const qint64 showCallbacks = metrics->count(MImMetrics::ShowCallbacks);
+    const qint64 hideCallbacks = metrics->count(MImMetrics::HideCallbacks);
+
+    focus(&fields[0]);
+    subject->showInputPanel();
+    QTRY_COMPARE(metrics->count(MImMetrics::ShowCallbacks), showCallbacks + 1);
+
+    focus(0);
+    subject->hideInputPanel();
+
+    // The server hides on focus loss by itself
+    QTRY_COMPARE(metrics->count(MImMetrics::HideCallbacks), hideCallbacks + 1);
+    QTest::qWait(SettleTime);
+    QCOMPARE(hides.count(), 0);
+    QCOMPARE(metrics->count(MImMetrics::HideCallbacks), hideCallbacks + 1);
+}
+
+void Ft_MInputContext::testPartialStateUpdates()
+{
+    QSignalSpy states(icConnection.data(),
+                      SIGNAL(widgetStateChanged(unsigned int, QMap<QString, QVariant>,
+                                                QMap<QString, QVariant>, bool)));
+    TextField &field = fields[0];
+    field.surroundingText = QString("abc");
+    field.cursorPosition = 1;
+
+    focus(&field);
+    QTRY_VERIFY(!states.isEmpty());
+    QTRY_COMPARE(states.last().at(1).toMap().value("surroundingText"), QVariant(QString("abc")));
+
+    // Only the cursor goes out; the server keeps the rest of the state
+    states.clear();
+    field.cursorPosition = 2;
+    subject->update(Qt::ImCursorPosition | Qt::ImAnchorPosition);
+    QTRY_COMPARE(states.count(), 1);
+
+    QVariantMap state = states.last().at(1).toMap();
+    QCOMPARE(state.value("cursorPosition"), QVariant(2));
+    QCOMPARE(state.value("anchorPosition"), QVariant(2));
+    QCOMPARE(state.value("surroundingText"), QVariant(QString("abc")));
+    QVERIFY(state.contains("winId"));
+
+    // A merged update could not drop the text, so the client sends the
+    // complete state instead
+    states.clear();
+    field.surroundingText = QVariant();
+    subject->update(Qt::ImSurroundingText);
+    QTRY_COMPARE(states.count(), 1);
+
+    state = states.last().at(1).toMap();
+    QVERIFY(!state.contains("surroundingText"));
+    QCOMPARE(state.value("cursorPosition"), QVariant(2));
+    QVERIFY(state.contains("winId"));
+}
+
+void Ft_MInputContext::testCompactPreedit()
+{
+    QSignalSpy states(icConnection.data(),
+                      SIGNAL(widgetStateChanged(unsigned int, QMap<QString, QVariant>,
+                                                QMap<QString, QVariant>, bool)));
+    TextField &field = fields[0];
+
+    focus(&field);
+    QTRY_VERIFY(!states.isEmpty());
+
+    // U+1F600 and U+1F601 share their high surrogate
+    const QString grinning = QString::fromUtf8("\xF0\x9F\x98\x80");
+    const QString beaming = QString::fromUtf8("\xF0\x9F\x98\x81");
+
+    // The client rebuilds every preedit from the part the server sent
+    // and the previous one
+    const QStringList preedits = QStringList() << "hello" << "help" << "helpful"
+                                               << "a" + grinning + "b"
+                                               << "a" + beaming + "b"
+                                               << "a" + beaming << QString();
+    Q_FOREACH (const QString &preedit, preedits) {
+        icConnection->sendPreeditString(preedit, QList<Maliit::PreeditTextFormat>());
+        QTRY_COMPARE(field.preedit, preedit);
+    }
+}
+
+QTEST_MAIN(Ft_MInputContext)
@@ -0,0 +1,83 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef FT_MINPUTCONTEXT_H
+#define FT_MINPUTCONTEXT_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QWindow>
+
+class MImMetrics;
+class MImServer;
+class MInputContext;
+class MInputContextConnection;
+
+//! Accepts input, like a text field
+class TextField : public QObject
+{
+    Q_OBJECT
+
+public:
+    TextField();
+
+    //! Reported as is; an invalid value is not reported at all
+    QVariant surroundingText;
+    int cursorPosition;
+    //! Last preedit received
+    QString preedit;
+
+protected:
+    bool event(QEvent *event) override;
+};
+
+//! Window whose focus object can be set directly
+class FocusWindow : public QWindow
+{
+    Q_OBJECT
+
+public:
+    FocusWindow();
+
+    void setFocusField(QObject *field);
+    QObject *focusObject() const override;
+
+private:
+    QObject *field;
+};
+
+class Ft_MInputContext : public QObject
+{
+    Q_OBJECT
+
+private:
+    void focus(QObject *field);
+
+    QTemporaryDir socketDir;
+    QSharedPointer<MImMetrics> metrics;
+    QSharedPointer<MInputContextConnection> icConnection;
+    MImServer *server;
+    FocusWindow *window;
+    MInputContext *subject;
+    TextField fields[2];
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void testFocusHopping();
+    void testFocusLoss();
+    void testPartialStateUpdates();
+    void testCompactPreedit();
+};
+
+#endif
@@ -0,0 +1,490 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "maliit-bench.h"
+
+#include "connectionfactory.h"
+#include "core-utils.h"
+#include "dbusserverconnection.h"
+#include "inputcontextdbusaddress.h"
+#include "minputcontextconnection.h"
+#include "serverdbusaddress.h"
+#include "mimserver.h"
+#include "mimsettings.h"
+#include "unknownplatform.h"
+
+#include <maliit/namespace.h>
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QtDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    const QString ConfigRoot        = MALIIT_CONFIG_ROOT;
+    const QString MImPluginPaths    = ConfigRoot + "paths";
+    const QString MImPluginDisabled = ConfigRoot + "disabledpluginfiles";
+    const QString EnabledPluginsKey = ConfigRoot + "onscreen/enabled";
+    const QString ActivePluginKey   = ConfigRoot + "onscreen/active";
+
+    const QString pluginId  = "libdummyimplugin.so";
+    const QString pluginId3 = "libdummyimplugin3.so";
+
+    const int ConnectTimeout = 5000; // in ms
+    const int SynchronizeTimeout = 5000; // in ms
+    const int LongTextLength = 64 * 1024;
+    const int PreeditUpdatesPerOperation = 16;
+
+    std::atomic<quint64> allocationCount(0);
+
+    QVariantMap widgetState(bool focused, const QString &text, int cursorPosition, qulonglong winId)
+    {
+        QVariantMap state;
+
+        state["focusState"] = focused;
+        state["surroundingText"] = text;
+        state["cursorPosition"] = cursorPosition;
+        state["anchorPosition"] = cursorPosition;
+        state["contentType"] = Maliit::FreeTextContentType;
+        state["autocapitalizationEnabled"] = true;
+        state["hiddenText"] = false;
+        state["predictionEnabled"] = true;
+        state["maliit-inputmethod-hints"] = 0;
+        state["hasSelection"] = false;
+        state["winId"] = winId;
+        state["toolbarId"] = 0;
+
+        return state;
+    }
+
+    // Waits until \a client is connected and the server handled everything it sent
+    bool waitForKeyboard(DBusServerConnection *client, bool *connected, int timeout)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!*connected) {
+            if (timer.hasExpired(timeout)) {
+                return false;
+            }
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+
+        client->reset(true);
+        while (client->pendingResets()) {
+            if (timer.hasExpired(timeout)) {
+                return false;
+            }
+            QCoreApplication::processEvents();
+        }
+
+        return true;
+    }
+
+    // Nearest rank percentile of sorted samples, in microseconds
+    double percentile(const QVector<qint64> &sorted, double fraction)
+    {
+        if (sorted.isEmpty()) {
+            return 0;
+        }
+
+        const int rank = qBound(1, int(std::ceil(fraction * sorted.count())), sorted.count());
+        return sorted.at(rank - 1) / 1000.0;
+    }
+}
+
+#if defined(__GLIBC__)
+// Count every heap allocation made by the process, including the ones made
+// inside Qt, libdbus and the plugins, by wrapping the glibc allocator.
+#define MALIIT_BENCH_COUNT_ALLOCATIONS
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+}
+#endif
+
+MaliitBench::MaliitBench(const QString &newAddress, int newClientCount, int newOperations)
+    : address(newAddress)
+    , clientCount(newClientCount)
+    , operations(newOperations)
+    , longText(LongTextLength, QChar('x'))
+    , activeClient(0)
+    , activeSubViewSetting(new MImSettings(ActivePluginKey))
+{}
+
+MaliitBench::~MaliitBench()
+{
+    qDeleteAll(clients);
+}
+
+QStringList MaliitBench::workloadNames()
+{
+    return QStringList() << "focus-churn" << "typing" << "long-surrounding-text"
+                         << "preedit-storm" << "plugin-switching" << "long-document-editing";
+}
+
+bool MaliitBench::connectClients(int timeout)
+{
+    int connected = 0;
+
+    for (int n = 0; n < clientCount; ++n) {
+        QSharedPointer<Maliit::InputContext::DBus::Address> clientAddress(
+            new Maliit::InputContext::DBus::FixedAddress(address));
+        DBusServerConnection *client = new DBusServerConnection(clientAddress);
+
+        connect(client, &MImServerConnection::connected, this, [&connected]() { ++connected; });
+        clients.append(client);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (connected < clientCount) {
+        if (timer.hasExpired(timeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+
+    // Also wait until the server has seen every client
+    Q_FOREACH (DBusServerConnection *client, clients) {
+        client->disconnect(this);
+        if (!synchronize(client)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QJsonObject MaliitBench::run(const QString &name)
+{
+    const Workload workload = static_cast<Workload>(workloadNames().indexOf(name));
+    QVector<qint64> latencies;
+    latencies.reserve(operations);
+
+    // Every workload starts its sessions from scratch
+    activeClient = 0;
+
+    // Warm up, so that lazy initialization is not measured
+    Q_FOREACH (DBusServerConnection *client, clients) {
+        runOperation(workload, client, 0);
+        synchronize(client);
+    }
+
+    const quint64 allocationsBefore = allocationCount.load();
+    QElapsedTimer total;
+    QElapsedTimer latency;
+    total.start();
+
+    for (int n = 0; n < operations; ++n) {
+        // Focus churn hops between clients on every operation, the other
+        // workloads give every client one session of consecutive operations.
+        DBusServerConnection *client = (workload == FocusChurn)
+                ? clients.at(n % clients.count())
+                : clients.at(qint64(n) * clients.count() / operations);
+
+        latency.start();
+        runOperation(workload, client, n);
+        if (!synchronize(client)) {
+            qWarning() << "maliit-bench: server did not respond during" << name;
+            break;
+        }
+        latencies.append(latency.nsecsElapsed());
+    }
+
+    const qint64 elapsed = total.nsecsElapsed();
+    const quint64 allocations = allocationCount.load() - allocationsBefore;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    QJsonObject result;
+    result["workload"] = name;
+    result["operations"] = latencies.count();
+    result["throughputPerSecond"] = elapsed > 0 ? latencies.count() * 1e9 / elapsed : 0.0;
+    result["latencyP50Microseconds"] = percentile(latencies, 0.50);
+    result["latencyP99Microseconds"] = percentile(latencies, 0.99);
+#ifdef MALIIT_BENCH_COUNT_ALLOCATIONS
+    result["allocationsPerOperation"] = latencies.isEmpty() ? 0.0 : double(allocations) / latencies.count();
+#else
+    Q_UNUSED(allocations);
+    result["allocationsPerOperation"] = QJsonValue();
+#endif
+
+    return result;
+}
+
+void MaliitBench::runOperation(Workload workload, DBusServerConnection *client, int index)
+{
+    const qulonglong winId = clients.indexOf(client) + 1;
+
+    if (workload == FocusChurn) {
+        const bool focused = (index / clients.count()) % 2 == 0;
+
+        client->activateContext();
+        client->updateWidgetInformation(widgetState(focused, QString(), 0, winId), true);
+        if (focused) {
+            client->showInputMethod();
+        } else {
+            client->hideInputMethod();
+        }
+        activeClient = focused ? client : 0;
+        return;
+    }
+
+    if (client != activeClient) {
+        // Editing starts with the cursor at the end of a long document
+        const QString text = (workload == LongDocumentEditing) ? longText : QString();
+
+        client->activateContext();
+        client->updateWidgetInformation(widgetState(true, text, text.length(), winId), true);
+        client->showInputMethod();
+        activeClient = client;
+    }
+
+    switch (workload) {
+    case Typing: {
+        const QChar character('a' + index % 26);
+        const Qt::Key key = static_cast<Qt::Key>(Qt::Key_A + index % 26);
+        const QString text(index % 80, QChar('a'));
+
+        client->processKeyEvent(QEvent::KeyPress, key, Qt::NoModifier, character,
+                                false, 1, 0, 0, 0);
+        client->processKeyEvent(QEvent::KeyRelease, key, Qt::NoModifier, character,
+                                false, 1, 0, 0, 0);
+        client->updateWidgetInformation(widgetState(true, text, text.length(), winId), false);
+        break;
+    }
+    case LongSurroundingText:
+        client->updateWidgetInformation(widgetState(true, longText, index % LongTextLength, winId),
+                                        false);
+        break;
+    case PreeditStorm:
+        for (int n = 1; n <= PreeditUpdatesPerOperation; ++n) {
+            client->setPreedit(QString(n, QChar('a' + index % 26)), n);
+        }
+        break;
+    case PluginSwitching:
+        activeSubViewSetting->set(index % 2 == 0 ? QString(pluginId3 + ":" + "dummyim3sv1")
+                                                 : QString(pluginId + ":" + "dummyimsv1"));
+        break;
+    case LongDocumentEditing:
+        // The input method sends the key back, and the server deletes a
+        // character from its copy of the surrounding text.
+        client->processKeyEvent(QEvent::KeyPress, Qt::Key_Backspace, Qt::NoModifier, QString(),
+                                false, 1, 0, 0, 0);
+        client->processKeyEvent(QEvent::KeyRelease, Qt::Key_Backspace, Qt::NoModifier, QString(),
+                                false, 1, 0, 0, 0);
+        break;
+    case FocusChurn:
+        break;
+    }
+}
+
+bool MaliitBench::synchronize(DBusServerConnection *client)
+{
+    // Messages are handled in order, so once the reply to this reset arrives
+    // the server has processed everything sent before it.
+    client->reset(true);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (client->pendingResets()) {
+        if (timer.hasExpired(SynchronizeTimeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents();
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // Run headless, and never load an input context into the benchmark itself.
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+    setenv("QT_IM_MODULE", "none", 1);
+
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("maliit-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs scripted workloads against an in-process Maliit server "
+                                     "and prints the measurements as JSON.\n"
+                                     "Workloads: " + MaliitBench::workloadNames().join(", "));
+    parser.addHelpOption();
+
+    QCommandLineOption clientsOption("clients", "Number of simulated input context clients.",
+                                     "count", "4");
+    QCommandLineOption operationsOption("operations", "Number of operations per workload.",
+                                        "count", "1000");
+    QCommandLineOption workloadOption("workload", "Workload to run, can be repeated; "
+                                      "all workloads are run by default.", "name");
+    QCommandLineOption outputOption("output", "Write the report to file instead of stdout.",
+                                    "file");
+    parser.addOption(clientsOption);
+    parser.addOption(operationsOption);
+    parser.addOption(workloadOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const int clientCount = parser.value(clientsOption).toInt();
+    const int operations = parser.value(operationsOption).toInt();
+    QStringList workloads = parser.values(workloadOption);
+    if (workloads.isEmpty()) {
+        workloads = MaliitBench::workloadNames();
+    }
+
+    if (clientCount < 1 || operations < 1) {
+        qCritical() << "maliit-bench: --clients and --operations must be positive";
+        return 1;
+    }
+    Q_FOREACH (const QString &workload, workloads) {
+        if (!MaliitBench::workloadNames().contains(workload)) {
+            qCritical() << "maliit-bench: unknown workload" << workload;
+            return 1;
+        }
+    }
+
+    MImServer::configureSettings(MImServer::TemporarySettings);
+    MImSettings(MImPluginPaths).set(MaliitTestUtils::getTestPluginPath());
+    MImSettings(MImPluginDisabled).set(QStringList("libdummyimplugin2.so"));
+    MImSettings(EnabledPluginsKey).set(QStringList()
+                                       << pluginId + ":" + "dummyimsv1"
+                                       << pluginId + ":" + "dummyimsv2"
+                                       << pluginId3 + ":" + "dummyim3sv1"
+                                       << pluginId3 + ":" + "dummyim3sv2");
+    MImSettings(ActivePluginKey).set(pluginId + ":" + "dummyimsv1");
+
+    // Clients use the same peer-to-peer D-Bus path as applications do, but on
+    // a private socket, so no session bus is needed.
+    QTemporaryDir socketDir;
+    if (!socketDir.isValid()) {
+        qCritical() << "maliit-bench: cannot create a directory for the server socket";
+        return 1;
+    }
+    const QString address = "unix:path=" + socketDir.path() + "/maliit-bench";
+
+    // The address file of the server goes there, too
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(socketDir.path()));
+
+    // An application started before the server shows its keyboard as soon
+    // as the server publishes its address.
+    bool waitingConnected = false;
+    QScopedPointer<DBusServerConnection> waitingClient(new DBusServerConnection(
+        QSharedPointer<Maliit::InputContext::DBus::Address>(new Maliit::InputContext::DBus::DynamicAddress)));
+    QObject::connect(waitingClient.data(), &MImServerConnection::connected,
+                     [&waitingConnected]() { waitingConnected = true; });
+    waitingClient->showInputMethod();
+
+    QElapsedTimer startup;
+    startup.start();
+    while (!startup.hasExpired(100)) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+
+    QSharedPointer<MInputContextConnection> icConnection(
+        Maliit::DBus::createInputContextConnectionWithFixedAddress(address, false));
+    QSharedPointer<Maliit::AbstractPlatform> platform(new Maliit::UnknownPlatform);
+    MImServer server(icConnection, platform);
+
+    QElapsedTimer firstKeyboard;
+    firstKeyboard.start();
+    if (!Maliit::Server::DBus::publishAddress(address)
+        || !waitForKeyboard(waitingClient.data(), &waitingConnected, ConnectTimeout)) {
+        qCritical() << "maliit-bench: waiting client did not find the server";
+        return 1;
+    }
+    const qint64 waitingTimeToKeyboard = firstKeyboard.nsecsElapsed();
+    waitingClient.reset();
+
+    // An application started after the server
+    bool startedConnected = false;
+    firstKeyboard.start();
+    QScopedPointer<DBusServerConnection> startedClient(new DBusServerConnection(
+        QSharedPointer<Maliit::InputContext::DBus::Address>(new Maliit::InputContext::DBus::DynamicAddress)));
+    QObject::connect(startedClient.data(), &MImServerConnection::connected,
+                     [&startedConnected]() { startedConnected = true; });
+    startedClient->showInputMethod();
+    if (!waitForKeyboard(startedClient.data(), &startedConnected, ConnectTimeout)) {
+        qCritical() << "maliit-bench: client did not find the running server";
+        return 1;
+    }
+    const qint64 startedTimeToKeyboard = firstKeyboard.nsecsElapsed();
+    startedClient.reset();
+
+    MaliitBench bench(address, clientCount, operations);
+    if (!bench.connectClients(ConnectTimeout)) {
+        qCritical() << "maliit-bench: clients could not connect to" << address;
+        return 1;
+    }
+
+    QJsonArray results;
+    Q_FOREACH (const QString &workload, workloads) {
+        results.append(bench.run(workload));
+    }
+
+    QJsonObject report;
+    report["clients"] = clientCount;
+    report["operationsPerWorkload"] = operations;
+    report["platform"] = QGuiApplication::platformName();
+    report["qtVersion"] = QString::fromLatin1(qVersion());
+    report["results"] = results;
+    // From the server publishing its address, and from creating the input
+    // context, until the server has handled the first show
+    report["timeToFirstKeyboardMicroseconds"] = waitingTimeToKeyboard / 1000.0;
+    report["timeToFirstKeyboardRunningServerMicroseconds"] = startedTimeToKeyboard / 1000.0;
+
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || output.write(json) != json.size()) {
+            qCritical() << "maliit-bench: cannot write" << output.fileName();
+            return 1;
+        }
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MALIIT_BENCH_H
+#define MALIIT_BENCH_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class DBusServerConnection;
+class MImSettings;
+
+//! Drives scripted workloads from simulated input context clients against an
+//! in-process MImServer and measures them.
+class MaliitBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Workload {
+        FocusChurn,
+        Typing,
+        LongSurroundingText,
+        PreeditStorm,
+        PluginSwitching,
+        LongDocumentEditing
+    };
+
+    MaliitBench(const QString &address, int clientCount, int operations);
+    ~MaliitBench();
+
+    //! Returns the names of all workloads, in the order they are run by default.
+    static QStringList workloadNames();
+
+    //! Connects all clients to the server; returns false on timeout.
+    bool connectClients(int timeout);
+
+    //! Runs the workload called \a name and returns its measurements.
+    QJsonObject run(const QString &name);
+
+private:
+    void runOperation(Workload workload, DBusServerConnection *client, int index);
+    bool synchronize(DBusServerConnection *client);
+
+    const QString address;
+    const int clientCount;
+    const int operations;
+    const QString longText;
+    QList<DBusServerConnection *> clients;
+    DBusServerConnection *activeClient;
+    QScopedPointer<MImSettings> activeSubViewSetting;
+};
+
+#endif // MALIIT_BENCH_H
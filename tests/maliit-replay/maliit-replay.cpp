@@ -0,0 +1,458 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "maliit-replay.h"
+
+#include "connectionfactory.h"
+#include "dbusserverconnection.h"
+#include "inputcontextdbusaddress.h"
+#include "minputcontextconnection.h"
+#include "mimserver.h"
+#include "mimsettings.h"
+#include "unknownplatform.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtDebug>
+
+#include <cstdlib>
+
+namespace
+{
+    const QString ConfigRoot        = MALIIT_CONFIG_ROOT;
+    const QString MImPluginPaths    = ConfigRoot + "paths";
+    const QString EnabledPluginsKey = ConfigRoot + "onscreen/enabled";
+    const QString ActivePluginKey   = ConfigRoot + "onscreen/active";
+
+    const int ConnectTimeout = 5000; // in ms
+    const int ReplayTimeout = 10000; // in ms, after the last call was sent
+    // Time given to the server to send outbound calls triggered by the last
+    // inbound one, e.g. from plugin timers.
+    const int SettleTime = 200; // in ms
+
+    QList<MImSessionEvent> readLog(const QString &fileName, QString *error)
+    {
+        QList<MImSessionEvent> events;
+        MImSessionReader reader(fileName);
+
+        if (!reader.isOpen()) {
+            *error = reader.errorString();
+            return events;
+        }
+
+        MImSessionEvent event;
+        while (reader.readNext(&event)) {
+            events.append(event);
+        }
+
+        return events;
+    }
+
+    QList<MImSessionEvent> filter(const QList<MImSessionEvent> &events, MImSessionEvent::Direction direction)
+    {
+        QList<MImSessionEvent> filtered;
+
+        Q_FOREACH (const MImSessionEvent &event, events) {
+            if (event.direction == direction) {
+                filtered.append(event);
+            }
+        }
+
+        return filtered;
+    }
+
+    // Client ids are handed out by the server, so the recording and the
+    // replay use different ones; compare them by order of first appearance.
+    QHash<quint32, int> clientIndexes(const QList<MImSessionEvent> &events)
+    {
+        QHash<quint32, int> indexes;
+
+        Q_FOREACH (const MImSessionEvent &event, events) {
+            if (event.clientId != 0 && !indexes.contains(event.clientId)) {
+                const int index = indexes.count();
+                indexes.insert(event.clientId, index);
+            }
+        }
+
+        return indexes;
+    }
+
+    QJsonObject describe(const MImSessionEvent &event)
+    {
+        QJsonObject description;
+
+        description["call"] = QString::fromLatin1(MImSessionEvent::callName(event.call));
+        description["clientId"] = qint64(event.clientId);
+        description["timestampMicroseconds"] = event.timestamp;
+        description["arguments"] = QJsonValue::fromVariant(event.arguments);
+
+        return description;
+    }
+
+    void wait(int milliseconds)
+    {
+        QEventLoop loop;
+        QTimer::singleShot(milliseconds, &loop, SLOT(quit()));
+        loop.exec();
+    }
+}
+
+MaliitReplay::MaliitReplay(const QString &newAddress)
+    : address(newAddress)
+    , skipped(0)
+    , replayDuration(0)
+{}
+
+MaliitReplay::~MaliitReplay()
+{
+    qDeleteAll(clients);
+}
+
+bool MaliitReplay::load(const QString &fileName, QString *error)
+{
+    const QList<MImSessionEvent> events = readLog(fileName, error);
+
+    if (!error->isEmpty()) {
+        return false;
+    }
+
+    inbound = filter(events, MImSessionEvent::Inbound);
+    outbound = filter(events, MImSessionEvent::Outbound);
+
+    return true;
+}
+
+bool MaliitReplay::replay(bool realTime, const MImSessionRecorder &serverRecorder)
+{
+    int sent = 0;
+    const qint64 start = inbound.isEmpty() ? 0 : inbound.first().timestamp;
+    QElapsedTimer clock;
+    clock.start();
+
+    Q_FOREACH (const MImSessionEvent &event, inbound) {
+        // The protocol has no call to drop a connection from the client side,
+        // so disconnections of the recording cannot be reproduced.
+        if (event.call == MImSessionEvent::ClientDisconnected) {
+            ++skipped;
+            continue;
+        }
+
+        DBusServerConnection *connection = client(event.clientId);
+        if (!connection) {
+            qWarning() << "maliit-replay: client" << event.clientId << "could not connect";
+            return false;
+        }
+
+        if (realTime) {
+            const qint64 due = (event.timestamp - start) / 1000;
+            if (due > clock.elapsed()) {
+                wait(due - clock.elapsed());
+            }
+        }
+
+        if (send(connection, event)) {
+            ++sent;
+        } else {
+            ++skipped;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (serverRecorder.count(MImSessionEvent::Inbound) < sent) {
+        if (timer.hasExpired(ReplayTimeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    replayDuration = clock.elapsed();
+
+    wait(SettleTime);
+
+    return true;
+}
+
+QJsonObject MaliitReplay::compare(const QString &replayLog) const
+{
+    QString error;
+    const QList<MImSessionEvent> replayed = filter(readLog(replayLog, &error),
+                                                   MImSessionEvent::Outbound);
+    const QHash<quint32, int> recordedClients = clientIndexes(outbound);
+    const QHash<quint32, int> replayedClients = clientIndexes(replayed);
+
+    int mismatches = qAbs(outbound.count() - replayed.count());
+    QJsonObject firstMismatch;
+
+    for (int n = 0; n < qMin(outbound.count(), replayed.count()); ++n) {
+        const MImSessionEvent &expected = outbound.at(n);
+        const MImSessionEvent &actual = replayed.at(n);
+
+        if (expected.call == actual.call
+            && recordedClients.value(expected.clientId, -1) == replayedClients.value(actual.clientId, -1)
+            && expected.arguments == actual.arguments) {
+            continue;
+        }
+
+        if (firstMismatch.isEmpty()) {
+            firstMismatch["index"] = n;
+            firstMismatch["expected"] = describe(expected);
+            firstMismatch["actual"] = describe(actual);
+        }
+        ++mismatches;
+    }
+
+    if (firstMismatch.isEmpty() && outbound.count() != replayed.count()) {
+        const int n = qMin(outbound.count(), replayed.count());
+        firstMismatch["index"] = n;
+        firstMismatch["expected"] = n < outbound.count() ? QJsonValue(describe(outbound.at(n)))
+                                                         : QJsonValue();
+        firstMismatch["actual"] = n < replayed.count() ? QJsonValue(describe(replayed.at(n)))
+                                                       : QJsonValue();
+    }
+
+    const qint64 recordedDuration = inbound.count() > 1
+            ? (inbound.last().timestamp - inbound.first().timestamp) / 1000 : 0;
+
+    QJsonObject result;
+    result["inboundCalls"] = inbound.count();
+    result["skippedCalls"] = skipped;
+    result["recordedDurationMilliseconds"] = recordedDuration;
+    result["replayDurationMilliseconds"] = replayDuration;
+    result["recordedOutboundCalls"] = outbound.count();
+    result["replayedOutboundCalls"] = replayed.count();
+    result["mismatches"] = mismatches;
+    result["firstMismatch"] = firstMismatch.isEmpty() ? QJsonValue() : QJsonValue(firstMismatch);
+    if (!error.isEmpty()) {
+        result["error"] = error;
+    }
+
+    return result;
+}
+
+DBusServerConnection *MaliitReplay::client(quint32 recordedClientId)
+{
+    if (DBusServerConnection *existing = clients.value(recordedClientId)) {
+        return existing;
+    }
+
+    QSharedPointer<Maliit::InputContext::DBus::Address> clientAddress(
+        new Maliit::InputContext::DBus::FixedAddress(address));
+    DBusServerConnection *connection = new DBusServerConnection(clientAddress);
+    bool connected = false;
+
+    connect(connection, &MImServerConnection::connected, this, [&connected]() { connected = true; });
+    clients.insert(recordedClientId, connection);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!connected) {
+        if (timer.hasExpired(ConnectTimeout)) {
+            return 0;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    connection->disconnect(this);
+
+    return connection;
+}
+
+bool MaliitReplay::send(DBusServerConnection *client, const MImSessionEvent &event)
+{
+    const QVariantList &args = event.arguments;
+
+    switch (event.call) {
+    case MImSessionEvent::ActivateContext:
+        client->activateContext();
+        return true;
+    case MImSessionEvent::ShowInputMethod:
+        client->showInputMethod();
+        return true;
+    case MImSessionEvent::HideInputMethod:
+        client->hideInputMethod();
+        return true;
+    case MImSessionEvent::Reset:
+        client->reset(false);
+        return true;
+    case MImSessionEvent::UnsubscribePluginSettings:
+        client->unsubscribePluginSettings();
+        return true;
+    default:
+        break;
+    }
+
+    if (args.isEmpty()) {
+        return false;
+    }
+
+    switch (event.call) {
+    case MImSessionEvent::MouseClickedOnPreedit:
+        client->mouseClickedOnPreedit(args.value(0).toPoint(), args.value(1).toRect());
+        return true;
+    case MImSessionEvent::SetPreedit:
+        client->setPreedit(args.value(0).toString(), args.value(1).toInt());
+        return true;
+    case MImSessionEvent::UpdateWidgetInformation:
+        client->updateWidgetInformation(args.value(0).toMap(), args.value(1).toBool());
+        return true;
+    case MImSessionEvent::AppOrientationAboutToChange:
+        client->appOrientationAboutToChange(args.value(0).toInt());
+        return true;
+    case MImSessionEvent::AppOrientationChanged:
+        client->appOrientationChanged(args.value(0).toInt());
+        return true;
+    case MImSessionEvent::SetCopyPasteState:
+        client->setCopyPasteState(args.value(0).toBool(), args.value(1).toBool());
+        return true;
+    case MImSessionEvent::ProcessKeyEvent:
+        client->processKeyEvent(static_cast<QEvent::Type>(args.value(0).toInt()),
+                                static_cast<Qt::Key>(args.value(1).toInt()),
+                                static_cast<Qt::KeyboardModifiers>(args.value(2).toInt()),
+                                args.value(3).toString(), args.value(4).toBool(),
+                                args.value(5).toInt(), args.value(6).toUInt(),
+                                args.value(7).toUInt(), args.value(8).toULongLong());
+        return true;
+    case MImSessionEvent::RegisterAttributeExtension:
+        client->registerAttributeExtension(args.value(0).toInt(), args.value(1).toString());
+        return true;
+    case MImSessionEvent::UnregisterAttributeExtension:
+        client->unregisterAttributeExtension(args.value(0).toInt());
+        return true;
+    case MImSessionEvent::SetExtendedAttribute:
+        client->setExtendedAttribute(args.value(0).toInt(), args.value(1).toString(),
+                                     args.value(2).toString(), args.value(3).toString(),
+                                     args.value(4));
+        return true;
+    case MImSessionEvent::LoadPluginSettings:
+        client->loadPluginSettings(args.value(0).toString());
+        return true;
+    case MImSessionEvent::LoadPluginSettingsSnapshot:
+        client->loadPluginSettingsSnapshot(args.value(0).toString(), args.value(1).toULongLong());
+        return true;
+    case MImSessionEvent::SubscribePluginSettings:
+        client->subscribePluginSettings(args.value(0).toString(), args.value(1).toULongLong());
+        return true;
+    default:
+        return false;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // Run headless, and never load an input context into the replay itself.
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+    setenv("QT_IM_MODULE", "none", 1);
+
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("maliit-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a session recorded with maliit-server -record-session "
+                                     "against an in-process Maliit server, compares the calls the "
+                                     "server sends back with the recorded ones and prints the "
+                                     "result as JSON. Exits with 2 if they differ.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("log", "Session log to replay.");
+
+    QCommandLineOption speedOption("speed", "Replay speed: 'original' keeps the recorded timing, "
+                                   "'max' sends calls as fast as possible.", "speed", "original");
+    QCommandLineOption pluginPathOption("plugin-path", "Directory to load input method plugins from.",
+                                        "path");
+    QCommandLineOption pluginOption("plugin", "Active plugin and subview, as plugin:subview.",
+                                    "plugin");
+    QCommandLineOption recordOption("record", "Keep the session log of the replay in file.", "file");
+    QCommandLineOption outputOption("output", "Write the report to file instead of stdout.",
+                                    "file");
+    parser.addOption(speedOption);
+    parser.addOption(pluginPathOption);
+    parser.addOption(pluginOption);
+    parser.addOption(recordOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const QString speed = parser.value(speedOption);
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+    if (speed != "original" && speed != "max") {
+        qCritical() << "maliit-replay: --speed must be 'original' or 'max'";
+        return 1;
+    }
+
+    // Replaying only makes sense with the plugins the session was recorded
+    // with; by default the server uses the installed ones.
+    MImServer::configureSettings(MImServer::TemporarySettings);
+    if (parser.isSet(pluginPathOption)) {
+        MImSettings(MImPluginPaths).set(parser.value(pluginPathOption));
+    }
+    if (parser.isSet(pluginOption)) {
+        MImSettings(EnabledPluginsKey).set(QStringList(parser.value(pluginOption)));
+        MImSettings(ActivePluginKey).set(parser.value(pluginOption));
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        qCritical() << "maliit-replay: cannot create a directory for the server socket";
+        return 1;
+    }
+    const QString address = "unix:path=" + workDir.path() + "/maliit-replay";
+    const QString replayLog = parser.isSet(recordOption) ? parser.value(recordOption)
+                                                         : workDir.path() + "/replay.log";
+
+    MaliitReplay replay(address);
+    QString error;
+    if (!replay.load(parser.positionalArguments().first(), &error)) {
+        qCritical() << "maliit-replay: cannot read session log:" << error;
+        return 1;
+    }
+
+    QSharedPointer<MImSessionRecorder> recorder(new MImSessionRecorder(replayLog));
+    if (!recorder->isOpen()) {
+        qCritical() << "maliit-replay: cannot write" << replayLog << recorder->errorString();
+        return 1;
+    }
+
+    QSharedPointer<MInputContextConnection> icConnection(
+        Maliit::DBus::createInputContextConnectionWithFixedAddress(address, false));
+    icConnection->setSessionRecorder(recorder);
+    QSharedPointer<Maliit::AbstractPlatform> platform(new Maliit::UnknownPlatform);
+    MImServer server(icConnection, platform);
+
+    if (!replay.replay(speed == "original", *recorder)) {
+        qCritical() << "maliit-replay: server did not handle the replayed session";
+        return 1;
+    }
+    recorder->flush();
+
+    QJsonObject report = replay.compare(replayLog);
+    report["speed"] = speed;
+    report["log"] = parser.positionalArguments().first();
+
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || output.write(json) != json.size()) {
+            qCritical() << "maliit-replay: cannot write" << output.fileName();
+            return 1;
+        }
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return report["mismatches"].toInt() == 0 ? 0 : 2;
+}
@@ -0,0 +1,62 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MALIIT_REPLAY_H
+#define MALIIT_REPLAY_H
+
+#include "mimsessionlog.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class DBusServerConnection;
+
+//! Feeds the inbound calls of a recorded session to a server through
+//! simulated input context clients, and compares what the server sends back.
+class MaliitReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MaliitReplay(const QString &address);
+    ~MaliitReplay();
+
+    //! Reads the session log \a fileName; returns false and sets \a error on failure.
+    bool load(const QString &fileName, QString *error);
+
+    /*!
+     * \brief Sends all recorded inbound calls to the server.
+     * \param realTime if true, keeps the original timing between calls,
+     *  otherwise sends them as fast as possible
+     * \param serverRecorder recorder of the server under test, used to wait
+     *  until the server has handled every call
+     * Returns false if the server did not handle all calls in time.
+     */
+    bool replay(bool realTime, const MImSessionRecorder &serverRecorder);
+
+    //! Compares the outbound calls of the recorded session to the ones of
+    //! the replay, stored in \a replayLog.
+    QJsonObject compare(const QString &replayLog) const;
+
+private:
+    DBusServerConnection *client(quint32 recordedClientId);
+    bool send(DBusServerConnection *client, const MImSessionEvent &event);
+
+    const QString address;
+    QList<MImSessionEvent> inbound;
+    QList<MImSessionEvent> outbound;
+    QHash<quint32, DBusServerConnection *> clients;
+    int skipped;
+    qint64 replayDuration;
+};
+
+#endif // MALIIT_REPLAY_H
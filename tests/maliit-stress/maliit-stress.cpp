@@ -0,0 +1,478 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "maliit-stress.h"
+
+#include "connectionfactory.h"
+#include "core-utils.h"
+#include "dbusserverconnection.h"
+#include "inputcontextdbusaddress.h"
+#include "mimmetrics.h"
+#include "minputcontextconnection.h"
+#include "mimserver.h"
+#include "mimsettings.h"
+#include "unknownplatform.h"
+
+#include <maliit/namespace.h>
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QtDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace
+{
+    const QString ConfigRoot        = MALIIT_CONFIG_ROOT;
+    const QString MImPluginPaths    = ConfigRoot + "paths";
+    const QString MImPluginDisabled = ConfigRoot + "disabledpluginfiles";
+    const QString EnabledPluginsKey = ConfigRoot + "onscreen/enabled";
+    const QString ActivePluginKey   = ConfigRoot + "onscreen/active";
+
+    const QString pluginId = "libdummyimplugin.so";
+
+    const int ConnectTimeout = 5000; // in ms
+    const int SynchronizeTimeout = 5000; // in ms
+    const int DisconnectTimeout = 5000; // in ms
+
+    // Growth of the median setup time is measured from this value on, so
+    // that noise on very fast connections does not count as growth.
+    const qint64 LatencyGrowthFloor = 100 * 1000; // in ns
+
+    QVariantMap widgetState(bool focused, qulonglong winId, int toolbarId)
+    {
+        QVariantMap state;
+
+        state["focusState"] = focused;
+        state["surroundingText"] = QString();
+        state["cursorPosition"] = 0;
+        state["anchorPosition"] = 0;
+        state["contentType"] = Maliit::FreeTextContentType;
+        state["hiddenText"] = false;
+        state["predictionEnabled"] = true;
+        state["maliit-inputmethod-hints"] = 0;
+        state["hasSelection"] = false;
+        state["winId"] = winId;
+        state["toolbarId"] = toolbarId;
+
+        return state;
+    }
+
+    // Nearest rank percentile of samples, in ns
+    qint64 percentile(QVector<qint64> samples, double fraction)
+    {
+        if (samples.isEmpty()) {
+            return 0;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const int rank = qBound(1, int(std::ceil(fraction * samples.count())), samples.count());
+        return samples.at(rank - 1);
+    }
+
+    double microseconds(qint64 nanoseconds)
+    {
+        return nanoseconds / 1000.0;
+    }
+}
+
+MaliitStress::MaliitStress(const QString &newAddress, const QSharedPointer<MImMetrics> &newMetrics,
+                           const Options &newOptions)
+    : address(newAddress)
+    , metrics(newMetrics)
+    , options(newOptions)
+    , finalResidentMemory(-1)
+    , leftoverClients(0)
+{}
+
+MaliitStress::~MaliitStress()
+{
+    qDeleteAll(clients);
+}
+
+bool MaliitStress::run()
+{
+    const int perWindow = qMax(1, (options.cycles + WindowCount - 1) / WindowCount);
+    int closed = 0;
+
+    windows.clear();
+
+    for (int n = 0; n < options.cycles; ++n) {
+        if (n % perWindow == 0) {
+            windows.append(Window());
+        }
+        Window &window = windows.last();
+
+        QElapsedTimer timer;
+        timer.start();
+        DBusServerConnection *client = openClient(n);
+        if (!client) {
+            qWarning() << "maliit-stress: client" << n << "could not connect";
+            return false;
+        }
+        window.setup.append(timer.nsecsElapsed());
+        clients.append(client);
+
+        if (clients.count() > options.concurrency) {
+            timer.start();
+            if (!closeClient(clients.takeFirst(), closed++)) {
+                qWarning() << "maliit-stress: server did not notice client" << closed - 1 << "leaving";
+                return false;
+            }
+            window.teardown.append(timer.nsecsElapsed());
+        }
+
+        if ((n + 1) % perWindow == 0 || n + 1 == options.cycles) {
+            window.residentMemory = residentMemory();
+        }
+    }
+
+    while (!clients.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!closeClient(clients.takeFirst(), closed++)) {
+            return false;
+        }
+        windows.last().teardown.append(timer.nsecsElapsed());
+    }
+
+    finalResidentMemory = residentMemory();
+    leftoverClients = metrics->gauge(MImMetrics::ConnectedClients);
+
+    return true;
+}
+
+QJsonObject MaliitStress::report() const
+{
+    QVector<qint64> setup;
+    QVector<qint64> teardown;
+    QJsonArray windowResults;
+
+    // The first window warms up caches and lazily created objects
+    for (int n = 1; n < windows.count(); ++n) {
+        setup += windows.at(n).setup;
+        teardown += windows.at(n).teardown;
+    }
+
+    Q_FOREACH (const Window &window, windows) {
+        QJsonObject result;
+        result["clients"] = window.setup.count();
+        result["setupP50Microseconds"] = microseconds(percentile(window.setup, 0.50));
+        result["setupP99Microseconds"] = microseconds(percentile(window.setup, 0.99));
+        result["teardownP50Microseconds"] = microseconds(percentile(window.teardown, 0.50));
+        result["teardownP99Microseconds"] = microseconds(percentile(window.teardown, 0.99));
+        result["residentMemoryKiB"] = window.residentMemory;
+        windowResults.append(result);
+    }
+
+    QJsonObject values;
+    values["cycles"] = options.cycles;
+    values["concurrency"] = options.concurrency;
+    values["extensionsPerClient"] = options.extensions;
+    values["attributesPerClient"] = options.attributes;
+    values["setupP50Microseconds"] = microseconds(percentile(setup, 0.50));
+    values["setupP99Microseconds"] = microseconds(percentile(setup, 0.99));
+    values["teardownP50Microseconds"] = microseconds(percentile(teardown, 0.50));
+    values["teardownP99Microseconds"] = microseconds(percentile(teardown, 0.99));
+    if (windows.count() > 1 && windows.first().residentMemory >= 0) {
+        values["memoryGrowthKiB"] = windows.last().residentMemory - windows.first().residentMemory;
+    } else {
+        values["memoryGrowthKiB"] = QJsonValue();
+    }
+    values["finalResidentMemoryKiB"] = finalResidentMemory;
+    values["leftoverClients"] = leftoverClients;
+    values["windows"] = windowResults;
+
+    return values;
+}
+
+QStringList MaliitStress::violations(const Limits &limits) const
+{
+    QStringList result;
+
+    if (leftoverClients != 0) {
+        result << QString("%1 clients are still known to the server after all disconnected")
+                  .arg(leftoverClients);
+    }
+
+    // Both samples are taken with the same number of clients connected
+    if (windows.count() > 1 && windows.first().residentMemory >= 0) {
+        const qint64 growth = windows.last().residentMemory - windows.first().residentMemory;
+        if (growth > limits.memoryGrowth) {
+            result << QString("resident memory grew by %1 KiB, limit is %2 KiB")
+                      .arg(growth).arg(limits.memoryGrowth);
+        }
+    }
+
+    QVector<qint64> setup;
+    QVector<qint64> teardown;
+    for (int n = 1; n < windows.count(); ++n) {
+        setup += windows.at(n).setup;
+        teardown += windows.at(n).teardown;
+    }
+
+    const double setupP99 = percentile(setup, 0.99) / 1e6;
+    const double teardownP99 = percentile(teardown, 0.99) / 1e6;
+    if (setupP99 > limits.latency) {
+        result << QString("p99 connection setup took %1 ms, limit is %2 ms")
+                  .arg(setupP99).arg(limits.latency);
+    }
+    if (teardownP99 > limits.latency) {
+        result << QString("p99 connection teardown took %1 ms, limit is %2 ms")
+                  .arg(teardownP99).arg(limits.latency);
+    }
+
+    // Costs that grow with the number of clients seen so far show up as a
+    // rising median between the first measured and the last window.
+    if (windows.count() > 2) {
+        const qint64 first = qMax(LatencyGrowthFloor, percentile(windows.at(1).setup, 0.50));
+        const qint64 last = percentile(windows.last().setup, 0.50);
+        const double growth = double(last) / first;
+
+        if (growth > limits.latencyGrowth) {
+            result << QString("median connection setup grew %1 times, limit is %2")
+                      .arg(growth).arg(limits.latencyGrowth);
+        }
+    }
+
+    return result;
+}
+
+DBusServerConnection *MaliitStress::openClient(int index)
+{
+    QSharedPointer<Maliit::InputContext::DBus::Address> clientAddress(
+        new Maliit::InputContext::DBus::FixedAddress(address));
+    DBusServerConnection *client = new DBusServerConnection(clientAddress);
+    bool connected = false;
+
+    connect(client, &MImServerConnection::connected, this, [&connected]() { connected = true; });
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!connected) {
+        if (timer.hasExpired(ConnectTimeout)) {
+            delete client;
+            return 0;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    client->disconnect(this);
+
+    // Behave like an application with a toolbar and customized action keys
+    client->activateContext();
+    for (int id = 1; id <= options.extensions; ++id) {
+        client->registerAttributeExtension(id, QString());
+    }
+    if (options.extensions > 0) {
+        for (int n = 0; n < options.attributes; ++n) {
+            client->setExtendedAttribute(1 + n % options.extensions, "/keys",
+                                         QString("key%1").arg(n), "label",
+                                         QString("client%1").arg(index));
+        }
+    }
+    client->updateWidgetInformation(widgetState(index % 2 == 0, index + 1,
+                                                 options.extensions > 0 ? 1 : 0), true);
+    if (index % 2 == 0) {
+        client->showInputMethod();
+    }
+
+    if (!synchronize(client)) {
+        delete client;
+        return 0;
+    }
+
+    return client;
+}
+
+bool MaliitStress::closeClient(DBusServerConnection *client, int index)
+{
+    const qint64 connectedClients = metrics->gauge(MImMetrics::ConnectedClients);
+
+    // Every other client leaves with messages still in flight
+    if (index % 2 == 1 && options.extensions > 0) {
+        for (int n = 0; n < options.attributes; ++n) {
+            client->setExtendedAttribute(1 + n % options.extensions, "/keys",
+                                         QString("key%1").arg(n), "highlighted", true);
+        }
+    }
+
+    // No unregisterAttributeExtension() or hideInputMethod(), just like a
+    // crashing application.
+    delete client;
+
+    return waitForConnectedClients(connectedClients - 1);
+}
+
+bool MaliitStress::synchronize(DBusServerConnection *client)
+{
+    // Messages are handled in order, so once the reply to this reset arrives
+    // the server has processed everything sent before it.
+    client->reset(true);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (client->pendingResets()) {
+        if (timer.hasExpired(SynchronizeTimeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents();
+    }
+
+    return true;
+}
+
+bool MaliitStress::waitForConnectedClients(qint64 count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (metrics->gauge(MImMetrics::ConnectedClients) > count) {
+        if (timer.hasExpired(DisconnectTimeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+
+    return true;
+}
+
+qint64 MaliitStress::residentMemory()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.count() < 2) {
+        return -1;
+    }
+
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+int main(int argc, char **argv)
+{
+    // Run headless, and never load an input context into the test itself.
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+    setenv("QT_IM_MODULE", "none", 1);
+
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("maliit-stress");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Opens and abruptly closes many input context clients against "
+                                     "an in-process Maliit server, prints the per-connection cost "
+                                     "as JSON and fails if memory or latency grow beyond the limits.");
+    parser.addHelpOption();
+
+    QCommandLineOption cyclesOption("cycles", "Number of clients to open and close.",
+                                    "count", "2000");
+    QCommandLineOption concurrencyOption("concurrency", "Number of clients connected at once.",
+                                         "count", "32");
+    QCommandLineOption extensionsOption("extensions", "Attribute extensions registered per client.",
+                                        "count", "4");
+    QCommandLineOption attributesOption("attributes", "Extended attributes set per client.",
+                                        "count", "16");
+    QCommandLineOption memoryOption("max-memory-growth", "Allowed growth of resident memory "
+                                    "after warm-up, in KiB.", "KiB", "8192");
+    QCommandLineOption latencyOption("max-latency", "Allowed 99th percentile of connection "
+                                     "setup and teardown, in ms.", "ms", "250");
+    QCommandLineOption latencyGrowthOption("max-latency-growth", "Allowed ratio of the median "
+                                           "setup time at the end to the one after warm-up.",
+                                           "factor", "4");
+    QCommandLineOption outputOption("output", "Write the report to file instead of stdout.",
+                                    "file");
+    parser.addOption(cyclesOption);
+    parser.addOption(concurrencyOption);
+    parser.addOption(extensionsOption);
+    parser.addOption(attributesOption);
+    parser.addOption(memoryOption);
+    parser.addOption(latencyOption);
+    parser.addOption(latencyGrowthOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    MaliitStress::Options options;
+    options.cycles = parser.value(cyclesOption).toInt();
+    options.concurrency = parser.value(concurrencyOption).toInt();
+    options.extensions = parser.value(extensionsOption).toInt();
+    options.attributes = parser.value(attributesOption).toInt();
+
+    MaliitStress::Limits limits;
+    limits.memoryGrowth = parser.value(memoryOption).toLongLong();
+    limits.latency = parser.value(latencyOption).toDouble();
+    limits.latencyGrowth = parser.value(latencyGrowthOption).toDouble();
+
+    if (options.cycles < 1 || options.concurrency < 1
+        || options.extensions < 0 || options.attributes < 0) {
+        qCritical() << "maliit-stress: --cycles and --concurrency must be positive, "
+                       "--extensions and --attributes must not be negative";
+        return 1;
+    }
+
+    MImServer::configureSettings(MImServer::TemporarySettings);
+    MImSettings(MImPluginPaths).set(MaliitTestUtils::getTestPluginPath());
+    MImSettings(MImPluginDisabled).set(QStringList() << "libdummyimplugin2.so"
+                                                     << "libdummyimplugin3.so");
+    MImSettings(EnabledPluginsKey).set(QStringList(pluginId + ":" + "dummyimsv1"));
+    MImSettings(ActivePluginKey).set(pluginId + ":" + "dummyimsv1");
+
+    // Clients use the same peer-to-peer D-Bus path as applications do, but on
+    // a private socket, so no session bus is needed.
+    QTemporaryDir socketDir;
+    if (!socketDir.isValid()) {
+        qCritical() << "maliit-stress: cannot create a directory for the server socket";
+        return 1;
+    }
+    const QString address = "unix:path=" + socketDir.path() + "/maliit-stress";
+
+    // The connected clients gauge tells when the server has dropped a client
+    QSharedPointer<MImMetrics> metrics(new MImMetrics);
+    QSharedPointer<MInputContextConnection> icConnection(
+        Maliit::DBus::createInputContextConnectionWithFixedAddress(address, false));
+    icConnection->setMetrics(metrics);
+    QSharedPointer<Maliit::AbstractPlatform> platform(new Maliit::UnknownPlatform);
+    MImServer server(icConnection, platform);
+
+    MaliitStress stress(address, metrics, options);
+    if (!stress.run()) {
+        qCritical() << "maliit-stress: aborted, the server stopped responding";
+        return 1;
+    }
+
+    const QByteArray json = QJsonDocument(stress.report()).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || output.write(json) != json.size()) {
+            qCritical() << "maliit-stress: cannot write" << output.fileName();
+            return 1;
+        }
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    const QStringList violations = stress.violations(limits);
+    Q_FOREACH (const QString &violation, violations) {
+        qCritical() << "maliit-stress:" << qPrintable(violation);
+    }
+
+    return violations.isEmpty() ? 0 : 2;
+}
@@ -0,0 +1,88 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef MALIIT_STRESS_H
+#define MALIIT_STRESS_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class DBusServerConnection;
+class MImMetrics;
+
+//! Opens and closes many short-lived input context clients against an
+//! in-process MImServer and watches the cost of every connection.
+class MaliitStress : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        int cycles;             //!< Number of clients opened and closed in total
+        int concurrency;        //!< Number of clients connected at the same time
+        int extensions;         //!< Attribute extensions registered per client
+        int attributes;         //!< Extended attributes set per client
+    };
+
+    struct Limits {
+        qint64 memoryGrowth;    //!< Resident memory growth after warm-up, in KiB
+        double latency;         //!< 99th percentile of setup and teardown, in ms
+        double latencyGrowth;   //!< Ratio of last to first window setup latency
+    };
+
+    //! Number of windows the cycles are split into; the first one warms up.
+    static const int WindowCount = 10;
+
+    MaliitStress(const QString &address, const QSharedPointer<MImMetrics> &metrics,
+                 const Options &options);
+    ~MaliitStress();
+
+    //! Runs all cycles; returns false if the server stopped responding.
+    bool run();
+
+    //! Returns the measurements of the last run.
+    QJsonObject report() const;
+
+    //! Returns a description of every limit the last run exceeded.
+    QStringList violations(const Limits &limits) const;
+
+private:
+    struct Window {
+        Window() : residentMemory(-1) {}
+
+        QVector<qint64> setup;      // in ns
+        QVector<qint64> teardown;   // in ns
+        qint64 residentMemory;      // in KiB, at the end of the window
+    };
+
+    //! Connects a client and has it use extensions and attributes, or returns null.
+    DBusServerConnection *openClient(int index);
+    //! Drops \a client without unregistering anything and waits until the server noticed.
+    bool closeClient(DBusServerConnection *client, int index);
+    bool synchronize(DBusServerConnection *client);
+    bool waitForConnectedClients(qint64 count);
+
+    //! Returns the resident memory of the process in KiB, or -1 if unknown.
+    static qint64 residentMemory();
+
+    const QString address;
+    const QSharedPointer<MImMetrics> metrics;
+    const Options options;
+    QList<DBusServerConnection *> clients;
+    QList<Window> windows;
+    qint64 finalResidentMemory;
+    qint64 leftoverClients;
+};
+
+#endif // MALIIT_STRESS_H
@@ -59,6 +59,22 @@ load_plugin_settings (MaliitServer *server,
     return TRUE;
 }
 
+/* Record the call, and respond with a list of settings */
+gboolean
+load_plugin_settings_snapshot (MaliitServer *server,
+                               GDBusMethodInvocation *invocation,
+                               const gchar *locale_name G_GNUC_UNUSED,
+                               guint64 known_version G_GNUC_UNUSED,
+                               gpointer user_data)
+{
+    MockMaliitServer *self = user_data;
+
+    self->load_plugin_settings_called = TRUE;
+
+    maliit_server_complete_load_plugin_settings_snapshot(server, invocation);
+    return TRUE;
+}
+
 static gboolean
 start_server(gpointer user_data)
 {
@@ -74,6 +90,7 @@ start_server(gpointer user_data)
                                                    SERVER_OBJECT_PATH,
                                                    NULL));
     g_signal_connect(self->priv->server, "handle-load-plugin-settings", G_CALLBACK(load_plugin_settings), self);
+    g_signal_connect(self->priv->server, "handle-load-plugin-settings-snapshot", G_CALLBACK(load_plugin_settings_snapshot), self);
 
     g_cond_signal(&self->priv->thread_cond);
     g_mutex_unlock(&self->priv->thread_mutex);
@@ -105,4 +105,40 @@ void Ut_MAttributeExtensionManager::testSetExtendedAttribute()
     QVERIFY(subject->keyOverrides(idList.at(1)).value("testKey")->icon().isEmpty());
 }
 
+void Ut_MAttributeExtensionManager::testClientDisconnect()
+{
+    const unsigned int client1 = 1;
+    const unsigned int client2 = 2;
+
+    subject->handleAttributeExtensionRegistered(client1, 1, "");
+    subject->handleAttributeExtensionRegistered(client1, 2, "");
+    subject->handleAttributeExtensionRegistered(client2, 1, "");
+    QCOMPARE(subject->attributeExtensionIdList().count(), 3);
+
+    QVERIFY(subject->contains(MAttributeExtensionId(1, client1)));
+    QVERIFY(subject->contains(MAttributeExtensionId(1, client2)));
+
+    // extended attributes are only applied to extensions of the sending client
+    subject->handleExtendedAttributeUpdate(client2, 2, "/keys", "testKey", "label", QVariant("testLabel"));
+    QVERIFY(subject->keyOverrides(MAttributeExtensionId(2, client1)).isEmpty());
+
+    subject->handleExtendedAttributeUpdate(client1, 2, "/keys", "testKey", "label", QVariant("testLabel"));
+    QCOMPARE(subject->keyOverrides(MAttributeExtensionId(2, client1)).count(), 1);
+
+    // disconnecting removes all extensions of that client and nothing else
+    subject->handleClientDisconnect(client1);
+    QCOMPARE(subject->attributeExtensionIdList().count(), 1);
+    QVERIFY(!subject->contains(MAttributeExtensionId(1, client1)));
+    QVERIFY(!subject->contains(MAttributeExtensionId(2, client1)));
+    QVERIFY(subject->contains(MAttributeExtensionId(1, client2)));
+
+    // reconnecting client can register the same local ids again
+    subject->handleAttributeExtensionRegistered(client1, 1, "");
+    QVERIFY(subject->contains(MAttributeExtensionId(1, client1)));
+
+    subject->handleAttributeExtensionUnregistered(client2, 1);
+    QVERIFY(!subject->contains(MAttributeExtensionId(1, client2)));
+    QCOMPARE(subject->attributeExtensionIdList().count(), 1);
+}
+
 QTEST_MAIN(Ut_MAttributeExtensionManager);
@@ -29,6 +29,7 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testSetExtendedAttribute();
+    void testClientDisconnect();
 
 private:
     MAttributeExtensionManager *subject;
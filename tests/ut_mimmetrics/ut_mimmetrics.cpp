@@ -0,0 +1,94 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_mimmetrics.h"
+
+#include "mimmetrics.h"
+#include "mimsettings.h"
+
+void Ut_MImMetrics::initTestCase()
+{
+    MImSettings::setPreferredSettingsType(MImSettings::TemporarySettings);
+}
+
+void Ut_MImMetrics::testCountersAndGauges()
+{
+    MImMetrics metrics;
+
+    QCOMPARE(metrics.counter(MImMetrics::KeyEvents), qint64(0));
+
+    metrics.increment(MImMetrics::KeyEvents);
+    metrics.increment(MImMetrics::KeyEvents, 2);
+    metrics.setGauge(MImMetrics::ConnectedClients, 3);
+    metrics.setGauge(MImMetrics::ConnectedClients, 2);
+
+    QCOMPARE(metrics.counter(MImMetrics::KeyEvents), qint64(3));
+    QCOMPARE(metrics.counter(MImMetrics::CommitStrings), qint64(0));
+    QCOMPARE(metrics.gauge(MImMetrics::ConnectedClients), qint64(2));
+
+    const QVariantMap snapshot = metrics.snapshot();
+    QCOMPARE(snapshot.value("counters").toMap().value("keyEvents").toLongLong(), qint64(3));
+    QCOMPARE(snapshot.value("gauges").toMap().value("connectedClients").toLongLong(), qint64(2));
+}
+
+void Ut_MImMetrics::testHistogram()
+{
+    MImMetrics metrics;
+
+    // 98 fast callbacks of 10us and two slow ones of 5ms
+    for (int n = 0; n < 98; ++n) {
+        metrics.addLatency(MImMetrics::KeyEventCallbacks, 10 * 1000);
+    }
+    metrics.addLatency(MImMetrics::KeyEventCallbacks, 5000 * 1000);
+    metrics.addLatency(MImMetrics::KeyEventCallbacks, 5000 * 1000);
+
+    QCOMPARE(metrics.count(MImMetrics::KeyEventCallbacks), qint64(100));
+    QCOMPARE(metrics.count(MImMetrics::WidgetStateCallbacks), qint64(0));
+
+    const QVariantMap histogram = metrics.snapshot().value("histograms").toMap()
+                                         .value("keyEventCallbacks").toMap();
+    QCOMPARE(histogram.value("count").toLongLong(), qint64(100));
+    QCOMPARE(histogram.value("sumMicroseconds").toLongLong(), qint64(98 * 10 + 2 * 5000));
+    QCOMPARE(histogram.value("maxMicroseconds").toLongLong(), qint64(5000));
+    // Percentiles are reported as the upper bound of their bucket
+    QCOMPARE(histogram.value("p50Microseconds").toLongLong(), qint64(16));
+    QCOMPARE(histogram.value("p99Microseconds").toLongLong(), qint64(8192));
+    QCOMPARE(histogram.value("buckets").toList().count(), MImMetrics::BucketCount);
+}
+
+void Ut_MImMetrics::testTimer()
+{
+    MImMetrics metrics;
+
+    {
+        MImMetricsTimer timer(&metrics, MImMetrics::ShowCallbacks);
+    }
+    {
+        // Disabled metrics must not crash
+        MImMetricsTimer timer(0, MImMetrics::ShowCallbacks);
+    }
+
+    QCOMPARE(metrics.count(MImMetrics::ShowCallbacks), qint64(1));
+}
+
+void Ut_MImMetrics::testSettingsWrites()
+{
+    QSharedPointer<MImMetrics> metrics(new MImMetrics);
+    MImSettings setting("/maliit/ut_mimmetrics/value");
+
+    MImSettings::setMetrics(metrics);
+    setting.set(42);
+    setting.unset();
+    MImSettings::setMetrics(QSharedPointer<MImMetrics>());
+    setting.set(43);
+
+    QCOMPARE(metrics->counter(MImMetrics::SettingsWrites), qint64(2));
+}
+
+QTEST_MAIN(Ut_MImMetrics)
@@ -17,9 +17,11 @@
 #include <QTimer>
 #include <QEventLoop>
 #include <QStringList>
+#include <QSemaphore>
 #include <mimpluginmanager.h>
 #include <mimpluginmanager_p.h>
 #include <maliit/plugins/inputmethodplugin.h>
+#include <maliit/plugins/abstractinputmethodhost.h>
 #include <unknownplatform.h>
 
 #include "mattributeextensionmanager.h"
@@ -38,6 +40,7 @@ namespace {
 
     const QString EnabledPluginsKey = MALIIT_CONFIG_ROOT"onscreen/enabled";
     const QString ActivePluginKey =   MALIIT_CONFIG_ROOT"onscreen/active";
+    const QString PluginEvictionTimeoutKey = MALIIT_CONFIG_ROOT"pluginevictiontimeout";
 
     const QString pluginName  = "DummyImPlugin";
     const QString pluginName2 = "DummyImPlugin2";
@@ -65,6 +68,11 @@ class MInputContextTestConnection : public MInputContextConnection
 public:
     MInputContextTestConnection() :
         pluginSettingsLoaded_called(0),
+        pluginSettingsSnapshot_version(0),
+        pluginSettingsUnchanged_version(0),
+        pluginSettingsChanged_called(0),
+        pluginSettingsChanged_fromVersion(0),
+        pluginSettingsChanged_version(0),
         notifyExtendedAttributeChanged_called(0)
     {
     }
@@ -76,6 +84,32 @@ public:
         pluginSettingsLoaded_settings = info;
     }
 
+    void pluginSettingsSnapshotLoaded(int clientId, quint64 version, const QList<MImPluginSettingsInfo> &info)
+    {
+        pluginSettingsSnapshot_version = version;
+        pluginSettingsLoaded(clientId, info);
+    }
+
+    void pluginSettingsUnchanged(int clientId, quint64 version)
+    {
+        Q_UNUSED(clientId);
+
+        pluginSettingsUnchanged_version = version;
+    }
+
+    void pluginSettingsChanged(int clientId, quint64 fromVersion, quint64 version,
+                               const QList<MImPluginSettingsInfo> &changed,
+                               const QStringList &removedPlugins)
+    {
+        Q_UNUSED(clientId);
+        Q_UNUSED(removedPlugins);
+
+        pluginSettingsChanged_called++;
+        pluginSettingsChanged_fromVersion = fromVersion;
+        pluginSettingsChanged_version = version;
+        pluginSettingsChanged_settings = changed;
+    }
+
     void notifyExtendedAttributeChanged(const QList<int> &clientIds, int id, const QString &target, const QString &targetItem, const QString &attribute, const QVariant &value)
     {
         Q_UNUSED(id);
@@ -89,6 +123,12 @@ public:
     int pluginSettingsLoaded_called;
     int pluginSettingsLoaded_clientId;
     QList<MImPluginSettingsInfo> pluginSettingsLoaded_settings;
+    quint64 pluginSettingsSnapshot_version;
+    quint64 pluginSettingsUnchanged_version;
+    int pluginSettingsChanged_called;
+    quint64 pluginSettingsChanged_fromVersion;
+    quint64 pluginSettingsChanged_version;
+    QList<MImPluginSettingsInfo> pluginSettingsChanged_settings;
 
     int notifyExtendedAttributeChanged_called;
     QList<int> notifyExtendedAttributeChanged_clientIds;
@@ -148,6 +188,8 @@ void Ut_MIMPluginManager::init()
 
 void Ut_MIMPluginManager::cleanup()
 {
+    MImSettings(PluginEvictionTimeoutKey).unset();
+
     delete manager;
     manager = 0;
     subject = 0;
@@ -814,6 +856,210 @@ void Ut_MIMPluginManager::testEnableAllSubviews()
     }
 }
 
+void Ut_MIMPluginManager::testEvictIdlePlugin()
+{
+    Maliit::Plugins::InputMethodPlugin *plugin = 0;
+    Maliit::Plugins::InputMethodPlugin *plugin3 = 0;
+
+    Q_FOREACH (Maliit::Plugins::InputMethodPlugin *p, subject->plugins.keys()) {
+        if (p->name() == pluginName) {
+            plugin = p;
+        } else if (p->name() == pluginName3) {
+            plugin3 = p;
+        }
+    }
+    QVERIFY(plugin != 0);
+    QVERIFY(plugin3 != 0);
+
+    subject->addHandlerMap(Maliit::OnScreen, pluginId);
+    subject->addHandlerMap(Maliit::Hardware, pluginId);
+    subject->addHandlerMap(Maliit::Accessory, pluginId);
+    subject->setActiveHandlers(QSet<Maliit::HandlerState>() << Maliit::Hardware);
+
+    const int settingsCount = subject->settings.count();
+    int settingsEntryCount = 0;
+    Q_FOREACH (const MImPluginSettingsInfo &info, subject->settings) {
+        settingsEntryCount += info.entries.count();
+    }
+    QVERIFY(settingsEntryCount > 0);
+
+    // DummyImPlugin3 has no enabled subview and is idle for longer than the timeout
+    MImSettings(EnabledPluginsKey).set(QStringList() << pluginId + ":" + "dummyimsv1");
+    MImSettings(PluginEvictionTimeoutKey).set(1);
+    subject->plugins[plugin3].lastUsed = subject->usageClock.elapsed() - 2000;
+    subject->evictIdlePlugins();
+
+    QVERIFY(subject->plugins[plugin].inputMethod != 0);
+    QVERIFY(subject->plugins[plugin3].inputMethod == 0);
+    QVERIFY(!subject->plugins[plugin3].evictedSubViews.value(Maliit::OnScreen).isEmpty());
+    QVERIFY(subject->loadedPluginsNames().contains(pluginId3));
+
+    bool found = false;
+    Q_FOREACH (const MImPluginDescription &desc, subject->pluginDescriptions(Maliit::Hardware)) {
+        if (desc.name() == pluginName3) {
+            found = true;
+            QVERIFY(!desc.loaded());
+            QCOMPARE(desc.memoryEstimate(), qint64(0));
+        }
+    }
+    QVERIFY(found);
+
+    // Switching to the evicted plugin reloads it
+    subject->switchPlugin(pluginId3, subject->plugins[plugin].inputMethod);
+    QVERIFY(subject->plugins[plugin3].inputMethod != 0);
+    QVERIFY(subject->plugins[plugin3].evictedSubViews.isEmpty());
+    QCOMPARE(subject->activePlugins.count(), 1);
+    QVERIFY(plugin3 == *subject->activePlugins.begin());
+
+    // The reloaded plugin registered its settings again, without duplicates
+    int reloadedEntryCount = 0;
+    Q_FOREACH (const MImPluginSettingsInfo &info, subject->settings) {
+        reloadedEntryCount += info.entries.count();
+    }
+    QCOMPARE(subject->settings.count(), settingsCount);
+    QCOMPARE(reloadedEntryCount, settingsEntryCount);
+}
+
+void Ut_MIMPluginManager::testStaleTaskResultDropped()
+{
+    Maliit::Plugins::InputMethodPlugin *plugin = *subject->activePlugins.begin();
+    MAbstractInputMethodHost *host = subject->plugins[plugin].imHost;
+    QVERIFY(host != 0);
+
+    QSemaphore started;
+    QSemaphore release;
+    int staleCalls = 0;
+
+    const int generation = host->runTask([&started, &release]() {
+                                             started.release();
+                                             release.acquire();
+                                             return QVariant(1);
+                                         },
+                                         this,
+                                         [&staleCalls](const QVariant &) {
+                                             ++staleCalls;
+                                         });
+    QCOMPARE(generation, host->editorStateGeneration());
+    QVERIFY(started.tryAcquire(1, 5000));
+
+    // A key event arriving while the task runs makes its result stale
+    manager->processKeyEvent(QEvent::KeyPress, Qt::Key_A, Qt::NoModifier, "a",
+                             false, 1, 0, 0, 0);
+    QVERIFY(host->isStale(generation));
+    release.release();
+
+    // Results for the current editor state are still delivered
+    QVariant result;
+    host->runTask([]() { return QVariant(2); },
+                  this,
+                  [&result](const QVariant &value) { result = value; });
+
+    QTRY_COMPARE(result, QVariant(2));
+    QTest::qWait(50);
+    QCOMPARE(staleCalls, 0);
+}
+
+void Ut_MIMPluginManager::testOwnEditsKeepTaskResult()
+{
+    Maliit::Plugins::InputMethodPlugin *plugin = *subject->activePlugins.begin();
+    MAbstractInputMethodHost *host = subject->plugins[plugin].imHost;
+    QVERIFY(host != 0);
+
+    // The host expects echoes relative to the state the connection knows
+    connection->activateContext(1);
+
+    QMap<QString, QVariant> state;
+    state["focusState"] = true;
+    state["surroundingText"] = QString("Hello ");
+    state["cursorPosition"] = 6;
+    state["anchorPosition"] = 6;
+    connection->updateWidgetInformation(1, state, true);
+
+    // Like the prediction example: the press updates the preedit, then asks
+    // for completions
+    manager->processKeyEvent(QEvent::KeyPress, Qt::Key_W, Qt::NoModifier, "w",
+                             false, 1, 0, 0, 0);
+    host->sendPreeditString("w", QList<Maliit::PreeditTextFormat>());
+
+    QVariant result;
+    const int generation = host->runTask([]() { return QVariant(3); },
+                                         this,
+                                         [&result](const QVariant &value) { result = value; });
+
+    manager->processKeyEvent(QEvent::KeyRelease, Qt::Key_W, Qt::NoModifier, "w",
+                             false, 1, 0, 0, 0);
+
+    // The editor echoes the preedit: first only the cursor rectangle moves,
+    // then editors showing the preedit inline report it as text
+    QMap<QString, QVariant> echo = state;
+    echo["cursorRectangle"] = QRect(60, 0, 1, 12);
+    connection->updateWidgetInformation(1, echo, false);
+
+    QMap<QString, QVariant> inlineEcho = echo;
+    inlineEcho["surroundingText"] = QString("Hello w");
+    inlineEcho["cursorPosition"] = 7;
+    inlineEcho["anchorPosition"] = 7;
+    connection->updateWidgetInformation(1, inlineEcho, false);
+
+    QVERIFY(!host->isStale(generation));
+    QTRY_COMPARE(result, QVariant(3));
+
+    // Edits the input method did not make still count
+    QMap<QString, QVariant> edited = inlineEcho;
+    edited["surroundingText"] = QString("Hello x");
+    connection->updateWidgetInformation(1, edited, false);
+    QVERIFY(host->isStale(generation));
+}
+
+void Ut_MIMPluginManager::testCursorMoveAfterCommit()
+{
+    Maliit::Plugins::InputMethodPlugin *plugin = *subject->activePlugins.begin();
+    MAbstractInputMethodHost *host = subject->plugins[plugin].imHost;
+    QVERIFY(host != 0);
+
+    connection->activateContext(1);
+
+    QMap<QString, QVariant> state;
+    state["focusState"] = true;
+    state["surroundingText"] = QString("hel");
+    state["cursorPosition"] = 3;
+    state["anchorPosition"] = 3;
+    connection->updateWidgetInformation(1, state, true);
+
+    manager->processKeyEvent(QEvent::KeyPress, Qt::Key_L, Qt::NoModifier, "l",
+                             false, 1, 0, 0, 0);
+    host->sendCommitString("l");
+    const int generation = host->editorStateGeneration();
+
+    // The echo of the commit, right behind it
+    QMap<QString, QVariant> echo = state;
+    echo["surroundingText"] = QString("hell");
+    echo["cursorPosition"] = 4;
+    echo["anchorPosition"] = 4;
+    connection->updateWidgetInformation(1, echo, false);
+    QVERIFY(!host->isStale(generation));
+
+    // Tapping the cursor behind another "l" is the user's doing
+    QMap<QString, QVariant> moved = echo;
+    moved["cursorPosition"] = 3;
+    moved["anchorPosition"] = 3;
+    connection->updateWidgetInformation(1, moved, false);
+    QVERIFY(host->isStale(generation));
+
+    // So is a commit echoed anywhere but behind the sent text
+    manager->processKeyEvent(QEvent::KeyPress, Qt::Key_O, Qt::NoModifier, "o",
+                             false, 1, 0, 0, 0);
+    host->sendCommitString("o");
+    const int nextGeneration = host->editorStateGeneration();
+
+    QMap<QString, QVariant> elsewhere = moved;
+    elsewhere["surroundingText"] = QString("hello");
+    elsewhere["cursorPosition"] = 5;
+    elsewhere["anchorPosition"] = 5;
+    connection->updateWidgetInformation(1, elsewhere, false);
+    QVERIFY(host->isStale(nextGeneration));
+}
+
 void Ut_MIMPluginManager::handleMessages()
 {
     QTest::qWait(100);
@@ -905,4 +1151,181 @@ void Ut_MIMPluginManager::testPluginSettingsUpdate()
     QCOMPARE(connection->notifyExtendedAttributeChanged_value, original_value);
 }
 
+void Ut_MIMPluginManager::testPluginSettingsSnapshot()
+{
+    manager->pluginSettingsSnapshotRequested(42, QString(), 0);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 1);
+    const quint64 version = connection->pluginSettingsSnapshot_version;
+    QVERIFY(version != 0);
+
+    // A client holding the current version does not get the settings again
+    manager->pluginSettingsSnapshotRequested(42, QString(), version);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 1);
+    QCOMPARE(connection->pluginSettingsUnchanged_version, version);
+
+    // Registering a setting starts a new version
+    QScopedPointer<Maliit::Plugins::AbstractPluginSetting> setting(
+                manager->registerPluginSetting("snapshottest", "Snapshot test", "value", "Value",
+                                               Maliit::IntType, QVariantMap()));
+    manager->pluginSettingsSnapshotRequested(42, QString(), version);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 2);
+    const quint64 registeredVersion = connection->pluginSettingsSnapshot_version;
+    QVERIFY(registeredVersion != version);
+
+    // So does changing a value, and the new snapshot carries it
+    MImSettings("/maliit/pluginsettings/snapshottest/value").set(7);
+    manager->pluginSettingsSnapshotRequested(42, QString(), registeredVersion);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 3);
+    QVERIFY(connection->pluginSettingsSnapshot_version != registeredVersion);
+
+    QVariant value;
+    Q_FOREACH (const MImPluginSettingsInfo &plugin, connection->pluginSettingsLoaded_settings) {
+        if (plugin.plugin_name == "snapshottest") {
+            QCOMPARE(plugin.entries.count(), 1);
+            value = plugin.entries.first().value;
+        }
+    }
+    QCOMPARE(value.toInt(), 7);
+}
+
+void Ut_MIMPluginManager::testPluginSettingsChanges()
+{
+    connection->subscribePluginSettings(42, QString(), 0);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 1);
+    const quint64 version = connection->pluginSettingsSnapshot_version;
+
+    // Settings registered in one go are pushed together, with the whole plugin
+    QScopedPointer<Maliit::Plugins::AbstractPluginSetting> first(
+                manager->registerPluginSetting("changestest", "Changes test", "first", "First",
+                                               Maliit::IntType, QVariantMap()));
+    QScopedPointer<Maliit::Plugins::AbstractPluginSetting> second(
+                manager->registerPluginSetting("changestest", "Changes test", "second", "Second",
+                                               Maliit::IntType, QVariantMap()));
+    QTRY_COMPARE(connection->pluginSettingsChanged_called, 1);
+    QCOMPARE(connection->pluginSettingsChanged_fromVersion, version);
+    QCOMPARE(connection->pluginSettingsChanged_settings.count(), 1);
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().plugin_name, QString("changestest"));
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().entries.count(), 2);
+    const quint64 registeredVersion = connection->pluginSettingsChanged_version;
+
+    // A changed value is pushed alone
+    MImSettings("/maliit/pluginsettings/changestest/second").set(3);
+    QTRY_COMPARE(connection->pluginSettingsChanged_called, 2);
+    QCOMPARE(connection->pluginSettingsChanged_fromVersion, registeredVersion);
+    QCOMPARE(connection->pluginSettingsChanged_settings.count(), 1);
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().entries.count(), 1);
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().entries.first().extension_key,
+             QString("/maliit/pluginsettings/changestest/second"));
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().entries.first().value.toInt(), 3);
+
+    // Nothing is pushed after unsubscribing
+    connection->unsubscribePluginSettings(42);
+    MImSettings("/maliit/pluginsettings/changestest/first").set(5);
+    QCoreApplication::processEvents();
+    QCOMPARE(connection->pluginSettingsChanged_called, 2);
+
+    // Subscribing again catches up with everything missed
+    connection->subscribePluginSettings(42, QString(), registeredVersion);
+    QCOMPARE(connection->pluginSettingsChanged_called, 3);
+    QCOMPARE(connection->pluginSettingsChanged_fromVersion, registeredVersion);
+    QCOMPARE(connection->pluginSettingsChanged_settings.first().entries.count(), 2);
+    QCOMPARE(connection->pluginSettingsLoaded_called, 1);
+}
+
+void Ut_MIMPluginManager::testResumeSession()
+{
+    QSignalSpy registered(connection, &MInputContextConnection::attributeExtensionRegistered);
+    QSignalSpy activated(connection, &MInputContextConnection::clientActivated);
+    QSignalSpy attributes(connection, &MInputContextConnection::extendedAttributeChanged);
+    QSignalSpy states(connection, &MInputContextConnection::widgetStateChanged);
+    QSignalSpy shown(connection, &MInputContextConnection::showInputMethodRequest);
+
+    QVariantMap extensionAttributes;
+    extensionAttributes.insert("/keys/actionKey/label", QString("Go"));
+    extensionAttributes.insert("invalid", true);
+
+    QVariantMap extension;
+    extension.insert("fileName", QString());
+    extension.insert("attributes", extensionAttributes);
+
+    QVariantMap extensions;
+    extensions.insert("3", extension);
+
+    QVariantMap widgetState;
+    widgetState.insert("focusState", true);
+
+    QVariantMap session;
+    session.insert("extensions", extensions);
+    session.insert("activate", true);
+    session.insert("widgetState", widgetState);
+    session.insert("showInputMethod", true);
+
+    connection->resumeSession(42, session);
+
+    QCOMPARE(registered.count(), 1);
+    QCOMPARE(registered.first().at(0).toUInt(), 42u);
+    QCOMPARE(registered.first().at(1).toInt(), 3);
+
+    QCOMPARE(activated.count(), 1);
+    QCOMPARE(activated.first().at(0).toUInt(), 42u);
+
+    // Invalid keys are dropped
+    QCOMPARE(attributes.count(), 1);
+    QCOMPARE(attributes.first().at(1).toInt(), 3);
+    QCOMPARE(attributes.first().at(2).toString(), QString("/keys"));
+    QCOMPARE(attributes.first().at(3).toString(), QString("actionKey"));
+    QCOMPARE(attributes.first().at(4).toString(), QString("label"));
+    QCOMPARE(attributes.first().at(5).toString(), QString("Go"));
+
+    QCOMPARE(states.count(), 1);
+    QCOMPARE(states.first().at(3).toBool(), true);
+    QCOMPARE(shown.count(), 1);
+}
+
+void Ut_MIMPluginManager::testKeyOverridesChanges()
+{
+    DummyInputMethod *inputMethod = dynamic_cast<DummyInputMethod *>(
+        subject->plugins[*subject->activePlugins.begin()].inputMethod);
+    QVERIFY(inputMethod != 0);
+
+    const MAttributeExtensionId id(1, "Ut_MIMPluginManager");
+    subject->attributeExtensionManager->registerAttributeExtension(id, "");
+    manager->setToolbar(id);
+    inputMethod->keyOverridesEventCount = 0;
+
+    // Only the added key is handed over
+    subject->attributeExtensionManager->setExtendedAttribute(id, "/keys", "a", "label", QVariant("A"));
+    QCOMPARE(inputMethod->keyOverridesEventCount, 1);
+    QCOMPARE(inputMethod->changedKeysParam, QStringList("a"));
+    QCOMPARE(inputMethod->replacedParam, false);
+
+    subject->attributeExtensionManager->setExtendedAttribute(id, "/keys", "b", "label", QVariant("B"));
+    QCOMPARE(inputMethod->keyOverridesEventCount, 2);
+    QCOMPARE(inputMethod->changedKeysParam, QStringList("b"));
+    QCOMPARE(inputMethod->replacedParam, false);
+
+    // Changing an attribute of an existing key is signalled by the key itself
+    subject->attributeExtensionManager->setExtendedAttribute(id, "/keys", "b", "icon", QVariant("icon"));
+    QCOMPARE(inputMethod->keyOverridesEventCount, 2);
+
+    // An extension registered again under the same id starts over with its
+    // keys; it must not be mistaken for the previous one.
+    const int previousRevision = inputMethod->keyOverridesRevisionParam;
+    subject->attributeExtensionManager->unregisterAttributeExtension(id);
+    subject->attributeExtensionManager->registerAttributeExtension(id, "");
+    subject->attributeExtensionManager->setExtendedAttribute(id, "/keys", "a", "label", QVariant("A"));
+
+    QCOMPARE(inputMethod->keyOverridesEventCount, 3);
+    QCOMPARE(inputMethod->changedKeysParam, QStringList("a"));
+    QCOMPARE(inputMethod->replacedParam, true);
+
+    // Reaches the key count, and so the revision, of the previous extension
+    subject->attributeExtensionManager->setExtendedAttribute(id, "/keys", "c", "label", QVariant("C"));
+
+    QCOMPARE(inputMethod->keyOverridesEventCount, 4);
+    QVERIFY(inputMethod->keyOverridesRevisionParam != previousRevision);
+    QCOMPARE(inputMethod->changedKeysParam, QStringList("c"));
+    QCOMPARE(inputMethod->replacedParam, false);
+}
+
 QTEST_MAIN(Ut_MIMPluginManager)
@@ -51,8 +51,18 @@ private Q_SLOTS:
 
     void testEnableAllSubviews();
 
+    void testEvictIdlePlugin();
+
+    void testStaleTaskResultDropped();
+    void testOwnEditsKeepTaskResult();
+    void testCursorMoveAfterCommit();
+
     void testPluginSettingsList();
     void testPluginSettingsUpdate();
+    void testPluginSettingsSnapshot();
+    void testPluginSettingsChanges();
+    void testResumeSession();
+    void testKeyOverridesChanges();
 
 private:
     void handleMessages();
@@ -0,0 +1,135 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_mimpluginwatchdog.h"
+
+#include "mimmetrics.h"
+#include "mimpluginwatchdog.h"
+
+void Ut_MImPluginWatchdog::testCallNames()
+{
+    QCOMPARE(MImPluginWatchdog::callName(MImPluginWatchdog::ProcessKeyEvent), "processKeyEvent");
+    QCOMPARE(MImPluginWatchdog::call("update"), MImPluginWatchdog::Update);
+    QCOMPARE(MImPluginWatchdog::call("noSuchCall"), MImPluginWatchdog::CallCount);
+}
+
+void Ut_MImPluginWatchdog::testOverBudget()
+{
+    QSharedPointer<MImMetrics> metrics(new MImMetrics);
+    MImPluginWatchdog watchdog;
+    QSignalSpy spy(&watchdog, SIGNAL(eventOccurred(MImPluginCallEvent)));
+
+    watchdog.setMetrics(metrics);
+    watchdog.setBudget(MImPluginWatchdog::Update, 1);
+
+    {
+        MImPluginCallGuard guard(&watchdog, "slowplugin", MImPluginWatchdog::Update);
+        QTest::qSleep(20);
+    }
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(watchdog.events().count(), 1);
+
+    const MImPluginCallEvent event = watchdog.events().first();
+    QCOMPARE(event.type, MImPluginCallEvent::OverBudget);
+    QCOMPARE(event.pluginId, QString("slowplugin"));
+    QCOMPARE(event.call, QString("update"));
+    QVERIFY(event.duration >= 20);
+    QCOMPARE(event.limit, qint64(1));
+    QCOMPARE(metrics->counter(MImMetrics::SlowPluginCalls), qint64(1));
+}
+
+void Ut_MImPluginWatchdog::testWithinBudget()
+{
+    MImPluginWatchdog watchdog;
+
+    {
+        MImPluginCallGuard guard(&watchdog, "fastplugin", MImPluginWatchdog::Show);
+    }
+    {
+        // Disabled budget
+        watchdog.setBudget(MImPluginWatchdog::Hide, 0);
+        MImPluginCallGuard guard(&watchdog, "slowplugin", MImPluginWatchdog::Hide);
+        QTest::qSleep(5);
+    }
+    {
+        // Null watchdog must not crash
+        MImPluginCallGuard guard(0, "fastplugin", MImPluginWatchdog::Show);
+    }
+
+    QVERIFY(watchdog.events().isEmpty());
+}
+
+void Ut_MImPluginWatchdog::testNestedCalls()
+{
+    MImPluginWatchdog watchdog;
+
+    watchdog.setBudget(MImPluginWatchdog::SetState, 1);
+    watchdog.setBudget(MImPluginWatchdog::Show, 1000);
+
+    {
+        MImPluginCallGuard outer(&watchdog, "outer", MImPluginWatchdog::SetState);
+        {
+            MImPluginCallGuard inner(&watchdog, "inner", MImPluginWatchdog::Show);
+        }
+        QTest::qSleep(20);
+    }
+
+    QCOMPARE(watchdog.events().count(), 1);
+    QCOMPARE(watchdog.events().first().pluginId, QString("outer"));
+    QCOMPARE(watchdog.events().first().call, QString("setState"));
+}
+
+void Ut_MImPluginWatchdog::testStall()
+{
+    QSharedPointer<MImMetrics> metrics(new MImMetrics);
+    MImPluginWatchdog watchdog;
+    QSignalSpy spy(&watchdog, SIGNAL(eventOccurred(MImPluginCallEvent)));
+
+    watchdog.setMetrics(metrics);
+    watchdog.setBudget(MImPluginWatchdog::ProcessKeyEvent, 0);
+    watchdog.setStallThreshold(50);
+
+    // Let the heartbeat run once, then block the main loop inside a plugin call
+    QTest::qWait(100);
+    QVERIFY(spy.isEmpty());
+
+    {
+        MImPluginCallGuard guard(&watchdog, "stuckplugin", MImPluginWatchdog::ProcessKeyEvent);
+        QTest::qSleep(300);
+    }
+
+    QTRY_COMPARE(spy.count(), 1);
+
+    const MImPluginCallEvent event = watchdog.events().first();
+    QCOMPARE(event.type, MImPluginCallEvent::Stall);
+    QCOMPARE(event.pluginId, QString("stuckplugin"));
+    QCOMPARE(event.call, QString("processKeyEvent"));
+    QVERIFY(event.duration > 50);
+    QCOMPARE(event.limit, qint64(50));
+    QCOMPARE(metrics->counter(MImMetrics::MainLoopStalls), qint64(1));
+
+    watchdog.setStallThreshold(0);
+}
+
+void Ut_MImPluginWatchdog::testBoundedEvents()
+{
+    MImPluginWatchdog watchdog;
+
+    watchdog.setBudget(MImPluginWatchdog::Reset, 1);
+    for (int n = 0; n < MImPluginWatchdog::MaxEvents + 2; ++n) {
+        MImPluginCallGuard guard(&watchdog, QString::number(n), MImPluginWatchdog::Reset);
+        QTest::qSleep(2);
+    }
+
+    QCOMPARE(watchdog.events().count(), int(MImPluginWatchdog::MaxEvents));
+    QCOMPARE(watchdog.events().first().pluginId, QString::number(2));
+}
+
+QTEST_MAIN(Ut_MImPluginWatchdog)
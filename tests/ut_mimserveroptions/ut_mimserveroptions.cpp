@@ -36,6 +36,9 @@ namespace {
     Args Nothing           = { 0, { 0 } };
     Args ProgramNameOnly   = { 1, { "name" } };
     Args BypassedParameter = { 1, { "name", "-help" } };
+    Args RecordSession     = { 3, { "", "-record-session", "session.log" } };
+    Args EnableMetrics     = { 2, { "", "-enable-metrics" } };
+    Args MetricsLog        = { 3, { "", "-metrics-log-interval", "60" } };
 
     Args Ignored = { 15, { "", "-style", "STYLE", "-session", "SESSION",
                            "-graphicssystem", "GRAPHICSSYSTEM",
@@ -66,6 +69,9 @@ void Ut_MImServerOptions::init()
 void Ut_MImServerOptions::cleanup()
 {
     commonOptions = MImServerCommonOptions();
+    connectionOptions.sessionRecordingFile.clear();
+    connectionOptions.metricsEnabled = false;
+    connectionOptions.metricsLogInterval = 0;
 }
 
 void Ut_MImServerOptions::testCommonOptions_data()
@@ -107,4 +113,25 @@ void Ut_MImServerOptions::testCommonOptions()
     QCOMPARE(commonOptions, expectedCommonOptions);
 }
 
+void Ut_MImServerOptions::testRecordSession()
+{
+    QVERIFY(parseCommandLine(RecordSession.argc, RecordSession.argv));
+    QCOMPARE(connectionOptions.sessionRecordingFile, QString("session.log"));
+    QCOMPARE(commonOptions.showHelp, false);
+}
+
+void Ut_MImServerOptions::testMetrics()
+{
+    QCOMPARE(connectionOptions.metricsEnabled, false);
+
+    QVERIFY(parseCommandLine(EnableMetrics.argc, EnableMetrics.argv));
+    QCOMPARE(connectionOptions.metricsEnabled, true);
+    QCOMPARE(connectionOptions.metricsLogInterval, 0);
+
+    connectionOptions.metricsEnabled = false;
+    QVERIFY(parseCommandLine(MetricsLog.argc, MetricsLog.argv));
+    QCOMPARE(connectionOptions.metricsEnabled, true);
+    QCOMPARE(connectionOptions.metricsLogInterval, 60);
+}
+
 QTEST_MAIN(Ut_MImServerOptions)
@@ -33,8 +33,13 @@ private Q_SLOTS:
     void testCommonOptions_data();
     void testCommonOptions();
 
+    void testRecordSession();
+
+    void testMetrics();
+
 private:
     MImServerCommonOptions commonOptions;
+    MImServerConnectionOptions connectionOptions;
 };
 
 #endif
@@ -0,0 +1,279 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_mimsessionlog.h"
+
+#include "mimsessionlog.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusServer>
+#include <QRect>
+
+namespace
+{
+    const quint32 LogMagic = 0x4d494d53; // "MIMS"
+    const quint32 LogVersion = 1;
+    const QString PeerName = "ut_mimsessionlog";
+
+    QVariant wrapped(const QVariant &value)
+    {
+        return QVariant::fromValue(QDBusVariant(value));
+    }
+}
+
+void Receiver::store(const QDBusVariant &value)
+{
+    values.append(value.variant());
+}
+
+void Ut_MImSessionLog::initTestCase()
+{
+    QVERIFY(dir.isValid());
+}
+
+QString Ut_MImSessionLog::writeHeader(const QString &name, quint32 magic, quint32 version)
+{
+    const QString fileName = dir.filePath(name);
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return QString();
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << magic << version;
+
+    return fileName;
+}
+
+void Ut_MImSessionLog::testHeader()
+{
+    const QString fileName = dir.filePath("header.log");
+    {
+        MImSessionRecorder recorder(fileName);
+        QVERIFY(recorder.isOpen());
+    }
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    QCOMPARE(magic, LogMagic);
+    QCOMPARE(version, LogVersion);
+    QVERIFY(stream.atEnd());
+
+    MImSessionReader reader(fileName);
+    QVERIFY(reader.isOpen());
+    QVERIFY(reader.errorString().isEmpty());
+
+    MImSessionEvent event;
+    QVERIFY(!reader.readNext(&event));
+}
+
+void Ut_MImSessionLog::testInvalidHeader()
+{
+    MImSessionReader wrongMagic(writeHeader("magic.log", 0x12345678, LogVersion));
+    QVERIFY(!wrongMagic.isOpen());
+    QCOMPARE(wrongMagic.errorString(), QString("not a Maliit session log"));
+
+    MImSessionReader wrongVersion(writeHeader("version.log", LogMagic, LogVersion + 1));
+    QVERIFY(!wrongVersion.isOpen());
+    QCOMPARE(wrongVersion.errorString(), QString("unsupported session log version 2"));
+
+    MImSessionReader missing(dir.filePath("missing.log"));
+    QVERIFY(!missing.isOpen());
+    QVERIFY(!missing.errorString().isEmpty());
+
+    MImSessionEvent event;
+    QVERIFY(!missing.readNext(&event));
+}
+
+void Ut_MImSessionLog::testRoundTrip()
+{
+    // Get structures and arrays the way the connection receives them,
+    // still marshalled
+    QDBusServer server("unix:path=" + dir.filePath("bus"));
+    QVERIFY(server.isConnected());
+
+    Receiver receiver;
+    QDBusConnection serverSide(QString{});
+    bool accepted = false;
+    connect(&server, &QDBusServer::newConnection,
+            this, [&receiver, &serverSide, &accepted](const QDBusConnection &connection) {
+        serverSide = connection;
+        serverSide.registerObject("/receiver", &receiver, QDBusConnection::ExportAllSlots);
+        accepted = true;
+    });
+
+    QDBusConnection client = QDBusConnection::connectToPeer(server.address(), PeerName);
+    QVERIFY(client.isConnected());
+    QTRY_VERIFY(accepted);
+
+    QDBusArgument rectangle;
+    rectangle.beginStructure();
+    rectangle << 1 << 2 << 30 << 40;
+    rectangle.endStructure();
+
+    QDBusArgument array;
+    array.beginArray(qMetaTypeId<int>());
+    array << 5 << 6;
+    array.endArray();
+
+    const QVariantList sent = QVariantList() << QVariant::fromValue(rectangle)
+                                             << QVariant::fromValue(rectangle)
+                                             << QVariant::fromValue(array);
+    Q_FOREACH (const QVariant &value, sent) {
+        QDBusMessage call = QDBusMessage::createMethodCall(QString(), "/receiver", QString(), "store");
+        call << wrapped(value);
+        QVERIFY(client.send(call));
+    }
+    QTRY_COMPARE(receiver.values.count(), sent.count());
+    QDBusConnection::disconnectFromPeer(PeerName);
+
+    Q_FOREACH (const QVariant &value, receiver.values) {
+        QCOMPARE(value.userType(), qMetaTypeId<QDBusArgument>());
+    }
+
+    QVariantMap widgetState;
+    widgetState["cursorRectangle"] = receiver.values.at(0);
+    widgetState["focusState"] = wrapped(true);
+    widgetState["surroundingText"] = QString("text");
+
+    QVariantList list;
+    list << wrapped(QString("nested")) << receiver.values.at(2);
+
+    const QString fileName = dir.filePath("roundtrip.log");
+    {
+        MImSessionRecorder recorder(fileName);
+        QVERIFY(recorder.isOpen());
+
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::ActivateContext, 1);
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::SetPreedit, 1,
+                        QVariantList() << QString("preedit") << 3);
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::SetExtendedAttribute, 2,
+                        QVariantList() << 4 << QString("/keys") << QString("a") << QString("label")
+                                       << wrapped(QString("A")));
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::UpdateWidgetInformation, 2,
+                        QVariantList() << widgetState << true);
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::LoadPluginSettingsSnapshot, 2,
+                        QVariantList() << QString("en") << quint64(42));
+        recorder.record(MImSessionEvent::Outbound, MImSessionEvent::UpdateInputMethodArea, 2,
+                        QVariantList() << receiver.values.at(1) << QVariant(list));
+
+        QCOMPARE(recorder.count(MImSessionEvent::Inbound), 5);
+        QCOMPARE(recorder.count(MImSessionEvent::Outbound), 1);
+    }
+
+    MImSessionReader reader(fileName);
+    QVERIFY(reader.isOpen());
+
+    MImSessionEvent event;
+    qint64 timestamp = 0;
+
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.direction, MImSessionEvent::Inbound);
+    QCOMPARE(event.call, MImSessionEvent::ActivateContext);
+    QCOMPARE(event.clientId, quint32(1));
+    QVERIFY(event.arguments.isEmpty());
+    QVERIFY(event.timestamp >= timestamp);
+    timestamp = event.timestamp;
+
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::SetPreedit);
+    QCOMPARE(event.arguments, QVariantList() << QString("preedit") << 3);
+    QVERIFY(event.timestamp >= timestamp);
+    timestamp = event.timestamp;
+
+    // D-Bus variants are unwrapped
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::SetExtendedAttribute);
+    QCOMPARE(event.clientId, quint32(2));
+    QCOMPARE(event.arguments.count(), 5);
+    QCOMPARE(event.arguments.at(4), QVariant(QString("A")));
+
+    // Maps are converted value by value, rectangles are kept
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::UpdateWidgetInformation);
+    const QVariantMap recordedState = event.arguments.value(0).toMap();
+    QCOMPARE(recordedState.value("cursorRectangle"), QVariant(QRect(1, 2, 30, 40)));
+    QCOMPARE(recordedState.value("focusState"), QVariant(true));
+    QCOMPARE(recordedState.value("surroundingText"), QVariant(QString("text")));
+    QCOMPARE(event.arguments.value(1), QVariant(true));
+
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::LoadPluginSettingsSnapshot);
+    QCOMPARE(QByteArray(MImSessionEvent::callName(event.call)), QByteArray("loadPluginSettingsSnapshot"));
+    QCOMPARE(event.arguments.value(0), QVariant(QString("en")));
+    QCOMPARE(event.arguments.value(1).toULongLong(), quint64(42));
+
+    // So are lists; other marshalled values are kept as their signature
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.direction, MImSessionEvent::Outbound);
+    QCOMPARE(event.call, MImSessionEvent::UpdateInputMethodArea);
+    QCOMPARE(event.arguments.value(0), QVariant(QRect(1, 2, 30, 40)));
+    QCOMPARE(event.arguments.value(1).toList(),
+             QVariantList() << QString("nested") << QString("ai"));
+
+    QVERIFY(!reader.readNext(&event));
+}
+
+void Ut_MImSessionLog::testFlushedPerRecord()
+{
+    const QString fileName = dir.filePath("flush.log");
+    MImSessionRecorder recorder(fileName);
+    QVERIFY(recorder.isOpen());
+
+    recorder.record(MImSessionEvent::Inbound, MImSessionEvent::ShowInputMethod, 1);
+
+    // The log is complete while the server still runs, e.g. when it is
+    // killed later on
+    MImSessionReader reader(fileName);
+    QVERIFY(reader.isOpen());
+
+    MImSessionEvent event;
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::ShowInputMethod);
+    QVERIFY(!reader.readNext(&event));
+}
+
+void Ut_MImSessionLog::testTruncated()
+{
+    const QString fileName = dir.filePath("truncated.log");
+    {
+        MImSessionRecorder recorder(fileName);
+        QVERIFY(recorder.isOpen());
+
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::ShowInputMethod, 1);
+        recorder.record(MImSessionEvent::Inbound, MImSessionEvent::SetPreedit, 1,
+                        QVariantList() << QString("cut short") << 9);
+    }
+
+    QFile file(fileName);
+    QVERIFY(file.resize(file.size() - 4));
+
+    MImSessionReader reader(fileName);
+    QVERIFY(reader.isOpen());
+
+    MImSessionEvent event;
+    QVERIFY(reader.readNext(&event));
+    QCOMPARE(event.call, MImSessionEvent::ShowInputMethod);
+
+    // The record cut short is dropped
+    QVERIFY(!reader.readNext(&event));
+    QVERIFY(!reader.readNext(&event));
+}
+
+QTEST_MAIN(Ut_MImSessionLog)
@@ -0,0 +1,51 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef UT_MIMSESSIONLOG_H
+#define UT_MIMSESSIONLOG_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QDBusVariant>
+#include <QTemporaryDir>
+
+//! Receives values over D-Bus, so that they arrive marshalled like the
+//! arguments of real input context calls
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Still marshalled values can only be read once, so each is sent on its own
+    QVariantList values;
+
+public Q_SLOTS:
+    void store(const QDBusVariant &value);
+};
+
+class Ut_MImSessionLog : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString writeHeader(const QString &name, quint32 magic, quint32 version);
+
+    QTemporaryDir dir;
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testHeader();
+    void testInvalidHeader();
+    void testRoundTrip();
+    void testFlushedPerRecord();
+    void testTruncated();
+};
+
+#endif
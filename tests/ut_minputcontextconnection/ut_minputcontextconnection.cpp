@@ -0,0 +1,103 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_minputcontextconnection.h"
+
+#include "minputcontextconnection.h"
+
+namespace
+{
+    const char * const WidgetStateChanged =
+            SIGNAL(widgetStateChanged(unsigned int, QMap<QString, QVariant>, QMap<QString, QVariant>, bool));
+
+    QVariantMap completeState(const QString &text)
+    {
+        QVariantMap state;
+        state["focusState"] = true;
+        state["surroundingText"] = text;
+        state["cursorPosition"] = 1;
+        state["hasSelection"] = false;
+        return state;
+    }
+
+    QVariantMap changedState()
+    {
+        QVariantMap state;
+        state["cursorPosition"] = 3;
+        state["hasSelection"] = true;
+        return state;
+    }
+}
+
+void Ut_MInputContextConnection::testPartialUpdateMerged()
+{
+    MInputContextConnection connection;
+    QSignalSpy states(&connection, WidgetStateChanged);
+
+    connection.activateContext(1);
+    const QVariantMap complete = completeState("abc");
+    connection.updateWidgetInformation(1, complete, true);
+    QCOMPARE(states.count(), 1);
+
+    connection.updateWidgetInformationPartial(1, changedState());
+    QCOMPARE(states.count(), 2);
+
+    // Plugins get the complete state, with the changed entries replaced
+    QVariantMap merged = complete;
+    merged["cursorPosition"] = 3;
+    merged["hasSelection"] = true;
+
+    const QList<QVariant> arguments = states.last();
+    QCOMPARE(arguments.at(0).toUInt(), 1u);
+    QCOMPARE(arguments.at(1).toMap(), merged);
+    QCOMPARE(arguments.at(2).toMap(), complete);
+    QCOMPARE(arguments.at(3).toBool(), false);
+
+    QString text;
+    int cursorPosition = 0;
+    QVERIFY(connection.surroundingText(text, cursorPosition));
+    QCOMPARE(text, QString("abc"));
+    QCOMPARE(cursorPosition, 3);
+}
+
+void Ut_MInputContextConnection::testPartialUpdateNeedsCompleteState()
+{
+    MInputContextConnection connection;
+    QSignalSpy states(&connection, WidgetStateChanged);
+
+    // Nothing to merge with yet
+    connection.activateContext(1);
+    connection.updateWidgetInformationPartial(1, changedState());
+    QCOMPARE(states.count(), 0);
+
+    connection.updateWidgetInformation(1, completeState("abc"), true);
+    QCOMPARE(states.count(), 1);
+
+    // The current state still belongs to the previous client
+    connection.activateContext(2);
+    connection.updateWidgetInformationPartial(2, changedState());
+    QCOMPARE(states.count(), 1);
+
+    // Inactive clients are ignored anyway
+    connection.updateWidgetInformationPartial(1, changedState());
+    QCOMPARE(states.count(), 1);
+
+    connection.updateWidgetInformation(2, completeState("xyz"), true);
+    QCOMPARE(states.count(), 2);
+
+    connection.updateWidgetInformationPartial(2, changedState());
+    QCOMPARE(states.count(), 3);
+
+    const QVariantMap state = states.last().at(1).toMap();
+    QCOMPARE(state.value("surroundingText").toString(), QString("xyz"));
+    QCOMPARE(state.value("cursorPosition").toInt(), 3);
+    QCOMPARE(state.value("hasSelection").toBool(), true);
+}
+
+QTEST_MAIN(Ut_MInputContextConnection)
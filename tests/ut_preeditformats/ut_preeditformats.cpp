@@ -0,0 +1,105 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_preeditformats.h"
+
+#include "dbuscustomarguments.h"
+
+#include <maliit/namespace.h>
+
+void Ut_PreeditFormats::testRoundTrip()
+{
+    QList<Maliit::PreeditTextFormat> formats;
+    formats << Maliit::PreeditTextFormat(0, 3, Maliit::PreeditActive)
+            << Maliit::PreeditTextFormat(3, 70000, Maliit::PreeditUnconvertible)
+            << Maliit::PreeditTextFormat(-1, 0, Maliit::PreeditNoCandidates);
+
+    const QByteArray packed = Maliit::DBus::packPreeditFormats(formats);
+    QCOMPARE(packed.size(), formats.count() * Maliit::DBus::PackedPreeditFormatSize);
+
+    QList<Maliit::PreeditTextFormat> unpacked;
+    QVERIFY(Maliit::DBus::unpackPreeditFormats(packed, &unpacked));
+    QCOMPARE(unpacked.count(), formats.count());
+
+    for (int n = 0; n < formats.count(); ++n) {
+        QCOMPARE(unpacked.at(n).start, formats.at(n).start);
+        QCOMPARE(unpacked.at(n).length, formats.at(n).length);
+        QCOMPARE(unpacked.at(n).preeditFace, formats.at(n).preeditFace);
+    }
+
+    QVERIFY(Maliit::DBus::packPreeditFormats(QList<Maliit::PreeditTextFormat>()).isEmpty());
+    QVERIFY(Maliit::DBus::unpackPreeditFormats(QByteArray(), &unpacked));
+    QVERIFY(unpacked.isEmpty());
+}
+
+void Ut_PreeditFormats::testLayout()
+{
+    // The layout is part of the D-Bus interface and must not change
+    QList<Maliit::PreeditTextFormat> formats;
+    formats << Maliit::PreeditTextFormat(0x01020304, 5, Maliit::PreeditActive);
+
+    QCOMPARE(Maliit::DBus::packPreeditFormats(formats),
+             QByteArray("\x04\x03\x02\x01\x05\x00\x00\x00\x04", 9));
+}
+
+void Ut_PreeditFormats::testMalformed()
+{
+    QList<Maliit::PreeditTextFormat> formats;
+
+    QVERIFY(!Maliit::DBus::unpackPreeditFormats(QByteArray(Maliit::DBus::PackedPreeditFormatSize + 1, '\0'),
+                                                &formats));
+}
+
+void Ut_PreeditFormats::testCompactUpdate_data()
+{
+    QTest::addColumn<QString>("sent");
+    QTest::addColumn<QString>("preedit");
+    QTest::addColumn<int>("prefix");
+
+    // U+1F600 and U+1F601 share their high surrogate
+    const QString grinning = QString::fromUtf8("\xF0\x9F\x98\x80");
+    const QString beaming = QString::fromUtf8("\xF0\x9F\x98\x81");
+
+    QTest::newRow("first") << QString() << QString("hello") << 0;
+    QTest::newRow("same") << QString("hello") << QString("hello") << 5;
+    QTest::newRow("growing") << QString("hel") << QString("hello") << 3;
+    QTest::newRow("shrinking") << QString("hello") << QString("help") << 3;
+    QTest::newRow("cleared") << QString("hello") << QString() << 0;
+    QTest::newRow("replaced") << QString("hello") << QString("world") << 0;
+    QTest::newRow("non-BMP kept") << "a" + grinning << "a" + grinning + "b" << 3;
+    QTest::newRow("non-BMP changed") << "a" + grinning + "b" << "a" + beaming + "b" << 1;
+    QTest::newRow("non-BMP removed") << "a" + grinning << QString("a") << 1;
+}
+
+void Ut_PreeditFormats::testCompactUpdate()
+{
+    QFETCH(QString, sent);
+    QFETCH(QString, preedit);
+    QFETCH(int, prefix);
+
+    QCOMPARE(Maliit::DBus::compactPreeditPrefix(sent, preedit), prefix);
+
+    // The client rebuilds the preedit from what it got last time
+    QString rebuilt = sent;
+    QVERIFY(Maliit::DBus::applyCompactPreedit(&rebuilt, prefix, preedit.mid(prefix)));
+    QCOMPARE(rebuilt, preedit);
+}
+
+void Ut_PreeditFormats::testCompactPrefixTooLong()
+{
+    QString preedit("abc");
+
+    QVERIFY(!Maliit::DBus::applyCompactPreedit(&preedit, 4, QString("d")));
+    QCOMPARE(preedit, QString("abc"));
+
+    QVERIFY(Maliit::DBus::applyCompactPreedit(&preedit, 3, QString("d")));
+    QCOMPARE(preedit, QString("abcd"));
+}
+
+QTEST_MAIN(Ut_PreeditFormats)
@@ -0,0 +1,29 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef UT_PREEDITFORMATS_H
+#define UT_PREEDITFORMATS_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+class Ut_PreeditFormats : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRoundTrip();
+    void testLayout();
+    void testMalformed();
+    void testCompactUpdate_data();
+    void testCompactUpdate();
+    void testCompactPrefixTooLong();
+};
+
+#endif
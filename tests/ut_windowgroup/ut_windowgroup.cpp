@@ -0,0 +1,75 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#include "ut_windowgroup.h"
+
+#include "unknownplatform.h"
+#include "windowgroup.h"
+
+#include <QWindow>
+
+namespace
+{
+    // Comfortably longer than a frame
+    const int FrameWait = 100; // in ms
+
+    QSharedPointer<Maliit::AbstractPlatform> platform()
+    {
+        return QSharedPointer<Maliit::AbstractPlatform>(new Maliit::UnknownPlatform);
+    }
+}
+
+void Ut_WindowGroup::testAreaUpdatesPerFrame()
+{
+    Maliit::WindowGroup group(platform());
+    QWindow window;
+    QSignalSpy areaChanged(&group, SIGNAL(inputMethodAreaChanged(QRegion)));
+
+    group.activate();
+    group.setupWindow(&window, Maliit::PositionCenterBottom);
+    window.show();
+    QTest::qWait(FrameWait);
+    QCOMPARE(areaChanged.count(), 0);
+
+    // An animation moving the keyboard in within a single frame
+    group.setInputMethodArea(QRegion(0, 300, 100, 20), &window);
+    group.setInputMethodArea(QRegion(0, 250, 100, 70), &window);
+    group.setInputMethodArea(QRegion(0, 200, 100, 120), &window);
+
+    QTRY_COMPARE(areaChanged.count(), 1);
+    QTest::qWait(FrameWait);
+
+    QCOMPARE(areaChanged.count(), 1);
+    QCOMPARE(group.inputMethodAreaUpdateCount(), quint64(1));
+    QCOMPARE(areaChanged.at(0).at(0).value<QRegion>(),
+             QRegion(0, 200, 100, 120).translated(window.position()));
+}
+
+void Ut_WindowGroup::testUpdateRateDecays()
+{
+    Maliit::WindowGroup group(platform());
+    QWindow window;
+
+    group.activate();
+    group.setupWindow(&window, Maliit::PositionCenterBottom);
+    window.show();
+
+    QCOMPARE(group.inputMethodAreaUpdateRate(), 0.0);
+
+    for (int n = 1; n <= 3; ++n) {
+        group.setInputMethodArea(QRegion(0, 0, 100, n * 10), &window);
+        QTRY_COMPARE(group.inputMethodAreaUpdateCount(), quint64(n));
+    }
+    QCOMPARE(group.inputMethodAreaUpdateRate(), 3.0);
+
+    // Without further updates the rate drops, although nothing is recomputed
+    QTRY_COMPARE_WITH_TIMEOUT(group.inputMethodAreaUpdateRate(), 0.0, 3000);
+}
+
+QTEST_MAIN(Ut_WindowGroup)
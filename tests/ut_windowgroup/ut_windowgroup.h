@@ -0,0 +1,25 @@
+/* * This file is part of Maliit framework *
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * and appearing in the file LICENSE.LGPL included in the packaging
+ * of this file.
+ */
+
+#ifndef UT_WINDOWGROUP_H
+#define UT_WINDOWGROUP_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+class Ut_WindowGroup : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testAreaUpdatesPerFrame();
+    void testUpdateRateDecays();
+};
+
+#endif